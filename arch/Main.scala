@@ -72,4 +72,6 @@ object MainSystem extends App {
     binPath = Some("build/config.pb"),
     isaBinPath = Some("build/isa.pb"),
   )
+  // Kept per design so sims can link several of them (DEMU_MODELS)
+  RiscDump.dumpConfig(p, s"build/${p(ISA).name}_config.json")
 }
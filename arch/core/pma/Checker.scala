@@ -21,10 +21,11 @@ class PmaChecker(implicit p: Parameters) extends Module {
   val is_sram = hits.filter(_._1 == DEVICE_TYPE_SRAM).map(_._2).reduce(_ || _)
   val is_uart = hits.filter(_._1 == DEVICE_TYPE_UART).map(_._2).reduce(_ || _)
   val is_irh  = hits.filter(_._1 == DEVICE_TYPE_IRH).map(_._2).reduce(_ || _)
+  val is_htif = hits.filter(_._1 == DEVICE_TYPE_HTIF).map(_._2).foldLeft(false.B)(_ || _)
 
-  valid     := is_sram || is_uart || is_irh
-  readable  := is_sram || is_uart || is_irh
-  writable  := is_sram || is_uart || is_irh
+  valid     := is_sram || is_uart || is_irh || is_htif
+  readable  := is_sram || is_uart || is_irh || is_htif
+  writable  := is_sram || is_uart || is_irh || is_htif
   cacheable := is_sram
 }
 
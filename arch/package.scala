@@ -79,7 +79,8 @@ package object configs {
           DeviceDescriptor(name = "imem", `type` = DEVICE_TYPE_SRAM, base = 0x80000000L, size = 0x40000L),
           DeviceDescriptor(name = "dmem", `type` = DEVICE_TYPE_SRAM, base = 0x80040000L, size = 0x40000L),
           DeviceDescriptor(name = "uart", `type` = DEVICE_TYPE_UART, base = 0x10000000L, size = 0x1000L),
-          DeviceDescriptor(name = "clint", `type` = DEVICE_TYPE_IRH, base = 0x20000000L, size = 0x10000L)
+          DeviceDescriptor(name = "clint", `type` = DEVICE_TYPE_IRH, base = 0x20000000L, size = 0x10000L),
+          DeviceDescriptor(name = "htif", `type` = DEVICE_TYPE_HTIF, base = 0x30000000L, size = 0x1000L)
         )
       )
   // --------------------------------------------
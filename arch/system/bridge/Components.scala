@@ -4,10 +4,18 @@ import arch.configs._
 import vopts.mem.cache._
 import chisel3._
 
+// AXI ID each bridge master drives, so slaves can tell the L1I, L1D and MMIO
+// requests apart
+object BusMasterId {
+  val IBUS = 0
+  val DBUS = 1
+  val MBUS = 2
+}
+
 trait BusBridgeUtils extends Utils {
   def busType: Bundle
-  def createBridge[T <: Data](gen: T, memory: CacheIO[T], isMmio: Boolean = false): Bundle
-  def createBridgeReadOnly[T <: Data](gen: T, memory: CacheReadOnlyIO[T], isMmio: Boolean = false): Bundle
+  def createBridge[T <: Data](gen: T, memory: CacheIO[T], isMmio: Boolean = false, id: Int = 0): Bundle
+  def createBridgeReadOnly[T <: Data](gen: T, memory: CacheReadOnlyIO[T], isMmio: Boolean = false, id: Int = 0): Bundle
 }
 
 object BusBridgeUtilsFactory extends UtilsFactory[BusBridgeUtils]("BusBridge")
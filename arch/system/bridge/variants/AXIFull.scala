@@ -13,7 +13,7 @@ object AXIFullBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
     override def busType: Bundle =
       new AXIFullMasterIO(addrWidth = p(XLen), dataWidth = p(XLen), idWidth = 4)
 
-    override def createBridge[T <: Data](gen: T, memory: CacheIO[T], isMmio: Boolean = false): Bundle = {
+    override def createBridge[T <: Data](gen: T, memory: CacheIO[T], isMmio: Boolean = false, id: Int = 0): Bundle = {
       val axi = Wire(new AXIFullMasterIO(addrWidth = p(XLen), dataWidth = p(XLen), idWidth = 4))
 
       val bytesPerGen    = memory.req.bits.data.getWidth / 8
@@ -66,7 +66,7 @@ object AXIFullBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
           axi.ar.bits.len   := burstLen
           axi.ar.bits.size  := log2Ceil(p(BytesPerWord)).U
           axi.ar.bits.burst := (if (isMmio) 1 else 2).U
-          axi.ar.bits.id    := 0.U
+          axi.ar.bits.id    := id.U
           when(axi.ar.fire)(state := AXIBridgeState.R)
         }
         is(AXIBridgeState.R) {
@@ -114,7 +114,7 @@ object AXIFullBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
           axi.aw.bits.len   := burstLen
           axi.aw.bits.size  := log2Ceil(p(BytesPerWord)).U
           axi.aw.bits.burst := 1.U
-          axi.aw.bits.id    := 0.U
+          axi.aw.bits.id    := id.U
           when(axi.aw.fire)(state := AXIBridgeState.W)
         }
         is(AXIBridgeState.W) {
@@ -184,7 +184,7 @@ object AXIFullBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
       axi
     }
 
-    override def createBridgeReadOnly[T <: Data](gen: T, memory: CacheReadOnlyIO[T], isMmio: Boolean = false): Bundle = {
+    override def createBridgeReadOnly[T <: Data](gen: T, memory: CacheReadOnlyIO[T], isMmio: Boolean = false, id: Int = 0): Bundle = {
       val axi = Wire(new AXIFullMasterIO(addrWidth = p(XLen), dataWidth = p(XLen), idWidth = 4))
 
       val bytesPerGen    = memory.resp.bits.data.getWidth / 8
@@ -226,7 +226,7 @@ object AXIFullBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
           axi.ar.bits.len   := burstLen
           axi.ar.bits.size  := log2Ceil(p(BytesPerWord)).U
           axi.ar.bits.burst := (if (isMmio) 1 else 2).U
-          axi.ar.bits.id    := 0.U
+          axi.ar.bits.id    := id.U
           when(axi.ar.fire)(state := AXIBridgeState.R)
         }
         is(AXIBridgeState.R) {
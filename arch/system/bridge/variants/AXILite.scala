@@ -17,7 +17,7 @@ object AXILiteBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
     override def busType: Bundle =
       new AXILiteMasterIO(addrWidth = p(XLen), dataWidth = p(XLen))
 
-    override def createBridge[T <: Data](gen: T, memory: CacheIO[T], isMmio: Boolean = false): Bundle = {
+    override def createBridge[T <: Data](gen: T, memory: CacheIO[T], isMmio: Boolean = false, id: Int = 0): Bundle = {
       val axi = Wire(new AXILiteMasterIO(addrWidth = p(XLen), dataWidth = p(XLen)))
 
       val beats = (gen.getWidth / p(XLen)).max(1)
@@ -113,7 +113,7 @@ object AXILiteBridgeUtils extends RegisteredUtils[BusBridgeUtils] {
       axi
     }
 
-    override def createBridgeReadOnly[T <: Data](gen: T, memory: CacheReadOnlyIO[T], isMmio: Boolean = false): Bundle = {
+    override def createBridgeReadOnly[T <: Data](gen: T, memory: CacheReadOnlyIO[T], isMmio: Boolean = false, id: Int = 0): Bundle = {
       val axi = Wire(new AXILiteMasterIO(addrWidth = p(XLen), dataWidth = p(XLen)))
 
       val bytesPerGen    = memory.resp.bits.data.getWidth / 8
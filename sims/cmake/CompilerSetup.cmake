@@ -55,6 +55,27 @@ else()
   )
 endif()
 
+# Profile-guided optimization of libdemu, the model and the tools. The
+# profiles are only valid for the build tree that generated them.
+if(PGO STREQUAL "GENERATE")
+  add_compile_options(-fprofile-generate=${PGO_DIR}/compiler
+                      -fprofile-update=atomic)
+  add_link_options(-fprofile-generate=${PGO_DIR}/compiler)
+elseif(PGO STREQUAL "USE")
+  add_compile_options(-fprofile-use=${PGO_DIR}/compiler)
+  add_link_options(-fprofile-use=${PGO_DIR}/compiler)
+  if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    # Keep code the training set never reached optimized for speed
+    add_compile_options(-fprofile-partial-training -Wno-missing-profile)
+  else()
+    add_compile_options(-Wno-profile-instr-unprofiled
+                        -Wno-profile-instr-out-of-date)
+  endif()
+elseif(PGO AND NOT PGO STREQUAL "OFF")
+  message(FATAL_ERROR "Unsupported PGO mode: ${PGO}. Supported: OFF, "
+                      "GENERATE, USE")
+endif()
+
 if(USE_CCACHE)
   find_program(CCACHE_PROGRAM ccache)
   if(CCACHE_PROGRAM)
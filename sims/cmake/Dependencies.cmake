@@ -33,15 +33,35 @@ else()
     message(FATAL_ERROR "Unsupported ISA: ${TARGET_ARCH}. Supported ISAs: rv32i, rv32im")
   endif()
 
+  if(NOT TARGET_ARCH IN_LIST DEMU_MODELS)
+    list(PREPEND DEMU_MODELS ${TARGET_ARCH})
+  endif()
+  list(REMOVE_DUPLICATES DEMU_MODELS)
+  foreach(_model ${DEMU_MODELS})
+    if(NOT _model MATCHES "^(rv32i|rv32im)$")
+      message(FATAL_ERROR "Unsupported model: ${_model}. Supported models: rv32i, rv32im")
+    endif()
+    string(TOUPPER ${_model} _model_upper)
+    add_compile_definitions(DEMU_MODEL_${_model_upper})
+  endforeach()
+  add_compile_definitions(DEMU_DEFAULT_MODEL="${TARGET_ARCH}")
+  # The disassembler decodes the widest linked ISA
+  if("rv32im" IN_LIST DEMU_MODELS AND NOT TARGET_ARCH STREQUAL "rv32im")
+    add_compile_definitions(__ISA_RV32IM__)
+  endif()
+
   add_definitions(-DNUM_THREADS=${NUM_THREADS})
 
+  # Both only apply to the instrumented model, see LibraryTargets.cmake
   if(ENABLE_TRACE)
-    list(APPEND VERILATOR_ARGS --trace)
     add_definitions(-DENABLE_TRACE)
+    if(ENABLE_TRACE_FST)
+      add_definitions(-DENABLE_TRACE_FST)
+    endif()
   endif()
 
   if(ENABLE_COVERAGE)
-    list(APPEND VERILATOR_ARGS --coverage)
+    add_definitions(-DENABLE_COVERAGE)
   endif()
 
 endif()
@@ -57,6 +77,7 @@ file(GLOB PROTO_FILES
   CONFIGURE_DEPENDS
   "${PROTO_ROOT}/isa/*.proto"
   "${PROTO_ROOT}/configs/*.proto"
+  "${PROTO_ROOT}/report/*.proto"
 )
 
 if(NOT PROTO_FILES)
@@ -65,6 +86,7 @@ endif()
 
 file(MAKE_DIRECTORY "${PROTO_OUT}/configs")
 file(MAKE_DIRECTORY "${PROTO_OUT}/isa")
+file(MAKE_DIRECTORY "${PROTO_OUT}/report")
 
 set(PROTO_GENERATED_HEADERS "")
 set(PROTO_GENERATED_SOURCES "")
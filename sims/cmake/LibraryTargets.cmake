@@ -8,34 +8,81 @@ add_library(demu
 
 add_dependencies(demu gen_proto)
 
-verilate(demu
-  SOURCES ${RTL_SOURCE}
-  VERILATOR_ARGS
-    -Wall
-    -Wno-WIDTH
-    -Wno-UNUSED
-    -Wno-UNOPTFLAT
-    -Wno-DECLFILENAME
-    -Wno-PINCONNECTEMPTY
-    -j 0
-    --top-module ${TARGET_ARCH}_system
-    -CFLAGS "-Wno-unused-variable -Wno-bool-operation -Wno-parentheses-equality"
-
-    --output-split 2000
-    --output-split-cfuncs 2000
-    --output-split-ctrace 2000
-
-  PREFIX V${TARGET_ARCH}_system
-  TRACE_THREADS ${NUM_TRACE_THREADS}
-  THREADS ${NUM_THREADS}
+# Records per-partition eval timing, enabled at run time with
+# +verilator+prof+exec+start+<time>; see scripts/demu-tune
+set(DEMU_PROF_ARGS "")
+if(ENABLE_PROF_EXEC)
+  set(DEMU_PROF_ARGS --prof-exec)
+endif()
+
+# Thread scheduling feedback: --prof-pgo records mtask costs to a .vlt file
+# that the USE build passes back to Verilator
+if(PGO STREQUAL "GENERATE")
+  list(APPEND DEMU_PROF_ARGS --prof-pgo)
+elseif(PGO STREQUAL "USE" AND EXISTS "${PGO_DIR}/profile.vlt")
+  list(APPEND DEMU_PROF_ARGS "${PGO_DIR}/profile.vlt")
+endif()
+
+set(DEMU_VERILATOR_ARGS
+  -Wall
+  -Wno-WIDTH
+  -Wno-UNUSED
+  -Wno-UNOPTFLAT
+  -Wno-DECLFILENAME
+  -Wno-PINCONNECTEMPTY
+  -j 0
+  -CFLAGS "-Wno-unused-variable -Wno-bool-operation -Wno-parentheses-equality"
+
+  --output-split 2000
+  --output-split-cfuncs 2000
+  --output-split-ctrace 2000
 )
 
+# Instrumented build of the same RTL, picked at run time by -t/--coverage
+set(DEMU_INST_OPTIONS "")
+if(ENABLE_TRACE AND ENABLE_TRACE_FST)
+  list(APPEND DEMU_INST_OPTIONS TRACE_FST TRACE_THREADS ${NUM_TRACE_THREADS})
+elseif(ENABLE_TRACE)
+  list(APPEND DEMU_INST_OPTIONS TRACE)
+endif()
+if(ENABLE_COVERAGE)
+  list(APPEND DEMU_INST_OPTIONS COVERAGE)
+endif()
+
+# Every model in DEMU_MODELS is linked in and picked at run time by --model.
+# The prefixes keep their generated classes apart.
+foreach(_model ${DEMU_MODELS})
+  # Lean model, run unless tracing or coverage is asked for
+  verilate(demu
+    SOURCES ${RTL_SOURCE_${_model}}
+    VERILATOR_ARGS ${DEMU_VERILATOR_ARGS} ${DEMU_PROF_ARGS}
+      --top-module ${_model}_system
+    PREFIX V${_model}_system
+    THREADS ${NUM_THREADS}
+  )
+
+  if(DEMU_INST_OPTIONS)
+    verilate(demu
+      SOURCES ${RTL_SOURCE_${_model}}
+      VERILATOR_ARGS ${DEMU_VERILATOR_ARGS} --top-module ${_model}_system
+      PREFIX V${_model}_system_inst
+      THREADS ${NUM_THREADS}
+      ${DEMU_INST_OPTIONS}
+    )
+  endif()
+endforeach()
+
+if(DEMU_INST_OPTIONS)
+  target_compile_definitions(demu PUBLIC DEMU_INSTRUMENTED_MODEL)
+endif()
+
 target_include_directories(demu PUBLIC
   $<BUILD_INTERFACE:${CMAKE_CURRENT_SOURCE_DIR}/include>
   $<INSTALL_INTERFACE:include>
   "${PROTO_OUT}"
   "${PROTO_OUT}/configs"
   "${PROTO_OUT}/isa"
+  "${PROTO_OUT}/report"
 )
 
 set_target_properties(demu PROPERTIES
@@ -46,6 +93,12 @@ set_target_properties(demu PROPERTIES
 # spdlog
 target_link_libraries(demu PUBLIC spdlog::spdlog)
 
+# shm_open, for live statistics; part of libc since glibc 2.34
+find_library(RT_LIB rt)
+if(RT_LIB)
+  target_link_libraries(demu PUBLIC ${RT_LIB})
+endif()
+
 # protobuf 
 set(ABSL_LINK_TARGETS "")
 
@@ -13,9 +13,13 @@ file(GLOB_RECURSE DEMU_HEADERS
 )
 
 # Use ISA-specific top RTL only to avoid duplicate module definitions
-# from multiple generated system variants in ../build.
-set(RTL_SOURCE "${RTL_DIR}/${TARGET_ARCH}_system.sv")
-if(NOT EXISTS "${RTL_SOURCE}")
-  message(WARNING "RTL file not found: ${RTL_SOURCE}")
-  message(WARNING "Please make sure your Chisel design has been generated")
-endif()
+# from multiple generated system variants in ../build. Each linked model is
+# verilated on its own, so every one of them gets a single top file.
+foreach(_model ${DEMU_MODELS})
+  set(RTL_SOURCE_${_model} "${RTL_DIR}/${_model}_system.sv")
+  if(NOT EXISTS "${RTL_SOURCE_${_model}}")
+    message(WARNING "RTL file not found: ${RTL_SOURCE_${_model}}")
+    message(WARNING "Please make sure your Chisel design has been generated")
+  endif()
+endforeach()
+set(RTL_SOURCE "${RTL_SOURCE_${TARGET_ARCH}}")
@@ -5,18 +5,32 @@ option(USE_CCACHE "Use ccache to speed up recompilation" ON)
 
 # settings
 set(TARGET_ARCH "rv32im")
+# models linked into libdemu and picked with --model; TARGET_ARCH is the
+# default and is always linked
+set(DEMU_MODELS "${TARGET_ARCH}")
 set(RTL_DIR "${CMAKE_SOURCE_DIR}/../build")
 
 option(ENABLE_SIM "Enable simulator" ON)
 option(ENABLE_DBG "Enable debugger" ON)
 option(ENABLE_DIFF "Enable difftest" ON)
+option(ENABLE_MODEL "Enable trace-driven timing model" ON)
+option(ENABLE_INTERVAL "Enable interval statistics reader" ON)
+option(ENABLE_TOP "Enable demu-top live statistics viewer" ON)
 
 # options
 set(NUM_THREADS 1)
 set(NUM_TRACE_THREADS 2)
 option(ENABLE_TESTING "Enable Testing" ON)
-option(ENABLE_TRACE "Enable VCD tracing" ON)
+# either one adds an instrumented model next to the lean one
+option(ENABLE_TRACE "Enable waveform tracing" ON)
+# FST is dumped on NUM_TRACE_THREADS threads; VCD on the simulation thread
+option(ENABLE_TRACE_FST "Write waveforms as FST instead of VCD" ON)
 option(ENABLE_COVERAGE "Enable coverage collection" ON)
+option(ENABLE_PROF_EXEC "Build the model with Verilator execution profiling" OFF)
+
+# profile-guided optimization: OFF, GENERATE or USE (see scripts/demu-pgo)
+set(PGO OFF)
+set(PGO_DIR "${CMAKE_BINARY_DIR}/pgo")
 
 # benchmarks
 option(ENABLE_COREMARK "Enable CoreMark" OFF)
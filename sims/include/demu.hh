@@ -1,8 +1,35 @@
 #pragma once
 
+#include "./demu/counters.hh"
+#include "./demu/debug_line.hh"
 #include "./demu/elf_loader.hh"
 #include "./demu/hal/hal.hh"
+#include "./demu/live_stats.hh"
 #include "./demu/isa/isa.hh"
 #include "./demu/logger.hh"
+#include "./demu/models.hh"
+#include "./demu/perf/bpu_model.hh"
+#include "./demu/perf/branch.hh"
+#include "./demu/perf/branch_stream.hh"
+#include "./demu/perf/cache_model.hh"
+#include "./demu/perf/hotspot.hh"
+#include "./demu/perf/interval.hh"
+#include "./demu/perf/inst_trace.hh"
+#include "./demu/perf/mem_stream.hh"
+#include "./demu/perf/miss.hh"
+#include "./demu/perf/prefetch.hh"
+#include "./demu/perf/probe.hh"
+#include "./demu/perf/shadow_bpu.hh"
+#include "./demu/perf/shadow_cache.hh"
+#include "./demu/perf/shadow_prefetch.hh"
+#include "./demu/perf/sweep.hh"
+#include "./demu/perf/timing_model.hh"
+#include "./demu/perf/util.hh"
+#include "./demu/profiling.hh"
 #include "./demu/retire_lane.hh"
+#include "./demu/roi.hh"
 #include "./demu/sim.hh"
+#include "./demu/symbols.hh"
+#include "./demu/topdown.hh"
+#include "./demu/watchdog.hh"
+#include "./demu/wave.hh"
@@ -41,7 +41,17 @@ public:
   [[nodiscard]] auto bus() const noexcept -> const risc::BusConfig & {
     return proto_.bus();
   }
+  [[nodiscard]] auto l2() const noexcept -> const risc::L2Config & {
+    return proto_.l2();
+  }
+
+  [[nodiscard]] auto proto() const noexcept -> const risc::RiscConfig & {
+    return proto_;
+  }
 
+  [[nodiscard]] auto path() const noexcept -> const std::string & {
+    return config_path_;
+  }
   [[nodiscard]] auto is_valid() const noexcept -> bool { return valid_; }
 
   [[nodiscard]] auto l1i_line_words(uint32_t word_bytes = 4) const noexcept
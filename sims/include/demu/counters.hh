@@ -0,0 +1,247 @@
+#pragma once
+
+#include "./logger.hh"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace demu {
+
+enum class CounterKind : uint8_t {
+  EVENT,     // pulses or per-cycle counts, summed
+  LEVEL,     // a 1-bit condition; sums the cycles it holds
+  HISTOGRAM, // a per-cycle count, summed, with its distribution kept
+};
+
+[[nodiscard]] constexpr auto counter_kind_name(CounterKind kind) noexcept
+    -> const char * {
+  switch (kind) {
+  case CounterKind::EVENT:
+    return "event";
+  case CounterKind::LEVEL:
+    return "level";
+  case CounterKind::HISTOGRAM:
+    return "histogram";
+  }
+  return "unknown";
+}
+
+struct CounterInfo {
+  std::string_view name; // DUT port without the debug_ prefix
+  std::string_view unit;
+  CounterKind kind{CounterKind::EVENT};
+  std::string_view description;
+};
+
+// X(signal, gate, unit, kind, description) for every per-cycle debug_*
+// port the harness accumulates. A signal counts only in cycles where
+// debug_<gate> is set; ungated signals are their own gate. Ports the DUT
+// does not have are skipped at compile time.
+#define DEMU_DEBUG_COUNTERS(X)                                                 \
+  X(l1_icache_access, l1_icache_access, "accesses", EVENT,                     \
+    "L1 I-cache lookups")                                                      \
+  X(l1_icache_miss, l1_icache_access, "misses", EVENT, "L1 I-cache misses")    \
+  X(l1_dcache_access, l1_dcache_access, "accesses", EVENT,                     \
+    "L1 D-cache lookups")                                                      \
+  X(l1_dcache_miss, l1_dcache_access, "misses", EVENT, "L1 D-cache misses")    \
+  X(branch_commit, branch_commit, "branches", EVENT, "Committed branches")     \
+  X(branch_taken, branch_taken, "branches", EVENT,                             \
+    "Taken branches trained into the BPU")                                     \
+  X(bpu_mispredict, bpu_mispredict, "mispredicts", EVENT,                      \
+    "Committed control flow that flushed the pipeline")                        \
+  X(flush_cycle, flush_cycle, "cycles", LEVEL, "Global pipeline flush")        \
+  X(rob_empty, rob_empty, "cycles", LEVEL, "ROB empty")                        \
+  X(frontend_stall, frontend_stall, "cycles", LEVEL,                           \
+    "Decoded instruction held back at dispatch")                               \
+  X(backend_stall, backend_stall, "cycles", LEVEL,                             \
+    "ROB occupied but nothing committed")                                      \
+  X(issue_count, issue_count, "uops", HISTOGRAM, "Dispatched per cycle")       \
+  X(commit_count, commit_count, "instructions", HISTOGRAM,                     \
+    "Committed per cycle")
+
+namespace detail {
+
+#define DEMU_DETECT_COUNTER(NAME, GATE, UNIT, KIND, DESC)                      \
+  template <typename DUT, typename Enable = void>                              \
+  struct HasCounter_##NAME : std::false_type {};                               \
+  template <typename DUT>                                                      \
+  struct HasCounter_##NAME<                                                    \
+      DUT, std::void_t<decltype(std::declval<DUT>().debug_##NAME),             \
+                       decltype(std::declval<DUT>().debug_##GATE)>>            \
+      : std::true_type {};
+
+DEMU_DEBUG_COUNTERS(DEMU_DETECT_COUNTER)
+
+#undef DEMU_DETECT_COUNTER
+
+#define DEMU_COUNT_COUNTER(NAME, GATE, UNIT, KIND, DESC)                       \
+  +size_t{HasCounter_##NAME<DUT>::value}
+
+template <typename DUT>
+inline constexpr size_t counter_count =
+    0 DEMU_DEBUG_COUNTERS(DEMU_COUNT_COUNTER);
+
+#undef DEMU_COUNT_COUNTER
+
+template <typename DUT>
+constexpr auto counter_infos() noexcept
+    -> std::array<CounterInfo, counter_count<DUT>> {
+  std::array<CounterInfo, counter_count<DUT>> out{};
+  size_t i = 0;
+#define DEMU_COUNTER_INFO(NAME, GATE, UNIT, KIND, DESC)                        \
+  if constexpr (HasCounter_##NAME<DUT>::value) {                               \
+    out[i++] = {#NAME, UNIT, CounterKind::KIND, DESC};                         \
+  }
+
+  DEMU_DEBUG_COUNTERS(DEMU_COUNTER_INFO)
+
+#undef DEMU_COUNTER_INFO
+  (void)i;
+  return out;
+}
+
+} // namespace detail
+
+// Accumulates every DEMU_DEBUG_COUNTERS port the DUT exposes. sample()
+// copies the ports into a contiguous array, then sums and tracks peaks in
+// branch-free loops over it; only histogram buckets are indexed per port.
+template <typename DUT> class CounterRegistry {
+public:
+  static constexpr size_t HISTOGRAM_BUCKETS = 9; // 0..8 lanes, last is 8+
+
+  static constexpr size_t size = detail::counter_count<DUT>;
+
+  using Histogram = std::array<uint64_t, HISTOGRAM_BUCKETS>;
+
+  static constexpr std::array<CounterInfo, size> INFOS =
+      detail::counter_infos<DUT>();
+
+  [[nodiscard]] static constexpr auto infos() noexcept
+      -> const std::array<CounterInfo, size> & {
+    return INFOS;
+  }
+
+  // `size` when the DUT has no such port
+  [[nodiscard]] static constexpr auto index_of(std::string_view name) noexcept
+      -> size_t {
+    for (size_t k = 0; k < size; ++k) {
+      if (INFOS[k].name == name) {
+        return k;
+      }
+    }
+    return size;
+  }
+
+  // `dut` may be any build of the same RTL; the ports are gated on DUT
+  template <typename Model> void sample(const Model *dut) noexcept {
+#define DEMU_COUNTER_READ(NAME, GATE, UNIT, KIND, DESC)                        \
+  if constexpr (detail::HasCounter_##NAME<DUT>::value) {                       \
+    constexpr size_t k = index_of(#NAME);                                      \
+    values_[k] = static_cast<uint64_t>(dut->debug_##NAME) *                    \
+                 static_cast<uint64_t>(dut->debug_##GATE != 0);                \
+    if constexpr (CounterKind::KIND == CounterKind::HISTOGRAM) {               \
+      histograms_[k][std::min<uint64_t>(values_[k], HISTOGRAM_BUCKETS - 1)]++; \
+    }                                                                          \
+  }
+
+    DEMU_DEBUG_COUNTERS(DEMU_COUNTER_READ)
+
+#undef DEMU_COUNTER_READ
+
+    for (size_t k = 0; k < size; ++k) {
+      totals_[k] += values_[k];
+    }
+    for (size_t k = 0; k < size; ++k) {
+      peaks_[k] = std::max(peaks_[k], values_[k]);
+    }
+  }
+
+  void reset() noexcept {
+    totals_.fill(0);
+    peaks_.fill(0);
+    values_.fill(0);
+    histograms_.fill({});
+  }
+
+  [[nodiscard]] auto total(size_t k) const noexcept -> uint64_t {
+    return k < size ? totals_[k] : 0;
+  }
+  [[nodiscard]] auto total(std::string_view name) const noexcept
+      -> uint64_t {
+    return total(index_of(name));
+  }
+  [[nodiscard]] auto peak(size_t k) const noexcept -> uint64_t {
+    return k < size ? peaks_[k] : 0;
+  }
+  [[nodiscard]] auto histogram(size_t k) const noexcept -> const Histogram & {
+    return histograms_[k];
+  }
+
+  // Sets the member of `out` named after each bound port to its total;
+  // ports the DUT lacks leave theirs untouched
+  template <typename Out> void totals_to(Out &out) const noexcept {
+    copy_to(totals_, out);
+  }
+  // The same with the gated values of the last sample()
+  template <typename Out> void values_to(Out &out) const noexcept {
+    copy_to(values_, out);
+  }
+
+  // f(const CounterInfo &, size_t index) for every bound counter
+  template <typename F> void for_each(F &&f) const {
+    for (size_t k = 0; k < size; ++k) {
+      f(INFOS[k], k);
+    }
+  }
+
+  void report(uint64_t cycles) const {
+    DEMU_INFO("--- DUT Counters ({} bound) ---", size);
+    for_each([&](const CounterInfo &info, size_t k) {
+      const double per_cycle =
+          cycles > 0 ? static_cast<double>(totals_[k]) / cycles : 0.0;
+      DEMU_INFO("  {:<18} {:>12} {:<12} {:>8.4f}/cycle  peak {:<3} {}",
+                info.name, totals_[k], info.unit, per_cycle, peaks_[k],
+                info.description);
+      if (info.kind == CounterKind::HISTOGRAM) {
+        std::string dist;
+        for (size_t b = 0; b <= std::min<uint64_t>(peaks_[k],
+                                                    HISTOGRAM_BUCKETS - 1);
+             ++b) {
+          dist += fmt::format(" {}:{:.1f}%", b,
+                              cycles > 0 ? 100.0 * histograms_[k][b] / cycles
+                                         : 0.0);
+        }
+        DEMU_INFO("  {:<18}{}", "", dist);
+      }
+    });
+    DEMU_INFO("")
+  }
+
+private:
+  std::array<uint64_t, size> values_{};
+  std::array<uint64_t, size> totals_{};
+  std::array<uint64_t, size> peaks_{};
+  std::array<Histogram, size> histograms_{};
+
+  template <typename Out>
+  static void copy_to(const std::array<uint64_t, size> &from,
+                      Out &out) noexcept {
+#define DEMU_COUNTER_COPY(NAME, GATE, UNIT, KIND, DESC)                        \
+  if constexpr (detail::HasCounter_##NAME<DUT>::value) {                       \
+    constexpr size_t k = index_of(#NAME);                                      \
+    out.NAME = static_cast<decltype(out.NAME)>(from[k]);                       \
+  }
+
+    DEMU_DEBUG_COUNTERS(DEMU_COUNTER_COPY)
+
+#undef DEMU_COUNTER_COPY
+    (void)from;
+    (void)out;
+  }
+};
+
+} // namespace demu
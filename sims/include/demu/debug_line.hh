@@ -0,0 +1,52 @@
+#pragma once
+
+#include "./isa/isa.hh"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace demu {
+using namespace isa;
+
+struct SourceLocation {
+  const std::string *file{nullptr};
+  uint32_t line{0};
+
+  [[nodiscard]] auto valid() const noexcept -> bool { return file != nullptr; }
+};
+
+// PC -> file:line map built from the DWARF `.debug_line` section (v2-v5).
+//
+// open() only records the path; the ELF is memory-mapped and the line
+// programs are decoded on the first lookup, then the mapping is dropped and
+// only the compact row table is kept. Lookups are thread-safe.
+class LineTable final {
+public:
+  void open(const std::string &filename);
+  void clear();
+
+  [[nodiscard]] auto lookup(addr_t pc) const -> SourceLocation;
+  // "file:line", or an empty string when the PC has no line info
+  [[nodiscard]] auto describe(addr_t pc) const -> std::string;
+
+  [[nodiscard]] auto empty() const -> bool;
+
+private:
+  struct Row {
+    addr_t addr;
+    uint32_t line;
+    uint32_t file;
+    bool end_sequence;
+  };
+
+  std::string path_;
+  mutable std::mutex mtx_;
+  mutable bool loaded_{false};
+  mutable std::vector<Row> rows_;
+  mutable std::vector<std::string> files_;
+
+  void load_locked() const;
+};
+
+} // namespace demu
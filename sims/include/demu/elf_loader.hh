@@ -9,6 +9,19 @@
 #define PT_LOAD 1
 #endif
 
+#ifndef SHT_SYMTAB
+#define SHT_SYMTAB 2
+#endif
+
+#ifndef STT_FUNC
+#define STT_NOTYPE 0
+#define STT_FUNC 2
+#endif
+
+#ifndef STB_LOCAL
+#define STB_LOCAL 0
+#endif
+
 namespace demu {
 struct ELF32_Header {
   uint8_t e_ident[16];
@@ -38,6 +51,37 @@ struct ELF32_ProgramHeader {
   uint32_t p_align;
 };
 
+struct ELF32_SectionHeader {
+  uint32_t sh_name;
+  uint32_t sh_type;
+  uint32_t sh_flags;
+  uint32_t sh_addr;
+  uint32_t sh_offset;
+  uint32_t sh_size;
+  uint32_t sh_link;
+  uint32_t sh_info;
+  uint32_t sh_addralign;
+  uint32_t sh_entsize;
+};
+
+struct ELF32_Symbol {
+  uint32_t st_name;
+  uint32_t st_value;
+  uint32_t st_size;
+  uint8_t st_info;
+  uint8_t st_other;
+  uint16_t st_shndx;
+};
+
+struct ELFSymbol {
+  std::string name;
+  uint32_t addr;
+  uint32_t size;
+  uint8_t type;
+  uint8_t bind;
+  bool code; // defined in an SHF_EXECINSTR section
+};
+
 struct ELFSection {
   std::string name;
   uint32_t addr;
@@ -51,6 +95,8 @@ public:
       -> bool;
   static auto load(std::vector<ELFSection> &sections, uint32_t &entry_point,
                    const std::string &filename) -> bool;
+  static auto load_symbols(std::vector<ELFSymbol> &symbols,
+                           const std::string &filename) -> bool;
 
 private:
   static auto is_elf(const std::string &filename) -> bool;
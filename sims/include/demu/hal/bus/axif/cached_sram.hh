@@ -0,0 +1,29 @@
+#pragma once
+#include "../../peripheral/cache/l2.hh"
+#include "./sram.hh"
+
+namespace demu::hal::axif {
+
+// AXIFullSRAM behind a shared L2Cache: data is read and written exactly as
+// in AXIFullSRAM, but a read burst's beats and a write burst's B response
+// are held until the L2 says the request has completed.
+class AXIFullCachedSRAM final : public AXIFullSRAM {
+public:
+  AXIFullCachedSRAM(const risc::DeviceDescriptor &desc, cache::L2Cache *l2)
+      : AXIFullSRAM(desc), l2_(l2), source_(l2->attach(desc.name())) {}
+  ~AXIFullCachedSRAM() override = default;
+
+protected:
+  auto ready_at(addr_t addr, uint32_t bytes, bool write) -> uint64_t override {
+    return l2_->request(source_, addr, bytes, write);
+  }
+  [[nodiscard]] auto now() const noexcept -> uint64_t override {
+    return l2_->now();
+  }
+
+private:
+  cache::L2Cache *l2_;
+  uint32_t source_;
+};
+
+} // namespace demu::hal::axif
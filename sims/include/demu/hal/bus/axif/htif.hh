@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../../peripheral/htif/htif.hh"
+#include "./slave.hh"
+
+namespace demu::hal::axif {
+
+class AXIFullHTIF final : public AXIFullSlave {
+public:
+  explicit AXIFullHTIF(const risc::DeviceDescriptor &desc,
+                       DeviceManager *devices = nullptr,
+                       htif::HTIF::ExitHandler on_exit = {})
+      : AXIFullSlave(desc), htif_(std::make_unique<htif::HTIF>(
+                               desc, devices, std::move(on_exit))) {}
+
+  ~AXIFullHTIF() override = default;
+
+  void reset() override;
+  void clock_tick() override;
+  void dump(addr_t start, size_t size) const noexcept override;
+
+  // Bypass MemoryAllocator to the underlying peripheral
+  [[nodiscard]] auto allocator() const noexcept -> MemoryAllocator * override {
+    return htif_->allocator();
+  }
+
+private:
+  std::unique_ptr<htif::HTIF> htif_;
+
+  void process_writes();
+  void process_reads();
+  void calculate_next_address(BurstTransaction &req);
+};
+
+} // namespace demu::hal::axif
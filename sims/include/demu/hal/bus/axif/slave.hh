@@ -1,7 +1,10 @@
 #pragma once
 
 #include "../../device.hh"
+#include "../observer.hh"
+#include <optional>
 #include <queue>
+#include <vector>
 
 namespace demu::hal::axif {
 using namespace isa;
@@ -11,6 +14,12 @@ public:
   explicit AXIFullSlave(const risc::DeviceDescriptor &desc) : Device(desc) {}
   ~AXIFullSlave() override = default;
 
+  // Taps every burst, or only the ones issued by `master`
+  void observe(BusObserver *observer,
+               std::optional<BusMaster> master = std::nullopt) {
+    observers_.push_back({observer, master});
+  }
+
   // AW
   virtual void aw_valid(bool valid, uint8_t id, addr_t addr, uint8_t len,
                         uint8_t size, uint8_t burst) {
@@ -75,6 +84,16 @@ public:
   }
 
 protected:
+  struct Tap {
+    BusObserver *observer;
+    std::optional<BusMaster> master;
+
+    [[nodiscard]] auto sees(uint8_t id) const noexcept -> bool {
+      return !master || static_cast<uint8_t>(*master) == id;
+    }
+  };
+  std::vector<Tap> observers_;
+
   // Cached Pin States
   bool pin_awvalid{false};
   uint8_t pin_awid{0};
@@ -5,7 +5,7 @@
 
 namespace demu::hal::axif {
 
-class AXIFullSRAM final : public AXIFullSlave {
+class AXIFullSRAM : public AXIFullSlave {
 public:
   explicit AXIFullSRAM(const risc::DeviceDescriptor &desc)
       : AXIFullSlave(desc), sram_(std::make_unique<sram::SRAM>(desc)) {}
@@ -20,9 +20,29 @@ public:
     return sram_->allocator();
   }
 
+protected:
+  // Latency hook: the cycle, on the now() clock, at which an accepted burst
+  // may complete. Read beats and the B response are held until then; plain
+  // SRAM completes every burst right away.
+  virtual auto ready_at(addr_t /*addr*/, uint32_t /*bytes*/, bool /*write*/)
+      -> uint64_t {
+    return 0;
+  }
+  [[nodiscard]] virtual auto now() const noexcept -> uint64_t { return 0; }
+
 private:
+  struct PendingResponse {
+    WriteResponse resp;
+    uint64_t ready;
+  };
+
   std::unique_ptr<sram::SRAM> sram_;
 
+  // ready_at() of the bursts in _read_req_queue / _write_req_queue
+  std::queue<uint64_t> read_ready_;
+  std::queue<uint64_t> write_ready_;
+  std::queue<PendingResponse> pending_resp_queue_;
+
   void process_writes();
   void process_reads();
   void calculate_next_address(BurstTransaction &req);
@@ -7,8 +7,12 @@ namespace demu::hal::axif {
 
 class AXIFullUART final : public AXIFullSlave {
 public:
-  explicit AXIFullUART(const risc::DeviceDescriptor &desc)
-      : AXIFullSlave(desc), uart_(std::make_unique<uart::UART>(desc)) {}
+  explicit AXIFullUART(const risc::DeviceDescriptor &desc,
+                       const uart::ConsoleConfig &console = {},
+                       const uart::InputConfig &input = {},
+                       InterruptLine *rx_line = nullptr)
+      : AXIFullSlave(desc),
+        uart_(std::make_unique<uart::UART>(desc, console, input, rx_line)) {}
 
   ~AXIFullUART() override = default;
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../../allocator.hh"
+#include "../../peripheral/htif/htif.hh"
+#include "./slave.hh"
+
+namespace demu::hal::axil {
+
+class AXILiteHTIF final : public AXILiteSlave {
+public:
+  explicit AXILiteHTIF(const risc::DeviceDescriptor &desc,
+                       DeviceManager *devices = nullptr,
+                       htif::HTIF::ExitHandler on_exit = {})
+      : AXILiteSlave(desc), htif_(std::make_unique<htif::HTIF>(
+                               desc, devices, std::move(on_exit))) {}
+
+  ~AXILiteHTIF() override = default;
+
+  void reset() override;
+  void clock_tick() override;
+  void dump(addr_t start, size_t size) const noexcept override;
+
+  // Bypass
+  [[nodiscard]] auto allocator() const noexcept -> MemoryAllocator * override {
+    return htif_->allocator();
+  }
+
+private:
+  std::unique_ptr<htif::HTIF> htif_;
+
+  void process_writes();
+  void process_reads();
+};
+
+} // namespace demu::hal::axil
@@ -8,8 +8,12 @@ namespace demu::hal::axil {
 
 class AXILiteUART final : public AXILiteSlave {
 public:
-  explicit AXILiteUART(const risc::DeviceDescriptor &desc)
-      : AXILiteSlave(desc), uart_(std::make_unique<uart::UART>(desc)) {}
+  explicit AXILiteUART(const risc::DeviceDescriptor &desc,
+                       const uart::ConsoleConfig &console = {},
+                       const uart::InputConfig &input = {},
+                       InterruptLine *rx_line = nullptr)
+      : AXILiteSlave(desc),
+        uart_(std::make_unique<uart::UART>(desc, console, input, rx_line)) {}
 
   ~AXILiteUART() override = default;
 
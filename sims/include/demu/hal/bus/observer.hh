@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../../isa/isa.hh"
+#include <cstdint>
+
+namespace demu::hal {
+using namespace isa;
+
+// AXI ID the bus bridge drives for each of its masters (BusMasterId in
+// arch/system/bridge), which the crossbar forwards to the slave unchanged
+enum class BusMaster : uint8_t {
+  ICACHE = 0,
+  DCACHE = 1,
+  MMIO = 2,
+};
+
+// Passive tap on a bus slave's channel handshakes. Callbacks run from the
+// device's clock_tick(), i.e. before that cycle's probes are sampled.
+class BusObserver {
+public:
+  virtual ~BusObserver() = default;
+
+  // Burst accepted on the AR/AW channel
+  virtual void on_read_request(addr_t /*addr*/, uint32_t /*bytes*/) {}
+  virtual void on_write_request(addr_t /*addr*/, uint32_t /*bytes*/) {}
+  // Last beat of the oldest read burst accepted by the master
+  virtual void on_read_response() {}
+};
+
+} // namespace demu::hal
@@ -14,8 +14,17 @@
 // UART
 #include "./peripheral/uart/uart.hh"
 
+// HTIF
+#include "./peripheral/htif/htif.hh"
+
+// L2 Cache
+#include "./peripheral/cache/l2.hh"
+
 // Bus
+#include "./bus/observer.hh"
+
 // AXI4-Lite
+#include "./bus/axil/htif.hh"
 #include "./bus/axil/interrupt.hh"
 #include "./bus/axil/port_handler.hh"
 #include "./bus/axil/slave.hh"
@@ -23,6 +32,8 @@
 #include "./bus/axil/uart.hh"
 
 // AXI4-Full
+#include "./bus/axif/cached_sram.hh"
+#include "./bus/axif/htif.hh"
 #include "./bus/axif/interrupt.hh"
 #include "./bus/axif/port_handler.hh"
 #include "./bus/axif/slave.hh"
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../../../perf/cache_model.hh"
+#include "../../../perf/prefetch.hh"
+#include "../../hardware.hh"
+#include "cache.pb.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace demu::hal::cache {
+using namespace isa;
+
+struct L2Counters {
+  struct Source {
+    std::string name;
+    uint64_t reads{0};
+    uint64_t writes{0};
+    uint64_t read_misses{0};
+    uint64_t write_misses{0};
+    uint64_t latency{0}; // summed request latency in cycles
+  };
+
+  std::vector<Source> sources;
+  uint64_t mshr_merges{0};
+  uint64_t mshr_stall_cycles{0}; // cycles misses waited for a free MSHR
+  uint64_t fills{0};
+  uint64_t evictions{0};
+  uint64_t writebacks{0};
+  uint64_t write_throughs{0};
+  uint64_t back_invalidations{0};
+  uint64_t prefetches{0};
+  uint64_t prefetch_useful{0};
+  uint64_t prefetch_late{0}; // demand arrived while the prefetch was in flight
+  uint64_t prefetch_useless{0};
+  uint64_t prefetch_dropped{0};
+};
+
+// Timing-only shared L2. Data always lives in the backing SRAM devices; the
+// cache decides when a request may complete.
+//
+// Every request costs `hit_latency` for the tag check. A miss allocates an
+// MSHR, or merges into the one already fetching that line, and fills
+// `miss_latency` cycles later; when all MSHRs are busy it waits for the
+// earliest one to retire. Write-back mode allocates on writes (full-line
+// writes need no fetch) and writes dirty victims back, each writeback
+// holding an MSHR for `miss_latency` cycles like a fetch; write-through mode
+// sends every write to memory and does not allocate on a write miss.
+//
+// The RTL L1s cannot be back-invalidated, so inclusive mode only counts the
+// L1-resident lines an inclusive L2 would have invalidated on eviction.
+//
+// An optional miss-triggered prefetcher trains on demand read misses and
+// prefetched-line hits; its prefetches only use MSHRs that are free, and are
+// dropped otherwise.
+class L2Cache final : public Hardware {
+public:
+  explicit L2Cache(const risc::L2Config &config);
+  ~L2Cache() override = default;
+
+  void clock_tick() override;
+  void reset() override;
+  [[nodiscard]] auto name() const noexcept -> const char * override {
+    return "l2";
+  }
+
+  // Registers an upstream port for per-source counters
+  auto attach(std::string_view source) -> uint32_t;
+  void prefetcher(std::unique_ptr<perf::Prefetcher> prefetcher);
+
+  // Issues a request for [addr, addr + bytes) at the current cycle and
+  // returns the cycle at which it completes.
+  auto request(uint32_t source, addr_t addr, uint32_t bytes, bool write)
+      -> uint64_t;
+
+  [[nodiscard]] auto now() const noexcept -> uint64_t { return now_; }
+  [[nodiscard]] auto config() const noexcept -> const risc::L2Config & {
+    return config_;
+  }
+  [[nodiscard]] auto counters() const noexcept -> const L2Counters & {
+    return counters_;
+  }
+  void report() const;
+
+private:
+  struct LineState {
+    addr_t line{0};
+    bool valid{false};
+    bool dirty{false};
+    bool in_l1{false};
+    bool prefetched{false};
+  };
+  struct Mshr {
+    addr_t line;
+    uint64_t start;
+    uint64_t ready;
+    bool dirty;
+    bool in_l1;
+    bool prefetch;
+    bool writeback{false}; // dirty victim on its way to memory, no fill
+  };
+
+  risc::L2Config config_;
+  perf::CacheModel tags_;
+  std::vector<LineState> state_;
+  std::vector<Mshr> mshrs_;
+  std::unique_ptr<perf::Prefetcher> prefetcher_;
+  std::vector<addr_t> candidates_;
+  std::vector<addr_t> victims_; // dirty lines evicted by fill()
+  uint64_t now_{0};
+  L2Counters counters_;
+
+  auto access_line(addr_t line, bool write, bool full_line, bool &miss)
+      -> uint64_t;
+  auto allocate_mshr(addr_t line, bool write) -> uint64_t;
+  [[nodiscard]] auto reserve(uint64_t earliest, uint64_t latency) const
+      -> uint64_t;
+  void write_back_victims();
+  [[nodiscard]] auto mshrs_busy(uint64_t cycle) const noexcept -> uint32_t;
+  void fill(const Mshr &mshr);
+  void train(addr_t addr);
+  void prefetch(addr_t line);
+};
+
+// Parses "<sets>x<ways>x<line>[:<option>,...]" where options are
+// hit=<n>, miss=<n>, mshr=<n>, <policy>, wb|wt and incl|nincl.
+auto parse_l2_spec(const std::string &spec, risc::L2Config &config) -> bool;
+
+} // namespace demu::hal::cache
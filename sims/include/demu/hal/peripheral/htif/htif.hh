@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../../allocator.hh"
+#include "../../device.hh"
+#include "../../device_manager.hh"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace demu::hal::htif {
+using namespace isa;
+
+enum HtifRegisters : addr_t {
+  HTIF_TOHOST_LO = 0x00,
+  HTIF_TOHOST_HI = 0x04,
+  HTIF_FROMHOST_LO = 0x08,
+  HTIF_FROMHOST_HI = 0x0C,
+  HTIF_MAGIC = 0x40, // uncached syscall block, HTIF_MAGIC_WORDS words
+};
+
+constexpr const addr_t HTIF_MAGIC_WORDS = 8;
+
+// Linux/newlib syscall numbers as used by riscv-pk style `magic_mem` blocks
+enum HtifSyscalls : word_t {
+  HTIF_SYS_OPENAT = 56,
+  HTIF_SYS_CLOSE = 57,
+  HTIF_SYS_LSEEK = 62,
+  HTIF_SYS_READ = 63,
+  HTIF_SYS_WRITE = 64,
+  HTIF_SYS_EXIT = 93,
+  HTIF_SYS_CLOCK_GETTIME = 113,
+};
+
+// Host-target interface in the style of HTIF `tohost`/`fromhost`.
+//
+// A write to TOHOST_LO with bit 0 set requests exit((tohost >> 1)). Any other
+// non-zero value is the address of a `magic_mem` block {num, a0, a1, a2, ...}
+// in target memory; the call is executed on the same cycle, its result is
+// stored back into magic_mem[0] and FROMHOST is set to 1. Guest buffers are
+// accessed in place through the owning device's MemoryAllocator.
+class HTIF final : public Device {
+public:
+  using ExitHandler = std::function<void(int)>;
+
+  explicit HTIF(const risc::DeviceDescriptor &desc,
+                DeviceManager *devices = nullptr, ExitHandler on_exit = {})
+      : Device(desc), allocator_(std::make_unique<MemoryAllocator>(
+                          base_address(), address_range())),
+        devices_(devices), on_exit_(std::move(on_exit)) {}
+
+  ~HTIF() override;
+
+  [[nodiscard]] auto allocator() const noexcept -> MemoryAllocator * override {
+    return allocator_.get();
+  }
+
+  void clock_tick() override {}
+  void reset() override;
+  void dump(addr_t start, size_t size) const noexcept override;
+
+  // Register access from the bus side
+  void write(addr_t addr, word_t data, byte_t strb) noexcept;
+  [[nodiscard]] auto read(addr_t addr) const noexcept -> word_t;
+
+  [[nodiscard]] auto exited() const noexcept -> bool { return exited_; }
+  [[nodiscard]] auto exit_code() const noexcept -> int { return exit_code_; }
+  [[nodiscard]] auto syscall_count() const noexcept -> uint64_t {
+    return syscalls_;
+  }
+
+private:
+  std::unique_ptr<MemoryAllocator> allocator_;
+  DeviceManager *devices_;
+  ExitHandler on_exit_;
+
+  std::vector<int> fds_;
+  bool exited_{false};
+  int exit_code_{0};
+  uint64_t syscalls_{0};
+
+  void dispatch(word_t tohost) noexcept;
+  void request_exit(int code) noexcept;
+  [[nodiscard]] auto syscall(word_t num, const word_t *args) noexcept -> int_t;
+  [[nodiscard]] auto guest_ptr(addr_t addr, size_t len) noexcept -> byte_t *;
+  [[nodiscard]] auto host_fd(word_t fd) const noexcept -> int;
+  void close_fds() noexcept;
+};
+
+} // namespace demu::hal::htif
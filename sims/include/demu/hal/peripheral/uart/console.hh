@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../../../isa/isa.hh"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace demu::hal::uart {
+using namespace isa;
+
+enum class FlushPolicy {
+  LINE, // flush on '\n'; a partial line once held flush_interval_ms
+  SIZE, // flush once flush_size bytes are pending
+  TIME, // flush once the oldest pending byte is flush_interval_ms old
+};
+
+struct ConsoleConfig {
+  // "" or "-" -> stdout, "stderr", "|<cmd>" -> pipe into <cmd>, otherwise a
+  // file (or FIFO) path
+  std::string path{};
+  FlushPolicy policy{FlushPolicy::LINE};
+  size_t flush_size{4096};
+  uint32_t flush_interval_ms{50};
+  size_t ring_size{1u << 16}; // rounded up to a power of two
+};
+
+// Parses "line", "size[:<bytes>]" or "time[:<ms>]" into config
+auto parse_flush_policy(const std::string &spec, ConsoleConfig &config)
+    -> bool;
+
+// Single-producer/single-consumer byte sink. The simulation thread only
+// stores into the ring; a background thread drains it to the output.
+class Console final {
+public:
+  explicit Console(const ConsoleConfig &config = {});
+  ~Console();
+
+  Console(const Console &) = delete;
+  auto operator=(const Console &) -> Console & = delete;
+
+  void put(byte_t c) noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (__builtin_expect(head - tail_cache_ > mask_, 0)) {
+      wait_for_space(head);
+    }
+    ring_[head & mask_] = c;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // Blocks until every byte put so far has reached the output
+  void flush();
+
+  [[nodiscard]] auto bytes_written() const noexcept -> uint64_t {
+    return bytes_written_.load(std::memory_order_relaxed);
+  }
+
+private:
+  ConsoleConfig config_;
+
+  std::vector<byte_t> ring_;
+  size_t mask_;
+  size_t tail_cache_{0};
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+
+  int fd_{-1};
+  FILE *pipe_{nullptr};
+  bool owns_fd_{false};
+
+  std::thread worker_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> flush_request_{false};
+  std::atomic<uint64_t> bytes_written_{0};
+
+  void open_output();
+  void close_output();
+  void wait_for_space(size_t head) noexcept;
+  void drain_loop();
+  void write_out(const byte_t *data, size_t size);
+};
+
+} // namespace demu::hal::uart
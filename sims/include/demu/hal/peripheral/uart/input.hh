@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../../../isa/isa.hh"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace demu::hal::uart {
+using namespace isa;
+
+enum class InputKind {
+  NONE,
+  STDIN,
+  FILE,
+  FIFO,
+  PTY,
+  SCRIPT, // "<cycle> <payload>" lines released at the given cycle
+};
+
+struct InputConfig {
+  InputKind kind{InputKind::NONE};
+  std::string path{};
+  size_t ring_size{1u << 12}; // rounded up to a power of two
+};
+
+// Parses "stdin", "pty", "file:<path>", "fifo:<path>" or "script:<path>"
+auto parse_input_source(const std::string &spec, InputConfig &config) -> bool;
+
+// Non-blocking host input for the UART receiver. Stream sources are read by
+// a background thread into a single-producer/single-consumer ring; scripted
+// input is loaded up front and released by cycle.
+class InputSource final {
+public:
+  explicit InputSource(const InputConfig &config);
+  ~InputSource();
+
+  InputSource(const InputSource &) = delete;
+  auto operator=(const InputSource &) -> InputSource & = delete;
+
+  // Called from the simulation thread, never blocks
+  auto poll(uint64_t cycle, byte_t &c) noexcept -> bool {
+    if (config_.kind == InputKind::SCRIPT) {
+      return poll_script(cycle, c);
+    }
+
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    c = ring_[tail & mask_];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  void rewind() noexcept { script_pos_ = {0, 0}; }
+
+  [[nodiscard]] auto pty_name() const noexcept -> const std::string & {
+    return pty_name_;
+  }
+
+private:
+  InputConfig config_;
+
+  // Stream sources
+  std::vector<byte_t> ring_;
+  size_t mask_{0};
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+
+  int fd_{-1};
+  bool owns_fd_{false};
+  std::string pty_name_;
+  std::thread reader_;
+  std::atomic<bool> running_{false};
+
+  // Scripted source
+  std::vector<std::pair<uint64_t, std::string>> script_;
+  std::pair<size_t, size_t> script_pos_{0, 0};
+
+  auto open_stream() -> bool;
+  auto load_script() -> bool;
+  auto poll_script(uint64_t cycle, byte_t &c) noexcept -> bool;
+  void read_loop();
+};
+
+} // namespace demu::hal::uart
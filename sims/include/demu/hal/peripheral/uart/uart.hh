@@ -2,6 +2,9 @@
 
 #include "../../allocator.hh"
 #include "../../device.hh"
+#include "../../interrupt.hh"
+#include "./console.hh"
+#include "./input.hh"
 #include <memory>
 
 namespace demu::hal::uart {
@@ -15,11 +18,20 @@ enum UartRegisters : addr_t {
   UART_BAUDIV = 0x10,
 };
 
+enum UartRxcBits : word_t {
+  UART_RXC_VALID = 1u << 0, // RXD holds an unread byte (read-only)
+  UART_RXC_IE = 1u << 1,    // raise rx_line while VALID is set
+};
+
 class UART final : public Device {
 public:
-  explicit UART(const risc::DeviceDescriptor &desc)
+  explicit UART(const risc::DeviceDescriptor &desc,
+                const ConsoleConfig &console = {},
+                const InputConfig &input = {}, InterruptLine *rx_line = nullptr)
       : Device(desc), allocator_(std::make_unique<MemoryAllocator>(
-                          base_address(), address_range())) {}
+                          base_address(), address_range())),
+        console_(std::make_unique<Console>(console)),
+        input_(std::make_unique<InputSource>(input)), rx_line_(rx_line) {}
 
   ~UART() override = default;
 
@@ -31,8 +43,27 @@ public:
   void reset() override;
   void dump(addr_t start, size_t size) const noexcept override;
 
+  // Register access from the bus side
+  void write(addr_t addr, word_t data, byte_t strb) noexcept;
+  [[nodiscard]] auto read(addr_t addr) noexcept -> word_t;
+
+  // TX
+  void transmit(byte_t c) noexcept { console_->put(c); }
+  [[nodiscard]] auto console() const noexcept -> Console * {
+    return console_.get();
+  }
+
+  // RX
+  [[nodiscard]] auto input() const noexcept -> InputSource * {
+    return input_.get();
+  }
+
 private:
   std::unique_ptr<MemoryAllocator> allocator_;
+  std::unique_ptr<Console> console_;
+  std::unique_ptr<InputSource> input_;
+  InterruptLine *rx_line_;
+  uint64_t ticks_{0};
 };
 
 } // namespace demu::hal::uart
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace demu {
+
+// Steps of DemuSimulator::clock_tick()
+enum class HostPhase : uint8_t {
+  PORTS,        // DeviceManager::handle_ports()
+  EVAL_NEGEDGE, // falling-edge eval()
+  EVAL_POSEDGE, // rising-edge eval()
+  L2,
+  DEVICES, // DeviceManager::clock_tick(), bus observers included
+  PROBES,
+  RETIRE,    // retirements and interrupt lines
+  PROFILING, // counters, top-down, intervals, live stats, watchdog
+  HOOK,      // on_clock_tick()
+  TRACE,     // both VCD dumps
+  COUNT,
+};
+
+[[nodiscard]] auto host_phase_name(HostPhase phase) noexcept -> const char *;
+
+// Hardware counters from perf_event_open, summed over every thread of the
+// process: simulation, Verilator workers, trace and difftest threads
+struct HostCounters {
+  bool valid{false};
+  uint32_t threads{0};
+  uint64_t cycles{0};
+  uint64_t instructions{0};
+  uint64_t llc_misses{0};
+  uint64_t branch_misses{0};
+};
+
+// Times the phases of one clock_tick() in every `every` with the time-stamp
+// counter (steady_clock where there is none), so an untimed tick costs a
+// countdown. Ticks are converted to ns against steady_clock over the run.
+class HostProfiler final {
+public:
+  HostProfiler() = default;
+  ~HostProfiler();
+  HostProfiler(const HostProfiler &) = delete;
+  auto operator=(const HostProfiler &) -> HostProfiler & = delete;
+
+  void configure(uint64_t every, bool hw_counters) noexcept {
+    every_ = every;
+    hw_counters_ = hw_counters;
+  }
+  [[nodiscard]] auto enabled() const noexcept -> bool { return every_ > 0; }
+
+  void start();
+  void stop();
+  void report() const;
+
+  // True when this tick is timed; starts its first phase
+  [[nodiscard]] auto sample() noexcept -> bool {
+    if (--countdown_ > 0) {
+      return false;
+    }
+    countdown_ = every_;
+    samples_++;
+    last_ = now();
+    return true;
+  }
+  // Charges the time since the previous mark to `phase`
+  void mark(HostPhase phase) noexcept {
+    const uint64_t t = now();
+    ticks_[static_cast<size_t>(phase)] += t - last_;
+    last_ = t;
+  }
+
+  [[nodiscard]] auto samples() const noexcept -> uint64_t { return samples_; }
+  // Mean host ns per timed tick spent in `phase`
+  [[nodiscard]] auto phase_ns(HostPhase phase) const noexcept -> double;
+  [[nodiscard]] auto counters() const noexcept -> const HostCounters & {
+    return counters_;
+  }
+
+private:
+  static constexpr size_t NUM_PHASES = static_cast<size_t>(HostPhase::COUNT);
+
+  uint64_t every_{0};
+  bool hw_counters_{false};
+  uint64_t countdown_{1};
+  uint64_t samples_{0};
+  uint64_t last_{0};
+  std::array<uint64_t, NUM_PHASES> ticks_{};
+
+  uint64_t start_ticks_{0};
+  std::chrono::steady_clock::time_point start_time_;
+  double ns_per_tick_{1.0};
+
+  // Four events per thread, opened for the threads alive at start()
+  std::vector<int> perf_fds_;
+  HostCounters counters_;
+
+  static auto now() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+  void open_counters();
+  void close_counters() noexcept;
+};
+
+} // namespace demu
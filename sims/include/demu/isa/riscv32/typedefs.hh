@@ -2,25 +2,42 @@
 
 #include <cstdint>
 
-#if defined(__ISA_RV32I__)
+// Every model in DEMU_MODELS is linked in; see demu/models.hh
+#ifdef DEMU_MODEL_RV32I
 #include "Vrv32i_system.h"
-#define ISA_NAME "rv32i"
+#ifdef DEMU_INSTRUMENTED_MODEL
+#include "Vrv32i_system_inst.h"
+#endif
+#endif
 
-#elif defined(__ISA_RV32IM__)
+#ifdef DEMU_MODEL_RV32IM
 #include "Vrv32im_system.h"
-#define ISA_NAME "rv32im"
-
+#ifdef DEMU_INSTRUMENTED_MODEL
+#include "Vrv32im_system_inst.h"
+#endif
 #endif
 
 namespace demu::isa {
 enum { NUM_GPRS = 32, INSTR_ALIGNMENT = 4 };
 
-#if defined(__ISA_RV32I__)
-using system_t = Vrv32i_system;
+// Each linked configuration as a lean model and, with trace or coverage
+// built, an instrumented one of the same RTL
+template <typename... Ts> struct ModelList {};
 
-#elif defined(__ISA_RV32IM__)
-using system_t = Vrv32im_system;
+#if defined(DEMU_MODEL_RV32I) && defined(DEMU_INSTRUMENTED_MODEL)
+using rv32i_models = ModelList<Vrv32i_system, Vrv32i_system_inst>;
+#elif defined(DEMU_MODEL_RV32I)
+using rv32i_models = ModelList<Vrv32i_system>;
+#else
+using rv32i_models = ModelList<>;
+#endif
 
+#if defined(DEMU_MODEL_RV32IM) && defined(DEMU_INSTRUMENTED_MODEL)
+using rv32im_models = ModelList<Vrv32im_system, Vrv32im_system_inst>;
+#elif defined(DEMU_MODEL_RV32IM)
+using rv32im_models = ModelList<Vrv32im_system>;
+#else
+using rv32im_models = ModelList<>;
 #endif
 
 using instr_t = uint32_t;
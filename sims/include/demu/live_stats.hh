@@ -0,0 +1,99 @@
+#pragma once
+
+#include "./roi.hh"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace demu {
+
+enum class LiveState : uint32_t {
+  RUNNING = 1,
+  EXITED = 2,
+};
+
+// Payload of a live statistics segment, copied out whole by readers
+struct LiveSnapshot {
+  int32_t pid{0};
+  LiveState state{LiveState::RUNNING};
+  int32_t exit_code{0};
+  uint64_t period{0};    // cycles between updates
+  uint64_t start_ns{0};  // host realtime the run started, ns since epoch
+  uint64_t update_ns{0}; // host realtime of this update
+  double khz{0};         // since the previous update
+  char isa[16]{};
+  char program[128]{};
+  uint64_t counters[PERF_COUNTER_FIELDS.size()]{};
+
+  [[nodiscard]] auto counter(uint64_t PerfCounters::*member) const noexcept
+      -> uint64_t;
+};
+
+// POSIX shared-memory page a simulation publishes to every `period`
+// cycles, named "/demu-<pid>". Updates are guarded by a seqlock: the
+// writer makes `seq` odd, copies the snapshot, then makes it even again,
+// so it never waits on readers; readers retry until they copy a snapshot
+// between two equal even sequence numbers.
+struct LiveStatsPage {
+  static constexpr uint32_t MAGIC = 0x44454d4c; // "DEML"
+  static constexpr uint32_t VERSION = 2;
+
+  uint32_t magic{MAGIC};
+  uint32_t version{VERSION};
+  std::atomic<uint64_t> seq{0};
+  LiveSnapshot snapshot;
+};
+
+class LiveStatsWriter final {
+public:
+  LiveStatsWriter() = default;
+  ~LiveStatsWriter() { close(); }
+  LiveStatsWriter(const LiveStatsWriter &) = delete;
+  auto operator=(const LiveStatsWriter &) -> LiveStatsWriter & = delete;
+
+  auto open(const std::string &program, const std::string &isa,
+            uint64_t period) -> bool;
+  void publish(const PerfCounters &counters,
+               LiveState state = LiveState::RUNNING,
+               int exit_code = 0) noexcept;
+  // Unmaps and removes the segment
+  void close() noexcept;
+
+  [[nodiscard]] auto is_open() const noexcept -> bool {
+    return page_ != nullptr;
+  }
+  [[nodiscard]] auto name() const noexcept -> const std::string & {
+    return name_;
+  }
+
+private:
+  LiveStatsPage *page_{nullptr};
+  std::string name_;
+  LiveSnapshot snapshot_;
+  uint64_t last_cycles_{0};
+  uint64_t last_ns_{0};
+};
+
+// Read-only view of another process's segment
+class LiveStatsReader final {
+public:
+  LiveStatsReader() = default;
+  ~LiveStatsReader() { detach(); }
+  LiveStatsReader(const LiveStatsReader &) = delete;
+  auto operator=(const LiveStatsReader &) -> LiveStatsReader & = delete;
+
+  auto attach(const std::string &name) -> bool;
+  void detach() noexcept;
+  // False when the segment is not attached or the writer kept it busy
+  auto read(LiveSnapshot &out) const noexcept -> bool;
+
+  // Names of every live statistics segment on this host. Segments left by
+  // writers that died without closing them are unlinked and skipped.
+  [[nodiscard]] static auto list() -> std::vector<std::string>;
+
+private:
+  const LiveStatsPage *page_{nullptr};
+};
+
+} // namespace demu
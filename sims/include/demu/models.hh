@@ -0,0 +1,48 @@
+#pragma once
+
+#include "./isa/isa.hh"
+#include "verilated.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace demu {
+
+namespace detail {
+template <typename... Lists> struct JoinModels;
+template <typename... Ts> struct JoinModels<isa::ModelList<Ts...>> {
+  using type = std::variant<std::unique_ptr<Ts>...>;
+};
+template <typename... A, typename... B, typename... Rest>
+struct JoinModels<isa::ModelList<A...>, isa::ModelList<B...>, Rest...>
+    : JoinModels<isa::ModelList<A..., B...>, Rest...> {};
+} // namespace detail
+
+// Owns whichever linked model a run uses. All of them expose the same
+// ports, so per-cycle code is written once as a template over the model.
+using model_t =
+    detail::JoinModels<isa::rv32i_models, isa::rv32im_models>::type;
+
+// Stands in for every model where only the port layout matters
+using system_t = std::variant_alternative_t<0, model_t>::element_type;
+
+struct ModelInfo {
+  const char *name; // TARGET_ARCH it was built from, e.g. "rv32im"
+  bool instrumented;
+  auto (*make)(VerilatedContext *context) -> model_t;
+};
+
+// Every linked model, lean before instrumented
+[[nodiscard]] auto models() -> const std::vector<ModelInfo> &;
+// The lean or instrumented build of `name`, or of the default model when
+// `name` is empty; nullptr when it is not linked
+[[nodiscard]] auto find_model(std::string_view name, bool instrumented)
+    -> const ModelInfo *;
+// Comma-separated names of the linked models
+[[nodiscard]] auto model_names() -> std::string;
+// <RTL_DIR>/<name>_config.json if the design wrote one, else config.json
+[[nodiscard]] auto model_config_path(const ModelInfo &model) -> std::string;
+
+} // namespace demu
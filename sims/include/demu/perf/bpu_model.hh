@@ -0,0 +1,159 @@
+#pragma once
+
+#include "./branch_stream.hh"
+#include "./cache_model.hh"
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace demu::perf {
+
+// Predictor replayed in commit order: predict() looks a record up, trains
+// on its outcome and tells whether the record counted and was mispredicted.
+class BranchPredictor {
+public:
+  enum class Outcome : uint8_t { IGNORED, CORRECT, MISPREDICT };
+
+  virtual ~BranchPredictor() = default;
+
+  [[nodiscard]] virtual auto name() const -> std::string = 0;
+  // What the accuracy is measured over, e.g. "cond" or "ret"
+  [[nodiscard]] virtual auto scope() const -> const char * = 0;
+  virtual auto predict(const BranchRecord &br) noexcept -> Outcome = 0;
+  virtual void reset() noexcept = 0;
+};
+
+// 2-bit saturating counters indexed by PC
+class BimodalPredictor final : public BranchPredictor {
+public:
+  explicit BimodalPredictor(uint32_t index_bits);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  [[nodiscard]] auto scope() const -> const char * override { return "cond"; }
+  auto predict(const BranchRecord &br) noexcept -> Outcome override;
+  void reset() noexcept override;
+
+private:
+  uint32_t bits_;
+  std::vector<uint8_t> pht_;
+};
+
+// Gshare with the RTL's PC folding, trained on committed outcomes
+class GSharePredictor final : public BranchPredictor {
+public:
+  explicit GSharePredictor(uint32_t ghr_width);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  [[nodiscard]] auto scope() const -> const char * override { return "cond"; }
+  auto predict(const BranchRecord &br) noexcept -> Outcome override;
+  void reset() noexcept override;
+
+private:
+  uint32_t width_;
+  uint32_t ghr_{0};
+  std::vector<uint8_t> pht_;
+};
+
+// Small TAGE: a bimodal base and four tagged tables with geometric history
+// lengths up to 64 branches, allocation on mispredict and periodic aging of
+// the useful bits.
+class TagePredictor final : public BranchPredictor {
+public:
+  TagePredictor();
+
+  [[nodiscard]] auto name() const -> std::string override { return "tage"; }
+  [[nodiscard]] auto scope() const -> const char * override { return "cond"; }
+  auto predict(const BranchRecord &br) noexcept -> Outcome override;
+  void reset() noexcept override;
+
+private:
+  static constexpr size_t TABLES = 4;
+  static constexpr uint32_t BASE_BITS = 12;
+  static constexpr uint32_t TABLE_BITS = 10;
+  static constexpr uint32_t TAG_BITS = 9;
+  static constexpr uint64_t AGING_PERIOD = 1u << 18;
+  static constexpr std::array<uint32_t, TABLES> HISTORY = {5, 12, 27, 64};
+
+  // Entries only provide once allocated, so tag 0 cannot hit a reset table
+  struct Entry {
+    bool valid{false};
+    uint16_t tag{0};
+    int8_t ctr{0};
+    uint8_t useful{0};
+  };
+
+  std::vector<uint8_t> base_;
+  std::array<std::vector<Entry>, TABLES> tables_;
+  uint64_t history_{0};
+  uint64_t branches_{0};
+  uint32_t alloc_rng_{1};
+
+  [[nodiscard]] auto index(size_t t, addr_t pc) const noexcept -> uint32_t;
+  [[nodiscard]] auto tag(size_t t, addr_t pc) const noexcept -> uint16_t;
+};
+
+// Branch target buffer on its own, scored over taken control flow: a taken
+// branch is mispredicted if it misses or hits with a stale target.
+class BtbPredictor final : public BranchPredictor {
+public:
+  BtbPredictor(uint32_t sets, uint32_t ways, risc::ReplPolicy policy);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  [[nodiscard]] auto scope() const -> const char * override {
+    return "taken";
+  }
+  auto predict(const BranchRecord &br) noexcept -> Outcome override;
+  void reset() noexcept override;
+
+private:
+  CacheModel table_;
+  std::vector<addr_t> targets_;
+};
+
+// Circular return address stack, scored over returns
+class RasPredictor final : public BranchPredictor {
+public:
+  explicit RasPredictor(uint32_t depth);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  [[nodiscard]] auto scope() const -> const char * override { return "ret"; }
+  auto predict(const BranchRecord &br) noexcept -> Outcome override;
+  void reset() noexcept override;
+
+private:
+  std::vector<addr_t> stack_;
+  uint32_t top_{0};
+  uint32_t size_{0};
+};
+
+// The DUT's front end: taken only on a BTB hit with a taken gshare counter;
+// the BTB is written on taken commits; the speculative history shifts for
+// BTB hits and is rebuilt from the snapshot on a mispredict. Scored over all
+// control flow, like debug_bpu_mispredict.
+class RtlPredictor final : public BranchPredictor {
+public:
+  RtlPredictor(uint32_t btb_sets, uint32_t btb_ways, risc::ReplPolicy policy,
+               uint32_t ghr_width);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  [[nodiscard]] auto scope() const -> const char * override { return "all"; }
+  auto predict(const BranchRecord &br) noexcept -> Outcome override;
+  void reset() noexcept override;
+
+private:
+  uint32_t width_;
+  uint32_t ghr_{0};
+  std::vector<uint8_t> pht_;
+  CacheModel btb_;
+  std::vector<addr_t> targets_;
+};
+
+// Parses "<model>:<args>" into predictors, e.g. "gshare:8,10,12",
+// "bimodal:10", "tage", "btb:64,128x2,4[:<policies>]", "ras:8,16" or
+// "rtl:<sets>x<ways>:<ghr>" with comma lists expanded as a cross product.
+auto parse_predictors(const std::string &spec,
+                      std::vector<std::unique_ptr<BranchPredictor>> &out)
+    -> bool;
+
+} // namespace demu::perf
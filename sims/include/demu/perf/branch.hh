@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../debug_line.hh"
+#include "../symbols.hh"
+#include "./branch_stream.hh"
+#include "./probe.hh"
+#include <string>
+#include <unordered_map>
+
+namespace demu::perf {
+
+// Per-branch BPU profile built from the retire stream.
+//
+// Control-flow instructions are decoded from the retired instruction word;
+// the direction is inferred from the PC of the next retirement. The DUT
+// raises bpu_mispredict in the cycle the mispredicted instruction commits,
+// and the flush squashes everything younger, so the event is charged to the
+// last instruction retired in that cycle. The penalty of a mispredict is
+// the number of cycles until the next retirement, i.e. the refill bubble.
+class BranchProfiler final : public Probe {
+public:
+  BranchProfiler(const SymbolTable &symbols, std::string path,
+                 size_t top = 25, const LineTable *lines = nullptr);
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+private:
+  struct BranchStats {
+    instr_t instr{0};
+    // false for mispredicts charged to a non-branch retirement
+    bool branch{false};
+    BranchKind kind{BranchKind::COND};
+    uint64_t execs{0};
+    uint64_t taken{0};
+    uint64_t mispredicts{0};
+    uint64_t penalty_cycles{0};
+  };
+
+  const SymbolTable &symbols_;
+  std::string path_;
+  size_t top_;
+  const LineTable *lines_;
+
+  std::unordered_map<addr_t, BranchStats> branches_;
+
+  // control-flow instruction whose direction awaits the next retirement
+  bool direction_pending_{false};
+  addr_t direction_pc_{0};
+
+  // retirements of the current cycle
+  bool cycle_mispredict_{false};
+  bool cycle_retired_{false};
+  addr_t cycle_last_pc_{0};
+  instr_t cycle_last_instr_{0};
+
+  // mispredict whose refill bubble is still being counted
+  BranchStats *penalty_owner_{nullptr};
+
+  void close_cycle();
+  auto stats_for(addr_t pc, instr_t instr) -> BranchStats &;
+};
+
+} // namespace demu::perf
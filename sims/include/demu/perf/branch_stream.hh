@@ -0,0 +1,85 @@
+#pragma once
+
+#include "./probe.hh"
+#include <cstdio>
+#include <string>
+
+namespace demu::perf {
+
+enum class BranchKind : uint8_t { COND, JUMP, INDIRECT, CALL, RET };
+inline constexpr size_t NUM_BRANCH_KINDS = 5;
+
+struct BranchRecord {
+  addr_t pc{0};
+  addr_t target{0};
+  bool taken{false};
+  BranchKind kind{BranchKind::COND};
+};
+
+[[nodiscard]] auto branch_kind_name(BranchKind kind) noexcept -> const char *;
+
+// Decodes a control-flow instruction; calls and returns follow the RISC-V
+// link-register hints (x1/x5). Returns false for anything else.
+auto classify_branch(instr_t instr, BranchKind &kind) noexcept -> bool;
+
+// Turns retirements into resolved control-flow records. A branch is
+// resolved by the next retirement, whose PC is the actual target.
+class BranchStream final {
+public:
+  // Returns true and fills `record` when `event` resolves a pending branch
+  auto on_retire(const RetireEvent &event, BranchRecord &record) noexcept
+      -> bool;
+  void reset() noexcept { pending_ = false; }
+
+private:
+  bool pending_{false};
+  BranchRecord record_;
+};
+
+// Compact branch trace: "DEMUBT" magic and a version byte, then one
+// LEB128 word per record holding the zigzagged distance from the previous
+// record's successor PC, the kind and the direction; taken records are
+// followed by the zigzagged target offset. A nearby not-taken branch costs
+// 2 bytes and a short taken one 3, about 2.8 bytes per branch on loop code.
+// The model tool replays it through the predictor models.
+class BranchTraceWriter final {
+public:
+  BranchTraceWriter() = default;
+  ~BranchTraceWriter() { close(); }
+  BranchTraceWriter(const BranchTraceWriter &) = delete;
+  auto operator=(const BranchTraceWriter &) -> BranchTraceWriter & = delete;
+
+  auto open(const std::string &path) -> bool;
+  void write(const BranchRecord &record) noexcept;
+  void close() noexcept;
+
+  [[nodiscard]] auto is_open() const noexcept -> bool {
+    return file_ != nullptr;
+  }
+  [[nodiscard]] auto records() const noexcept -> uint64_t { return records_; }
+  [[nodiscard]] auto bytes() const noexcept -> uint64_t { return bytes_; }
+
+private:
+  std::FILE *file_{nullptr};
+  addr_t next_pc_{0};
+  uint64_t records_{0};
+  uint64_t bytes_{0};
+};
+
+class BranchTraceReader final {
+public:
+  BranchTraceReader() = default;
+  ~BranchTraceReader() { close(); }
+  BranchTraceReader(const BranchTraceReader &) = delete;
+  auto operator=(const BranchTraceReader &) -> BranchTraceReader & = delete;
+
+  auto open(const std::string &path) -> bool;
+  auto next(BranchRecord &record) noexcept -> bool;
+  void close() noexcept;
+
+private:
+  std::FILE *file_{nullptr};
+  addr_t next_pc_{0};
+};
+
+} // namespace demu::perf
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../isa/isa.hh"
+#include "cache.pb.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace demu::perf {
+using namespace isa;
+
+struct CacheGeometry {
+  uint32_t sets{0};
+  uint32_t ways{0};
+  uint32_t line_size{0};
+  risc::ReplPolicy policy{risc::REPL_POLICY_LRU};
+
+  [[nodiscard]] auto valid() const noexcept -> bool;
+  [[nodiscard]] auto bytes() const noexcept -> uint64_t {
+    return static_cast<uint64_t>(sets) * ways * line_size;
+  }
+  [[nodiscard]] auto to_string() const -> std::string;
+
+  static auto from_config(const risc::CacheConfig &config) -> CacheGeometry;
+};
+
+[[nodiscard]] auto repl_policy_name(risc::ReplPolicy policy) noexcept
+    -> const char *;
+auto parse_repl_policy(std::string_view name, risc::ReplPolicy &policy)
+    -> bool;
+
+// Functional set-associative cache (tags only) with the ReplPolicy variants
+// of CacheConfig. Fills go to an invalid way first; RANDOM uses a seeded
+// xorshift so runs are reproducible.
+class CacheModel final {
+public:
+  explicit CacheModel(const CacheGeometry &geometry, uint32_t seed = 1);
+
+  // Looks up and fills `addr`; returns true on a hit
+  auto access(addr_t addr) noexcept -> bool;
+  void reset() noexcept;
+
+  // Lower-level interface for tables with per-entry payloads: `slot`
+  // identifies the entry and stays valid until it is replaced.
+  // find() has no side effects; insert() touches a hit or fills a victim.
+  [[nodiscard]] auto find(addr_t addr, uint32_t &slot) const noexcept -> bool;
+  auto insert(addr_t addr) noexcept -> uint32_t;
+  [[nodiscard]] auto slots() const noexcept -> size_t { return lines_.size(); }
+
+  [[nodiscard]] auto geometry() const noexcept -> const CacheGeometry & {
+    return geometry_;
+  }
+  [[nodiscard]] auto accesses() const noexcept -> uint64_t {
+    return accesses_;
+  }
+  [[nodiscard]] auto misses() const noexcept -> uint64_t { return misses_; }
+
+private:
+  struct Line {
+    addr_t tag{0};
+    bool valid{false};
+    uint64_t stamp{0};
+    uint32_t count{0};
+  };
+
+  CacheGeometry geometry_;
+  uint32_t offset_bits_;
+  uint32_t index_bits_;
+  uint32_t seed_;
+  uint32_t rng_;
+
+  std::vector<Line> lines_;
+  std::vector<uint64_t> plru_;
+  uint64_t tick_{0};
+  uint64_t accesses_{0};
+  uint64_t misses_{0};
+
+  auto victim(uint32_t set) noexcept -> uint32_t;
+  void touch(uint32_t set, uint32_t way) noexcept;
+};
+
+} // namespace demu::perf
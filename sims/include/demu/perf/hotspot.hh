@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../debug_line.hh"
+#include "../symbols.hh"
+#include "./probe.hh"
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace demu::perf {
+
+// Cycle profiler keyed by retire PC and by calling context.
+//
+// Every cycle is charged to the next instruction that retires, so a PC's
+// cycle count includes the stall cycles spent waiting for it. Calls and
+// returns are recognized from the retire stream (jal/jalr linking through
+// x1/x5, jalr x0 through x1/x5) to maintain a calling-context tree, which
+// yields inclusive times and a collapsed-stack file for flamegraph.pl.
+// When a line table is given, PCs are also rolled up per source line.
+class HotspotProfiler final : public Probe {
+public:
+  HotspotProfiler(const SymbolTable &symbols, std::string prefix,
+                  size_t top = 25, const LineTable *lines = nullptr);
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+private:
+  struct PcStats {
+    instr_t instr{0};
+    uint64_t cycles{0};
+    uint64_t instret{0};
+    uint64_t frontend_stalls{0};
+    uint64_t backend_stalls{0};
+    uint64_t icache_misses{0};
+    uint64_t dcache_misses{0};
+  };
+
+  struct Node {
+    uint32_t func;
+    uint32_t parent;
+    uint64_t cycles{0};
+    std::unordered_map<uint32_t, uint32_t> children;
+  };
+
+  static constexpr size_t MAX_DEPTH = 512;
+
+  const SymbolTable &symbols_;
+  std::string prefix_;
+  size_t top_;
+  const LineTable *lines_;
+
+  std::unordered_map<addr_t, PcStats> pcs_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> stack_;
+
+  uint64_t pending_cycles_{0};
+  uint64_t pending_frontend_{0};
+  uint64_t pending_backend_{0};
+  uint64_t pending_icache_misses_{0};
+  uint64_t pending_dcache_misses_{0};
+  bool call_pending_{false};
+  bool ret_pending_{false};
+
+  // one-entry lookup cache for the current function
+  addr_t cached_start_{1};
+  addr_t cached_end_{0};
+  uint32_t cached_func_{SymbolTable::npos};
+
+  [[nodiscard]] auto func_of(addr_t pc) noexcept -> uint32_t;
+  [[nodiscard]] auto func_name(uint32_t func) const -> std::string;
+  auto child(uint32_t node, uint32_t func) -> uint32_t;
+  void update_context(uint32_t func);
+
+  void write_text(const std::string &path) const;
+  void write_lines(std::ostream &out, uint64_t total_cycles) const;
+  void write_folded(const std::string &path) const;
+};
+
+} // namespace demu::perf
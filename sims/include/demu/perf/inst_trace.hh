@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../roi.hh"
+#include "./mem_stream.hh"
+#include "./probe.hh"
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace demu::perf {
+
+struct InstRecord {
+  addr_t pc{0};
+  instr_t instr{0};
+  addr_t addr{0}; // effective address of a load/store
+  bool mem{false};
+};
+
+// Committed instruction trace: "DEMUIT" magic and a version byte, then one
+// LEB128 word per record holding the zigzagged distance from the previous
+// record's successor PC, a first-sight flag and a memory flag. The
+// instruction word follows only the first time a PC is seen; loads and
+// stores add the zigzagged offset from the previous effective address.
+// A word of 1 ends the records and is followed by a count and the run's
+// raw DUT counters (the first NUM_DUT_PERF_COUNTERS of PERF_COUNTER_FIELDS)
+// as the reference for calibration.
+class InstTraceWriter final {
+public:
+  InstTraceWriter() = default;
+  ~InstTraceWriter() { close(); }
+  InstTraceWriter(const InstTraceWriter &) = delete;
+  auto operator=(const InstTraceWriter &) -> InstTraceWriter & = delete;
+
+  auto open(const std::string &path) -> bool;
+  void write(const InstRecord &record) noexcept;
+  // Writes the footer and closes the file
+  void finish(const PerfCounters &counters) noexcept;
+  void close() noexcept;
+
+  [[nodiscard]] auto is_open() const noexcept -> bool {
+    return file_ != nullptr;
+  }
+  [[nodiscard]] auto records() const noexcept -> uint64_t { return records_; }
+  [[nodiscard]] auto bytes() const noexcept -> uint64_t { return bytes_; }
+
+private:
+  std::FILE *file_{nullptr};
+  addr_t next_pc_{0};
+  addr_t last_addr_{0};
+  std::unordered_set<addr_t> seen_;
+  uint64_t records_{0};
+  uint64_t bytes_{0};
+};
+
+class InstTraceReader final {
+public:
+  InstTraceReader() = default;
+  ~InstTraceReader() { close(); }
+  InstTraceReader(const InstTraceReader &) = delete;
+  auto operator=(const InstTraceReader &) -> InstTraceReader & = delete;
+
+  auto open(const std::string &path) -> bool;
+  // Returns false at the end of the records or on a truncated trace
+  auto next(InstRecord &record) noexcept -> bool;
+  void close() noexcept;
+
+  // Valid once next() has returned false on a complete trace
+  [[nodiscard]] auto has_reference() const noexcept -> bool {
+    return has_reference_;
+  }
+  [[nodiscard]] auto reference() const noexcept -> const PerfCounters & {
+    return reference_;
+  }
+
+private:
+  std::FILE *file_{nullptr};
+  addr_t next_pc_{0};
+  addr_t last_addr_{0};
+  std::unordered_map<addr_t, instr_t> instrs_;
+  PerfCounters reference_;
+  bool has_reference_{false};
+
+  void read_footer() noexcept;
+};
+
+// Writes the committed instruction stream and the run's counters, summed
+// the same way as the simulator's own, for trace-driven timing models
+class InstTracer final : public Probe {
+public:
+  explicit InstTracer(std::string path) : path_(std::move(path)) {}
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+private:
+  std::string path_;
+  InstTraceWriter trace_;
+  MemStream mem_;
+  PerfCounters counters_;
+};
+
+} // namespace demu::perf
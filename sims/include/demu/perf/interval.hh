@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../roi.hh"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace demu::perf {
+
+struct IntervalSpec {
+  uint64_t period{0};       // 0 disables sampling
+  bool instructions{false}; // period counts retired instructions
+};
+
+// Parses "<n>" (cycles) or "<n>i" (instructions) as given to --interval
+auto parse_interval_spec(const std::string &spec, IntervalSpec &out) -> bool;
+
+// Per-interval counter deltas, one column per PerfCounters field after an
+// absolute "cycle" column holding the cycle each interval ended on.
+//
+// Rows are buffered column-major and handed off in chunks to a writer
+// thread, so sampling never waits on the file. A ".csv" path gets a CSV
+// table; anything else the binary format: "DEMUIV" magic and a version
+// byte, the LEB128 column count and length-prefixed column names, then
+// chunks of a LEB128 row count followed by each column's values in turn,
+// each LEB128 encoded (the "cycle" column as the delta from the previous
+// row). A row count of 0 ends the file.
+class IntervalWriter final {
+public:
+  static constexpr size_t CHUNK_ROWS = 4096;
+
+  IntervalWriter() = default;
+  ~IntervalWriter() { close(); }
+  IntervalWriter(const IntervalWriter &) = delete;
+  auto operator=(const IntervalWriter &) -> IntervalWriter & = delete;
+
+  auto open(const std::string &path) -> bool;
+  void append(uint64_t cycle, const PerfCounters &delta);
+  // Writes any buffered rows and the end marker, then joins the writer
+  void close();
+
+  [[nodiscard]] auto is_open() const noexcept -> bool {
+    return file_ != nullptr;
+  }
+  [[nodiscard]] auto rows() const noexcept -> uint64_t { return rows_; }
+
+private:
+  using Chunk = std::vector<std::vector<uint64_t>>; // [column][row]
+
+  std::FILE *file_{nullptr};
+  bool csv_{false};
+  Chunk chunk_;
+  uint64_t rows_{0};
+  uint64_t last_cycle_{0}; // written by the worker only
+
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<Chunk> queue_;
+  bool closing_{false};
+
+  void submit();
+  void drain();
+  void write(const Chunk &chunk);
+};
+
+// A whole interval file, CSV or binary, loaded column-major
+struct IntervalTable {
+  std::vector<std::string> columns;
+  std::vector<std::vector<uint64_t>> data; // [column][row]
+
+  auto load(const std::string &path) -> bool;
+
+  [[nodiscard]] auto rows() const noexcept -> size_t {
+    return data.empty() ? 0 : data.front().size();
+  }
+  // nullptr when the file has no such column
+  [[nodiscard]] auto column(const std::string &name) const
+      -> const std::vector<uint64_t> *;
+  // PerfCounters fields summed over rows [first, last]
+  [[nodiscard]] auto sum(size_t first, size_t last) const -> PerfCounters;
+};
+
+// A run of consecutive intervals with a similar IPC
+struct Phase {
+  size_t first{0}; // row range [first, last]
+  size_t last{0};
+  uint64_t start_cycle{0};
+  uint64_t end_cycle{0};
+  PerfCounters total;
+};
+
+// Splits the table into phases: a new phase starts once `hold` consecutive
+// intervals differ from the running phase's IPC by more than `threshold`
+// (relative). Returns one phase covering everything when the table lacks
+// the cycles or instret columns.
+auto detect_phases(const IntervalTable &table, double threshold = 0.15,
+                   size_t hold = 3) -> std::vector<Phase>;
+
+} // namespace demu::perf
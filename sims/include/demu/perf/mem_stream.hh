@@ -0,0 +1,27 @@
+#pragma once
+
+#include "./probe.hh"
+#include <array>
+
+namespace demu::perf {
+
+// Recovers the data-side address stream from retirements. The DUT does not
+// export LSU addresses, so loads and stores are re-evaluated as rs1 + imm
+// against a register file rebuilt from the retire writebacks.
+class MemStream final {
+public:
+  struct Access {
+    addr_t addr;
+    bool store;
+  };
+
+  // Returns true and fills `access` when `event` is a load or store; the
+  // event's writeback is applied afterwards either way.
+  auto on_retire(const RetireEvent &event, Access &access) noexcept -> bool;
+  void reset() noexcept { regs_.fill(0); }
+
+private:
+  std::array<word_t, NUM_GPRS> regs_{};
+};
+
+} // namespace demu::perf
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../debug_line.hh"
+#include "../hal/bus/observer.hh"
+#include "../symbols.hh"
+#include "./mem_stream.hh"
+#include "./probe.hh"
+#include <array>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace demu::perf {
+
+// Data-cache miss attribution from the LSU side.
+//
+// Attached to the L1D master's bursts on both memories, so .rodata refills
+// served by imem count too, it records every refill burst (AR accept to last
+// R beat). Retired loads and stores are mapped to
+// addresses through MemStream; the first memory instruction to retire on a
+// line with an unclaimed refill owns that miss. Its latency, from the refill
+// request to the retirement of the instruction that needed it, goes into a
+// per-PC log2 histogram and is split at the last R beat into the bus part
+// and the pipeline part that follows it. Secondary misses merged into the
+// same refill are not counted.
+class MissProfiler final : public Probe, public hal::BusObserver {
+public:
+  MissProfiler(const SymbolTable &symbols, std::string path,
+               uint32_t line_bytes, size_t top = 25,
+               const LineTable *lines = nullptr);
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+  void on_read_request(addr_t addr, uint32_t bytes) override;
+  void on_read_response() override;
+
+private:
+  static constexpr size_t HIST_BUCKETS = 16;
+  static constexpr size_t MAX_LINES_PER_PC = 64;
+  // unclaimed refills older than this are written off (wrong path, evicted)
+  static constexpr uint64_t STALE_CYCLES = 1u << 16;
+
+  struct Refill {
+    uint64_t request_cycle{0};
+    uint64_t response_cycle{0};
+  };
+
+  struct PcStats {
+    instr_t instr{0};
+    bool store{false};
+    uint64_t accesses{0};
+    uint64_t misses{0};
+    uint64_t latency_sum{0};
+    uint64_t latency_max{0};
+    // request to last beat; the rest of latency_sum is pipeline time
+    uint64_t bus_sum{0};
+    std::array<uint64_t, HIST_BUCKETS> histogram{};
+    std::unordered_map<addr_t, uint64_t> lines;
+    uint64_t other_lines{0};
+  };
+
+  const SymbolTable &symbols_;
+  std::string path_;
+  addr_t line_mask_;
+  size_t top_;
+  const LineTable *lines_;
+
+  uint64_t cycle_{0};
+  MemStream mem_;
+
+  // bus events seen since the last sample, stamped in on_cycle()
+  std::vector<addr_t> new_requests_;
+  uint32_t new_responses_{0};
+
+  std::unordered_map<addr_t, Refill> refills_;
+  std::deque<addr_t> in_flight_;
+  uint64_t refills_total_{0};
+  uint64_t refills_stale_{0};
+
+  std::unordered_map<addr_t, PcStats> pcs_;
+
+  void expire(uint64_t now);
+};
+
+} // namespace demu::perf
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../isa/isa.hh"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace demu::perf {
+using namespace isa;
+
+// Memory-side hardware prefetcher. Miss-triggered prefetchers see the refill
+// stream of the cache they sit behind; access-triggered ones see every
+// retired load/store with its PC. Candidates are line addresses, unfiltered.
+class Prefetcher {
+public:
+  enum class Trigger { MISS, ACCESS };
+
+  struct Event {
+    uint64_t cycle;
+    addr_t addr;
+    addr_t pc; // 0 for miss-triggered prefetchers
+  };
+
+  explicit Prefetcher(uint32_t line_bytes)
+      : line_shift_(static_cast<uint32_t>(__builtin_ctz(line_bytes))) {}
+  virtual ~Prefetcher() = default;
+
+  [[nodiscard]] virtual auto name() const -> std::string = 0;
+  [[nodiscard]] virtual auto trigger() const noexcept -> Trigger {
+    return Trigger::MISS;
+  }
+  virtual void train(const Event &event, std::vector<addr_t> &out) = 0;
+  virtual void reset() = 0;
+
+protected:
+  uint32_t line_shift_;
+
+  [[nodiscard]] auto line_of(addr_t addr) const noexcept -> addr_t {
+    return addr >> line_shift_;
+  }
+  [[nodiscard]] auto addr_of(addr_t line) const noexcept -> addr_t {
+    return line << line_shift_;
+  }
+};
+
+// Prefetches the next `degree` lines after every miss
+class NextLinePrefetcher final : public Prefetcher {
+public:
+  NextLinePrefetcher(uint32_t line_bytes, uint32_t degree)
+      : Prefetcher(line_bytes), degree_(degree) {}
+
+  [[nodiscard]] auto name() const -> std::string override;
+  void train(const Event &event, std::vector<addr_t> &out) override;
+  void reset() override {}
+
+private:
+  uint32_t degree_;
+};
+
+// PC-indexed reference prediction table: a direct-mapped table of
+// {last address, stride, 2-bit confidence} per load/store PC
+class StridePrefetcher final : public Prefetcher {
+public:
+  StridePrefetcher(uint32_t line_bytes, uint32_t degree, uint32_t entries = 64);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  [[nodiscard]] auto trigger() const noexcept -> Trigger override {
+    return Trigger::ACCESS;
+  }
+  void train(const Event &event, std::vector<addr_t> &out) override;
+  void reset() override;
+
+private:
+  struct Entry {
+    addr_t pc{0};
+    addr_t last{0};
+    int32_t stride{0};
+    uint8_t confidence{0};
+    bool valid{false};
+  };
+
+  uint32_t degree_;
+  std::vector<Entry> table_;
+};
+
+// Tracks up to `streams` miss streams within a window of lines; once a
+// second miss gives a stream its direction, runs `degree` lines ahead of it
+class StreamPrefetcher final : public Prefetcher {
+public:
+  StreamPrefetcher(uint32_t line_bytes, uint32_t degree, uint32_t streams = 16);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  void train(const Event &event, std::vector<addr_t> &out) override;
+  void reset() override;
+
+private:
+  static constexpr int64_t WINDOW = 16;
+
+  struct Tracker {
+    addr_t last{0};
+    int32_t direction{0};
+    uint64_t stamp{0};
+    bool valid{false};
+  };
+
+  uint32_t degree_;
+  std::vector<Tracker> trackers_;
+  uint64_t tick_{0};
+};
+
+// Global delta correlation over the miss stream: finds the previous
+// occurrence of the two most recent line deltas in a delta history and
+// replays the deltas that followed it
+class DeltaPrefetcher final : public Prefetcher {
+public:
+  DeltaPrefetcher(uint32_t line_bytes, uint32_t degree, size_t history = 32);
+
+  [[nodiscard]] auto name() const -> std::string override;
+  void train(const Event &event, std::vector<addr_t> &out) override;
+  void reset() override;
+
+private:
+  uint32_t degree_;
+  size_t history_size_;
+  std::deque<int64_t> deltas_;
+  addr_t last_{0};
+  bool valid_{false};
+};
+
+// Parses "<kind>[:<degree>,...]" with kind one of next, stride, stream,
+// delta or all; one prefetcher is created per degree, each in [1, 16].
+auto parse_prefetchers(const std::string &spec, uint32_t line_bytes,
+                       std::vector<std::unique_ptr<Prefetcher>> &out) -> bool;
+
+} // namespace demu::perf
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../counters.hh"
+#include "../isa/isa.hh"
+#include <cstdint>
+
+namespace demu::perf {
+using namespace isa;
+
+// Per-cycle view of the DUT debug counters, sampled after the rising edge:
+// one field per DEMU_DEBUG_COUNTERS port, gated as CounterRegistry sums it
+struct CycleSample {
+  uint64_t cycle{0};
+#define DEMU_SAMPLE_FIELD(NAME, GATE, UNIT, KIND, DESC) uint32_t NAME{0};
+  DEMU_DEBUG_COUNTERS(DEMU_SAMPLE_FIELD)
+#undef DEMU_SAMPLE_FIELD
+};
+
+struct RetireEvent {
+  uint64_t cycle{0};
+  uint32_t lane{0};
+  addr_t pc{0};
+  instr_t instr{0};
+  bool reg_we{false};
+  uint8_t reg_addr{0};
+  word_t reg_data{0};
+};
+
+// Observer attached to DemuSimulator. on_cycle() runs once per cycle before
+// that cycle's retirements are delivered through on_retire().
+class Probe {
+public:
+  virtual ~Probe() = default;
+
+  virtual void on_cycle(const CycleSample &/*sample*/) {}
+  virtual void on_retire(const RetireEvent &/*event*/) {}
+  virtual void reset() {}
+  virtual void report() {}
+};
+
+} // namespace demu::perf
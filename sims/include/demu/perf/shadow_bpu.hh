@@ -0,0 +1,50 @@
+#pragma once
+
+#include "./bpu_model.hh"
+#include "./branch_stream.hh"
+#include "./probe.hh"
+#include "bpu.pb.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace demu::perf {
+
+// Replays the committed branch stream through a set of predictor models.
+// A model of the built BpuConfig is always present; its mispredict count is
+// reported next to the DUT's debug_bpu_mispredict total so the sweep can be
+// trusted before touching the RTL. Optionally writes a branch trace.
+class ShadowBpu final : public Probe {
+public:
+  ShadowBpu(const risc::BpuConfig &config, std::string report_path,
+            std::string trace_path);
+
+  // See parse_predictors() for the spec syntax
+  auto add_sweep(const std::string &spec) -> bool;
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+private:
+  struct Shadow {
+    std::unique_ptr<BranchPredictor> model;
+    bool built{false};
+    uint64_t lookups{0};
+    uint64_t mispredicts{0};
+  };
+
+  std::string report_path_;
+  std::string trace_path_;
+  std::vector<Shadow> shadows_;
+  BranchStream stream_;
+  BranchTraceWriter trace_;
+
+  uint64_t instret_{0};
+  uint64_t branches_[NUM_BRANCH_KINDS]{};
+  uint64_t dut_branches_{0};
+  uint64_t dut_mispredicts_{0};
+};
+
+} // namespace demu::perf
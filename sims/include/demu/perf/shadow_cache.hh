@@ -0,0 +1,62 @@
+#pragma once
+
+#include "./cache_model.hh"
+#include "./mem_stream.hh"
+#include "./probe.hh"
+#include "bus.pb.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace demu::perf {
+
+// What-if L1 models driven by the retire stream.
+//
+// The instruction side sees one access per change of fetch line in the
+// retired PC stream, the data side one access per retired load or store
+// to a cacheable (SRAM) region of the address map, as the PMA checker does.
+// Each side also models the configuration actually built, and its miss
+// count is reported next to the DUT's debug_l1_*_miss total; the gap
+// measures how far the retire-ordered stream is from the real one
+// (wrong-path fetches, fetch packets, merged misses).
+class ShadowCaches final : public Probe {
+public:
+  enum class Side : uint8_t { ICACHE, DCACHE };
+
+  ShadowCaches(const risc::CacheConfig &l1i, const risc::CacheConfig &l1d,
+               const risc::BusConfig &bus, std::string path);
+
+  // "<i|d>:<sets>x<ways>x<line>[:<policies>]" where every field may be a
+  // comma-separated list and policies may be "all"; adds the cross product
+  auto add_sweep(const std::string &spec) -> bool;
+  void add(Side side, const CacheGeometry &geometry, bool built = false);
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+private:
+  struct Shadow {
+    Side side;
+    bool built;
+    CacheModel model;
+    addr_t last_line{~addr_t{0}};
+  };
+
+  std::string path_;
+  risc::ReplPolicy built_policy_[2];
+  std::vector<Shadow> shadows_;
+  MemStream mem_;
+  // [base, end) of the cacheable regions; empty caches everything
+  std::vector<std::pair<uint64_t, uint64_t>> cacheable_;
+
+  uint64_t instret_{0};
+  uint64_t real_accesses_[2]{};
+  uint64_t real_misses_[2]{};
+  uint64_t uncached_{0};
+
+  [[nodiscard]] auto is_cacheable(addr_t addr) const noexcept -> bool;
+};
+
+} // namespace demu::perf
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../hal/bus/observer.hh"
+#include "./cache_model.hh"
+#include "./mem_stream.hh"
+#include "./prefetch.hh"
+#include "./probe.hh"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace demu::perf {
+
+// Shadow-mode prefetcher evaluation on the L1 refill streams.
+//
+// Each side's cache master is observed through port(), on whichever memory
+// serves it; every read burst is a demand miss. Every prefetcher runs
+// independently with its own prefetch buffer of `buffer_lines` lines next to
+// the L1, so none of them changes what the DUT does. A demand miss that finds
+// its line in the buffer is covered (timely if the prefetch had completed, late
+// otherwise); lines evicted from the buffer unused are useless and are the
+// extra traffic a prefetcher costs. Candidates already in the buffer or in a
+// tag mirror of the L1 fed by the refill stream are filtered rather than
+// issued. Prefetches complete after the mean refill latency observed so far.
+class ShadowPrefetchers final : public Probe {
+public:
+  enum class Side : uint8_t { ICACHE, DCACHE };
+
+  ShadowPrefetchers(const risc::CacheConfig &l1i, const risc::CacheConfig &l1d,
+                    std::string path, uint32_t buffer_lines = 32);
+
+  // "<i|d>:<kind>[:<degree>,...]"; see parse_prefetchers()
+  auto add_sweep(const std::string &spec) -> bool;
+  [[nodiscard]] auto port(Side side) noexcept -> hal::BusObserver * {
+    return &sides_[static_cast<size_t>(side)].port;
+  }
+
+  void on_cycle(const CycleSample &sample) override;
+  void on_retire(const RetireEvent &event) override;
+  void reset() override;
+  void report() override;
+
+private:
+  struct Port final : public hal::BusObserver {
+    std::vector<addr_t> requests;
+    uint32_t responses{0};
+
+    void on_read_request(addr_t addr, uint32_t bytes) override;
+    void on_read_response() override { responses++; }
+  };
+
+  struct Buffered {
+    addr_t line;
+    uint64_t ready;
+  };
+
+  struct Shadow {
+    Side side;
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::deque<Buffered> buffer;
+    uint64_t issued{0};
+    uint64_t useful{0};
+    uint64_t timely{0};
+    uint64_t useless{0};
+    uint64_t filtered{0};
+  };
+
+  struct SideState {
+    explicit SideState(const CacheGeometry &geometry)
+        : line_bytes(geometry.line_size), l1(geometry) {}
+
+    uint32_t line_bytes;
+    CacheModel l1;
+    Port port;
+    std::deque<uint64_t> in_flight;
+    uint64_t misses{0};
+    uint64_t latency_sum{0};
+    uint64_t responses{0};
+
+    [[nodiscard]] auto latency() const noexcept -> uint64_t;
+  };
+
+  std::string path_;
+  uint32_t buffer_lines_;
+  SideState sides_[2];
+  std::vector<Shadow> shadows_;
+  MemStream mem_;
+  uint64_t cycle_{0};
+  std::vector<addr_t> candidates_;
+
+  void on_miss(Side side, addr_t line);
+  void issue(Shadow &shadow, const Prefetcher::Event &event);
+};
+
+} // namespace demu::perf
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace demu::perf {
+
+// Helpers for "<a>:<b>x<c>"-style sweep specs
+[[nodiscard]] auto split_spec(const std::string &s, char sep)
+    -> std::vector<std::string>;
+// Comma-separated positive integers (decimal or 0x-prefixed)
+auto parse_uint_list(const std::string &s, std::vector<uint32_t> &out) -> bool;
+
+} // namespace demu::perf
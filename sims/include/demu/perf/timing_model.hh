@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../roi.hh"
+#include "./branch_stream.hh"
+#include "risc.pb.h"
+#include <string>
+#include <vector>
+
+namespace demu::perf {
+
+// Latencies RiscConfig does not pin down, in cycles. The miss penalties
+// are on top of a hit; calibrate() fits them to a reference run.
+struct TimingParams {
+  uint32_t icache_miss{20};
+  uint32_t dcache_miss{20};
+  uint32_t mispredict{3};
+  uint32_t load_use{2};
+  uint32_t mult{3};
+  uint32_t div{34};
+
+  // "<name>=<value>" lines, '#' starts a comment
+  auto read(const std::string &path) -> bool;
+  [[nodiscard]] auto write(const std::string &path) const -> bool;
+  [[nodiscard]] auto to_string() const -> std::string;
+};
+
+// A committed instruction, pre-decoded for the timing model
+struct TimingOp {
+  addr_t pc{0};
+  addr_t addr{0};   // load/store effective address
+  addr_t target{0}; // successor PC
+  risc::FunctionalUnitType unit{risc::FUNCTIONAL_UNIT_TYPE_ALU};
+  uint8_t rd{0};
+  uint8_t rs1{0};
+  uint8_t rs2{0};
+  bool branch{false};
+  bool serialize{false}; // CSR and fence: waits for the ROB to drain
+  BranchKind kind{BranchKind::COND};
+};
+
+// An instruction trace (see InstTraceWriter) loaded into memory once and
+// replayed for every configuration
+class TimingTrace final {
+public:
+  auto load(const std::string &path) -> bool;
+
+  [[nodiscard]] auto ops() const noexcept -> const std::vector<TimingOp> & {
+    return ops_;
+  }
+  [[nodiscard]] auto has_reference() const noexcept -> bool {
+    return has_reference_;
+  }
+  [[nodiscard]] auto reference() const noexcept -> const PerfCounters & {
+    return reference_;
+  }
+
+private:
+  std::vector<TimingOp> ops_;
+  PerfCounters reference_;
+  bool has_reference_{false};
+};
+
+// Trace-driven model of the core: fetch groups of issue_width with an
+// L1I tag model and the RTL branch predictor, an ibuffer_size-deep fetch
+// queue, in-order dispatch into a rob.size-entry ROB, issue per scheduler
+// policy onto the configured functional units (multiplier and divider are
+// not pipelined), an L1D tag model for loads, a store buffer drained after
+// commit and in-order commit of issue_width per cycle. Each instruction's
+// stage times follow from its predecessors, so one pass gives the cycles.
+// The result only fills the fields of PerfCounters the model predicts.
+class TimingModel final {
+public:
+  TimingModel(const risc::RiscConfig &config, const TimingParams &params)
+      : config_(config), params_(params) {}
+
+  [[nodiscard]] auto run(const TimingTrace &trace) const -> PerfCounters;
+
+private:
+  risc::RiscConfig config_;
+  TimingParams params_;
+};
+
+// Fits `params` to the trace's reference counters: the mispredict penalty
+// from the flush cycles per mispredict, then one miss penalty for both
+// L1s by bisection on the total cycles. Returns the remaining relative
+// cycle error, or a negative value when the trace has no reference.
+auto calibrate(const risc::RiscConfig &config, const TimingTrace &trace,
+               TimingParams &params) -> double;
+
+// Design-space sweep over RiscConfig fields, expanded as a cross product.
+// Axes are "<key>=<value>,..." with keys issue_width, ibuffer, rob,
+// scheduler (inorder, scoreboard, tomasulo), l1i and l1d
+// (<sets>x<ways>x<line>), btb (<sets>x<ways>), ghr and the unit counts
+// alu, mult, ld, st, bru, csr and div.
+class TimingSweep final {
+public:
+  struct Point {
+    risc::RiscConfig config;
+    std::string label;
+  };
+
+  auto add_axis(const std::string &spec) -> bool;
+  [[nodiscard]] auto expand(const risc::RiscConfig &base) const
+      -> std::vector<Point>;
+
+private:
+  struct Axis {
+    std::string key;
+    std::vector<std::string> values;
+  };
+
+  std::vector<Axis> axes_;
+};
+
+} // namespace demu::perf
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+namespace demu::perf {
+
+// RV32 major opcodes the retire-stream models decode
+inline constexpr uint8_t OPCODE_LOAD = 0x03;
+inline constexpr uint8_t OPCODE_MISC_MEM = 0x0F;
+inline constexpr uint8_t OPCODE_OP_IMM = 0x13;
+inline constexpr uint8_t OPCODE_AUIPC = 0x17;
+inline constexpr uint8_t OPCODE_STORE = 0x23;
+inline constexpr uint8_t OPCODE_OP = 0x33;
+inline constexpr uint8_t OPCODE_LUI = 0x37;
+inline constexpr uint8_t OPCODE_BRANCH = 0x63;
+inline constexpr uint8_t OPCODE_JALR = 0x67;
+inline constexpr uint8_t OPCODE_JAL = 0x6F;
+inline constexpr uint8_t OPCODE_SYSTEM = 0x73;
+
+[[nodiscard]] inline auto percent(uint64_t part, uint64_t whole) noexcept
+    -> double {
+  return whole > 0 ? 100.0 * static_cast<double>(part) / whole : 0.0;
+}
+
+// Events per thousand retired instructions
+[[nodiscard]] inline auto per_kilo(uint64_t events, uint64_t instret) noexcept
+    -> double {
+  return instret > 0 ? 1000.0 * static_cast<double>(events) / instret : 0.0;
+}
+
+// Signed deltas of the trace formats, zigzagged so small ones stay short
+[[nodiscard]] inline auto zigzag(int32_t v) noexcept -> uint64_t {
+  return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+[[nodiscard]] inline auto unzigzag(uint64_t v) noexcept -> int32_t {
+  const auto u = static_cast<uint32_t>(v);
+  return static_cast<int32_t>((u >> 1) ^ (0u - (u & 1)));
+}
+
+// Writes `value` as LEB128; returns the number of bytes written
+inline auto put_varint(std::FILE *file, uint64_t value) noexcept -> uint64_t {
+  uint64_t bytes = 0;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value) {
+      byte |= 0x80;
+    }
+    std::fputc(byte, file);
+    bytes++;
+  } while (value);
+  return bytes;
+}
+
+// False at the end of the file or on an overlong encoding
+inline auto get_varint(std::FILE *file, uint64_t &value) noexcept -> bool {
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    const int c = std::fgetc(file);
+    if (c == EOF) {
+      return false;
+    }
+    value |= static_cast<uint64_t>(c & 0x7F) << shift;
+    if (!(c & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace demu::perf
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "./perf/interval.hh"
+#include "./watchdog.hh"
+#include "cache.pb.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace demu {
+
+class DemuSimulator;
+
+enum class OptionMatch : uint8_t {
+  NONE,     // not a profiling option, the front end handles it
+  CONSUMED, // parsed, along with its value
+  INVALID,  // a profiling option with a malformed value
+};
+
+// Profiling and analysis options shared by every front end, so each one is
+// parsed, attached and reported in one place
+struct ProfilingOptions {
+  std::vector<std::pair<uint8_t, std::string>> roi_names;
+  WatchdogConfig watchdog;
+  std::string profile_prefix;
+  std::string branch_profile;
+  std::string miss_profile;
+  bool shadow_caches{false};
+  std::vector<std::string> shadow_specs;
+  std::string shadow_report;
+  bool shadow_bpu{false};
+  std::vector<std::string> bpu_specs;
+  std::string bpu_report;
+  std::string branch_trace;
+  std::string inst_trace;
+  bool shadow_prefetch{false};
+  std::vector<std::string> prefetch_specs;
+  std::string prefetch_report;
+  std::string l2_prefetcher;
+  bool l2{false};
+  risc::L2Config l2_config;
+  uint64_t topdown_interval{0};
+  std::string topdown_report;
+  perf::IntervalSpec interval{10000, false};
+  std::string interval_report;
+  std::string report_file;
+  uint64_t live_stats{0};
+  uint64_t host_profile{0};
+  bool host_counters{false};
+
+  // Parses argv[i], advancing i past its value when it takes one
+  auto parse(int argc, char **argv, int &i) -> OptionMatch;
+
+  // Help lines for every option parse() accepts
+  static void print_usage();
+};
+
+// Configures `sim` and adds the probes and bus observers `options` ask for;
+// call before init(). False on an invalid sweep spec.
+auto attach_profilers(DemuSimulator &sim, const ProfilingOptions &options)
+    -> bool;
+
+// End-of-run output that is not a probe report, e.g. the run report
+void finish_profilers(const DemuSimulator &sim,
+                      const ProfilingOptions &options);
+
+} // namespace demu
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "./counters.hh"
+#include "./isa/isa.hh"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace demu {
+using namespace isa;
+
+// X(name) for the dispatch slots (issue_width per cycle) and the unfilled
+// ones by cause, which the harness derives rather than reads; see TopDown
+#define DEMU_SLOT_COUNTERS(X)                                                  \
+  X(slots)                                                                     \
+  X(recovery_slots)                                                            \
+  X(fetch_latency_slots)                                                       \
+  X(fetch_bandwidth_slots)                                                     \
+  X(memory_bound_slots)                                                        \
+  X(core_bound_slots)
+
+// Snapshot of every counter sampled by the profiling handlers: cycles and
+// instret, one field per DEMU_DEBUG_COUNTERS port named after it, then the
+// DEMU_SLOT_COUNTERS
+struct PerfCounters {
+  uint64_t cycles{0};
+  uint64_t instret{0};
+#define DEMU_PERF_PORT_FIELD(NAME, GATE, UNIT, KIND, DESC) uint64_t NAME{0};
+  DEMU_DEBUG_COUNTERS(DEMU_PERF_PORT_FIELD)
+#undef DEMU_PERF_PORT_FIELD
+#define DEMU_PERF_SLOT_FIELD(NAME) uint64_t NAME{0};
+  DEMU_SLOT_COUNTERS(DEMU_PERF_SLOT_FIELD)
+#undef DEMU_PERF_SLOT_FIELD
+
+  auto operator+=(const PerfCounters &rhs) noexcept -> PerfCounters &;
+  auto operator-(const PerfCounters &rhs) const noexcept -> PerfCounters;
+
+  void dump() const;
+};
+
+struct PerfCounterField {
+  const char *name;
+  uint64_t PerfCounters::*member;
+};
+
+#define DEMU_PERF_COUNT(...) +1
+
+// cycles, instret and the DUT ports, which lead PERF_COUNTER_FIELDS
+inline constexpr size_t NUM_DUT_PERF_COUNTERS =
+    2 DEMU_DEBUG_COUNTERS(DEMU_PERF_COUNT);
+inline constexpr size_t NUM_PERF_COUNTERS =
+    NUM_DUT_PERF_COUNTERS DEMU_SLOT_COUNTERS(DEMU_PERF_COUNT);
+
+#undef DEMU_PERF_COUNT
+
+#define DEMU_PERF_PORT_ENTRY(NAME, GATE, UNIT, KIND, DESC)                     \
+  {#NAME, &PerfCounters::NAME},
+#define DEMU_PERF_SLOT_ENTRY(NAME) {#NAME, &PerfCounters::NAME},
+
+// Every PerfCounters field in declaration order, for uniform export
+inline constexpr std::array<PerfCounterField, NUM_PERF_COUNTERS>
+    PERF_COUNTER_FIELDS = {{
+        {"cycles", &PerfCounters::cycles},
+        {"instret", &PerfCounters::instret},
+        DEMU_DEBUG_COUNTERS(DEMU_PERF_PORT_ENTRY)
+        DEMU_SLOT_COUNTERS(DEMU_PERF_SLOT_ENTRY)
+    }};
+
+#undef DEMU_PERF_PORT_ENTRY
+#undef DEMU_PERF_SLOT_ENTRY
+
+// ROI markers are hint-encoded `addi x0, x0, imm` with imm = (op << 8) | id.
+// imm == 0 is the canonical nop and is never treated as a marker.
+enum class RoiOp : uint8_t {
+  START = 1,
+  STOP = 2,
+  RESET = 3,
+  DUMP = 4,
+};
+
+constexpr const instr_t ROI_MARKER_MASK = 0x000FFFFF; // rd, rs1, funct3, opc
+constexpr const instr_t ROI_MARKER_MATCH = 0x00000013;
+
+[[nodiscard]] constexpr auto decode_roi_marker(instr_t instr, RoiOp &op,
+                                               uint8_t &id) noexcept -> bool {
+  if ((instr & ROI_MARKER_MASK) != ROI_MARKER_MATCH) {
+    return false;
+  }
+  const uint32_t imm = instr >> 20;
+  const uint32_t code = imm >> 8;
+  if (code < static_cast<uint32_t>(RoiOp::START) ||
+      code > static_cast<uint32_t>(RoiOp::DUMP)) {
+    return false;
+  }
+  op = static_cast<RoiOp>(code);
+  id = static_cast<uint8_t>(imm & 0xFF);
+  return true;
+}
+
+// Parses "<id>=<name>" as given to --roi
+auto parse_roi_name(const std::string &spec, uint8_t &id, std::string &name)
+    -> bool;
+
+class RoiTracker {
+public:
+  void name(uint8_t id, const std::string &name) { names_[id] = name; }
+
+  void on_marker(RoiOp op, uint8_t id, const PerfCounters &now, addr_t pc);
+  void finish(const PerfCounters &now);
+  void clear() { regions_.clear(); }
+  void report() const;
+
+  [[nodiscard]] auto used() const noexcept -> bool {
+    return !regions_.empty();
+  }
+
+  struct Region {
+    std::string name;
+    bool active{false};
+    uint64_t entries{0};
+    PerfCounters start;
+    PerfCounters total;
+  };
+
+  [[nodiscard]] auto regions() const noexcept
+      -> const std::map<uint8_t, Region> & {
+    return regions_;
+  }
+
+private:
+  std::map<uint8_t, Region> regions_;
+  std::map<uint8_t, std::string> names_;
+
+  auto region(uint8_t id) -> Region &;
+};
+
+} // namespace demu
@@ -1,26 +1,86 @@
 #pragma once
 
 #include "./config.hh"
+#include "./counters.hh"
+#include "./debug_line.hh"
 #include "./hal/hal.hh"
+#include "./host_profile.hh"
+#include "./live_stats.hh"
+#include "./models.hh"
+#include "./perf/interval.hh"
+#include "./perf/mem_stream.hh"
+#include "./perf/probe.hh"
 #include "./retire_lane.hh"
+#include "./roi.hh"
+#include "./symbols.hh"
+#include "./topdown.hh"
+#include "./watchdog.hh"
+#include "./wave.hh"
+#include "report.pb.h"
 #include "verilated.h"
+#include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <variant>
+#include <vector>
 
-#ifdef ENABLE_TRACE
+#ifdef ENABLE_TRACE_FST
+#include "verilated_fst_c.h"
+#elif defined(ENABLE_TRACE)
 #include "verilated_vcd_c.h"
 #endif
 
 namespace demu {
 using namespace isa;
 
+#ifdef ENABLE_TRACE_FST
+using wave_file_t = VerilatedFstC;
+inline constexpr const char *WAVE_EXT = "fst";
+#elif defined(ENABLE_TRACE)
+using wave_file_t = VerilatedVcdC;
+inline constexpr const char *WAVE_EXT = "vcd";
+#endif
+
+// Counters and retire lanes are laid out from system_t, which has to
+// hold for every linked model
+template <typename Variant> struct SharedPorts;
+template <typename... Ts>
+struct SharedPorts<std::variant<std::unique_ptr<Ts>...>> {
+  static constexpr bool value =
+      ((CounterRegistry<Ts>::size == CounterRegistry<system_t>::size &&
+        RetireSignalInfo<Ts>::detected_lanes ==
+            RetireSignalInfo<system_t>::detected_lanes) &&
+       ...);
+};
+static_assert(SharedPorts<model_t>::value,
+              "linked models expose different debug or retire ports");
+
 class DemuSimulator {
 public:
   explicit DemuSimulator(bool enabled_trace = false, int threads = NUM_THREADS,
-                         int argc = 0, char **argv = nullptr);
+                         int argc = 0, char **argv = nullptr,
+                         bool coverage = false,
+                         const std::string &model = "");
   ~DemuSimulator();
 
+  // Calls f(dut) with the model this run uses
+  template <typename F> auto with_dut(F &&f) -> decltype(auto) {
+    return std::visit([&](auto &dut) -> decltype(auto) { return f(dut.get()); },
+                      dut_);
+  }
+  template <typename F> auto with_dut(F &&f) const -> decltype(auto) {
+    return std::visit(
+        [&](const auto &dut) -> decltype(auto) {
+          const auto *model = dut.get();
+          return f(model);
+        },
+        dut_);
+  }
+
   // Program loading
   auto load_bin(const std::string &filename, addr_t offset = 0) -> bool;
   auto load_elf(const std::string &filename) -> bool;
@@ -30,6 +90,11 @@ public:
   void reset();
   void step(uint64_t cycles = 1);
   void run(uint64_t max_cycles = 0);
+  // Flushes the interval, top-down and live outputs and prints the
+  // end-of-run reports. run() calls it; front ends that drive step()
+  // themselves call it once when they stop.
+  void finish();
+  void halt(int code) noexcept;
 
   // Architecture state access
   [[nodiscard]] auto device(addr_t addr) -> hal::Device * {
@@ -39,61 +104,131 @@ public:
   [[nodiscard]] auto reg(uint8_t reg) const noexcept -> word_t {
     return _register_values[reg];
   }
+  [[nodiscard]] auto config() const noexcept -> const RiscConfig & {
+    return *config_;
+  }
+  [[nodiscard]] auto model() const noexcept -> const ModelInfo & {
+    return *model_;
+  }
+  // True when running the trace/coverage build of the model
+  [[nodiscard]] auto instrumented() const noexcept -> bool {
+    return model_->instrumented;
+  }
+  [[nodiscard]] auto symbols() const noexcept -> const SymbolTable & {
+    return symbols_;
+  }
+  [[nodiscard]] auto lines() const noexcept -> const LineTable & {
+    return lines_;
+  }
+  // "symbol+0xoff (file:line)" with whichever parts are known
+  [[nodiscard]] auto describe_pc(addr_t pc) const -> std::string;
+  [[nodiscard]] auto halted() const noexcept -> bool { return _halted; }
+  [[nodiscard]] auto exit_code() const noexcept -> int { return _exit_code; }
 
   // Simulator configuration
   void timeout(uint64_t timeout) noexcept { timeout_ = timeout; }
+  void uart_console(const hal::uart::ConsoleConfig &config) {
+    uart_console_ = config;
+  }
+  void uart_input(const hal::uart::InputConfig &config) {
+    uart_input_ = config;
+  }
+  void roi_name(uint8_t id, const std::string &name) { roi_.name(id, name); }
+  void watchdog(const WatchdogConfig &config) { watchdog_.configure(config); }
+  // Limits dumping to the triggered windows; needs a traced run (-t)
+  void wave(const WaveConfig &config) { wave_trigger_.configure(config); }
+  // Keeps the rotating segments of a `mismatch` wave once the run stops
+  void keep_wave();
+  // Top-down breakdown every `cycles`, logged or written as CSV to `path`
+  void topdown_interval(uint64_t cycles, std::string path = "") {
+    topdown_interval_ = cycles;
+    topdown_path_ = std::move(path);
+  }
+  // Per-interval counter deltas, written as CSV or binary to `path`
+  void intervals(const perf::IntervalSpec &spec, std::string path) {
+    interval_spec_ = spec;
+    interval_path_ = std::move(path);
+  }
+  // Publishes counters to shared memory every `cycles`; see demu-top
+  void live_stats(uint64_t cycles) noexcept { live_period_ = cycles; }
+  // Times the host phases of one tick in every `every`; `hw_counters` adds
+  // perf_event_open counts summed over the threads running when run() starts
+  void host_profile(uint64_t every, bool hw_counters = false) noexcept {
+    host_profile_.configure(every, hw_counters);
+  }
+  // Overrides RiscConfig.l2; must be set before init()
+  void l2(const risc::L2Config &config) { l2_config_ = config; }
+  // Miss-triggered L2 prefetcher, "<kind>[:<degree>]"
+  void l2_prefetcher(const std::string &spec) { l2_prefetcher_ = spec; }
+  [[nodiscard]] auto l2() const noexcept -> const hal::cache::L2Cache * {
+    return l2_.get();
+  }
+
+  // Performance probes, reported at the end of run()
+  template <typename T, typename... Args>
+  auto add_probe(Args &&...args) -> T * {
+    auto probe = std::make_unique<T>(std::forward<Args>(args)...);
+    T *ptr = probe.get();
+    probes_.push_back(std::move(probe));
+    return ptr;
+  }
+  // Taps the AXI slave behind `region`; attached once devices exist
+  void observe_bus(const std::string &region, hal::BusObserver *observer) {
+    bus_observers_.push_back({region, observer, std::nullopt});
+  }
+  // Taps the bursts `master` issues to either memory, e.g. L1D refills of
+  // .rodata served by imem as well as those served by dmem
+  void observe_master(hal::BusMaster master, hal::BusObserver *observer) {
+    bus_observers_.push_back({"imem", observer, master});
+    bus_observers_.push_back({"dmem", observer, master});
+  }
 
   // Simulator statistics
+  [[nodiscard]] auto counters() const noexcept -> PerfCounters;
   [[nodiscard]] auto cycle_count() const noexcept -> uint64_t {
-    return dut_->debug_cycle_count;
+    return with_dut(
+        [](const auto *dut) -> uint64_t { return dut->debug_cycle_count; });
   }
   [[nodiscard]] auto instret_count() const -> uint64_t {
-    return dut_->debug_instret_count;
+    return with_dut(
+        [](const auto *dut) -> uint64_t { return dut->debug_instret_count; });
   }
   [[nodiscard]] auto ipc() const noexcept -> double {
-    return dut_->debug_cycle_count > 0
-               ? static_cast<double>(dut_->debug_instret_count) /
-                     dut_->debug_cycle_count
-               : 0.0;
+    const uint64_t cycles = cycle_count();
+    return cycles > 0 ? static_cast<double>(instret_count()) / cycles : 0.0;
   };
   [[nodiscard]] auto l1_icache_hit_rate() const noexcept -> double {
-    return _l1_icache_accesses > 0
-               ? 1.0 - static_cast<double>(_l1_icache_misses) /
-                           _l1_icache_accesses
-               : 0.0;
+    return counter_hit_rate(&PerfCounters::l1_icache_miss,
+                            &PerfCounters::l1_icache_access);
   };
   [[nodiscard]] auto l1_dcache_hit_rate() const noexcept -> double {
-    return _l1_dcache_accesses > 0
-               ? 1.0 - static_cast<double>(_l1_dcache_misses) /
-                           _l1_dcache_accesses
-               : 0.0;
+    return counter_hit_rate(&PerfCounters::l1_dcache_miss,
+                            &PerfCounters::l1_dcache_access);
   };
   [[nodiscard]] auto bpu_hit_rate() const noexcept -> double {
-    return _branches_committed > 0
-               ? 1.0 -
-                     static_cast<double>(_bpu_mispredicts) / _branches_committed
-               : 0.0;
+    return counter_hit_rate(&PerfCounters::bpu_mispredict,
+                            &PerfCounters::branch_commit);
   }
   [[nodiscard]] auto issue_rate() const noexcept -> double {
-    return dut_->debug_cycle_count > 0
-               ? static_cast<double>(_issue_count) / dut_->debug_cycle_count
-               : 0.0;
+    return counter_rate(&PerfCounters::issue_count);
   }
   [[nodiscard]] auto frontend_starvation_rate() const noexcept -> double {
-    return dut_->debug_cycle_count > 0
-               ? static_cast<double>(_rob_empty_cycles) /
-                     dut_->debug_cycle_count
-               : 0.0;
+    return counter_rate(&PerfCounters::rob_empty);
   }
   [[nodiscard]] auto frontend_stall_rate() const noexcept -> double {
-    return dut_->debug_cycle_count > 0
-               ? static_cast<double>(_frontend_stalls) / dut_->debug_cycle_count
-               : 0.0;
+    return counter_rate(&PerfCounters::frontend_stall);
   }
   [[nodiscard]] auto backend_stall_rate() const noexcept -> double {
-    return dut_->debug_cycle_count > 0
-               ? static_cast<double>(_backend_stalls) / dut_->debug_cycle_count
-               : 0.0;
+    return counter_rate(&PerfCounters::backend_stall);
+  }
+  // Everything run() reports, for dashboards; see report.proto
+  [[nodiscard]] auto run_report() const -> report::RunReport;
+  // Writes run_report() to <base>.pb and <base>.json, where <base> is
+  // `path` without a .pb or .json extension
+  auto write_report(const std::string &path) const -> bool;
+  [[nodiscard]] auto debug_counters() const noexcept
+      -> const CounterRegistry<system_t> & {
+    return debug_counters_;
   }
 
   // Debug output
@@ -105,46 +240,117 @@ protected:
   std::unique_ptr<RiscConfig> config_;
 
   std::unique_ptr<VerilatedContext> context_;
-  std::unique_ptr<system_t> dut_;
+  const ModelInfo *model_{nullptr};
+  model_t dut_;
   std::unique_ptr<hal::DeviceManager> device_manager_;
 
   std::unique_ptr<demu::hal::InterruptLine> timer_irq_;
   std::unique_ptr<demu::hal::InterruptLine> soft_irq_;
+  std::unique_ptr<hal::cache::L2Cache> l2_;
 
 #ifdef ENABLE_TRACE
-  std::unique_ptr<VerilatedVcdC> vcd_;
+  std::unique_ptr<wave_file_t> wave_;
+  std::string wave_path_;
+  uint32_t wave_segment_{0};
+  uint64_t wave_rotate_at_{0};
+  bool wave_kept_{false};
 #endif
+  WaveTrigger wave_trigger_;
 
   uint64_t timeout_{1000000};
   bool trace_enabled_{false};
+  bool coverage_enabled_{false};
+  hal::uart::ConsoleConfig uart_console_;
+  hal::uart::InputConfig uart_input_;
+  std::optional<risc::L2Config> l2_config_;
+  std::string l2_prefetcher_;
 
   // Simulator state
   bool _terminate{false};
-
-  // Cache Profiling
-  uint64_t _l1_icache_accesses{0};
-  uint64_t _l1_icache_misses{0};
-  uint64_t _l1_dcache_accesses{0};
-  uint64_t _l1_dcache_misses{0};
-
-  // Advanced Pipeline Profiling
-  uint64_t _bpu_mispredicts{0};
-  uint64_t _branches_committed{0};
-  uint64_t _flush_cycles{0};
-  uint64_t _rob_empty_cycles{0};
-  uint64_t _issue_count{0};
-  uint64_t _frontend_stalls{0};
-  uint64_t _backend_stalls{0};
+  bool _halted{false};
+  int _exit_code{0};
+  report::ExitReason exit_reason_{report::EXIT_REASON_UNKNOWN};
+  std::string program_path_;
+  double host_seconds_{0}; // spent in run(), or since reset() without it
+  std::chrono::steady_clock::time_point host_start_;
+
+  // Per-cycle DUT debug counters
+  CounterRegistry<system_t> debug_counters_;
+
+  // Top-Down Slot Accounting
+  uint64_t _slots{0};
+  uint64_t _recovery_slots{0};
+  uint64_t _fetch_latency_slots{0};
+  uint64_t _fetch_bandwidth_slots{0};
+  uint64_t _memory_bound_slots{0};
+  uint64_t _core_bound_slots{0};
+
+  // Refills in flight per requesting cache, whichever memory serves them
+  struct RefillTracker final : public hal::BusObserver {
+    uint32_t pending{0};
+
+    void on_read_request(addr_t /*addr*/, uint32_t /*bytes*/) override {
+      pending++;
+    }
+    void on_read_response() override { pending -= pending > 0 ? 1 : 0; }
+  };
+  RefillTracker icache_refills_;
+  RefillTracker dcache_refills_;
+
+  uint64_t topdown_interval_{0};
+  std::string topdown_path_;
+  std::ofstream topdown_out_;
+  PerfCounters topdown_last_;
+
+  perf::IntervalSpec interval_spec_;
+  std::string interval_path_;
+  perf::IntervalWriter intervals_;
+  PerfCounters interval_last_;
+  uint64_t interval_next_{0};
+
+  uint64_t live_period_{0};
+  LiveStatsWriter live_;
+
+  HostProfiler host_profile_;
+
+  // Region of Interest
+  RoiTracker roi_;
+
+  // Hang detection
+  Watchdog watchdog_;
+  // Load addresses, so polling a device register is told apart from a spin
+  perf::MemStream watchdog_loads_;
+
+  // Profiling
+  SymbolTable symbols_;
+  LineTable lines_;
+  std::vector<std::unique_ptr<perf::Probe>> probes_;
+  struct BusTap {
+    std::string region;
+    hal::BusObserver *observer;
+    std::optional<hal::BusMaster> master;
+  };
+  std::vector<BusTap> bus_observers_;
 
   addr_t last_retire_pc_{0};
   std::array<word_t, NUM_GPRS> _register_values{};
 
-  // Internal simulation methods
-  void clock_tick();
-  void handle_retirements();
-  void handle_interrupt();
-  void handle_cache_profiling();
-  void handle_performance_profiling();
+  // Internal simulation methods, instantiated for each model
+  template <typename DUT> void clock_tick(DUT *dut);
+  template <typename DUT> void handle_retirements(DUT *dut);
+  template <typename DUT> void handle_interrupt(DUT *dut);
+  template <typename DUT> void handle_performance_profiling(DUT *dut);
+  template <typename DUT> void handle_probes(DUT *dut);
+  void handle_topdown_interval();
+  void handle_interval();
+  void handle_live_stats();
+  void handle_watchdog();
+  // True for an address backed by a device other than a memory
+  [[nodiscard]] auto is_device_register(addr_t addr) noexcept -> bool;
+#ifdef ENABLE_TRACE
+  void dump_wave(uint64_t cycle);
+  [[nodiscard]] auto wave_segment_path(uint32_t segment) const -> std::string;
+#endif
 
   // Overridable hooks
   virtual void register_devices() {};
@@ -152,6 +358,23 @@ protected:
   virtual void on_init() {};
   virtual void on_exit() {};
   virtual void on_reset() {};
+  // Before a `mismatch` wave drops its older segment; returns once every
+  // retirement up to now has been checked
+  virtual void on_wave_rotate() {}
+
+  // debug counter helpers
+  [[nodiscard]] auto counter_hit_rate(
+      uint64_t PerfCounters::*misses,
+      uint64_t PerfCounters::*accesses) const noexcept -> double {
+    const PerfCounters c = counters();
+    return c.*accesses > 0 ? 1.0 - static_cast<double>(c.*misses) / c.*accesses
+                           : 0.0;
+  }
+  [[nodiscard]] auto counter_rate(uint64_t PerfCounters::*member) const noexcept
+      -> double {
+    const PerfCounters c = counters();
+    return c.cycles > 0 ? static_cast<double>(c.*member) / c.cycles : 0.0;
+  }
 
   // retire lane helper
   [[nodiscard]] auto active_retire_lanes() const noexcept -> uint32_t {
@@ -170,41 +393,56 @@ protected:
 
   [[nodiscard]] auto read_retire_lane(uint32_t lane) const noexcept
       -> demu::RetirePacket {
-    return demu::RetireSignalInfo<system_t>::read(dut_.get(), lane);
+    return with_dut([lane](const auto *dut) {
+      using DUT = std::remove_cv_t<std::remove_pointer_t<decltype(dut)>>;
+      return demu::RetireSignalInfo<DUT>::read(dut, lane);
+    });
   }
 
   // device registry helper
   template <size_t PortID, typename HandlerType, typename DeviceType,
             typename... Args>
   auto register_port(const std::string &region_name, Args &&...args) -> void {
+    with_dut([&](auto *dut) {
+      using DUT = std::remove_pointer_t<decltype(dut)>;
 
-    auto *specific_dut = static_cast<system_t *>(this->dut_.get());
+      if constexpr (demu::hal::SignalBinder<DUT, HandlerType, PortID>::exists) {
 
-    if constexpr (demu::hal::SignalBinder<system_t, HandlerType,
-                                          PortID>::exists) {
+        const auto *region = config_->find_region(region_name);
+        if (!region) {
+          DEMU_WARN("Region '{}' for Port {} not found in config. Skipping.",
+                    region_name, PortID);
+          return;
+        }
 
-      const auto *region = config_->find_region(region_name);
-      if (!region) {
-        DEMU_WARN("Region '{}' for Port {} not found in config. Skipping.",
-                  region_name, PortID);
-        return;
-      }
+        device_manager_->register_device<DeviceType>(
+            PortID, *region, std::forward<Args>(args)...);
 
-      device_manager_->register_device<DeviceType>(PortID, *region,
-                                                   std::forward<Args>(args)...);
+        device_manager_->register_handler(
+            PortID, std::make_unique<HandlerType>([dut]() -> auto {
+              return demu::hal::SignalBinder<DUT, HandlerType, PortID>::bind(
+                  dut);
+            }));
 
-      device_manager_->register_handler(
-          PortID, std::make_unique<HandlerType>([specific_dut]() -> auto {
-            return demu::hal::SignalBinder<system_t, HandlerType, PortID>::bind(
-                specific_dut);
-          }));
+        DEMU_DEBUG("Registered '{}' on Port {}", region_name, PortID)
 
-      DEMU_DEBUG("Registered '{}' on Port {}", region_name, PortID)
+      } else {
+        DEMU_ERROR("Compile-Time SFINAE Failed: Port {} does not exist on DUT "
+                   "for '{}'",
+                   PortID, region_name);
+      }
+    });
+  }
 
+  // Memory region behind the shared L2 when one is configured
+  template <size_t PortID>
+  auto register_memory(const std::string &region_name) -> void {
+    if (l2_) {
+      register_port<PortID, hal::axif::AXIFullPortHandler,
+                    hal::axif::AXIFullCachedSRAM>(region_name, l2_.get());
     } else {
-      DEMU_ERROR(
-          "Compile-Time SFINAE Failed: Port {} does not exist on DUT for '{}'",
-          PortID, region_name);
+      register_port<PortID, hal::axif::AXIFullPortHandler,
+                    hal::axif::AXIFullSRAM>(region_name);
     }
   }
 };
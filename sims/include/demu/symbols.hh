@@ -0,0 +1,47 @@
+#pragma once
+
+#include "./elf_loader.hh"
+#include "./isa/isa.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace demu {
+using namespace isa;
+
+// Code symbols of the loaded program as a sorted, non-overlapping interval
+// index. Zero-sized symbols (assembly labels) extend to the next symbol.
+class SymbolTable final {
+public:
+  struct Entry {
+    addr_t start;
+    addr_t end;
+    std::string name;
+  };
+
+  static constexpr uint32_t npos = UINT32_MAX;
+
+  auto load(const std::string &filename) -> bool;
+  void clear() { entries_.clear(); }
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return entries_.empty(); }
+  [[nodiscard]] auto size() const noexcept -> size_t { return entries_.size(); }
+  [[nodiscard]] auto entries() const noexcept -> const std::vector<Entry> & {
+    return entries_;
+  }
+  [[nodiscard]] auto operator[](uint32_t idx) const noexcept -> const Entry & {
+    return entries_[idx];
+  }
+
+  // Index of the symbol covering addr, or npos
+  [[nodiscard]] auto find(addr_t addr) const noexcept -> uint32_t;
+  [[nodiscard]] auto lookup(addr_t addr) const noexcept -> const Entry *;
+
+  // "name+0xoff" or "0xaddr" when unknown
+  [[nodiscard]] auto describe(addr_t addr) const -> std::string;
+
+private:
+  std::vector<Entry> entries_;
+};
+
+} // namespace demu
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "./roi.hh"
+#include <string>
+
+namespace demu {
+
+// Top-down (TMA-style) breakdown of the dispatch slots, issue_width per
+// cycle, as fractions of PerfCounters::slots. Level 1 sums to 1; each
+// level-2 pair sums to its parent. Squashed slots dispatched work that
+// never retired; the other categories are unfilled slots as classified by
+// the simulator each cycle.
+struct TopDown {
+  uint64_t slots{0};
+
+  double retiring{0};
+  double bad_speculation{0};
+  double squashed{0};
+  double recovery{0};
+  double frontend_bound{0};
+  double fetch_latency{0};
+  double fetch_bandwidth{0};
+  double backend_bound{0};
+  double memory_bound{0};
+  double core_bound{0};
+
+  [[nodiscard]] static auto from(const PerfCounters &c) noexcept -> TopDown;
+
+  void dump() const;
+  [[nodiscard]] static auto csv_header() -> std::string;
+  [[nodiscard]] auto csv() const -> std::string;
+};
+
+} // namespace demu
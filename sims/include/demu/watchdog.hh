@@ -0,0 +1,96 @@
+#pragma once
+
+#include "./isa/isa.hh"
+#include <cstdint>
+#include <vector>
+
+namespace demu {
+using namespace isa;
+
+// Process exit statuses reported when the watchdog ends a run
+enum WatchdogExitStatus : int {
+  WATCHDOG_EXIT_DEADLOCK = 120,
+  WATCHDOG_EXIT_LIVELOCK = 121,
+};
+
+enum class WatchdogVerdict : uint8_t {
+  NONE,
+  DEADLOCK,  // no instruction retired for stall_cycles cycles
+  LIVELOCK,  // retire stream keeps revisiting the same (pc, rd, value) states
+  SAFE_LOOP, // livelock made purely of the SAFE_LOOP self-jump
+};
+
+struct WatchdogConfig {
+  uint64_t stall_cycles{0};    // 0 disables the deadlock check
+  uint64_t livelock_window{0}; // retirements per window, 0 disables
+};
+
+// A run is considered livelocked once two consecutive windows of
+// `livelock_window` retirements contain no (pc, rd, value) tuple that was not
+// already seen in the previous window. Any periodic loop shorter than the
+// window trips this; loops that make progress keep producing new values.
+// A window that loads from a device register, e.g. polling the UART RXC
+// flag, is waiting on the outside world and never counts as stale.
+class Watchdog {
+public:
+  void configure(const WatchdogConfig &config);
+  void reset();
+
+  [[nodiscard]] auto config() const noexcept -> const WatchdogConfig & {
+    return config_;
+  }
+  [[nodiscard]] auto enabled() const noexcept -> bool {
+    return config_.stall_cycles > 0 || config_.livelock_window > 0;
+  }
+
+  void on_retire(addr_t pc, instr_t instr, bool reg_we, uint8_t reg_addr,
+                 word_t reg_data);
+  // Reported before the on_retire() of the load that read the device
+  void on_device_read() noexcept { device_read_ = true; }
+  [[nodiscard]] auto check(uint64_t cycle) noexcept -> WatchdogVerdict;
+
+  [[nodiscard]] auto last_retire_cycle() const noexcept -> uint64_t {
+    return last_retire_cycle_;
+  }
+  [[nodiscard]] auto window_start_pc() const noexcept -> addr_t {
+    return window_start_pc_;
+  }
+
+private:
+  // Open-addressing set of nonzero keys sized for one window, so tracking
+  // a retirement costs a probe or two and no allocation
+  class KeySet {
+  public:
+    void resize(uint64_t keys);
+    void clear() noexcept;
+    // Returns true if `key` was not present
+    auto insert(uint64_t key) noexcept -> bool;
+    [[nodiscard]] auto contains(uint64_t key) const noexcept -> bool;
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+    void swap(KeySet &other) noexcept;
+
+  private:
+    std::vector<uint64_t> slots_;
+    uint64_t mask_{0};
+    uint64_t size_{0};
+  };
+
+  WatchdogConfig config_;
+
+  // deadlock
+  bool retired_{false};
+  uint64_t last_retire_cycle_{0};
+
+  // livelock
+  KeySet prev_window_;
+  KeySet curr_window_;
+  uint64_t window_retired_{0};
+  uint64_t novel_{0};
+  uint32_t stale_windows_{0};
+  bool device_read_{false};
+  bool only_safe_loop_{true};
+  addr_t window_start_pc_{0};
+  bool livelocked_{false};
+};
+
+} // namespace demu
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "./isa/isa.hh"
+#include "./roi.hh"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+
+namespace demu {
+using namespace isa;
+
+// Which cycles of a traced run are dumped. With no trigger set the whole
+// run is, as plain -t does.
+struct WaveConfig {
+  bool cycles{false}; // dump [from_cycle, to_cycle)
+  uint64_t from_cycle{0};
+  uint64_t to_cycle{std::numeric_limits<uint64_t>::max()};
+  std::optional<addr_t> pc;   // each retire of pc opens a window
+  uint64_t instret{0};        // the instret-th retirement opens one
+  std::optional<uint8_t> roi; // dumps while this ROI is open
+  // Dumps everything into two rotating segments of `window` cycles and
+  // keeps them only if difftest reports a mismatch
+  bool mismatch{false};
+  uint64_t window{10000}; // cycles dumped after a pc/instret trigger
+  int depth{99};
+  std::string scope; // hierarchy to dump, e.g. TOP.rv32im_system.core
+  std::string path;  // default logs/demu_<model>_trace.<vcd|fst>
+
+  [[nodiscard]] auto triggered() const noexcept -> bool {
+    return cycles || pc || instret > 0 || roi || mismatch;
+  }
+};
+
+// Parses the --wave spec, a comma-separated list of
+// cycles=<from>:[<to>], pc=<addr>, instret=<n>, roi=<id>, mismatch,
+// window=<n>, depth=<n>, scope=<hier> and out=<path>
+auto parse_wave_spec(const std::string &spec, WaveConfig &config) -> bool;
+
+class WaveTrigger {
+public:
+  void configure(const WaveConfig &config) {
+    config_ = config;
+    reset();
+  }
+  void reset() noexcept;
+
+  [[nodiscard]] auto config() const noexcept -> const WaveConfig & {
+    return config_;
+  }
+  // Only the pc and instret triggers need to see every retirement
+  [[nodiscard]] auto watches_retire() const noexcept -> bool {
+    return config_.pc || config_.instret > 0;
+  }
+  [[nodiscard]] auto active(uint64_t cycle) const noexcept -> bool {
+    return !config_.triggered() || config_.mismatch || roi_open_ ||
+           cycle < open_until_ ||
+           (config_.cycles && cycle >= config_.from_cycle &&
+            cycle < config_.to_cycle);
+  }
+  [[nodiscard]] auto windows() const noexcept -> uint64_t { return windows_; }
+
+  void on_retire(uint64_t cycle, addr_t pc);
+  void on_roi(RoiOp op, uint8_t id, uint64_t cycle);
+
+private:
+  WaveConfig config_;
+  uint64_t open_until_{0};
+  uint64_t retired_{0};
+  bool roi_open_{false};
+  uint64_t windows_{0};
+
+  void open(uint64_t cycle, const char *cause);
+};
+
+} // namespace demu
@@ -0,0 +1,564 @@
+#include "demu/debug_line.hh"
+#include "demu/elf_loader.hh"
+#include "demu/logger.hh"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace demu {
+
+namespace {
+
+// DWARF constants used by the line program decoder
+enum : uint8_t {
+  DW_LNS_copy = 1,
+  DW_LNS_advance_pc = 2,
+  DW_LNS_advance_line = 3,
+  DW_LNS_set_file = 4,
+  DW_LNS_const_add_pc = 8,
+  DW_LNS_fixed_advance_pc = 9,
+
+  DW_LNE_end_sequence = 1,
+  DW_LNE_set_address = 2,
+  DW_LNE_define_file = 3,
+};
+
+enum : uint16_t {
+  DW_FORM_block = 0x09,
+  DW_FORM_block1 = 0x0a,
+  DW_FORM_block2 = 0x03,
+  DW_FORM_block4 = 0x04,
+  DW_FORM_data1 = 0x0b,
+  DW_FORM_data2 = 0x05,
+  DW_FORM_data4 = 0x06,
+  DW_FORM_data8 = 0x07,
+  DW_FORM_data16 = 0x1e,
+  DW_FORM_string = 0x08,
+  DW_FORM_strp = 0x0e,
+  DW_FORM_udata = 0x0f,
+  DW_FORM_line_strp = 0x1f,
+  DW_FORM_strx = 0x1a,
+  DW_FORM_strx1 = 0x25,
+  DW_FORM_strx2 = 0x26,
+  DW_FORM_strx3 = 0x27,
+  DW_FORM_strx4 = 0x28,
+
+  DW_LNCT_path = 1,
+  DW_LNCT_directory_index = 2,
+};
+
+using Section = std::string_view;
+
+// Bounds-checked cursor over a section; reads past the end yield zeros and
+// latch `bad` so a truncated unit is dropped instead of crashing the run.
+struct Reader {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool bad{false};
+
+  [[nodiscard]] auto remaining() const noexcept -> size_t {
+    return static_cast<size_t>(end - p);
+  }
+
+  auto bytes(size_t n) noexcept -> const uint8_t * {
+    if (remaining() < n) {
+      bad = true;
+      p = end;
+      return nullptr;
+    }
+    const uint8_t *r = p;
+    p += n;
+    return r;
+  }
+
+  template <typename T> auto fixed() noexcept -> T {
+    T v{};
+    if (const uint8_t *b = bytes(sizeof(T))) {
+      std::memcpy(&v, b, sizeof(T));
+    }
+    return v;
+  }
+
+  auto sized(size_t n) noexcept -> uint64_t {
+    switch (n) {
+    case 1:
+      return fixed<uint8_t>();
+    case 2:
+      return fixed<uint16_t>();
+    case 4:
+      return fixed<uint32_t>();
+    case 8:
+      return fixed<uint64_t>();
+    default:
+      bytes(n);
+      return 0;
+    }
+  }
+
+  auto uleb() noexcept -> uint64_t {
+    uint64_t result = 0;
+    unsigned shift = 0;
+    while (p < end) {
+      const uint8_t b = *p++;
+      if (shift < 64) {
+        result |= static_cast<uint64_t>(b & 0x7f) << shift;
+      }
+      shift += 7;
+      if (!(b & 0x80)) {
+        return result;
+      }
+    }
+    bad = true;
+    return result;
+  }
+
+  auto sleb() noexcept -> int64_t {
+    int64_t result = 0;
+    unsigned shift = 0;
+    uint8_t b = 0;
+    do {
+      if (p >= end) {
+        bad = true;
+        return result;
+      }
+      b = *p++;
+      if (shift < 64) {
+        result |= static_cast<int64_t>(b & 0x7f) << shift;
+      }
+      shift += 7;
+    } while (b & 0x80);
+    if (shift < 64 && (b & 0x40)) {
+      result |= -(static_cast<int64_t>(1) << shift);
+    }
+    return result;
+  }
+
+  auto cstr() noexcept -> std::string_view {
+    const auto *nul = static_cast<const uint8_t *>(
+        std::memchr(p, 0, remaining()));
+    if (!nul) {
+      bad = true;
+      p = end;
+      return {};
+    }
+    std::string_view s(reinterpret_cast<const char *>(p),
+                       static_cast<size_t>(nul - p));
+    p = nul + 1;
+    return s;
+  }
+};
+
+auto string_at(Section sec, uint64_t off) -> std::string_view {
+  if (off >= sec.size()) {
+    return {};
+  }
+  const char *s = sec.data() + off;
+  return {s, strnlen(s, sec.size() - off)};
+}
+
+struct Sections {
+  Section line;
+  Section line_str;
+  Section str;
+};
+
+auto find_sections(const uint8_t *base, size_t size, Sections &out) -> bool {
+  if (size < sizeof(ELF32_Header) || std::memcmp(base, "\x7f" "ELF", 4) != 0 ||
+      base[4] != 1 /* ELFCLASS32 */) {
+    return false;
+  }
+
+  ELF32_Header eh;
+  std::memcpy(&eh, base, sizeof(eh));
+  if (eh.e_shoff == 0 || eh.e_shentsize != sizeof(ELF32_SectionHeader) ||
+      eh.e_shoff + static_cast<uint64_t>(eh.e_shnum) * eh.e_shentsize > size ||
+      eh.e_shstrndx >= eh.e_shnum) {
+    return false;
+  }
+
+  std::vector<ELF32_SectionHeader> shdrs(eh.e_shnum);
+  std::memcpy(shdrs.data(), base + eh.e_shoff,
+              shdrs.size() * sizeof(ELF32_SectionHeader));
+
+  auto section = [&](const ELF32_SectionHeader &sh) -> Section {
+    if (static_cast<uint64_t>(sh.sh_offset) + sh.sh_size > size) {
+      return {};
+    }
+    return {reinterpret_cast<const char *>(base + sh.sh_offset), sh.sh_size};
+  };
+
+  const Section shstr = section(shdrs[eh.e_shstrndx]);
+  for (const auto &sh : shdrs) {
+    const std::string_view name = string_at(shstr, sh.sh_name);
+    if (name == ".debug_line") {
+      out.line = section(sh);
+    } else if (name == ".debug_line_str") {
+      out.line_str = section(sh);
+    } else if (name == ".debug_str") {
+      out.str = section(sh);
+    }
+  }
+  return !out.line.empty();
+}
+
+// Decodes one v5 entry format list and returns (content type, form) pairs
+auto read_formats(Reader &r) -> std::vector<std::pair<uint64_t, uint64_t>> {
+  const uint8_t count = r.fixed<uint8_t>();
+  std::vector<std::pair<uint64_t, uint64_t>> formats;
+  formats.reserve(count);
+  for (uint8_t i = 0; i < count && !r.bad; ++i) {
+    const uint64_t type = r.uleb();
+    const uint64_t form = r.uleb();
+    formats.emplace_back(type, form);
+  }
+  return formats;
+}
+
+struct Entry {
+  std::string_view path;
+  uint64_t dir{0};
+};
+
+auto read_entry(Reader &r,
+                const std::vector<std::pair<uint64_t, uint64_t>> &formats,
+                const Sections &secs, bool dwarf64) -> Entry {
+  Entry e;
+  for (const auto &[type, form] : formats) {
+    std::string_view str;
+    uint64_t value = 0;
+    switch (form) {
+    case DW_FORM_string:
+      str = r.cstr();
+      break;
+    case DW_FORM_line_strp:
+      str = string_at(secs.line_str, r.sized(dwarf64 ? 8 : 4));
+      break;
+    case DW_FORM_strp:
+      str = string_at(secs.str, r.sized(dwarf64 ? 8 : 4));
+      break;
+    case DW_FORM_strx:
+    case DW_FORM_udata:
+      value = r.uleb();
+      break;
+    case DW_FORM_strx1:
+    case DW_FORM_data1:
+      value = r.sized(1);
+      break;
+    case DW_FORM_strx2:
+    case DW_FORM_data2:
+      value = r.sized(2);
+      break;
+    case DW_FORM_strx3:
+      r.bytes(3);
+      break;
+    case DW_FORM_strx4:
+    case DW_FORM_data4:
+      value = r.sized(4);
+      break;
+    case DW_FORM_data8:
+      value = r.sized(8);
+      break;
+    case DW_FORM_data16:
+      r.bytes(16);
+      break;
+    case DW_FORM_block:
+      r.bytes(r.uleb());
+      break;
+    case DW_FORM_block1:
+      r.bytes(r.sized(1));
+      break;
+    case DW_FORM_block2:
+      r.bytes(r.sized(2));
+      break;
+    case DW_FORM_block4:
+      r.bytes(r.sized(4));
+      break;
+    default:
+      // Unknown form: the rest of the header cannot be decoded
+      r.bad = true;
+      return e;
+    }
+
+    if (type == DW_LNCT_path) {
+      e.path = str;
+    } else if (type == DW_LNCT_directory_index) {
+      e.dir = value;
+    }
+  }
+  return e;
+}
+
+} // namespace
+
+void LineTable::open(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  path_ = filename;
+  loaded_ = false;
+  rows_.clear();
+  files_.clear();
+}
+
+void LineTable::clear() { open(""); }
+
+auto LineTable::empty() const -> bool {
+  std::lock_guard<std::mutex> lock(mtx_);
+  load_locked();
+  return rows_.empty();
+}
+
+auto LineTable::lookup(addr_t pc) const -> SourceLocation {
+  std::lock_guard<std::mutex> lock(mtx_);
+  load_locked();
+
+  auto it = std::upper_bound(
+      rows_.begin(), rows_.end(), pc,
+      [](addr_t a, const Row &row) -> bool { return a < row.addr; });
+  if (it == rows_.begin()) {
+    return {};
+  }
+  --it;
+  if (it->end_sequence || it->file >= files_.size()) {
+    return {};
+  }
+  return {&files_[it->file], it->line};
+}
+
+auto LineTable::describe(addr_t pc) const -> std::string {
+  const SourceLocation loc = lookup(pc);
+  if (!loc.valid()) {
+    return {};
+  }
+  return fmt::format("{}:{}", *loc.file, loc.line);
+}
+
+void LineTable::load_locked() const {
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+
+  if (path_.empty()) {
+    return;
+  }
+
+  const int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) < 0 || st.st_size <= 0) {
+    ::close(fd);
+    return;
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    DEMU_WARN("Failed to map {} for line info", path_);
+    return;
+  }
+
+  const auto *base = static_cast<const uint8_t *>(map);
+  Sections secs;
+  if (!find_sections(base, size, secs)) {
+    ::munmap(map, size);
+    DEMU_DEBUG("No .debug_line in {}", path_);
+    return;
+  }
+
+  std::unordered_map<std::string, uint32_t> file_ids;
+  auto intern = [&](std::string name) -> uint32_t {
+    auto [it, inserted] =
+        file_ids.try_emplace(name, static_cast<uint32_t>(files_.size()));
+    if (inserted) {
+      files_.push_back(std::move(name));
+    }
+    return it->second;
+  };
+
+  Reader unit{reinterpret_cast<const uint8_t *>(secs.line.data()),
+              reinterpret_cast<const uint8_t *>(secs.line.data()) +
+                  secs.line.size()};
+
+  while (unit.remaining() > 0 && !unit.bad) {
+    uint64_t length = unit.fixed<uint32_t>();
+    const bool dwarf64 = length == 0xffffffff;
+    if (dwarf64) {
+      length = unit.fixed<uint64_t>();
+    }
+    const uint8_t *unit_start = unit.p;
+    if (unit.bad || length > unit.remaining()) {
+      break;
+    }
+    unit.p += length;
+
+    Reader r{unit_start, unit_start + length};
+    const uint16_t version = r.fixed<uint16_t>();
+    if (version < 2 || version > 5) {
+      continue;
+    }
+    uint8_t addr_size = 4;
+    if (version >= 5) {
+      addr_size = r.fixed<uint8_t>();
+      r.fixed<uint8_t>(); // segment selector size
+    }
+    const uint64_t header_length = r.sized(dwarf64 ? 8 : 4);
+    const uint8_t *program = r.p + header_length;
+    if (r.bad || header_length > r.remaining()) {
+      continue;
+    }
+
+    const uint8_t min_inst_length = r.fixed<uint8_t>();
+    if (version >= 4) {
+      r.fixed<uint8_t>(); // maximum_operations_per_instruction
+    }
+    r.fixed<uint8_t>(); // default_is_stmt
+    const auto line_base = static_cast<int8_t>(r.fixed<uint8_t>());
+    const uint8_t line_range = r.fixed<uint8_t>();
+    const uint8_t opcode_base = r.fixed<uint8_t>();
+    std::vector<uint8_t> opcode_lengths(opcode_base > 0 ? opcode_base - 1 : 0);
+    for (auto &len : opcode_lengths) {
+      len = r.fixed<uint8_t>();
+    }
+    if (r.bad || line_range == 0) {
+      continue;
+    }
+
+    // File table, mapped to interned ids; v2-v4 index from 1, v5 from 0
+    std::vector<std::string> dirs;
+    std::vector<uint32_t> files;
+    auto add_file = [&](std::string_view name, uint64_t dir) {
+      std::string path(name);
+      if (!name.empty() && name[0] != '/' && dir < dirs.size() &&
+          !dirs[dir].empty()) {
+        path = dirs[dir] + "/" + path;
+      }
+      files.push_back(intern(std::move(path)));
+    };
+
+    if (version >= 5) {
+      const auto dir_formats = read_formats(r);
+      const uint64_t dir_count = r.uleb();
+      for (uint64_t i = 0; i < dir_count && !r.bad; ++i) {
+        dirs.emplace_back(read_entry(r, dir_formats, secs, dwarf64).path);
+      }
+      const auto file_formats = read_formats(r);
+      const uint64_t file_count = r.uleb();
+      for (uint64_t i = 0; i < file_count && !r.bad; ++i) {
+        const Entry e = read_entry(r, file_formats, secs, dwarf64);
+        add_file(e.path, e.dir);
+      }
+    } else {
+      dirs.emplace_back(); // index 0: compilation directory
+      for (std::string_view d = r.cstr(); !d.empty() && !r.bad; d = r.cstr()) {
+        dirs.emplace_back(d);
+      }
+      files.push_back(UINT32_MAX); // index 0 is unused before v5
+      for (std::string_view f = r.cstr(); !f.empty() && !r.bad; f = r.cstr()) {
+        const uint64_t dir = r.uleb();
+        r.uleb(); // mtime
+        r.uleb(); // length
+        add_file(f, dir);
+      }
+    }
+    if (r.bad) {
+      continue;
+    }
+
+    // Line number program
+    r.p = program;
+    uint64_t address = 0;
+    int64_t line = 1;
+    uint64_t file = 1;
+    auto emit = [&](bool end_sequence) {
+      const uint32_t id = file < files.size() ? files[file] : UINT32_MAX;
+      rows_.push_back({static_cast<addr_t>(address),
+                       static_cast<uint32_t>(line), id, end_sequence});
+    };
+
+    while (r.remaining() > 0 && !r.bad) {
+      const uint8_t op = r.fixed<uint8_t>();
+
+      if (op >= opcode_base) {
+        const uint8_t adj = op - opcode_base;
+        address += static_cast<uint64_t>(adj / line_range) * min_inst_length;
+        line += line_base + (adj % line_range);
+        emit(false);
+        continue;
+      }
+
+      switch (op) {
+      case 0: {
+        const uint64_t len = r.uleb();
+        const uint8_t *next = r.p + len;
+        if (len == 0 || len > r.remaining()) {
+          r.bad = true;
+          break;
+        }
+        const uint8_t sub = r.fixed<uint8_t>();
+        if (sub == DW_LNE_end_sequence) {
+          emit(true);
+          address = 0;
+          line = 1;
+          file = 1;
+        } else if (sub == DW_LNE_set_address) {
+          address = r.sized(std::min<size_t>(len - 1, addr_size));
+        } else if (sub == DW_LNE_define_file) {
+          const std::string_view name = r.cstr();
+          add_file(name, r.uleb());
+        }
+        r.p = next;
+        break;
+      }
+      case DW_LNS_copy:
+        emit(false);
+        break;
+      case DW_LNS_advance_pc:
+        address += r.uleb() * min_inst_length;
+        break;
+      case DW_LNS_advance_line:
+        line += r.sleb();
+        break;
+      case DW_LNS_set_file:
+        file = r.uleb();
+        break;
+      case DW_LNS_const_add_pc:
+        address +=
+            static_cast<uint64_t>((255 - opcode_base) / line_range) *
+            min_inst_length;
+        break;
+      case DW_LNS_fixed_advance_pc:
+        address += r.fixed<uint16_t>();
+        break;
+      default:
+        // Standard opcodes without special handling take ULEB operands
+        for (uint8_t i = 0; i < opcode_lengths[op - 1]; ++i) {
+          r.uleb();
+        }
+        break;
+      }
+    }
+  }
+
+  ::munmap(map, size);
+
+  // End-of-sequence rows sort before a sequence starting at the same address
+  std::stable_sort(rows_.begin(), rows_.end(),
+                   [](const Row &a, const Row &b) -> bool {
+                     if (a.addr != b.addr) {
+                       return a.addr < b.addr;
+                     }
+                     return a.end_sequence && !b.end_sequence;
+                   });
+  rows_.shrink_to_fit();
+
+  DEMU_DEBUG("Loaded {} line rows for {} files from {}", rows_.size(),
+             files_.size(), path_);
+}
+
+} // namespace demu
@@ -140,4 +140,63 @@ auto ELFLoader::load(std::vector<ELFSection> &sections, uint32_t &entry_point,
   return true;
 }
 
+auto ELFLoader::load_symbols(std::vector<ELFSymbol> &symbols,
+                             const std::string &filename) -> bool {
+  symbols.clear();
+
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  ELF32_Header elf_header;
+  file.read(reinterpret_cast<char *>(&elf_header), sizeof(elf_header));
+  if (!file || elf_header.e_shoff == 0 ||
+      elf_header.e_shentsize != sizeof(ELF32_SectionHeader)) {
+    return false;
+  }
+
+  std::vector<ELF32_SectionHeader> shdrs(elf_header.e_shnum);
+  file.seekg(elf_header.e_shoff);
+  file.read(reinterpret_cast<char *>(shdrs.data()),
+            static_cast<std::streamsize>(shdrs.size() * sizeof(shdrs[0])));
+  if (!file) {
+    return false;
+  }
+
+  for (const auto &sh : shdrs) {
+    if (sh.sh_type != SHT_SYMTAB || sh.sh_link >= shdrs.size()) {
+      continue;
+    }
+
+    const auto &strtab = shdrs[sh.sh_link];
+    std::vector<char> strings(strtab.sh_size + 1, '\0');
+    file.seekg(strtab.sh_offset);
+    file.read(strings.data(), strtab.sh_size);
+
+    std::vector<ELF32_Symbol> syms(sh.sh_size / sizeof(ELF32_Symbol));
+    file.seekg(sh.sh_offset);
+    file.read(reinterpret_cast<char *>(syms.data()),
+              static_cast<std::streamsize>(syms.size() * sizeof(syms[0])));
+    if (!file) {
+      return false;
+    }
+
+    for (const auto &sym : syms) {
+      if (sym.st_name == 0 || sym.st_name >= strtab.sh_size ||
+          sym.st_shndx == 0) {
+        continue;
+      }
+      const bool code = sym.st_shndx < shdrs.size() &&
+                        (shdrs[sym.st_shndx].sh_flags & 0x4); // SHF_EXECINSTR
+      symbols.push_back({std::string(&strings[sym.st_name]), sym.st_value,
+                         sym.st_size, static_cast<uint8_t>(sym.st_info & 0xF),
+                         static_cast<uint8_t>(sym.st_info >> 4), code});
+    }
+  }
+
+  DEMU_DEBUG("Read {} symbols from {}", symbols.size(), filename);
+  return !symbols.empty();
+}
+
 } // namespace demu
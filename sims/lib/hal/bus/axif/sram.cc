@@ -10,6 +10,9 @@ void AXIFullSRAM::reset() {
   _write_resp_queue = std::queue<WriteResponse>();
   _read_req_queue = std::queue<BurstTransaction>();
   _read_data_queue = std::queue<ReadData>();
+  read_ready_ = std::queue<uint64_t>();
+  write_ready_ = std::queue<uint64_t>();
+  pending_resp_queue_ = std::queue<PendingResponse>();
 
   pin_awvalid = false;
   pin_wvalid = false;
@@ -20,8 +23,15 @@ void AXIFullSRAM::reset() {
 
 void AXIFullSRAM::clock_tick() {
   if (pin_awvalid && aw_ready()) {
+    const uint32_t bytes = (pin_awlen + 1u) << pin_awsize;
     _write_req_queue.push(
         {pin_awid, pin_awaddr, pin_awlen, pin_awsize, pin_awburst, 0});
+    write_ready_.push(ready_at(pin_awaddr, bytes, true));
+    for (const auto &tap : observers_) {
+      if (tap.sees(pin_awid)) {
+        tap.observer->on_write_request(pin_awaddr, bytes);
+      }
+    }
   }
   if (pin_wvalid && w_ready()) {
     _write_data_queue.push({pin_wdata, pin_wstrb, pin_wlast});
@@ -30,13 +40,35 @@ void AXIFullSRAM::clock_tick() {
     _write_resp_queue.pop();
   }
   if (pin_arvalid && ar_ready()) {
+    const uint32_t bytes = (pin_arlen + 1u) << pin_arsize;
     _read_req_queue.push(
         {pin_arid, pin_araddr, pin_arlen, pin_arsize, pin_arburst, 0});
+    read_ready_.push(ready_at(pin_araddr, bytes, false));
+    for (const auto &tap : observers_) {
+      if (tap.sees(pin_arid)) {
+        tap.observer->on_read_request(pin_araddr, bytes);
+      }
+    }
   }
   if (pin_rready && r_valid()) {
+    if (r_last()) {
+      for (const auto &tap : observers_) {
+        if (tap.sees(_read_data_queue.front().id)) {
+          tap.observer->on_read_response();
+        }
+      }
+    }
     _read_data_queue.pop();
   }
 
+  // Released after the handshakes, so a response never pops in the cycle
+  // it becomes visible
+  while (!pending_resp_queue_.empty() &&
+         pending_resp_queue_.front().ready <= now()) {
+    _write_resp_queue.push(pending_resp_queue_.front().resp);
+    pending_resp_queue_.pop();
+  }
+
   process_writes();
   process_reads();
 }
@@ -85,15 +117,21 @@ void AXIFullSRAM::process_writes() {
   calculate_next_address(req);
 
   if (wdata.last || req.beats > req.len) {
-    _write_resp_queue.push(
-        {req.id,
-         static_cast<uint8_t>(valid ? 0 : 2)}); // OKAY (0) or SLVERR (2)
+    const WriteResponse resp{
+        req.id, static_cast<uint8_t>(valid ? 0 : 2)}; // OKAY (0) or SLVERR (2)
+    // B responses stay in order behind any that are still held
+    if (pending_resp_queue_.empty() && write_ready_.front() <= now()) {
+      _write_resp_queue.push(resp);
+    } else {
+      pending_resp_queue_.push({resp, write_ready_.front()});
+    }
     _write_req_queue.pop();
+    write_ready_.pop();
   }
 }
 
 void AXIFullSRAM::process_reads() {
-  if (_read_req_queue.empty()) {
+  if (_read_req_queue.empty() || read_ready_.front() > now()) {
     return;
   }
 
@@ -112,6 +150,7 @@ void AXIFullSRAM::process_reads() {
 
   if (last) {
     _read_req_queue.pop();
+    read_ready_.pop();
   }
 }
 
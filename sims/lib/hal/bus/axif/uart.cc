@@ -61,20 +61,7 @@ void AXIFullUART::process_writes() {
   const bool valid = owns_address(req.addr);
 
   if (valid) {
-    addr_t offset = to_offset(req.addr);
-
-    if (offset == uart::UART_TXD) {
-      char c = static_cast<char>(wdata.data & 0xFF);
-      std::cout << c << std::flush;
-    } else {
-      for (int i = 0; i < 4; ++i) {
-        if (wdata.strb & (1u << i)) {
-          allocator()->write_byte(
-              req.addr + i,
-              static_cast<byte_t>((wdata.data >> (i * 8)) & 0xFF));
-        }
-      }
-    }
+    uart_->write(req.addr, wdata.data, wdata.strb);
   }
 
   req.beats++;
@@ -94,7 +81,7 @@ void AXIFullUART::process_reads() {
   BurstTransaction &req = _read_req_queue.front();
   const bool valid = owns_address(req.addr);
 
-  word_t data = valid ? allocator()->read_word(req.addr) : 0u;
+  word_t data = valid ? uart_->read(req.addr) : 0u;
 
   const bool last = (req.beats == req.len);
   _read_data_queue.push(
@@ -0,0 +1,56 @@
+#include "demu/hal/bus/axil/htif.hh"
+
+namespace demu::hal::axil {
+
+void AXILiteHTIF::reset() {
+  htif_->reset();
+  _write_addr_queue = {};
+  _write_data_queue = {};
+  _write_resp_queue = {};
+  _read_queue = {};
+}
+
+void AXILiteHTIF::clock_tick() {
+  htif_->clock_tick();
+
+  process_writes();
+  process_reads();
+}
+
+void AXILiteHTIF::process_writes() {
+  if (_write_addr_queue.empty() || _write_data_queue.empty()) {
+    return;
+  }
+
+  const addr_t addr = _write_addr_queue.front();
+  _write_addr_queue.pop();
+  const WriteData wdata = _write_data_queue.front();
+  _write_data_queue.pop();
+
+  const bool valid = owns_address(addr) && (addr % INSTR_ALIGNMENT == 0);
+
+  if (valid) {
+    htif_->write(addr, wdata.data, wdata.strb);
+  }
+
+  _write_resp_queue.push(
+      {valid ? static_cast<uint8_t>(0) : static_cast<uint8_t>(2)});
+}
+
+void AXILiteHTIF::process_reads() {
+  if (_read_queue.empty() || _read_queue.front().processed) {
+    return;
+  }
+
+  ReadTransaction &rt = _read_queue.front();
+  const bool valid = owns_address(rt.addr) && (rt.addr % INSTR_ALIGNMENT == 0);
+
+  rt.data = valid ? htif_->read(rt.addr) : 0u;
+  rt.processed = true;
+}
+
+void AXILiteHTIF::dump(addr_t start, size_t size) const noexcept {
+  htif_->dump(start, size);
+}
+
+} // namespace demu::hal::axil
@@ -11,6 +11,8 @@ void AXILiteUART::reset() {
 }
 
 void AXILiteUART::clock_tick() {
+  uart_->clock_tick();
+
   process_writes();
   process_reads();
 }
@@ -28,19 +30,7 @@ void AXILiteUART::process_writes() {
   const bool valid = owns_address(addr) && (addr % INSTR_ALIGNMENT == 0);
 
   if (valid) {
-    addr_t offset = to_offset(addr);
-
-    if (offset == uart::UART_TXD) {
-      char c = static_cast<char>(wdata.data & 0xFF);
-      std::cout << c << std::flush;
-    } else {
-      for (int i = 0; i < 4; ++i) {
-        if (wdata.strb & (1u << i)) {
-          allocator()->write_byte(
-              addr + i, static_cast<byte_t>((wdata.data >> (i * 8)) & 0xFF));
-        }
-      }
-    }
+    uart_->write(addr, wdata.data, wdata.strb);
   }
 
   _write_resp_queue.push(
@@ -55,7 +45,7 @@ void AXILiteUART::process_reads() {
   ReadTransaction &rt = _read_queue.front();
   const bool valid = owns_address(rt.addr) && (rt.addr % INSTR_ALIGNMENT == 0);
 
-  rt.data = valid ? allocator()->read_word(rt.addr) : 0u;
+  rt.data = valid ? uart_->read(rt.addr) : 0u;
   rt.processed = true;
 }
 
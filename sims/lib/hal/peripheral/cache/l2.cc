@@ -0,0 +1,410 @@
+#include "demu/hal/peripheral/cache/l2.hh"
+#include "demu/logger.hh"
+#include "demu/perf/sweep.hh"
+#include <algorithm>
+#include <limits>
+
+namespace demu::hal::cache {
+
+namespace {
+
+auto geometry_of(const risc::L2Config &config) -> perf::CacheGeometry {
+  auto geometry = perf::CacheGeometry::from_config(config.cache());
+  if (geometry.policy == risc::REPL_POLICY_UNKNOWN) {
+    geometry.policy = risc::REPL_POLICY_LRU;
+  }
+  return geometry;
+}
+
+auto parse_single(const std::string &s, uint32_t &value) -> bool {
+  std::vector<uint32_t> values;
+  if (!perf::parse_uint_list(s, values) || values.size() != 1) {
+    return false;
+  }
+  value = values[0];
+  return true;
+}
+
+} // namespace
+
+L2Cache::L2Cache(const risc::L2Config &config)
+    : config_(config), tags_(geometry_of(config)) {
+  if (!geometry_of(config_).valid()) {
+    HAL_ERROR("L2: invalid geometry {}", geometry_of(config_).to_string());
+  }
+  if (config_.mshrs() == 0) {
+    config_.set_mshrs(1);
+  }
+  state_.resize(tags_.slots());
+}
+
+auto L2Cache::attach(std::string_view source) -> uint32_t {
+  counters_.sources.push_back({std::string(source)});
+  return static_cast<uint32_t>(counters_.sources.size() - 1);
+}
+
+void L2Cache::prefetcher(std::unique_ptr<perf::Prefetcher> prefetcher) {
+  if (prefetcher->trigger() != perf::Prefetcher::Trigger::MISS) {
+    HAL_WARN("L2: {} needs load/store PCs and cannot run in the L2",
+             prefetcher->name());
+    return;
+  }
+  prefetcher_ = std::move(prefetcher);
+}
+
+void L2Cache::reset() {
+  tags_.reset();
+  std::fill(state_.begin(), state_.end(), LineState{});
+  mshrs_.clear();
+  victims_.clear();
+  now_ = 0;
+  if (prefetcher_) {
+    prefetcher_->reset();
+  }
+
+  L2Counters counters;
+  for (const auto &source : counters_.sources) {
+    counters.sources.push_back({source.name});
+  }
+  counters_ = std::move(counters);
+}
+
+void L2Cache::clock_tick() {
+  ++now_;
+  for (auto it = mshrs_.begin(); it != mshrs_.end();) {
+    if (it->ready <= now_) {
+      if (!it->writeback) {
+        fill(*it);
+      }
+      it = mshrs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  write_back_victims();
+}
+
+auto L2Cache::request(uint32_t source, addr_t addr, uint32_t bytes,
+                      bool write) -> uint64_t {
+  auto &src = counters_.sources[source];
+  (write ? src.writes : src.reads)++;
+
+  const addr_t line_size = tags_.geometry().line_size;
+  const addr_t first = addr / line_size;
+  const addr_t last = (addr + std::max(bytes, 1u) - 1) / line_size;
+
+  uint64_t ready = now_;
+  bool miss = false;
+  for (addr_t line = first; line <= last; ++line) {
+    const bool full_line =
+        addr <= line * line_size && addr + bytes >= (line + 1) * line_size;
+    ready = std::max(ready, access_line(line, write, full_line, miss));
+  }
+
+  if (miss) {
+    (write ? src.write_misses : src.read_misses)++;
+  }
+  src.latency += ready - now_;
+  return ready;
+}
+
+auto L2Cache::access_line(addr_t line, bool write, bool full_line, bool &miss)
+    -> uint64_t {
+  const addr_t addr = line * tags_.geometry().line_size;
+  const uint64_t hit_ready = now_ + config_.hit_latency();
+  const bool write_back = config_.write_back();
+
+  for (auto &mshr : mshrs_) {
+    if (mshr.line == line && !mshr.writeback) {
+      counters_.mshr_merges++;
+      miss = true;
+      mshr.dirty |= write && write_back;
+      mshr.in_l1 |= !write;
+      if (mshr.prefetch) {
+        counters_.prefetch_useful++;
+        counters_.prefetch_late++;
+        mshr.prefetch = false;
+      }
+      uint64_t ready = std::max(mshr.ready, hit_ready);
+      if (write && !write_back) {
+        counters_.write_throughs++;
+        ready = std::max(ready, hit_ready + config_.miss_latency());
+      }
+      if (!write) {
+        train(addr);
+      }
+      return ready;
+    }
+  }
+
+  uint32_t slot;
+  if (tags_.find(addr, slot)) {
+    tags_.insert(addr);
+    auto &state = state_[slot];
+    if (state.prefetched) {
+      counters_.prefetch_useful++;
+      state.prefetched = false;
+      if (!write) {
+        train(addr);
+      }
+    }
+    if (!write) {
+      state.in_l1 = true;
+      return hit_ready;
+    }
+    if (write_back) {
+      state.dirty = true;
+      return hit_ready;
+    }
+    counters_.write_throughs++;
+    return hit_ready + config_.miss_latency();
+  }
+
+  miss = true;
+  if (write && !write_back) {
+    counters_.write_throughs++;
+    return hit_ready + config_.miss_latency();
+  }
+  if (write && full_line) {
+    fill({line, now_, hit_ready, true, false, false});
+    write_back_victims();
+    return hit_ready;
+  }
+  const uint64_t ready = allocate_mshr(line, write);
+  if (!write) {
+    train(addr);
+  }
+  return ready;
+}
+
+auto L2Cache::mshrs_busy(uint64_t cycle) const noexcept -> uint32_t {
+  uint32_t busy = 0;
+  for (const auto &mshr : mshrs_) {
+    busy += static_cast<uint32_t>(mshr.start <= cycle && mshr.ready > cycle);
+  }
+  return busy;
+}
+
+auto L2Cache::reserve(uint64_t earliest, uint64_t latency) const
+    -> uint64_t {
+  // Occupancy only rises at another MSHR's start, so the window is free if
+  // it is free at `start` and at every start inside it.
+  uint64_t start = earliest;
+  for (;;) {
+    bool free = mshrs_busy(start) < config_.mshrs();
+    for (const auto &mshr : mshrs_) {
+      if (free && mshr.start > start && mshr.start < start + latency) {
+        free = mshrs_busy(mshr.start) < config_.mshrs();
+      }
+    }
+    if (free) {
+      return start;
+    }
+    uint64_t next = std::numeric_limits<uint64_t>::max();
+    for (const auto &mshr : mshrs_) {
+      if (mshr.ready > start) {
+        next = std::min(next, mshr.ready);
+      }
+    }
+    start = next;
+  }
+}
+
+auto L2Cache::allocate_mshr(addr_t line, bool write) -> uint64_t {
+  const uint64_t earliest = now_ + config_.hit_latency();
+  const uint64_t latency = config_.miss_latency();
+  const uint64_t start = reserve(earliest, latency);
+
+  counters_.mshr_stall_cycles += start - earliest;
+  mshrs_.push_back({line, start, start + latency, write, !write, false});
+  return start + latency;
+}
+
+// Writebacks take memory bandwidth from the fetches: each one holds an MSHR
+// from the first free slot after the eviction
+void L2Cache::write_back_victims() {
+  const uint64_t latency = config_.miss_latency();
+  for (const addr_t line : victims_) {
+    const uint64_t start = reserve(now_, latency);
+    mshrs_.push_back(
+        {line, start, start + latency, false, false, false, true});
+  }
+  victims_.clear();
+}
+
+void L2Cache::train(addr_t addr) {
+  if (!prefetcher_) {
+    return;
+  }
+  candidates_.clear();
+  prefetcher_->train({now_, addr, 0}, candidates_);
+  for (const addr_t candidate : candidates_) {
+    prefetch(candidate / tags_.geometry().line_size);
+  }
+}
+
+void L2Cache::prefetch(addr_t line) {
+  const uint64_t start = now_ + config_.hit_latency();
+  uint32_t slot;
+  if (tags_.find(line * tags_.geometry().line_size, slot) ||
+      std::any_of(mshrs_.begin(), mshrs_.end(),
+                  [line](const Mshr &m) {
+                    return m.line == line && !m.writeback;
+                  }) ||
+      mshrs_busy(start) >= config_.mshrs()) {
+    counters_.prefetch_dropped++;
+    return;
+  }
+  counters_.prefetches++;
+  mshrs_.push_back(
+      {line, start, start + config_.miss_latency(), false, false, true});
+}
+
+void L2Cache::fill(const Mshr &mshr) {
+  const addr_t addr = mshr.line * tags_.geometry().line_size;
+  counters_.fills++;
+
+  uint32_t slot;
+  if (!tags_.find(addr, slot)) {
+    slot = tags_.insert(addr);
+    const auto &victim = state_[slot];
+    if (victim.valid) {
+      counters_.evictions++;
+      if (victim.dirty) {
+        counters_.writebacks++;
+        victims_.push_back(victim.line);
+      }
+      counters_.back_invalidations +=
+          static_cast<uint64_t>(config_.inclusive() && victim.in_l1);
+      counters_.prefetch_useless += static_cast<uint64_t>(victim.prefetched);
+    }
+    state_[slot] = {};
+    state_[slot].valid = true;
+    state_[slot].line = mshr.line;
+  }
+
+  state_[slot].dirty |= mshr.dirty;
+  state_[slot].in_l1 |= mshr.in_l1;
+  state_[slot].prefetched = mshr.prefetch;
+}
+
+void L2Cache::report() const {
+  HAL_INFO("--- L2 Cache ({}, {}, {}, {} MSHRs, hit {} / miss {} cycles) ---",
+           tags_.geometry().to_string(),
+           config_.write_back() ? "write-back" : "write-through",
+           config_.inclusive() ? "inclusive" : "non-inclusive",
+           config_.mshrs(), config_.hit_latency(), config_.miss_latency());
+  HAL_INFO("  {:<8} {:>10} {:>10} {:>10} {:>10} {:>8} {:>8}", "source",
+           "reads", "rd_miss", "writes", "wr_miss", "miss%", "avg_lat");
+
+  L2Counters::Source total{"total"};
+  auto row = [](const L2Counters::Source &s) {
+    const uint64_t requests = s.reads + s.writes;
+    const uint64_t misses = s.read_misses + s.write_misses;
+    const double miss_rate =
+        requests > 0 ? 100.0 * static_cast<double>(misses) / requests : 0.0;
+    const double latency =
+        requests > 0 ? static_cast<double>(s.latency) / requests : 0.0;
+    HAL_INFO("  {:<8} {:>10} {:>10} {:>10} {:>10} {:>7.2f}% {:>8.1f}", s.name,
+             s.reads, s.read_misses, s.writes, s.write_misses, miss_rate,
+             latency);
+  };
+  for (const auto &source : counters_.sources) {
+    row(source);
+    total.reads += source.reads;
+    total.writes += source.writes;
+    total.read_misses += source.read_misses;
+    total.write_misses += source.write_misses;
+    total.latency += source.latency;
+  }
+  if (counters_.sources.size() > 1) {
+    row(total);
+  }
+
+  HAL_INFO("  MSHR merges: {}, MSHR stall cycles: {}", counters_.mshr_merges,
+           counters_.mshr_stall_cycles);
+  HAL_INFO("  fills: {}, evictions: {}, writebacks: {}, write-throughs: {}",
+           counters_.fills, counters_.evictions, counters_.writebacks,
+           counters_.write_throughs);
+  if (config_.inclusive()) {
+    HAL_INFO("  back-invalidations: {}", counters_.back_invalidations);
+  }
+  if (prefetcher_) {
+    const uint64_t issued = counters_.prefetches;
+    HAL_INFO("  prefetcher {}: issued {}, useful {} ({} late), useless {}, "
+             "dropped {}, accuracy {:.2f}%",
+             prefetcher_->name(), issued, counters_.prefetch_useful,
+             counters_.prefetch_late, counters_.prefetch_useless,
+             counters_.prefetch_dropped,
+             issued > 0 ? 100.0 * static_cast<double>(
+                                      counters_.prefetch_useful) /
+                              issued
+                        : 0.0);
+  }
+  HAL_INFO("");
+}
+
+auto parse_l2_spec(const std::string &spec, risc::L2Config &config) -> bool {
+  const auto fields = perf::split_spec(spec, ':');
+  if (fields.empty() || fields.size() > 2) {
+    return false;
+  }
+
+  const auto dims = perf::split_spec(fields[0], 'x');
+  uint32_t sets, ways, line_size;
+  if (dims.size() != 3 || !parse_single(dims[0], sets) ||
+      !parse_single(dims[1], ways) || !parse_single(dims[2], line_size)) {
+    return false;
+  }
+
+  risc::L2Config parsed;
+  auto *cache = parsed.mutable_cache();
+  cache->set_sets(sets);
+  cache->set_ways(ways);
+  cache->set_line_size(line_size);
+  cache->set_repl_policy(risc::REPL_POLICY_LRU);
+  parsed.set_write_back(true);
+  parsed.set_inclusive(false);
+  parsed.set_mshrs(8);
+  parsed.set_hit_latency(10);
+  parsed.set_miss_latency(100);
+
+  if (fields.size() == 2) {
+    for (const auto &option : perf::split_spec(fields[1], ',')) {
+      const auto eq = option.find('=');
+      uint32_t value;
+      risc::ReplPolicy policy;
+      if (option == "wb" || option == "wt") {
+        parsed.set_write_back(option == "wb");
+      } else if (option == "incl" || option == "nincl") {
+        parsed.set_inclusive(option == "incl");
+      } else if (eq != std::string::npos) {
+        const auto key = option.substr(0, eq);
+        if (!parse_single(option.substr(eq + 1), value)) {
+          return false;
+        }
+        if (key == "hit") {
+          parsed.set_hit_latency(value);
+        } else if (key == "miss") {
+          parsed.set_miss_latency(value);
+        } else if (key == "mshr") {
+          parsed.set_mshrs(value);
+        } else {
+          return false;
+        }
+      } else if (perf::parse_repl_policy(option, policy)) {
+        cache->set_repl_policy(policy);
+      } else {
+        return false;
+      }
+    }
+  }
+
+  if (!geometry_of(parsed).valid()) {
+    return false;
+  }
+  config = std::move(parsed);
+  return true;
+}
+
+} // namespace demu::hal::cache
@@ -0,0 +1,266 @@
+#include "demu/hal/peripheral/htif/htif.hh"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+namespace demu::hal::htif {
+
+namespace {
+
+constexpr size_t MAX_PATH_LEN = 4096;
+
+auto negate_errno() noexcept -> int_t { return -static_cast<int_t>(errno); }
+
+} // namespace
+
+HTIF::~HTIF() { close_fds(); }
+
+void HTIF::reset() {
+  allocator_->clear();
+  close_fds();
+  exited_ = false;
+  exit_code_ = 0;
+  syscalls_ = 0;
+}
+
+void HTIF::write(addr_t addr, word_t data, byte_t strb) noexcept {
+  for (int i = 0; i < 4; ++i) {
+    if (strb & (1u << i)) {
+      allocator_->write_byte(addr + i,
+                             static_cast<byte_t>((data >> (i * 8)) & 0xFF));
+    }
+  }
+
+  if (to_offset(addr) == HTIF_TOHOST_LO) {
+    const word_t tohost =
+        allocator_->read_word(base_address() + HTIF_TOHOST_LO);
+    if (tohost != 0) {
+      dispatch(tohost);
+    }
+  }
+}
+
+auto HTIF::read(addr_t addr) const noexcept -> word_t {
+  return allocator_->read_word(addr);
+}
+
+void HTIF::dispatch(word_t tohost) noexcept {
+  const addr_t base = base_address();
+  allocator_->write_word(base + HTIF_TOHOST_LO, 0);
+  allocator_->write_word(base + HTIF_TOHOST_HI, 0);
+
+  if (tohost & 1) {
+    request_exit(static_cast<int>(tohost >> 1));
+    return;
+  }
+
+  constexpr size_t block_size = HTIF_MAGIC_WORDS * sizeof(word_t);
+  byte_t *block = guest_ptr(tohost, block_size);
+  if (!block) {
+    HAL_WARN("HTIF: magic_mem at 0x{:08x} is not backed by memory", tohost);
+    return;
+  }
+
+  std::array<word_t, HTIF_MAGIC_WORDS> magic{};
+  std::memcpy(magic.data(), block, block_size);
+
+  const int_t ret = syscall(magic[0], magic.data() + 1);
+  const auto result = static_cast<word_t>(ret);
+  std::memcpy(block, &result, sizeof(result));
+
+  allocator_->write_word(base + HTIF_FROMHOST_LO, 1);
+  allocator_->write_word(base + HTIF_FROMHOST_HI, 0);
+}
+
+void HTIF::request_exit(int code) noexcept {
+  if (exited_) {
+    return;
+  }
+  exited_ = true;
+  exit_code_ = code;
+  HAL_DEBUG("HTIF: exit({}) after {} host calls", code, syscalls_);
+  if (on_exit_) {
+    on_exit_(code);
+  }
+}
+
+auto HTIF::syscall(word_t num, const word_t *args) noexcept -> int_t {
+  ++syscalls_;
+
+  switch (num) {
+  case HTIF_SYS_EXIT:
+    request_exit(static_cast<int>(static_cast<int_t>(args[0])));
+    return 0;
+
+  case HTIF_SYS_WRITE: {
+    const int fd = host_fd(args[0]);
+    if (fd < 0) {
+      return -EBADF;
+    }
+    if (args[2] == 0) {
+      return 0;
+    }
+    const byte_t *buf = guest_ptr(args[1], args[2]);
+    if (!buf) {
+      return -EFAULT;
+    }
+    const ssize_t n = ::write(fd, buf, args[2]);
+    return n < 0 ? negate_errno() : static_cast<int_t>(n);
+  }
+
+  case HTIF_SYS_READ: {
+    const int fd = host_fd(args[0]);
+    if (fd < 0) {
+      return -EBADF;
+    }
+    if (args[2] == 0) {
+      return 0;
+    }
+    byte_t *buf = guest_ptr(args[1], args[2]);
+    if (!buf) {
+      return -EFAULT;
+    }
+    const ssize_t n = ::read(fd, buf, args[2]);
+    return n < 0 ? negate_errno() : static_cast<int_t>(n);
+  }
+
+  case HTIF_SYS_OPENAT: {
+    // Only read-only opens are honoured; the guest must not be able to
+    // create or clobber host files.
+    if ((args[2] & O_ACCMODE) != O_RDONLY) {
+      return -EACCES;
+    }
+
+    std::string path;
+    for (addr_t addr = args[1]; path.size() < MAX_PATH_LEN; ++addr) {
+      const byte_t *c = guest_ptr(addr, 1);
+      if (!c) {
+        return -EFAULT;
+      }
+      if (*c == '\0') {
+        break;
+      }
+      path.push_back(static_cast<char>(*c));
+    }
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return negate_errno();
+    }
+
+    for (size_t i = 0; i < fds_.size(); ++i) {
+      if (fds_[i] < 0) {
+        fds_[i] = fd;
+        return static_cast<int_t>(i + 3);
+      }
+    }
+    fds_.push_back(fd);
+    return static_cast<int_t>(fds_.size() + 2);
+  }
+
+  case HTIF_SYS_CLOSE: {
+    if (args[0] < 3 || args[0] - 3 >= fds_.size() || fds_[args[0] - 3] < 0) {
+      return -EBADF;
+    }
+    const int ret = ::close(fds_[args[0] - 3]);
+    fds_[args[0] - 3] = -1;
+    return ret < 0 ? negate_errno() : 0;
+  }
+
+  case HTIF_SYS_LSEEK: {
+    const int fd = host_fd(args[0]);
+    if (fd < 0) {
+      return -EBADF;
+    }
+    const off_t off =
+        ::lseek(fd, static_cast<int_t>(args[1]), static_cast<int>(args[2]));
+    return off < 0 ? negate_errno() : static_cast<int_t>(off);
+  }
+
+  case HTIF_SYS_CLOCK_GETTIME: {
+    // struct timespec on ilp32: 64-bit tv_sec, 32-bit tv_nsec, padding
+    const clockid_t clk = args[0] == 0 ? CLOCK_REALTIME : CLOCK_MONOTONIC;
+    struct timespec ts {};
+    if (::clock_gettime(clk, &ts) < 0) {
+      return negate_errno();
+    }
+    byte_t *tp = guest_ptr(args[1], 16);
+    if (!tp) {
+      return -EFAULT;
+    }
+    const auto sec = static_cast<uint64_t>(ts.tv_sec);
+    const auto nsec = static_cast<word_t>(ts.tv_nsec);
+    std::memset(tp, 0, 16);
+    std::memcpy(tp, &sec, sizeof(sec));
+    std::memcpy(tp + 8, &nsec, sizeof(nsec));
+    return 0;
+  }
+
+  default:
+    HAL_WARN("HTIF: unsupported host call {}", num);
+    return -ENOSYS;
+  }
+}
+
+auto HTIF::guest_ptr(addr_t addr, size_t len) noexcept -> byte_t * {
+  Device *device =
+      devices_ ? devices_->find_device_for_address(addr) : nullptr;
+  if (!device && owns_address(addr)) {
+    device = this;
+  }
+
+  MemoryAllocator *alloc = device ? device->allocator() : nullptr;
+  if (!alloc || len == 0 || !alloc->is_valid_addr(addr)) {
+    return nullptr;
+  }
+
+  // Bytes left in the region from addr on; compared rather than computing
+  // addr + len, which wraps in addr_t for guest-controlled lengths.
+  const size_t avail = alloc->size() - alloc->to_offset(addr);
+  if (len > avail) {
+    return nullptr;
+  }
+  return alloc->get_ptr(addr);
+}
+
+auto HTIF::host_fd(word_t fd) const noexcept -> int {
+  if (fd < 3) {
+    return static_cast<int>(fd);
+  }
+  if (fd - 3 < fds_.size()) {
+    return fds_[fd - 3];
+  }
+  return -1;
+}
+
+void HTIF::close_fds() noexcept {
+  for (int &fd : fds_) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+  fds_.clear();
+}
+
+void HTIF::dump(addr_t start, size_t size) const noexcept {
+  const addr_t base = base_address();
+  HAL_INFO("--- HTIF Registers Dump [0x{:08X} - 0x{:08X}] ---", start,
+           start + size);
+  HAL_INFO("  TOHOST   : 0x{:08x}{:08x}",
+           allocator_->read_word(base + HTIF_TOHOST_HI),
+           allocator_->read_word(base + HTIF_TOHOST_LO));
+  HAL_INFO("  FROMHOST : 0x{:08x}{:08x}",
+           allocator_->read_word(base + HTIF_FROMHOST_HI),
+           allocator_->read_word(base + HTIF_FROMHOST_LO));
+  HAL_INFO("  CALLS    : {}", syscalls_);
+  if (exited_) {
+    HAL_INFO("  EXIT     : {}", exit_code_);
+  }
+  HAL_INFO("--------------------------------------------------");
+}
+
+} // namespace demu::hal::htif
@@ -0,0 +1,206 @@
+#include "demu/hal/peripheral/uart/console.hh"
+#include "demu/logger.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace demu::hal::uart {
+
+auto parse_flush_policy(const std::string &spec, ConsoleConfig &config)
+    -> bool {
+  const auto colon = spec.find(':');
+  const std::string kind = spec.substr(0, colon);
+  const std::string arg =
+      colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+  try {
+    if (kind == "line") {
+      config.policy = FlushPolicy::LINE;
+    } else if (kind == "size") {
+      config.policy = FlushPolicy::SIZE;
+      if (!arg.empty()) {
+        config.flush_size = std::max<size_t>(1, std::stoull(arg));
+      }
+    } else if (kind == "time") {
+      config.policy = FlushPolicy::TIME;
+      if (!arg.empty()) {
+        config.flush_interval_ms = static_cast<uint32_t>(std::stoul(arg));
+      }
+    } else {
+      return false;
+    }
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+
+Console::Console(const ConsoleConfig &config) : config_(config) {
+  size_t capacity = 64;
+  while (capacity < config_.ring_size) {
+    capacity <<= 1;
+  }
+  ring_.resize(capacity);
+  mask_ = capacity - 1;
+
+  open_output();
+
+  running_.store(true, std::memory_order_release);
+  worker_ = std::thread(&Console::drain_loop, this);
+}
+
+Console::~Console() {
+  running_.store(false, std::memory_order_release);
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  close_output();
+}
+
+void Console::flush() {
+  const uint64_t target = head_.load(std::memory_order_relaxed);
+  while (bytes_written_.load(std::memory_order_acquire) < target) {
+    flush_request_.store(true, std::memory_order_release);
+    std::this_thread::yield();
+  }
+}
+
+void Console::open_output() {
+  const std::string &path = config_.path;
+
+  if (path.empty() || path == "-" || path == "stdout") {
+    fd_ = STDOUT_FILENO;
+  } else if (path == "stderr") {
+    fd_ = STDERR_FILENO;
+  } else if (path[0] == '|') {
+    pipe_ = popen(path.substr(1).c_str(), "w");
+    if (pipe_) {
+      fd_ = fileno(pipe_);
+    }
+  } else {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    owns_fd_ = fd_ >= 0;
+  }
+
+  if (fd_ < 0) {
+    HAL_WARN("UART console: cannot open '{}', falling back to stdout", path);
+    fd_ = STDOUT_FILENO;
+    owns_fd_ = false;
+  }
+}
+
+void Console::close_output() {
+  if (pipe_) {
+    pclose(pipe_);
+    pipe_ = nullptr;
+  } else if (owns_fd_) {
+    ::close(fd_);
+  }
+  fd_ = -1;
+  owns_fd_ = false;
+}
+
+void Console::wait_for_space(size_t head) noexcept {
+  tail_cache_ = tail_.load(std::memory_order_acquire);
+  while (head - tail_cache_ > mask_) {
+    std::this_thread::yield();
+    tail_cache_ = tail_.load(std::memory_order_acquire);
+  }
+}
+
+void Console::drain_loop() {
+  using clock = std::chrono::steady_clock;
+
+  std::vector<byte_t> pending;
+  pending.reserve(std::max<size_t>(config_.flush_size, 256));
+
+  // Age of the oldest byte still held, so the interval bounds how long any
+  // byte waits rather than the gap since the previous write
+  const auto interval = std::chrono::milliseconds(config_.flush_interval_ms);
+  auto first_pending = clock::now();
+
+  auto write_pending = [&](size_t count) {
+    if (count == 0) {
+      return;
+    }
+    write_out(pending.data(), count);
+    pending.erase(pending.begin(), pending.begin() + count);
+    first_pending = clock::now();
+  };
+
+  while (true) {
+    const bool running = running_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+
+    if (pending.empty() && tail != head) {
+      first_pending = clock::now();
+    }
+    for (size_t i = tail; i != head; ++i) {
+      pending.push_back(ring_[i & mask_]);
+    }
+    tail_.store(head, std::memory_order_release);
+
+    const bool force =
+        !running || flush_request_.exchange(false, std::memory_order_acq_rel);
+
+    if (force) {
+      write_pending(pending.size());
+    } else {
+      switch (config_.policy) {
+      case FlushPolicy::LINE: {
+        auto it = std::find(pending.rbegin(), pending.rend(), '\n');
+        if (it != pending.rend()) {
+          write_pending(static_cast<size_t>(pending.rend() - it));
+        } else if (pending.size() >= config_.flush_size ||
+                   clock::now() - first_pending >= interval) {
+          // a prompt without '\n' must not wait for the next line
+          write_pending(pending.size());
+        }
+        break;
+      }
+      case FlushPolicy::SIZE:
+        if (pending.size() >= config_.flush_size) {
+          write_pending(pending.size());
+        }
+        break;
+      case FlushPolicy::TIME:
+        if (!pending.empty() && clock::now() - first_pending >= interval) {
+          write_pending(pending.size());
+        }
+        break;
+      }
+    }
+
+    if (!running) {
+      if (head_.load(std::memory_order_acquire) == head) {
+        break;
+      }
+      continue;
+    }
+
+    if (head == tail) {
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+  }
+}
+
+void Console::write_out(const byte_t *data, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = ::write(fd_, data + done, size - done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  bytes_written_.fetch_add(size, std::memory_order_release);
+}
+
+} // namespace demu::hal::uart
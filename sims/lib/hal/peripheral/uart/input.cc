@@ -0,0 +1,249 @@
+#include "demu/hal/peripheral/uart/input.hh"
+#include "demu/logger.hh"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <unistd.h>
+
+namespace demu::hal::uart {
+
+namespace {
+
+// Expands \n, \r, \t, \0, \\ and \xHH in scripted payloads
+auto unescape(const std::string &s) -> std::string {
+  std::string out;
+  out.reserve(s.size());
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s[i] != '\\' || i + 1 >= s.size()) {
+      out.push_back(s[i]);
+      continue;
+    }
+    const char e = s[++i];
+    switch (e) {
+    case 'n':
+      out.push_back('\n');
+      break;
+    case 'r':
+      out.push_back('\r');
+      break;
+    case 't':
+      out.push_back('\t');
+      break;
+    case '0':
+      out.push_back('\0');
+      break;
+    case 'x':
+      if (i + 2 < s.size()) {
+        out.push_back(static_cast<char>(
+            std::strtoul(s.substr(i + 1, 2).c_str(), nullptr, 16)));
+        i += 2;
+      }
+      break;
+    default:
+      out.push_back(e);
+      break;
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+auto parse_input_source(const std::string &spec, InputConfig &config) -> bool {
+  const auto colon = spec.find(':');
+  const std::string kind = spec.substr(0, colon);
+  const std::string path =
+      colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+  if (kind == "stdin" || kind == "-") {
+    config.kind = InputKind::STDIN;
+  } else if (kind == "pty") {
+    config.kind = InputKind::PTY;
+  } else if (kind == "file") {
+    config.kind = InputKind::FILE;
+  } else if (kind == "fifo") {
+    config.kind = InputKind::FIFO;
+  } else if (kind == "script") {
+    config.kind = InputKind::SCRIPT;
+  } else {
+    return false;
+  }
+
+  config.path = path;
+  const bool needs_path = config.kind == InputKind::FILE ||
+                          config.kind == InputKind::FIFO ||
+                          config.kind == InputKind::SCRIPT;
+  return !needs_path || !path.empty();
+}
+
+InputSource::InputSource(const InputConfig &config) : config_(config) {
+  if (config_.kind == InputKind::NONE) {
+    return;
+  }
+
+  if (config_.kind == InputKind::SCRIPT) {
+    load_script();
+    return;
+  }
+
+  size_t capacity = 64;
+  while (capacity < config_.ring_size) {
+    capacity <<= 1;
+  }
+  ring_.resize(capacity);
+  mask_ = capacity - 1;
+
+  if (!open_stream()) {
+    return;
+  }
+
+  running_.store(true, std::memory_order_release);
+  reader_ = std::thread(&InputSource::read_loop, this);
+}
+
+InputSource::~InputSource() {
+  running_.store(false, std::memory_order_release);
+  if (reader_.joinable()) {
+    reader_.join();
+  }
+  if (owns_fd_) {
+    ::close(fd_);
+  }
+}
+
+auto InputSource::open_stream() -> bool {
+  switch (config_.kind) {
+  case InputKind::STDIN:
+    fd_ = STDIN_FILENO;
+    break;
+  case InputKind::FILE:
+    fd_ = ::open(config_.path.c_str(), O_RDONLY);
+    owns_fd_ = fd_ >= 0;
+    break;
+  case InputKind::FIFO:
+    // O_RDWR keeps the FIFO from reporting EOF while no writer is attached
+    fd_ = ::open(config_.path.c_str(), O_RDWR | O_NONBLOCK);
+    owns_fd_ = fd_ >= 0;
+    break;
+  case InputKind::PTY:
+    fd_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd_ >= 0 && ::grantpt(fd_) == 0 && ::unlockpt(fd_) == 0) {
+      owns_fd_ = true;
+      pty_name_ = ::ptsname(fd_);
+      HAL_INFO("UART RX attached to PTY {}", pty_name_);
+    } else if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    break;
+  default:
+    break;
+  }
+
+  if (fd_ < 0) {
+    HAL_WARN("UART RX: cannot open input source '{}'", config_.path);
+    return false;
+  }
+  return true;
+}
+
+auto InputSource::load_script() -> bool {
+  std::ifstream file(config_.path);
+  if (!file.is_open()) {
+    HAL_WARN("UART RX: cannot open input script '{}'", config_.path);
+    return false;
+  }
+
+  std::string line;
+  size_t lineno = 0;
+  uint64_t last_cycle = 0;
+  while (std::getline(file, line)) {
+    ++lineno;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    std::istringstream ss(line);
+    uint64_t cycle = 0;
+    if (!(ss >> cycle)) {
+      HAL_WARN("UART RX: {}:{}: expected '<cycle> <payload>'", config_.path,
+               lineno);
+      continue;
+    }
+    if (cycle < last_cycle) {
+      HAL_WARN("UART RX: {}:{}: cycle {} is earlier than {}", config_.path,
+               lineno, cycle, last_cycle);
+      cycle = last_cycle;
+    }
+    last_cycle = cycle;
+
+    std::string payload;
+    std::getline(ss >> std::ws, payload);
+    script_.emplace_back(cycle, unescape(payload));
+  }
+
+  HAL_DEBUG("UART RX: loaded {} scripted input entries from '{}'",
+            script_.size(), config_.path);
+  return true;
+}
+
+auto InputSource::poll_script(uint64_t cycle, byte_t &c) noexcept -> bool {
+  auto &[entry, offset] = script_pos_;
+  while (entry < script_.size()) {
+    const auto &[at, payload] = script_[entry];
+    if (at > cycle) {
+      return false;
+    }
+    if (offset < payload.size()) {
+      c = static_cast<byte_t>(payload[offset++]);
+      return true;
+    }
+    ++entry;
+    offset = 0;
+  }
+  return false;
+}
+
+void InputSource::read_loop() {
+  byte_t buf[256];
+
+  while (running_.load(std::memory_order_acquire)) {
+    pollfd pfd{fd_, POLLIN, 0};
+    const int ready = ::poll(&pfd, 1, 50);
+    if (ready <= 0 || !(pfd.revents & (POLLIN | POLLHUP))) {
+      continue;
+    }
+
+    const ssize_t n = ::read(fd_, buf, sizeof(buf));
+    if (n == 0 && config_.kind != InputKind::PTY) {
+      HAL_DEBUG("UART RX: end of input on '{}'", config_.path);
+      break;
+    }
+    if (n <= 0) {
+      if (n < 0 && errno != EAGAIN && errno != EINTR && errno != EIO) {
+        break;
+      }
+      // PTY master reports EIO while no client holds the slave open
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      continue;
+    }
+
+    for (ssize_t i = 0; i < n; ++i) {
+      const size_t head = head_.load(std::memory_order_relaxed);
+      while (head - tail_.load(std::memory_order_acquire) > mask_) {
+        if (!running_.load(std::memory_order_acquire)) {
+          return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+      ring_[head & mask_] = buf[i];
+      head_.store(head + 1, std::memory_order_release);
+    }
+  }
+}
+
+} // namespace demu::hal::uart
@@ -5,10 +5,73 @@ namespace demu::hal::uart {
 void UART::reset() {
   allocator_->clear();
   allocator_->write_word(base_address() + UART_TXC, 0x00000000);
+  input_->rewind();
+  ticks_ = 0;
+
+  if (rx_line_) {
+    rx_line_->deassert_line();
+  }
 }
 
 void UART::clock_tick() {
-  // placeholder
+  const addr_t base = base_address();
+  word_t rxc = allocator_->read_word(base + UART_RXC);
+
+  byte_t c;
+  if (!(rxc & UART_RXC_VALID) && input_->poll(ticks_, c)) {
+    allocator_->write_word(base + UART_RXD, c);
+    rxc |= UART_RXC_VALID;
+    allocator_->write_word(base + UART_RXC, rxc);
+  }
+
+  if (rx_line_) {
+    rx_line_->set_level((rxc & UART_RXC_VALID) && (rxc & UART_RXC_IE));
+  }
+
+  ticks_++;
+}
+
+void UART::write(addr_t addr, word_t data, byte_t strb) noexcept {
+  const addr_t offset = to_offset(addr);
+
+  if (offset == UART_TXD) {
+    transmit(static_cast<byte_t>(data & 0xFF));
+    return;
+  }
+
+  if (offset == UART_RXC) {
+    // Only the enable bits are writable, VALID is owned by the receiver
+    const word_t rxc = allocator_->read_word(addr);
+    word_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+      if (strb & (1u << i)) {
+        mask |= 0xFFu << (i * 8);
+      }
+    }
+    mask &= ~UART_RXC_VALID;
+    allocator_->write_word(addr, (rxc & ~mask) | (data & mask));
+    return;
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    if (strb & (1u << i)) {
+      allocator_->write_byte(addr + i,
+                             static_cast<byte_t>((data >> (i * 8)) & 0xFF));
+    }
+  }
+}
+
+auto UART::read(addr_t addr) noexcept -> word_t {
+  const word_t data = allocator_->read_word(addr);
+
+  if (to_offset(addr) == UART_RXD) {
+    // Reading RXD consumes the byte, the next one is latched on the next tick
+    const addr_t rxc_addr = base_address() + UART_RXC;
+    allocator_->write_word(rxc_addr,
+                           allocator_->read_word(rxc_addr) & ~UART_RXC_VALID);
+  }
+
+  return data;
 }
 
 void UART::dump(addr_t start, size_t size) const noexcept {
@@ -27,12 +90,24 @@ void UART::dump(addr_t start, size_t size) const noexcept {
     }
   };
 
+  if (overlaps(base + UART_RXD, 4)) {
+    print_header_once();
+    uint32_t rxd = allocator_->read_word(base + UART_RXD);
+    HAL_INFO("  RXDATA   : 0x{:08x}", rxd);
+  }
+
   if (overlaps(base + UART_TXC, 4)) {
     print_header_once();
     uint32_t txc = allocator_->read_word(base + UART_TXC);
     HAL_INFO("  TXCTRL   : 0x{:08x}", txc);
   }
 
+  if (overlaps(base + UART_RXC, 4)) {
+    print_header_once();
+    uint32_t rxc = allocator_->read_word(base + UART_RXC);
+    HAL_INFO("  RXCTRL   : 0x{:08x}", rxc);
+  }
+
   if (overlaps(base + UART_BAUDIV, 4)) {
     print_header_once();
     uint32_t div = allocator_->read_word(base + UART_BAUDIV);
@@ -0,0 +1,188 @@
+#include "demu/host_profile.hh"
+#include "demu/logger.hh"
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace demu {
+
+namespace {
+
+// perf_event_open(2) configs, in HostCounters field order
+constexpr std::array<std::pair<uint32_t, uint64_t>, 4> PERF_EVENTS = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+
+auto perf_event_open(perf_event_attr *attr, pid_t tid) -> int {
+  return static_cast<int>(syscall(SYS_perf_event_open, attr, tid, -1, -1, 0));
+}
+
+// Threads of this process; the Verilator pool, the FST writer and the
+// difftest worker are all running by the time the loop starts
+auto process_threads() -> std::vector<pid_t> {
+  std::vector<pid_t> tids;
+  DIR *dir = opendir("/proc/self/task");
+  if (!dir) {
+    tids.push_back(0);
+    return tids;
+  }
+  while (const dirent *entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      tids.push_back(
+          static_cast<pid_t>(std::strtol(entry->d_name, nullptr, 10)));
+    }
+  }
+  closedir(dir);
+  return tids;
+}
+
+auto ratio(uint64_t a, uint64_t b) noexcept -> double {
+  return b > 0 ? static_cast<double>(a) / static_cast<double>(b) : 0.0;
+}
+
+} // namespace
+
+auto host_phase_name(HostPhase phase) noexcept -> const char * {
+  switch (phase) {
+  case HostPhase::PORTS:
+    return "ports";
+  case HostPhase::EVAL_NEGEDGE:
+    return "eval_negedge";
+  case HostPhase::EVAL_POSEDGE:
+    return "eval_posedge";
+  case HostPhase::L2:
+    return "l2";
+  case HostPhase::DEVICES:
+    return "devices";
+  case HostPhase::PROBES:
+    return "probes";
+  case HostPhase::RETIRE:
+    return "retire";
+  case HostPhase::PROFILING:
+    return "profiling";
+  case HostPhase::HOOK:
+    return "hook";
+  case HostPhase::TRACE:
+    return "trace";
+  case HostPhase::COUNT:
+    break;
+  }
+  return "unknown";
+}
+
+HostProfiler::~HostProfiler() { close_counters(); }
+
+void HostProfiler::start() {
+  countdown_ = 1;
+  samples_ = 0;
+  ticks_.fill(0);
+  counters_ = {};
+  start_ticks_ = now();
+  start_time_ = std::chrono::steady_clock::now();
+  if (hw_counters_) {
+    open_counters();
+  }
+}
+
+void HostProfiler::stop() {
+  const uint64_t ticks = now() - start_ticks_;
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start_time_)
+                        .count();
+  ns_per_tick_ = ticks > 0 ? ns / static_cast<double>(ticks) : 1.0;
+
+  if (!perf_fds_.empty()) {
+    uint64_t *fields[] = {&counters_.cycles, &counters_.instructions,
+                          &counters_.llc_misses, &counters_.branch_misses};
+    counters_.valid = true;
+    counters_.threads = static_cast<uint32_t>(perf_fds_.size() /
+                                              PERF_EVENTS.size());
+    for (size_t i = 0; i < perf_fds_.size(); ++i) {
+      uint64_t value = 0;
+      ioctl(perf_fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(perf_fds_[i], &value, sizeof(value)) != sizeof(value)) {
+        counters_.valid = false;
+      }
+      *fields[i % PERF_EVENTS.size()] += value;
+    }
+  }
+  close_counters();
+}
+
+void HostProfiler::open_counters() {
+  close_counters();
+  for (const pid_t tid : process_threads()) {
+    for (const auto &[type, config] : PERF_EVENTS) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      const int fd = perf_event_open(&attr, tid);
+      if (fd < 0) {
+        DEMU_WARN("Host counters unavailable ({}); see "
+                  "/proc/sys/kernel/perf_event_paranoid",
+                  std::strerror(errno));
+        close_counters();
+        return;
+      }
+      perf_fds_.push_back(fd);
+    }
+  }
+  for (const int fd : perf_fds_) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void HostProfiler::close_counters() noexcept {
+  for (const int fd : perf_fds_) {
+    ::close(fd);
+  }
+  perf_fds_.clear();
+}
+
+auto HostProfiler::phase_ns(HostPhase phase) const noexcept -> double {
+  return samples_ > 0 ? static_cast<double>(
+                            ticks_[static_cast<size_t>(phase)]) *
+                            ns_per_tick_ / static_cast<double>(samples_)
+                      : 0.0;
+}
+
+void HostProfiler::report() const {
+  double total = 0;
+  for (size_t p = 0; p < NUM_PHASES; ++p) {
+    total += phase_ns(static_cast<HostPhase>(p));
+  }
+
+  DEMU_INFO("--- Host Profile ({} ticks timed, 1 in {}) ---", samples_,
+            every_);
+  DEMU_INFO("  {:<14} {:>10} {:>7}", "phase", "ns/tick", "share");
+  for (size_t p = 0; p < NUM_PHASES; ++p) {
+    const auto phase = static_cast<HostPhase>(p);
+    const double ns = phase_ns(phase);
+    DEMU_INFO("  {:<14} {:>10.1f} {:>6.1f}%", host_phase_name(phase), ns,
+              total > 0 ? 100.0 * ns / total : 0.0);
+  }
+  DEMU_INFO("  {:<14} {:>10.1f}", "total", total);
+  if (counters_.valid) {
+    DEMU_INFO("  host IPC: {:.3f}  LLC misses: {}  branch misses: {} "
+              "({} threads)",
+              ratio(counters_.instructions, counters_.cycles),
+              counters_.llc_misses, counters_.branch_misses,
+              counters_.threads);
+  }
+  DEMU_INFO("")
+}
+
+} // namespace demu
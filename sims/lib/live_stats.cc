@@ -0,0 +1,195 @@
+#include "demu/live_stats.hh"
+#include "demu/logger.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace demu {
+
+namespace {
+
+constexpr char SEGMENT_PREFIX[] = "demu-";
+
+auto now_ns() noexcept -> uint64_t {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+template <size_t N> void copy_string(char (&dst)[N], const std::string &src) {
+  const size_t n = std::min(src.size(), N - 1);
+  std::memcpy(dst, src.data(), n);
+  dst[n] = '\0';
+}
+
+} // namespace
+
+auto LiveSnapshot::counter(uint64_t PerfCounters::*member) const noexcept
+    -> uint64_t {
+  for (size_t k = 0; k < PERF_COUNTER_FIELDS.size(); ++k) {
+    if (PERF_COUNTER_FIELDS[k].member == member) {
+      return counters[k];
+    }
+  }
+  return 0;
+}
+
+auto LiveStatsWriter::open(const std::string &program,
+                           const std::string &isa, uint64_t period) -> bool {
+  close();
+  name_ = "/" + std::string(SEGMENT_PREFIX) + std::to_string(getpid());
+  const int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  void *addr = MAP_FAILED;
+  if (ftruncate(fd, sizeof(LiveStatsPage)) == 0) {
+    addr = mmap(nullptr, sizeof(LiveStatsPage), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(name_.c_str());
+    return false;
+  }
+  page_ = new (addr) LiveStatsPage();
+
+  snapshot_ = {};
+  snapshot_.pid = static_cast<int32_t>(getpid());
+  snapshot_.period = period;
+  snapshot_.start_ns = now_ns();
+  copy_string(snapshot_.isa, isa);
+  copy_string(snapshot_.program, program);
+  last_cycles_ = 0;
+  last_ns_ = snapshot_.start_ns;
+  publish({});
+  return true;
+}
+
+void LiveStatsWriter::publish(const PerfCounters &counters, LiveState state,
+                              int exit_code) noexcept {
+  if (!page_) {
+    return;
+  }
+  const uint64_t ns = now_ns();
+  if (ns > last_ns_ && counters.cycles >= last_cycles_) {
+    snapshot_.khz = static_cast<double>(counters.cycles - last_cycles_) /
+                    static_cast<double>(ns - last_ns_) * 1e6;
+  }
+  last_cycles_ = counters.cycles;
+  last_ns_ = ns;
+
+  snapshot_.state = state;
+  snapshot_.exit_code = exit_code;
+  snapshot_.update_ns = ns;
+  for (size_t k = 0; k < PERF_COUNTER_FIELDS.size(); ++k) {
+    snapshot_.counters[k] = counters.*PERF_COUNTER_FIELDS[k].member;
+  }
+
+  const uint64_t seq = page_->seq.load(std::memory_order_relaxed);
+  page_->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&page_->snapshot, &snapshot_, sizeof(LiveSnapshot));
+  page_->seq.store(seq + 2, std::memory_order_release);
+}
+
+void LiveStatsWriter::close() noexcept {
+  if (!page_) {
+    return;
+  }
+  munmap(page_, sizeof(LiveStatsPage));
+  shm_unlink(name_.c_str());
+  page_ = nullptr;
+}
+
+auto LiveStatsReader::attach(const std::string &name) -> bool {
+  detach();
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  // The writer sizes the segment after creating it; mapping it before then
+  // would fault on the first read
+  struct stat st {};
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(LiveStatsPage)) {
+    ::close(fd);
+    return false;
+  }
+  void *addr = mmap(nullptr, sizeof(LiveStatsPage), PROT_READ, MAP_SHARED,
+                    fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  page_ = static_cast<const LiveStatsPage *>(addr);
+  if (page_->magic != LiveStatsPage::MAGIC ||
+      page_->version != LiveStatsPage::VERSION) {
+    detach();
+    return false;
+  }
+  return true;
+}
+
+void LiveStatsReader::detach() noexcept {
+  if (page_) {
+    munmap(const_cast<LiveStatsPage *>(page_), sizeof(LiveStatsPage));
+    page_ = nullptr;
+  }
+}
+
+auto LiveStatsReader::read(LiveSnapshot &out) const noexcept -> bool {
+  if (!page_) {
+    return false;
+  }
+  for (int attempt = 0; attempt < 1000; ++attempt) {
+    const uint64_t before = page_->seq.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue;
+    }
+    std::memcpy(&out, &page_->snapshot, sizeof(LiveSnapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (page_->seq.load(std::memory_order_relaxed) == before) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto LiveStatsReader::list() -> std::vector<std::string> {
+  std::vector<std::string> names;
+  DIR *dir = opendir("/dev/shm");
+  if (!dir) {
+    return names;
+  }
+  while (const dirent *entry = readdir(dir)) {
+    if (std::strncmp(entry->d_name, SEGMENT_PREFIX,
+                     sizeof(SEGMENT_PREFIX) - 1) != 0) {
+      continue;
+    }
+    const std::string name = "/" + std::string(entry->d_name);
+    // A writer that crashed never unlinked its segment; drop it once its
+    // pid is gone so it does not linger as a run that stopped updating
+    const long pid =
+        std::strtol(entry->d_name + sizeof(SEGMENT_PREFIX) - 1, nullptr, 10);
+    if (pid > 0 && kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) {
+      shm_unlink(name.c_str());
+      continue;
+    }
+    names.push_back(name);
+  }
+  closedir(dir);
+  return names;
+}
+
+} // namespace demu
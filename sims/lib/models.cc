@@ -0,0 +1,66 @@
+#include "demu/models.hh"
+#include "demu/logger.hh"
+#include <filesystem>
+
+namespace demu {
+
+namespace {
+
+template <typename DUT> auto make_model(VerilatedContext *context) -> model_t {
+  return std::make_unique<DUT>(context, "TOP");
+}
+
+} // namespace
+
+auto models() -> const std::vector<ModelInfo> & {
+  static const std::vector<ModelInfo> linked = {
+#ifdef DEMU_MODEL_RV32I
+      {"rv32i", false, make_model<Vrv32i_system>},
+#ifdef DEMU_INSTRUMENTED_MODEL
+      {"rv32i", true, make_model<Vrv32i_system_inst>},
+#endif
+#endif
+#ifdef DEMU_MODEL_RV32IM
+      {"rv32im", false, make_model<Vrv32im_system>},
+#ifdef DEMU_INSTRUMENTED_MODEL
+      {"rv32im", true, make_model<Vrv32im_system_inst>},
+#endif
+#endif
+  };
+  return linked;
+}
+
+auto find_model(std::string_view name, bool instrumented)
+    -> const ModelInfo * {
+  if (name.empty()) {
+    name = DEMU_DEFAULT_MODEL;
+  }
+  for (const auto &model : models()) {
+    if (model.name == name && model.instrumented == instrumented) {
+      return &model;
+    }
+  }
+  return nullptr;
+}
+
+auto model_names() -> std::string {
+  std::string names;
+  for (const auto &model : models()) {
+    if (model.instrumented) {
+      continue;
+    }
+    if (!names.empty()) {
+      names += ", ";
+    }
+    names += model.name;
+  }
+  return names;
+}
+
+auto model_config_path(const ModelInfo &model) -> std::string {
+  const std::string own =
+      fmt::format("{}/{}_config.json", RTL_DIR, model.name);
+  return std::filesystem::exists(own) ? own : RTL_CONFIG_FILE;
+}
+
+} // namespace demu
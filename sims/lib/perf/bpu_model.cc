@@ -0,0 +1,433 @@
+#include "demu/perf/bpu_model.hh"
+#include "demu/perf/sweep.hh"
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace demu::perf {
+
+namespace {
+
+// 2-bit counters, initialised weakly taken like the RTL PHT
+constexpr uint8_t CTR_WT = 2;
+constexpr uint8_t CTR_MAX = 3;
+
+inline auto sat_update(uint8_t ctr, bool taken) noexcept -> uint8_t {
+  if (taken) {
+    return ctr == CTR_MAX ? CTR_MAX : ctr + 1;
+  }
+  return ctr == 0 ? 0 : ctr - 1;
+}
+
+inline auto counter_taken(uint8_t ctr) noexcept -> bool { return ctr >= 2; }
+
+// GShare::foldPc: XOR of `width`-bit chunks of pc[XLEN-1:2]
+auto fold_pc(addr_t pc, uint32_t width) noexcept -> uint32_t {
+  uint32_t folded = 0;
+  for (uint32_t lo = 2; lo < 32; lo += width) {
+    folded ^= (pc >> lo) & ((1u << width) - 1);
+  }
+  return folded;
+}
+
+// XOR-folds the newest `length` history bits down to `bits` bits
+auto fold_history(uint64_t history, uint32_t length, uint32_t bits) noexcept
+    -> uint32_t {
+  if (length < 64) {
+    history &= (uint64_t{1} << length) - 1;
+  }
+  uint32_t folded = 0;
+  for (uint32_t i = 0; i < length; i += bits) {
+    folded ^= static_cast<uint32_t>(history >> i) & ((1u << bits) - 1);
+  }
+  return folded;
+}
+
+inline auto outcome(bool mispredict) noexcept -> BranchPredictor::Outcome {
+  return mispredict ? BranchPredictor::Outcome::MISPREDICT
+                    : BranchPredictor::Outcome::CORRECT;
+}
+
+} // namespace
+
+// Bimodal
+
+BimodalPredictor::BimodalPredictor(uint32_t index_bits)
+    : bits_(index_bits), pht_(size_t{1} << index_bits, CTR_WT) {}
+
+auto BimodalPredictor::name() const -> std::string {
+  return fmt::format("bimodal-{}", bits_);
+}
+
+auto BimodalPredictor::predict(const BranchRecord &br) noexcept -> Outcome {
+  if (br.kind != BranchKind::COND) {
+    return Outcome::IGNORED;
+  }
+  uint8_t &ctr = pht_[(br.pc >> 2) & (pht_.size() - 1)];
+  const bool mispredict = counter_taken(ctr) != br.taken;
+  ctr = sat_update(ctr, br.taken);
+  return outcome(mispredict);
+}
+
+void BimodalPredictor::reset() noexcept {
+  std::fill(pht_.begin(), pht_.end(), CTR_WT);
+}
+
+// GShare
+
+GSharePredictor::GSharePredictor(uint32_t ghr_width)
+    : width_(ghr_width), pht_(size_t{1} << ghr_width, CTR_WT) {}
+
+auto GSharePredictor::name() const -> std::string {
+  return fmt::format("gshare-{}", width_);
+}
+
+auto GSharePredictor::predict(const BranchRecord &br) noexcept -> Outcome {
+  if (br.kind != BranchKind::COND) {
+    return Outcome::IGNORED;
+  }
+  const uint32_t mask = (1u << width_) - 1;
+  uint8_t &ctr = pht_[(fold_pc(br.pc, width_) ^ ghr_) & mask];
+  const bool mispredict = counter_taken(ctr) != br.taken;
+  ctr = sat_update(ctr, br.taken);
+  ghr_ = ((ghr_ << 1) | static_cast<uint32_t>(br.taken)) & mask;
+  return outcome(mispredict);
+}
+
+void GSharePredictor::reset() noexcept {
+  std::fill(pht_.begin(), pht_.end(), CTR_WT);
+  ghr_ = 0;
+}
+
+// TAGE
+
+TagePredictor::TagePredictor() : base_(size_t{1} << BASE_BITS, CTR_WT) {
+  for (auto &table : tables_) {
+    table.resize(size_t{1} << TABLE_BITS);
+  }
+}
+
+auto TagePredictor::index(size_t t, addr_t pc) const noexcept -> uint32_t {
+  const uint32_t mask = (1u << TABLE_BITS) - 1;
+  return ((pc >> 2) ^ (pc >> (2 + TABLE_BITS)) ^
+          fold_history(history_, HISTORY[t], TABLE_BITS)) &
+         mask;
+}
+
+auto TagePredictor::tag(size_t t, addr_t pc) const noexcept -> uint16_t {
+  const uint32_t mask = (1u << TAG_BITS) - 1;
+  return static_cast<uint16_t>(
+      ((pc >> 2) ^ fold_history(history_, HISTORY[t], TAG_BITS) ^
+       (fold_history(history_, HISTORY[t], TAG_BITS - 1) << 1)) &
+      mask);
+}
+
+auto TagePredictor::predict(const BranchRecord &br) noexcept -> Outcome {
+  if (br.kind != BranchKind::COND) {
+    return Outcome::IGNORED;
+  }
+
+  std::array<uint32_t, TABLES> idx;
+  std::array<uint16_t, TABLES> tags;
+  int provider = -1;
+  int alt = -1;
+  for (size_t t = 0; t < TABLES; ++t) {
+    idx[t] = index(t, br.pc);
+    tags[t] = tag(t, br.pc);
+  }
+  for (int t = TABLES - 1; t >= 0; --t) {
+    const Entry &e = tables_[t][idx[t]];
+    if (e.valid && e.tag == tags[t]) {
+      if (provider < 0) {
+        provider = t;
+      } else {
+        alt = t;
+        break;
+      }
+    }
+  }
+
+  uint8_t &base = base_[(br.pc >> 2) & (base_.size() - 1)];
+  const bool base_pred = counter_taken(base);
+  const bool alt_pred = alt >= 0 ? tables_[alt][idx[alt]].ctr >= 0 : base_pred;
+  const bool pred =
+      provider >= 0 ? tables_[provider][idx[provider]].ctr >= 0 : base_pred;
+  const bool mispredict = pred != br.taken;
+
+  if (provider >= 0) {
+    Entry &e = tables_[provider][idx[provider]];
+    if (br.taken) {
+      e.ctr = static_cast<int8_t>(e.ctr < 3 ? e.ctr + 1 : 3);
+    } else {
+      e.ctr = static_cast<int8_t>(e.ctr > -4 ? e.ctr - 1 : -4);
+    }
+    if (pred != alt_pred) {
+      if (!mispredict) {
+        e.useful = static_cast<uint8_t>(e.useful < 3 ? e.useful + 1 : 3);
+      } else if (e.useful > 0) {
+        e.useful--;
+      }
+    }
+  } else {
+    base = sat_update(base, br.taken);
+  }
+
+  // Allocate one longer-history entry after a mispredict, starting at a
+  // pseudo-random table among the candidates to spread allocations
+  if (mispredict && provider < static_cast<int>(TABLES) - 1) {
+    alloc_rng_ = alloc_rng_ * 1103515245u + 12345u;
+    const auto first = static_cast<size_t>(provider + 1);
+    size_t start = first;
+    if (first + 1 < TABLES && (alloc_rng_ >> 16) & 1) {
+      start++;
+    }
+    bool allocated = false;
+    for (size_t t = start; t < TABLES; ++t) {
+      Entry &e = tables_[t][idx[t]];
+      if (e.useful == 0) {
+        e = {true, tags[t], static_cast<int8_t>(br.taken ? 0 : -1), 0};
+        allocated = true;
+        break;
+      }
+    }
+    if (!allocated) {
+      for (size_t t = first; t < TABLES; ++t) {
+        Entry &e = tables_[t][idx[t]];
+        if (e.useful > 0) {
+          e.useful--;
+        }
+      }
+    }
+  }
+
+  if (++branches_ % AGING_PERIOD == 0) {
+    for (auto &table : tables_) {
+      for (auto &e : table) {
+        e.useful >>= 1;
+      }
+    }
+  }
+
+  history_ = (history_ << 1) | static_cast<uint64_t>(br.taken);
+  return outcome(mispredict);
+}
+
+void TagePredictor::reset() noexcept {
+  std::fill(base_.begin(), base_.end(), CTR_WT);
+  for (auto &table : tables_) {
+    std::fill(table.begin(), table.end(), Entry{});
+  }
+  history_ = 0;
+  branches_ = 0;
+  alloc_rng_ = 1;
+}
+
+// BTB
+
+BtbPredictor::BtbPredictor(uint32_t sets, uint32_t ways,
+                           risc::ReplPolicy policy)
+    : table_({sets, ways, 4, policy}), targets_(table_.slots(), 0) {}
+
+auto BtbPredictor::name() const -> std::string {
+  const CacheGeometry &g = table_.geometry();
+  return fmt::format("btb-{}x{}-{}", g.sets, g.ways,
+                     repl_policy_name(g.policy));
+}
+
+auto BtbPredictor::predict(const BranchRecord &br) noexcept -> Outcome {
+  if (!br.taken) {
+    return Outcome::IGNORED;
+  }
+  uint32_t slot;
+  const bool hit = table_.find(br.pc, slot);
+  const bool mispredict = !hit || targets_[slot] != br.target;
+  targets_[table_.insert(br.pc)] = br.target;
+  return outcome(mispredict);
+}
+
+void BtbPredictor::reset() noexcept {
+  table_.reset();
+  std::fill(targets_.begin(), targets_.end(), 0);
+}
+
+// RAS
+
+RasPredictor::RasPredictor(uint32_t depth) : stack_(depth, 0) {}
+
+auto RasPredictor::name() const -> std::string {
+  return fmt::format("ras-{}", stack_.size());
+}
+
+auto RasPredictor::predict(const BranchRecord &br) noexcept -> Outcome {
+  const auto depth = static_cast<uint32_t>(stack_.size());
+  if (br.kind == BranchKind::CALL) {
+    top_ = (top_ + 1) % depth;
+    stack_[top_] = br.pc + 4;
+    size_ = std::min(size_ + 1, depth);
+    return Outcome::IGNORED;
+  }
+  if (br.kind != BranchKind::RET) {
+    return Outcome::IGNORED;
+  }
+  if (size_ == 0) {
+    return Outcome::MISPREDICT;
+  }
+  const addr_t predicted = stack_[top_];
+  top_ = (top_ + depth - 1) % depth;
+  size_--;
+  return outcome(predicted != br.target);
+}
+
+void RasPredictor::reset() noexcept {
+  std::fill(stack_.begin(), stack_.end(), 0);
+  top_ = 0;
+  size_ = 0;
+}
+
+// RTL front end
+
+RtlPredictor::RtlPredictor(uint32_t btb_sets, uint32_t btb_ways,
+                           risc::ReplPolicy policy, uint32_t ghr_width)
+    : width_(ghr_width), pht_(size_t{1} << ghr_width, CTR_WT),
+      btb_({btb_sets, btb_ways, 4, policy}), targets_(btb_.slots(), 0) {}
+
+auto RtlPredictor::name() const -> std::string {
+  const CacheGeometry &g = btb_.geometry();
+  return fmt::format("rtl-btb{}x{}-{}-ghr{}", g.sets, g.ways,
+                     repl_policy_name(g.policy), width_);
+}
+
+auto RtlPredictor::predict(const BranchRecord &br) noexcept -> Outcome {
+  const uint32_t mask = (1u << width_) - 1;
+
+  uint32_t slot;
+  const bool hit = btb_.find(br.pc, slot);
+  uint8_t &ctr = pht_[(fold_pc(br.pc, width_) ^ ghr_) & mask];
+  const bool pred_taken = hit && counter_taken(ctr);
+  const bool mispredict =
+      pred_taken != br.taken || (pred_taken && targets_[slot] != br.target);
+
+  ctr = sat_update(ctr, br.taken);
+  if (br.taken) {
+    targets_[btb_.insert(br.pc)] = br.target;
+  }
+  if (hit || mispredict) {
+    ghr_ = ((ghr_ << 1) | static_cast<uint32_t>(br.taken)) & mask;
+  }
+  return outcome(mispredict);
+}
+
+void RtlPredictor::reset() noexcept {
+  std::fill(pht_.begin(), pht_.end(), CTR_WT);
+  btb_.reset();
+  std::fill(targets_.begin(), targets_.end(), 0);
+  ghr_ = 0;
+}
+
+auto parse_predictors(const std::string &spec,
+                      std::vector<std::unique_ptr<BranchPredictor>> &out)
+    -> bool {
+  const auto fields = split_spec(spec, ':');
+  if (fields.empty()) {
+    return false;
+  }
+  const std::string &model = fields[0];
+
+  auto parse_policies = [](const std::string &s,
+                           std::vector<risc::ReplPolicy> &policies) -> bool {
+    if (s == "all") {
+      policies = {risc::REPL_POLICY_LRU, risc::REPL_POLICY_PSEUDO_LRU,
+                  risc::REPL_POLICY_FIFO, risc::REPL_POLICY_LFU,
+                  risc::REPL_POLICY_RANDOM};
+      return true;
+    }
+    for (const auto &name : split_spec(s, ',')) {
+      risc::ReplPolicy policy;
+      if (!parse_repl_policy(name, policy)) {
+        return false;
+      }
+      policies.push_back(policy);
+    }
+    return !policies.empty();
+  };
+
+  auto parse_geometry = [](const std::string &s, std::vector<uint32_t> &sets,
+                           std::vector<uint32_t> &ways) -> bool {
+    const auto dims = split_spec(s, 'x');
+    if (dims.size() != 2 || !parse_uint_list(dims[0], sets) ||
+        !parse_uint_list(dims[1], ways)) {
+      return false;
+    }
+    for (uint32_t v : sets) {
+      if (v & (v - 1)) {
+        return false;
+      }
+    }
+    for (uint32_t v : ways) {
+      if ((v & (v - 1)) || v > 64) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  std::vector<uint32_t> values;
+  if (model == "tage" && fields.size() == 1) {
+    out.push_back(std::make_unique<TagePredictor>());
+  } else if ((model == "gshare" || model == "bimodal") && fields.size() == 2 &&
+             parse_uint_list(fields[1], values)) {
+    for (uint32_t bits : values) {
+      if (bits < 2 || bits > 24) {
+        return false;
+      }
+      if (model == "gshare") {
+        out.push_back(std::make_unique<GSharePredictor>(bits));
+      } else {
+        out.push_back(std::make_unique<BimodalPredictor>(bits));
+      }
+    }
+  } else if (model == "ras" && fields.size() == 2 &&
+             parse_uint_list(fields[1], values)) {
+    for (uint32_t depth : values) {
+      out.push_back(std::make_unique<RasPredictor>(depth));
+    }
+  } else if (model == "btb" && (fields.size() == 2 || fields.size() == 3)) {
+    std::vector<uint32_t> sets, ways;
+    std::vector<risc::ReplPolicy> policies;
+    if (!parse_geometry(fields[1], sets, ways) ||
+        !parse_policies(fields.size() == 3 ? fields[2] : "plru", policies)) {
+      return false;
+    }
+    for (uint32_t s : sets) {
+      for (uint32_t w : ways) {
+        for (risc::ReplPolicy p : policies) {
+          out.push_back(std::make_unique<BtbPredictor>(s, w, p));
+        }
+      }
+    }
+  } else if (model == "rtl" && (fields.size() == 3 || fields.size() == 4)) {
+    std::vector<uint32_t> sets, ways, widths;
+    std::vector<risc::ReplPolicy> policies;
+    if (!parse_geometry(fields[1], sets, ways) ||
+        !parse_uint_list(fields[2], widths) ||
+        !parse_policies(fields.size() == 4 ? fields[3] : "plru", policies)) {
+      return false;
+    }
+    for (uint32_t s : sets) {
+      for (uint32_t w : ways) {
+        for (uint32_t g : widths) {
+          if (g < 2 || g > 24) {
+            return false;
+          }
+          for (risc::ReplPolicy p : policies) {
+            out.push_back(std::make_unique<RtlPredictor>(s, w, p, g));
+          }
+        }
+      }
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+} // namespace demu::perf
@@ -0,0 +1,174 @@
+#include "demu/perf/branch.hh"
+#include "demu/logger.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace demu::perf {
+
+namespace {
+
+// Per-kind rows of the summary; the last one holds non-branches
+constexpr size_t NUM_ROWS = NUM_BRANCH_KINDS + 1;
+
+auto row_name(size_t row) noexcept -> const char * {
+  if (row < NUM_BRANCH_KINDS) {
+    return branch_kind_name(static_cast<BranchKind>(row));
+  }
+  return "other";
+}
+
+} // namespace
+
+BranchProfiler::BranchProfiler(const SymbolTable &symbols, std::string path,
+                               size_t top, const LineTable *lines)
+    : symbols_(symbols), path_(std::move(path)), top_(top), lines_(lines) {
+  reset();
+}
+
+void BranchProfiler::reset() {
+  branches_.clear();
+  direction_pending_ = false;
+  cycle_mispredict_ = false;
+  cycle_retired_ = false;
+  penalty_owner_ = nullptr;
+}
+
+auto BranchProfiler::stats_for(addr_t pc, instr_t instr) -> BranchStats & {
+  BranchStats &b = branches_[pc];
+  if (b.execs == 0 && b.mispredicts == 0) {
+    b.instr = instr;
+    b.branch = classify_branch(instr, b.kind);
+  }
+  return b;
+}
+
+void BranchProfiler::close_cycle() {
+  if (cycle_mispredict_ && cycle_retired_) {
+    BranchStats &b = stats_for(cycle_last_pc_, cycle_last_instr_);
+    b.mispredicts++;
+    penalty_owner_ = &b;
+  }
+  cycle_mispredict_ = false;
+  cycle_retired_ = false;
+}
+
+void BranchProfiler::on_cycle(const CycleSample &sample) {
+  close_cycle();
+
+  if (penalty_owner_) {
+    if (sample.commit_count == 0) {
+      penalty_owner_->penalty_cycles++;
+    } else {
+      penalty_owner_ = nullptr;
+    }
+  }
+  cycle_mispredict_ = sample.bpu_mispredict;
+}
+
+void BranchProfiler::on_retire(const RetireEvent &event) {
+  if (direction_pending_) {
+    auto it = branches_.find(direction_pc_);
+    if (it != branches_.end() && event.pc != direction_pc_ + 4) {
+      it->second.taken++;
+    }
+    direction_pending_ = false;
+  }
+
+  cycle_retired_ = true;
+  cycle_last_pc_ = event.pc;
+  cycle_last_instr_ = event.instr;
+
+  BranchKind kind;
+  if (classify_branch(event.instr, kind)) {
+    stats_for(event.pc, event.instr).execs++;
+    direction_pending_ = true;
+    direction_pc_ = event.pc;
+  }
+}
+
+void BranchProfiler::report() {
+  close_cycle();
+
+  std::vector<std::pair<addr_t, const BranchStats *>> sorted;
+  sorted.reserve(branches_.size());
+  uint64_t execs[NUM_ROWS] = {};
+  uint64_t mispredicts[NUM_ROWS] = {};
+  uint64_t total_mispredicts = 0;
+  uint64_t total_penalty = 0;
+  for (const auto &[pc, b] : branches_) {
+    sorted.emplace_back(pc, &b);
+    const size_t row =
+        b.branch ? static_cast<size_t>(b.kind) : NUM_BRANCH_KINDS;
+    execs[row] += b.execs;
+    mispredicts[row] += b.mispredicts;
+    total_mispredicts += b.mispredicts;
+    total_penalty += b.penalty_cycles;
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto &a, const auto &b) -> bool {
+              if (a.second->penalty_cycles != b.second->penalty_cycles) {
+                return a.second->penalty_cycles > b.second->penalty_cycles;
+              }
+              if (a.second->mispredicts != b.second->mispredicts) {
+                return a.second->mispredicts > b.second->mispredicts;
+              }
+              return a.first < b.first;
+            });
+
+  DEMU_INFO("--- Branch Profile ({} static branches) ---", branches_.size());
+  for (size_t k = 0; k < NUM_ROWS; ++k) {
+    if (execs[k] == 0 && mispredicts[k] == 0) {
+      continue;
+    }
+    DEMU_INFO("  {:<8} {:>10} executed  {:>8} mispredicted ({:.2f}%)",
+              row_name(k), execs[k], mispredicts[k],
+              percent(mispredicts[k], execs[k]));
+  }
+  DEMU_INFO("  Penalty: {} cycles over {} mispredicts", total_penalty,
+            total_mispredicts);
+  for (size_t i = 0; i < std::min<size_t>(10, sorted.size()); ++i) {
+    const auto &[pc, b] = sorted[i];
+    if (b->mispredicts == 0) {
+      break;
+    }
+    DEMU_INFO("  0x{:08x} {:<28} miss {:>6.2f}%  penalty {}", pc,
+              symbols_.describe(pc), percent(b->mispredicts, b->execs),
+              b->penalty_cycles);
+  }
+
+  std::ofstream out(path_);
+  if (!out.is_open()) {
+    DEMU_WARN("Failed to write branch profile: {}", path_);
+    return;
+  }
+
+  out << fmt::format("# DEMU branch profile\n");
+  out << fmt::format("# mispredicts {} penalty_cycles {}\n\n",
+                     total_mispredicts, total_penalty);
+  out << fmt::format("{:<10} {:<28} {:<28} {:<8} {:>10} {:>7} {:>8} {:>7} "
+                     "{:>10} {:>7}  {}\n",
+                     "pc", "location", "instruction", "kind", "execs",
+                     "taken%", "mispred", "miss%", "penalty", "avg",
+                     "source");
+  const size_t shown = std::min(top_, sorted.size());
+  for (size_t i = 0; i < shown; ++i) {
+    const auto &[pc, b] = sorted[i];
+    const char *kind = b->branch ? branch_kind_name(b->kind) : "other";
+    out << fmt::format(
+        "0x{:08x} {:<28} {:<28} {:<8} {:>10} {:>6.2f}% {:>8} {:>6.2f}% "
+        "{:>10} {:>7.2f}  {}\n",
+        pc, symbols_.describe(pc), Instruction(b->instr).to_string(),
+        kind, b->execs, percent(b->taken, b->execs),
+        b->mispredicts, percent(b->mispredicts, b->execs), b->penalty_cycles,
+        b->mispredicts > 0
+            ? static_cast<double>(b->penalty_cycles) / b->mispredicts
+            : 0.0,
+        lines_ ? lines_->describe(pc) : std::string());
+  }
+  DEMU_INFO("  Report: {}", path_);
+  DEMU_INFO("")
+}
+
+} // namespace demu::perf
@@ -0,0 +1,156 @@
+#include "demu/perf/branch_stream.hh"
+#include "demu/perf/util.hh"
+#include <cstring>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr char TRACE_MAGIC[] = "DEMUBT";
+constexpr uint8_t TRACE_VERSION = 1;
+
+inline auto is_link_reg(uint32_t r) noexcept -> bool {
+  return r == 1 || r == 5;
+}
+
+} // namespace
+
+auto branch_kind_name(BranchKind kind) noexcept -> const char * {
+  switch (kind) {
+  case BranchKind::COND:
+    return "cond";
+  case BranchKind::JUMP:
+    return "jump";
+  case BranchKind::INDIRECT:
+    return "indirect";
+  case BranchKind::CALL:
+    return "call";
+  case BranchKind::RET:
+    return "ret";
+  }
+  return "unknown";
+}
+
+auto classify_branch(instr_t instr, BranchKind &kind) noexcept -> bool {
+  const uint32_t opcode = instr & 0x7F;
+  const uint32_t rd = (instr >> 7) & 0x1F;
+  const uint32_t rs1 = (instr >> 15) & 0x1F;
+
+  switch (opcode) {
+  case OPCODE_BRANCH:
+    kind = BranchKind::COND;
+    return true;
+  case OPCODE_JAL:
+    kind = is_link_reg(rd) ? BranchKind::CALL : BranchKind::JUMP;
+    return true;
+  case OPCODE_JALR:
+    if (is_link_reg(rd)) {
+      kind = BranchKind::CALL;
+    } else if (rd == 0 && is_link_reg(rs1)) {
+      kind = BranchKind::RET;
+    } else {
+      kind = BranchKind::INDIRECT;
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+auto BranchStream::on_retire(const RetireEvent &event,
+                             BranchRecord &record) noexcept -> bool {
+  bool resolved = false;
+  if (pending_) {
+    record = record_;
+    record.target = event.pc;
+    record.taken = event.pc != record_.pc + 4;
+    resolved = true;
+  }
+
+  pending_ = classify_branch(event.instr, record_.kind);
+  record_.pc = event.pc;
+  return resolved;
+}
+
+auto BranchTraceWriter::open(const std::string &path) -> bool {
+  close();
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_) {
+    return false;
+  }
+  std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC) - 1, file_);
+  std::fputc(TRACE_VERSION, file_);
+  next_pc_ = 0;
+  records_ = 0;
+  bytes_ = sizeof(TRACE_MAGIC) - 1 + sizeof(TRACE_VERSION);
+  return true;
+}
+
+void BranchTraceWriter::write(const BranchRecord &record) noexcept {
+  if (!file_) {
+    return;
+  }
+  const auto delta = static_cast<int32_t>(record.pc - next_pc_);
+  bytes_ += put_varint(file_, zigzag(delta) << 4 |
+                                  static_cast<uint64_t>(record.kind) << 1 |
+                                  static_cast<uint64_t>(record.taken));
+  if (record.taken) {
+    const auto offset = static_cast<int32_t>(record.target - record.pc);
+    bytes_ += put_varint(file_, zigzag(offset));
+  }
+  next_pc_ = record.taken ? record.target : record.pc + 4;
+  records_++;
+}
+
+void BranchTraceWriter::close() noexcept {
+  if (file_) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+auto BranchTraceReader::open(const std::string &path) -> bool {
+  close();
+  file_ = std::fopen(path.c_str(), "rb");
+  if (!file_) {
+    return false;
+  }
+  char magic[sizeof(TRACE_MAGIC)] = {};
+  if (std::fread(magic, 1, sizeof(magic), file_) != sizeof(magic) ||
+      std::memcmp(magic, TRACE_MAGIC, sizeof(TRACE_MAGIC) - 1) != 0 ||
+      static_cast<uint8_t>(magic[sizeof(magic) - 1]) != TRACE_VERSION) {
+    close();
+    return false;
+  }
+  next_pc_ = 0;
+  return true;
+}
+
+auto BranchTraceReader::next(BranchRecord &record) noexcept -> bool {
+  uint64_t word;
+  if (!file_ || !get_varint(file_, word)) {
+    return false;
+  }
+  record.pc = next_pc_ + static_cast<addr_t>(unzigzag(word >> 4));
+  record.kind = static_cast<BranchKind>((word >> 1) & 0x7);
+  record.taken = word & 1;
+  record.target = record.pc + 4;
+  if (record.taken) {
+    uint64_t offset;
+    if (!get_varint(file_, offset)) {
+      return false;
+    }
+    record.target = record.pc + static_cast<addr_t>(unzigzag(offset));
+  }
+  next_pc_ = record.target;
+  return true;
+}
+
+void BranchTraceReader::close() noexcept {
+  if (file_) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+} // namespace demu::perf
@@ -0,0 +1,221 @@
+#include "demu/perf/cache_model.hh"
+#include "demu/logger.hh"
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr uint32_t MAX_WAYS = 64;
+
+inline auto is_pow2(uint32_t v) noexcept -> bool {
+  return v != 0 && (v & (v - 1)) == 0;
+}
+
+inline auto log2u(uint32_t v) noexcept -> uint32_t {
+  return 31 - static_cast<uint32_t>(__builtin_clz(v));
+}
+
+// The index/offset arithmetic below needs non-zero powers of two
+auto checked(const CacheGeometry &geometry) -> const CacheGeometry & {
+  if (!is_pow2(geometry.sets) || !is_pow2(geometry.ways) ||
+      !is_pow2(geometry.line_size)) {
+    DEMU_ERROR("Invalid cache geometry {}x{}x{}B: sets, ways and line size "
+               "must be non-zero powers of two",
+               geometry.sets, geometry.ways, geometry.line_size);
+  }
+  return geometry;
+}
+
+} // namespace
+
+auto CacheGeometry::valid() const noexcept -> bool {
+  return is_pow2(sets) && is_pow2(ways) && ways <= MAX_WAYS &&
+         is_pow2(line_size) && line_size >= 4 &&
+         policy != risc::REPL_POLICY_UNKNOWN;
+}
+
+auto CacheGeometry::to_string() const -> std::string {
+  return fmt::format("{}x{}x{}B {}", sets, ways, line_size,
+                     repl_policy_name(policy));
+}
+
+auto CacheGeometry::from_config(const risc::CacheConfig &config)
+    -> CacheGeometry {
+  return {config.sets(), config.ways(), config.line_size(),
+          config.repl_policy()};
+}
+
+auto repl_policy_name(risc::ReplPolicy policy) noexcept -> const char * {
+  switch (policy) {
+  case risc::REPL_POLICY_RANDOM:
+    return "random";
+  case risc::REPL_POLICY_FIFO:
+    return "fifo";
+  case risc::REPL_POLICY_LFU:
+    return "lfu";
+  case risc::REPL_POLICY_LRU:
+    return "lru";
+  case risc::REPL_POLICY_PSEUDO_LRU:
+    return "plru";
+  default:
+    return "unknown";
+  }
+}
+
+auto parse_repl_policy(std::string_view name, risc::ReplPolicy &policy)
+    -> bool {
+  for (auto p : {risc::REPL_POLICY_RANDOM, risc::REPL_POLICY_FIFO,
+                 risc::REPL_POLICY_LFU, risc::REPL_POLICY_LRU,
+                 risc::REPL_POLICY_PSEUDO_LRU}) {
+    if (name == repl_policy_name(p)) {
+      policy = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+CacheModel::CacheModel(const CacheGeometry &geometry, uint32_t seed)
+    : geometry_(checked(geometry)), offset_bits_(log2u(geometry_.line_size)),
+      index_bits_(log2u(geometry_.sets)), seed_(seed ? seed : 1), rng_(seed_),
+      lines_(static_cast<size_t>(geometry.sets) * geometry.ways),
+      plru_(geometry.sets, 0) {}
+
+void CacheModel::reset() noexcept {
+  std::fill(lines_.begin(), lines_.end(), Line{});
+  std::fill(plru_.begin(), plru_.end(), 0);
+  rng_ = seed_;
+  tick_ = 0;
+  accesses_ = 0;
+  misses_ = 0;
+}
+
+auto CacheModel::find(addr_t addr, uint32_t &slot) const noexcept -> bool {
+  const addr_t block = addr >> offset_bits_;
+  const auto set = static_cast<uint32_t>(block & (geometry_.sets - 1));
+  const addr_t tag = block >> index_bits_;
+  const uint32_t base = set * geometry_.ways;
+
+  for (uint32_t w = 0; w < geometry_.ways; ++w) {
+    if (lines_[base + w].valid && lines_[base + w].tag == tag) {
+      slot = base + w;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto CacheModel::insert(addr_t addr) noexcept -> uint32_t {
+  const addr_t block = addr >> offset_bits_;
+  const auto set = static_cast<uint32_t>(block & (geometry_.sets - 1));
+  const uint32_t base = set * geometry_.ways;
+
+  tick_++;
+
+  uint32_t slot;
+  if (find(addr, slot)) {
+    lines_[slot].count++;
+  } else {
+    slot = base + victim(set);
+    lines_[slot] = {block >> index_bits_, true, tick_, 1};
+  }
+  touch(set, slot - base);
+  return slot;
+}
+
+auto CacheModel::access(addr_t addr) noexcept -> bool {
+  uint32_t slot;
+  const bool hit = find(addr, slot);
+  accesses_++;
+  misses_ += static_cast<uint64_t>(!hit);
+  insert(addr);
+  return hit;
+}
+
+void CacheModel::touch(uint32_t set, uint32_t way) noexcept {
+  Line &line = lines_[static_cast<size_t>(set) * geometry_.ways + way];
+  if (geometry_.policy != risc::REPL_POLICY_FIFO) {
+    line.stamp = tick_;
+  }
+
+  if (geometry_.policy == risc::REPL_POLICY_PSEUDO_LRU) {
+    // Tree bit set: the victim lies in the upper half of that node
+    uint64_t &bits = plru_[set];
+    uint32_t node = 0;
+    uint32_t lo = 0;
+    uint32_t hi = geometry_.ways;
+    while (hi - lo > 1) {
+      const uint32_t mid = (lo + hi) / 2;
+      if (way < mid) {
+        bits |= uint64_t{1} << node;
+        node = 2 * node + 1;
+        hi = mid;
+      } else {
+        bits &= ~(uint64_t{1} << node);
+        node = 2 * node + 2;
+        lo = mid;
+      }
+    }
+  }
+}
+
+auto CacheModel::victim(uint32_t set) noexcept -> uint32_t {
+  const Line *ways = &lines_[static_cast<size_t>(set) * geometry_.ways];
+  for (uint32_t w = 0; w < geometry_.ways; ++w) {
+    if (!ways[w].valid) {
+      return w;
+    }
+  }
+
+  switch (geometry_.policy) {
+  case risc::REPL_POLICY_RANDOM: {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return rng_ & (geometry_.ways - 1);
+  }
+  case risc::REPL_POLICY_PSEUDO_LRU: {
+    const uint64_t bits = plru_[set];
+    uint32_t node = 0;
+    uint32_t lo = 0;
+    uint32_t hi = geometry_.ways;
+    while (hi - lo > 1) {
+      const uint32_t mid = (lo + hi) / 2;
+      if (bits & (uint64_t{1} << node)) {
+        node = 2 * node + 2;
+        lo = mid;
+      } else {
+        node = 2 * node + 1;
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+  case risc::REPL_POLICY_LFU: {
+    // least frequently used, oldest first among equals
+    uint32_t best = 0;
+    for (uint32_t w = 1; w < geometry_.ways; ++w) {
+      if (ways[w].count < ways[best].count ||
+          (ways[w].count == ways[best].count &&
+           ways[w].stamp < ways[best].stamp)) {
+        best = w;
+      }
+    }
+    return best;
+  }
+  default: {
+    // LRU and FIFO differ only in when the stamp is refreshed
+    uint32_t best = 0;
+    for (uint32_t w = 1; w < geometry_.ways; ++w) {
+      if (ways[w].stamp < ways[best].stamp) {
+        best = w;
+      }
+    }
+    return best;
+  }
+  }
+}
+
+} // namespace demu::perf
@@ -0,0 +1,348 @@
+#include "demu/perf/hotspot.hh"
+#include "demu/logger.hh"
+#include "demu/perf/branch_stream.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr uint32_t ROOT = 0;
+
+auto ipc(uint64_t instret, uint64_t cycles) noexcept -> double {
+  return cycles > 0 ? static_cast<double>(instret) / cycles : 0.0;
+}
+
+} // namespace
+
+HotspotProfiler::HotspotProfiler(const SymbolTable &symbols,
+                                 std::string prefix, size_t top,
+                                 const LineTable *lines)
+    : symbols_(symbols), prefix_(std::move(prefix)), top_(top), lines_(lines) {
+  reset();
+}
+
+void HotspotProfiler::reset() {
+  pcs_.clear();
+  nodes_.clear();
+  nodes_.push_back({SymbolTable::npos, ROOT, 0, {}});
+  stack_.assign(1, ROOT);
+
+  pending_cycles_ = 0;
+  pending_frontend_ = 0;
+  pending_backend_ = 0;
+  pending_icache_misses_ = 0;
+  pending_dcache_misses_ = 0;
+  call_pending_ = false;
+  ret_pending_ = false;
+
+  cached_start_ = 1;
+  cached_end_ = 0;
+  cached_func_ = SymbolTable::npos;
+}
+
+void HotspotProfiler::on_cycle(const CycleSample &sample) {
+  pending_cycles_++;
+  pending_frontend_ += static_cast<uint64_t>(sample.frontend_stall);
+  pending_backend_ += static_cast<uint64_t>(sample.backend_stall);
+  pending_icache_misses_ += static_cast<uint64_t>(sample.l1_icache_miss);
+  pending_dcache_misses_ += static_cast<uint64_t>(sample.l1_dcache_miss);
+}
+
+void HotspotProfiler::on_retire(const RetireEvent &event) {
+  PcStats &pc = pcs_[event.pc];
+  pc.instr = event.instr;
+  pc.cycles += pending_cycles_;
+  pc.instret++;
+  pc.frontend_stalls += pending_frontend_;
+  pc.backend_stalls += pending_backend_;
+  pc.icache_misses += pending_icache_misses_;
+  pc.dcache_misses += pending_dcache_misses_;
+
+  update_context(func_of(event.pc));
+  nodes_[stack_.back()].cycles += pending_cycles_;
+
+  pending_cycles_ = 0;
+  pending_frontend_ = 0;
+  pending_backend_ = 0;
+  pending_icache_misses_ = 0;
+  pending_dcache_misses_ = 0;
+
+  BranchKind kind;
+  const bool branch = classify_branch(event.instr, kind);
+  call_pending_ = branch && kind == BranchKind::CALL;
+  ret_pending_ = branch && kind == BranchKind::RET;
+}
+
+auto HotspotProfiler::func_of(addr_t pc) noexcept -> uint32_t {
+  if (pc >= cached_start_ && pc < cached_end_) {
+    return cached_func_;
+  }
+  const uint32_t func = symbols_.find(pc);
+  if (func != SymbolTable::npos) {
+    cached_start_ = symbols_[func].start;
+    cached_end_ = symbols_[func].end;
+    cached_func_ = func;
+  }
+  return func;
+}
+
+auto HotspotProfiler::func_name(uint32_t func) const -> std::string {
+  return func == SymbolTable::npos ? "[unknown]" : symbols_[func].name;
+}
+
+auto HotspotProfiler::child(uint32_t node, uint32_t func) -> uint32_t {
+  auto it = nodes_[node].children.find(func);
+  if (it != nodes_[node].children.end()) {
+    return it->second;
+  }
+  const auto idx = static_cast<uint32_t>(nodes_.size());
+  nodes_.push_back({func, node, 0, {}});
+  nodes_[node].children.emplace(func, idx);
+  return idx;
+}
+
+void HotspotProfiler::update_context(uint32_t func) {
+  if (call_pending_ && stack_.size() < MAX_DEPTH) {
+    stack_.push_back(child(stack_.back(), func));
+    return;
+  }
+  if (ret_pending_ && stack_.size() > 2) {
+    stack_.pop_back();
+  }
+
+  const uint32_t top = stack_.back();
+  if (top == ROOT) {
+    stack_.push_back(child(ROOT, func));
+  } else if (nodes_[top].func != func) {
+    // tail call, jump between functions or unbalanced return
+    stack_.back() = child(nodes_[top].parent, func);
+  }
+}
+
+void HotspotProfiler::report() {
+  uint64_t total_cycles = 0;
+  uint64_t total_instret = 0;
+  for (const auto &[pc, s] : pcs_) {
+    total_cycles += s.cycles;
+    total_instret += s.instret;
+  }
+
+  DEMU_INFO("--- Hotspot Profile ({} cycles, {} instructions) ---",
+            total_cycles, total_instret);
+  write_text(prefix_ + ".txt");
+  write_folded(prefix_ + ".folded");
+  DEMU_INFO("  Report:          {}.txt", prefix_);
+  DEMU_INFO("  Collapsed stack: {}.folded", prefix_);
+  DEMU_INFO("")
+}
+
+void HotspotProfiler::write_text(const std::string &path) const {
+  struct FuncStats {
+    uint32_t func{SymbolTable::npos};
+    uint64_t inclusive{0};
+    uint64_t exclusive{0};
+    uint64_t instret{0};
+    uint64_t frontend_stalls{0};
+    uint64_t backend_stalls{0};
+  };
+
+  std::unordered_map<uint32_t, FuncStats> funcs;
+  uint64_t total_cycles = 0;
+  uint64_t total_instret = 0;
+
+  for (const auto &[pc, s] : pcs_) {
+    const uint32_t func = symbols_.find(pc);
+    FuncStats &f = funcs[func];
+    f.func = func;
+    f.exclusive += s.cycles;
+    f.instret += s.instret;
+    f.frontend_stalls += s.frontend_stalls;
+    f.backend_stalls += s.backend_stalls;
+    total_cycles += s.cycles;
+    total_instret += s.instret;
+  }
+
+  // Inclusive: charge each node's cycles once to every distinct function on
+  // its path, so recursion is not double counted.
+  std::vector<uint32_t> seen;
+  for (uint32_t n = 1; n < nodes_.size(); ++n) {
+    if (nodes_[n].cycles == 0) {
+      continue;
+    }
+    seen.clear();
+    for (uint32_t p = n; p != ROOT; p = nodes_[p].parent) {
+      const uint32_t func = nodes_[p].func;
+      if (std::find(seen.begin(), seen.end(), func) == seen.end()) {
+        seen.push_back(func);
+        FuncStats &f = funcs[func];
+        f.func = func;
+        f.inclusive += nodes_[n].cycles;
+      }
+    }
+  }
+
+  std::vector<FuncStats> by_func;
+  by_func.reserve(funcs.size());
+  for (const auto &[func, f] : funcs) {
+    by_func.push_back(f);
+  }
+  std::sort(by_func.begin(), by_func.end(),
+            [](const FuncStats &a, const FuncStats &b) -> bool {
+              return a.exclusive != b.exclusive ? a.exclusive > b.exclusive
+                                                : a.inclusive > b.inclusive;
+            });
+
+  std::vector<std::pair<addr_t, const PcStats *>> by_pc;
+  by_pc.reserve(pcs_.size());
+  for (const auto &[pc, s] : pcs_) {
+    by_pc.emplace_back(pc, &s);
+  }
+  std::sort(by_pc.begin(), by_pc.end(),
+            [](const auto &a, const auto &b) -> bool {
+              return a.second->cycles != b.second->cycles
+                         ? a.second->cycles > b.second->cycles
+                         : a.first < b.first;
+            });
+
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    DEMU_WARN("Failed to write profile: {}", path);
+    return;
+  }
+
+  out << fmt::format("# DEMU hotspot profile\n");
+  out << fmt::format("# cycles {} instret {} IPC {:.3f}\n\n", total_cycles,
+                     total_instret, ipc(total_instret, total_cycles));
+
+  out << fmt::format("{:<32} {:>12} {:>7} {:>12} {:>7} {:>12} {:>6} "
+                     "{:>10} {:>10}\n",
+                     "function", "incl", "incl%", "excl", "excl%", "instret",
+                     "IPC", "fe_stall", "be_stall");
+  for (const auto &f : by_func) {
+    out << fmt::format("{:<32} {:>12} {:>6.2f}% {:>12} {:>6.2f}% {:>12} "
+                       "{:>6.3f} {:>10} {:>10}\n",
+                       func_name(f.func), f.inclusive,
+                       percent(f.inclusive, total_cycles), f.exclusive,
+                       percent(f.exclusive, total_cycles), f.instret,
+                       ipc(f.instret, f.exclusive), f.frontend_stalls,
+                       f.backend_stalls);
+  }
+
+  out << fmt::format("\n{:<10} {:<28} {:<28} {:>10} {:>7} {:>10} {:>6} "
+                     "{:>10} {:>10} {:>8} {:>8}  {}\n",
+                     "pc", "location", "instruction", "cycles", "cyc%",
+                     "instret", "CPI", "fe_stall", "be_stall", "i_miss",
+                     "d_miss", "source");
+  const size_t shown = std::min(top_, by_pc.size());
+  for (size_t i = 0; i < shown; ++i) {
+    const auto &[pc, s] = by_pc[i];
+    out << fmt::format(
+        "0x{:08x} {:<28} {:<28} {:>10} {:>6.2f}% {:>10} {:>6.2f} {:>10} "
+        "{:>10} {:>8} {:>8}  {}\n",
+        pc, symbols_.describe(pc), Instruction(s->instr).to_string(),
+        s->cycles, percent(s->cycles, total_cycles), s->instret,
+        s->instret > 0 ? static_cast<double>(s->cycles) / s->instret : 0.0,
+        s->frontend_stalls, s->backend_stalls, s->icache_misses,
+        s->dcache_misses, lines_ ? lines_->describe(pc) : std::string());
+  }
+
+  write_lines(out, total_cycles);
+
+  for (size_t i = 0; i < std::min<size_t>(10, by_func.size()); ++i) {
+    DEMU_INFO("  {:<28} excl {:>6.2f}%  incl {:>6.2f}%  IPC {:.3f}",
+              func_name(by_func[i].func),
+              percent(by_func[i].exclusive, total_cycles),
+              percent(by_func[i].inclusive, total_cycles),
+              ipc(by_func[i].instret, by_func[i].exclusive));
+  }
+}
+
+void HotspotProfiler::write_lines(std::ostream &out,
+                                  uint64_t total_cycles) const {
+  if (!lines_ || lines_->empty()) {
+    return;
+  }
+
+  struct LineStats {
+    const std::string *file{nullptr};
+    uint32_t line{0};
+    uint64_t cycles{0};
+    uint64_t instret{0};
+    uint64_t icache_misses{0};
+    uint64_t dcache_misses{0};
+  };
+
+  // file strings are interned by the line table, so the pointer is an id
+  std::map<std::pair<const std::string *, uint32_t>, LineStats> by_key;
+  for (const auto &[pc, s] : pcs_) {
+    const SourceLocation loc = lines_->lookup(pc);
+    if (!loc.valid()) {
+      continue;
+    }
+    LineStats &l = by_key[{loc.file, loc.line}];
+    l.file = loc.file;
+    l.line = loc.line;
+    l.cycles += s.cycles;
+    l.instret += s.instret;
+    l.icache_misses += s.icache_misses;
+    l.dcache_misses += s.dcache_misses;
+  }
+
+  std::vector<const LineStats *> sorted;
+  sorted.reserve(by_key.size());
+  for (const auto &[key, l] : by_key) {
+    sorted.push_back(&l);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const LineStats *a, const LineStats *b) -> bool {
+              return a->cycles > b->cycles;
+            });
+
+  out << fmt::format("\n{:<48} {:>10} {:>7} {:>10} {:>6} {:>8} {:>8}\n",
+                     "source", "cycles", "cyc%", "instret", "CPI", "i_miss",
+                     "d_miss");
+  const size_t shown = std::min(top_, sorted.size());
+  for (size_t i = 0; i < shown; ++i) {
+    const LineStats &l = *sorted[i];
+    out << fmt::format(
+        "{:<48} {:>10} {:>6.2f}% {:>10} {:>6.2f} {:>8} {:>8}\n",
+        fmt::format("{}:{}", *l.file, l.line), l.cycles,
+        percent(l.cycles, total_cycles), l.instret,
+        l.instret > 0 ? static_cast<double>(l.cycles) / l.instret : 0.0,
+        l.icache_misses, l.dcache_misses);
+  }
+}
+
+void HotspotProfiler::write_folded(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    DEMU_WARN("Failed to write collapsed stacks: {}", path);
+    return;
+  }
+
+  std::vector<uint32_t> chain;
+  for (uint32_t n = 1; n < nodes_.size(); ++n) {
+    if (nodes_[n].cycles == 0) {
+      continue;
+    }
+    chain.clear();
+    for (uint32_t p = n; p != ROOT; p = nodes_[p].parent) {
+      chain.push_back(nodes_[p].func);
+    }
+
+    std::string line;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      if (!line.empty()) {
+        line += ';';
+      }
+      line += func_name(*it);
+    }
+    out << line << ' ' << nodes_[n].cycles << '\n';
+  }
+}
+
+} // namespace demu::perf
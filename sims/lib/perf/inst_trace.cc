@@ -0,0 +1,206 @@
+#include "demu/perf/inst_trace.hh"
+#include "demu/logger.hh"
+#include "demu/perf/util.hh"
+#include <cstring>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr char TRACE_MAGIC[] = "DEMUIT";
+constexpr uint8_t TRACE_VERSION = 2;
+
+constexpr uint64_t END_WORD = 1;
+constexpr uint64_t FLAG_FIRST = 1u << 2;
+constexpr uint64_t FLAG_MEM = 1u << 1;
+
+} // namespace
+
+auto InstTraceWriter::open(const std::string &path) -> bool {
+  close();
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_) {
+    return false;
+  }
+  std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC) - 1, file_);
+  std::fputc(TRACE_VERSION, file_);
+  next_pc_ = 0;
+  last_addr_ = 0;
+  seen_.clear();
+  records_ = 0;
+  bytes_ = sizeof(TRACE_MAGIC) - 1 + sizeof(TRACE_VERSION);
+  return true;
+}
+
+void InstTraceWriter::write(const InstRecord &record) noexcept {
+  if (!file_) {
+    return;
+  }
+  const bool first = seen_.insert(record.pc).second;
+  const auto delta = static_cast<int32_t>(record.pc - next_pc_);
+  bytes_ += put_varint(file_, zigzag(delta) << 3 | (first ? FLAG_FIRST : 0) |
+                                  (record.mem ? FLAG_MEM : 0));
+  if (first) {
+    bytes_ += put_varint(file_, record.instr);
+  }
+  if (record.mem) {
+    const auto offset = static_cast<int32_t>(record.addr - last_addr_);
+    bytes_ += put_varint(file_, zigzag(offset));
+    last_addr_ = record.addr;
+  }
+  next_pc_ = record.pc + 4;
+  records_++;
+}
+
+void InstTraceWriter::finish(const PerfCounters &counters) noexcept {
+  if (!file_) {
+    return;
+  }
+  bytes_ += put_varint(file_, END_WORD);
+  bytes_ += put_varint(file_, NUM_DUT_PERF_COUNTERS);
+  for (size_t k = 0; k < NUM_DUT_PERF_COUNTERS; ++k) {
+    bytes_ += put_varint(file_, counters.*PERF_COUNTER_FIELDS[k].member);
+  }
+  close();
+}
+
+void InstTraceWriter::close() noexcept {
+  if (file_) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+auto InstTraceReader::open(const std::string &path) -> bool {
+  close();
+  file_ = std::fopen(path.c_str(), "rb");
+  if (!file_) {
+    return false;
+  }
+  char magic[sizeof(TRACE_MAGIC)] = {};
+  if (std::fread(magic, 1, sizeof(magic), file_) != sizeof(magic) ||
+      std::memcmp(magic, TRACE_MAGIC, sizeof(TRACE_MAGIC) - 1) != 0 ||
+      static_cast<uint8_t>(magic[sizeof(magic) - 1]) != TRACE_VERSION) {
+    close();
+    return false;
+  }
+  next_pc_ = 0;
+  last_addr_ = 0;
+  instrs_.clear();
+  reference_ = {};
+  has_reference_ = false;
+  return true;
+}
+
+void InstTraceReader::read_footer() noexcept {
+  // Counters this build does not know are skipped
+  uint64_t count;
+  if (!get_varint(file_, count)) {
+    return;
+  }
+  for (uint64_t k = 0; k < count; ++k) {
+    uint64_t value;
+    if (!get_varint(file_, value)) {
+      return;
+    }
+    if (k < NUM_DUT_PERF_COUNTERS) {
+      reference_.*PERF_COUNTER_FIELDS[k].member = value;
+    }
+  }
+  has_reference_ = true;
+}
+
+auto InstTraceReader::next(InstRecord &record) noexcept -> bool {
+  uint64_t word;
+  if (!file_ || !get_varint(file_, word)) {
+    return false;
+  }
+  if (word == END_WORD) {
+    read_footer();
+    close();
+    return false;
+  }
+
+  record.pc = next_pc_ + static_cast<addr_t>(unzigzag(word >> 3));
+  record.mem = word & FLAG_MEM;
+  if (word & FLAG_FIRST) {
+    uint64_t instr;
+    if (!get_varint(file_, instr)) {
+      return false;
+    }
+    instrs_[record.pc] = static_cast<instr_t>(instr);
+  }
+  auto it = instrs_.find(record.pc);
+  if (it == instrs_.end()) {
+    return false;
+  }
+  record.instr = it->second;
+
+  record.addr = 0;
+  if (record.mem) {
+    uint64_t offset;
+    if (!get_varint(file_, offset)) {
+      return false;
+    }
+    last_addr_ += static_cast<addr_t>(unzigzag(offset));
+    record.addr = last_addr_;
+  }
+  next_pc_ = record.pc + 4;
+  return true;
+}
+
+void InstTraceReader::close() noexcept {
+  if (file_) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+void InstTracer::reset() {
+  mem_.reset();
+  counters_ = {};
+  if (!trace_.open(path_)) {
+    DEMU_WARN("Failed to open instruction trace: {}", path_);
+  }
+}
+
+void InstTracer::on_cycle(const CycleSample &sample) {
+  counters_.cycles++;
+  counters_.instret += sample.commit_count;
+#define DEMU_TRACE_COUNTER(NAME, GATE, UNIT, KIND, DESC)                       \
+  counters_.NAME += sample.NAME;
+
+  DEMU_DEBUG_COUNTERS(DEMU_TRACE_COUNTER)
+
+#undef DEMU_TRACE_COUNTER
+}
+
+void InstTracer::on_retire(const RetireEvent &event) {
+  InstRecord record;
+  record.pc = event.pc;
+  record.instr = event.instr;
+
+  MemStream::Access access;
+  if (mem_.on_retire(event, access)) {
+    record.mem = true;
+    record.addr = access.addr;
+  }
+  trace_.write(record);
+}
+
+void InstTracer::report() {
+  if (!trace_.is_open()) {
+    return;
+  }
+  trace_.finish(counters_);
+  DEMU_INFO("--- Instruction Trace ---");
+  DEMU_INFO("  {}: {} records, {:.2f} bytes/record, {} cycles", path_,
+            trace_.records(),
+            trace_.records() > 0
+                ? static_cast<double>(trace_.bytes()) / trace_.records()
+                : 0.0,
+            counters_.cycles);
+  DEMU_INFO("")
+}
+
+} // namespace demu::perf
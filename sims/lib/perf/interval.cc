@@ -0,0 +1,354 @@
+#include "demu/perf/interval.hh"
+#include "demu/logger.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr char INTERVAL_MAGIC[] = "DEMUIV";
+constexpr uint8_t INTERVAL_VERSION = 1;
+
+constexpr size_t NUM_COLUMNS = 1 + PERF_COUNTER_FIELDS.size();
+
+auto empty_chunk() -> std::vector<std::vector<uint64_t>> {
+  std::vector<std::vector<uint64_t>> chunk(NUM_COLUMNS);
+  for (auto &column : chunk) {
+    column.reserve(IntervalWriter::CHUNK_ROWS);
+  }
+  return chunk;
+}
+
+auto load_binary(std::FILE *file, IntervalTable &table) -> bool {
+  uint64_t num_columns;
+  if (!get_varint(file, num_columns) || num_columns == 0) {
+    return false;
+  }
+  for (uint64_t c = 0; c < num_columns; ++c) {
+    uint64_t length;
+    if (!get_varint(file, length)) {
+      return false;
+    }
+    std::string name(length, '\0');
+    if (std::fread(name.data(), 1, length, file) != length) {
+      return false;
+    }
+    table.columns.push_back(std::move(name));
+  }
+  table.data.assign(num_columns, {});
+
+  uint64_t last_cycle = 0;
+  uint64_t rows;
+  while (get_varint(file, rows) && rows > 0) {
+    for (uint64_t c = 0; c < num_columns; ++c) {
+      for (uint64_t r = 0; r < rows; ++r) {
+        uint64_t value;
+        if (!get_varint(file, value)) {
+          DEMU_WARN("Interval file is truncated after {} rows",
+                    table.data.front().size());
+          const size_t complete = table.data.front().size() -
+                                  (c == 0 ? r : rows);
+          for (auto &column : table.data) {
+            column.resize(complete);
+          }
+          return true;
+        }
+        if (c == 0) {
+          last_cycle += value;
+          value = last_cycle;
+        }
+        table.data[c].push_back(value);
+      }
+    }
+  }
+  return true;
+}
+
+auto load_csv(const std::string &path, IntervalTable &table) -> bool {
+  std::ifstream in(path);
+  std::string line;
+  if (!in.is_open() || !std::getline(in, line)) {
+    return false;
+  }
+  std::stringstream header(line);
+  for (std::string name; std::getline(header, name, ',');) {
+    table.columns.push_back(name);
+  }
+  table.data.assign(table.columns.size(), {});
+
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::vector<uint64_t> row;
+    std::stringstream fields(line);
+    for (std::string field; std::getline(fields, field, ',');) {
+      row.push_back(std::strtoull(field.c_str(), nullptr, 10));
+    }
+    if (row.size() != table.columns.size()) {
+      DEMU_WARN("Skipping malformed interval row: {}", line);
+      continue;
+    }
+    for (size_t c = 0; c < row.size(); ++c) {
+      table.data[c].push_back(row[c]);
+    }
+  }
+  return !table.columns.empty();
+}
+
+} // namespace
+
+auto parse_interval_spec(const std::string &spec, IntervalSpec &out) -> bool {
+  if (spec.empty()) {
+    return false;
+  }
+  const bool instructions = spec.back() == 'i';
+  const std::string digits =
+      instructions ? spec.substr(0, spec.size() - 1) : spec;
+  if (digits.empty() ||
+      digits.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  out.period = std::stoull(digits);
+  out.instructions = instructions;
+  return out.period > 0;
+}
+
+auto IntervalWriter::open(const std::string &path) -> bool {
+  close();
+  csv_ = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+  file_ = std::fopen(path.c_str(), csv_ ? "w" : "wb");
+  if (!file_) {
+    return false;
+  }
+
+  if (csv_) {
+    std::fputs("cycle", file_);
+    for (const auto &field : PERF_COUNTER_FIELDS) {
+      std::fprintf(file_, ",%s", field.name);
+    }
+    std::fputc('\n', file_);
+  } else {
+    std::fwrite(INTERVAL_MAGIC, 1, sizeof(INTERVAL_MAGIC) - 1, file_);
+    std::fputc(INTERVAL_VERSION, file_);
+    put_varint(file_, NUM_COLUMNS);
+    put_varint(file_, std::strlen("cycle"));
+    std::fputs("cycle", file_);
+    for (const auto &field : PERF_COUNTER_FIELDS) {
+      put_varint(file_, std::strlen(field.name));
+      std::fputs(field.name, file_);
+    }
+  }
+
+  chunk_ = empty_chunk();
+  rows_ = 0;
+  last_cycle_ = 0;
+  closing_ = false;
+  worker_ = std::thread(&IntervalWriter::drain, this);
+  return true;
+}
+
+void IntervalWriter::append(uint64_t cycle, const PerfCounters &delta) {
+  if (!file_) {
+    return;
+  }
+  chunk_[0].push_back(cycle);
+  for (size_t k = 0; k < PERF_COUNTER_FIELDS.size(); ++k) {
+    chunk_[k + 1].push_back(delta.*PERF_COUNTER_FIELDS[k].member);
+  }
+  rows_++;
+  if (chunk_[0].size() >= CHUNK_ROWS) {
+    submit();
+  }
+}
+
+void IntervalWriter::submit() {
+  if (chunk_[0].empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(chunk_));
+  }
+  ready_.notify_one();
+  chunk_ = empty_chunk();
+}
+
+void IntervalWriter::drain() {
+  for (;;) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return closing_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    Chunk chunk = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    write(chunk);
+  }
+}
+
+void IntervalWriter::write(const Chunk &chunk) {
+  const size_t rows = chunk[0].size();
+  if (csv_) {
+    std::string line;
+    for (size_t r = 0; r < rows; ++r) {
+      line.clear();
+      for (size_t c = 0; c < chunk.size(); ++c) {
+        line += std::to_string(chunk[c][r]);
+        line += c + 1 < chunk.size() ? ',' : '\n';
+      }
+      std::fputs(line.c_str(), file_);
+    }
+    return;
+  }
+
+  put_varint(file_, rows);
+  for (const uint64_t cycle : chunk[0]) {
+    put_varint(file_, cycle - last_cycle_);
+    last_cycle_ = cycle;
+  }
+  for (size_t c = 1; c < chunk.size(); ++c) {
+    for (const uint64_t value : chunk[c]) {
+      put_varint(file_, value);
+    }
+  }
+}
+
+void IntervalWriter::close() {
+  if (!file_) {
+    return;
+  }
+  submit();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+  }
+  ready_.notify_one();
+  worker_.join();
+  if (!csv_) {
+    put_varint(file_, 0);
+  }
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+auto IntervalTable::load(const std::string &path) -> bool {
+  columns.clear();
+  data.clear();
+
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  char magic[sizeof(INTERVAL_MAGIC)] = {};
+  const bool binary =
+      std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+      std::memcmp(magic, INTERVAL_MAGIC, sizeof(INTERVAL_MAGIC) - 1) == 0;
+  if (binary && static_cast<uint8_t>(magic[sizeof(magic) - 1]) !=
+                    INTERVAL_VERSION) {
+    DEMU_WARN("Unsupported interval file version: {}",
+              static_cast<int>(magic[sizeof(magic) - 1]));
+    std::fclose(file);
+    return false;
+  }
+  const bool ok = binary ? load_binary(file, *this) : false;
+  std::fclose(file);
+  return binary ? ok : load_csv(path, *this);
+}
+
+auto IntervalTable::column(const std::string &name) const
+    -> const std::vector<uint64_t> * {
+  for (size_t c = 0; c < columns.size(); ++c) {
+    if (columns[c] == name) {
+      return &data[c];
+    }
+  }
+  return nullptr;
+}
+
+auto IntervalTable::sum(size_t first, size_t last) const -> PerfCounters {
+  PerfCounters total;
+  for (const auto &field : PERF_COUNTER_FIELDS) {
+    const auto *values = column(field.name);
+    if (!values) {
+      continue;
+    }
+    for (size_t r = first; r <= last && r < values->size(); ++r) {
+      total.*field.member += (*values)[r];
+    }
+  }
+  return total;
+}
+
+auto detect_phases(const IntervalTable &table, double threshold, size_t hold)
+    -> std::vector<Phase> {
+  const size_t rows = table.rows();
+  if (rows == 0) {
+    return {};
+  }
+  hold = std::max<size_t>(hold, 1);
+
+  std::vector<size_t> starts = {0};
+  const auto *cycles = table.column("cycles");
+  const auto *instret = table.column("instret");
+  if (cycles && instret) {
+    uint64_t phase_cycles = 0;
+    uint64_t phase_instret = 0;
+    size_t pending = 0; // deviating rows not yet folded into the phase
+    const auto add = [&](size_t r) {
+      phase_cycles += (*cycles)[r];
+      phase_instret += (*instret)[r];
+    };
+
+    for (size_t r = 0; r < rows; ++r) {
+      if (phase_cycles > 0 && (*cycles)[r] > 0) {
+        const double phase_ipc =
+            static_cast<double>(phase_instret) / phase_cycles;
+        const double ipc = static_cast<double>((*instret)[r]) / (*cycles)[r];
+        if (std::abs(ipc - phase_ipc) >
+            threshold * std::max(phase_ipc, 1e-3)) {
+          if (++pending < hold) {
+            continue;
+          }
+          starts.push_back(r + 1 - pending);
+          phase_cycles = 0;
+          phase_instret = 0;
+          for (size_t k = r + 1 - pending; k <= r; ++k) {
+            add(k);
+          }
+          pending = 0;
+          continue;
+        }
+      }
+      for (size_t k = r - pending; k < r; ++k) {
+        add(k);
+      }
+      pending = 0;
+      add(r);
+    }
+  }
+
+  const auto *cycle = table.column("cycle");
+
+  std::vector<Phase> phases;
+  for (size_t p = 0; p < starts.size(); ++p) {
+    Phase phase;
+    phase.first = starts[p];
+    phase.last = p + 1 < starts.size() ? starts[p + 1] - 1 : rows - 1;
+    phase.total = table.sum(phase.first, phase.last);
+    if (cycle) {
+      phase.end_cycle = (*cycle)[phase.last];
+      phase.start_cycle = phase.end_cycle - phase.total.cycles;
+    }
+    phases.push_back(phase);
+  }
+  return phases;
+}
+
+} // namespace demu::perf
@@ -0,0 +1,24 @@
+#include "demu/perf/mem_stream.hh"
+#include "demu/perf/util.hh"
+
+namespace demu::perf {
+
+auto MemStream::on_retire(const RetireEvent &event, Access &access) noexcept
+    -> bool {
+  const uint8_t opcode = event.instr & 0x7F;
+  bool is_mem = false;
+
+  if (opcode == OPCODE_LOAD || opcode == OPCODE_STORE) {
+    const Instruction inst(event.instr);
+    access.addr = regs_[inst.rs1()] + static_cast<addr_t>(inst.imm());
+    access.store = opcode == OPCODE_STORE;
+    is_mem = true;
+  }
+
+  if (event.reg_we && event.reg_addr != 0 && event.reg_addr < NUM_GPRS) {
+    regs_[event.reg_addr] = event.reg_data;
+  }
+  return is_mem;
+}
+
+} // namespace demu::perf
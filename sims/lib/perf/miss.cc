@@ -0,0 +1,221 @@
+#include "demu/perf/miss.hh"
+#include "demu/logger.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <fstream>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr uint64_t EXPIRE_INTERVAL = 4096;
+
+// bucket 0 holds latency 0, bucket n holds [2^(n-1), 2^n)
+auto bucket_of(uint64_t latency, size_t buckets) noexcept -> size_t {
+  const auto b = static_cast<size_t>(
+      latency == 0 ? 0 : 64 - __builtin_clzll(latency));
+  return std::min(b, buckets - 1);
+}
+
+} // namespace
+
+MissProfiler::MissProfiler(const SymbolTable &symbols, std::string path,
+                           uint32_t line_bytes, size_t top,
+                           const LineTable *lines)
+    : symbols_(symbols), path_(std::move(path)),
+      line_mask_(~static_cast<addr_t>(std::max(line_bytes, 4u) - 1)),
+      top_(top), lines_(lines) {
+  reset();
+}
+
+void MissProfiler::reset() {
+  cycle_ = 0;
+  mem_.reset();
+  new_requests_.clear();
+  new_responses_ = 0;
+  refills_.clear();
+  in_flight_.clear();
+  refills_total_ = 0;
+  refills_stale_ = 0;
+  pcs_.clear();
+}
+
+void MissProfiler::on_read_request(addr_t addr, uint32_t /*bytes*/) {
+  new_requests_.push_back(addr & line_mask_);
+}
+
+void MissProfiler::on_read_response() { new_responses_++; }
+
+void MissProfiler::on_cycle(const CycleSample &sample) {
+  cycle_ = sample.cycle;
+
+  for (const addr_t line : new_requests_) {
+    auto [it, inserted] = refills_.try_emplace(line);
+    if (!inserted) {
+      refills_stale_++;
+    }
+    it->second = {cycle_, 0};
+    in_flight_.push_back(line);
+    refills_total_++;
+  }
+  new_requests_.clear();
+
+  for (; new_responses_ > 0 && !in_flight_.empty(); --new_responses_) {
+    auto it = refills_.find(in_flight_.front());
+    if (it != refills_.end() && it->second.response_cycle == 0) {
+      it->second.response_cycle = cycle_;
+    }
+    in_flight_.pop_front();
+  }
+  new_responses_ = 0;
+
+  if (cycle_ % EXPIRE_INTERVAL == 0) {
+    expire(cycle_);
+  }
+}
+
+void MissProfiler::expire(uint64_t now) {
+  for (auto it = refills_.begin(); it != refills_.end();) {
+    if (now - it->second.request_cycle > STALE_CYCLES) {
+      refills_stale_++;
+      it = refills_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MissProfiler::on_retire(const RetireEvent &event) {
+  MemStream::Access access;
+  if (!mem_.on_retire(event, access)) {
+    return;
+  }
+  const addr_t line = access.addr & line_mask_;
+
+  PcStats &pc = pcs_[event.pc];
+  pc.instr = event.instr;
+  pc.store = access.store;
+  pc.accesses++;
+
+  auto it = refills_.find(line);
+  if (it != refills_.end() && it->second.request_cycle <= event.cycle) {
+    const Refill &refill = it->second;
+    const uint64_t latency = event.cycle - refill.request_cycle;
+    // Retired ahead of the last beat (critical word first): all bus time
+    const uint64_t bus =
+        refill.response_cycle > 0
+            ? std::min(refill.response_cycle - refill.request_cycle, latency)
+            : latency;
+    pc.misses++;
+    pc.latency_sum += latency;
+    pc.bus_sum += bus;
+    pc.latency_max = std::max(pc.latency_max, latency);
+    pc.histogram[bucket_of(latency, HIST_BUCKETS)]++;
+    if (pc.lines.size() < MAX_LINES_PER_PC || pc.lines.count(line)) {
+      pc.lines[line]++;
+    } else {
+      pc.other_lines++;
+    }
+    refills_.erase(it);
+  }
+}
+
+void MissProfiler::report() {
+  expire(cycle_);
+
+  std::vector<std::pair<addr_t, const PcStats *>> sorted;
+  uint64_t accesses = 0;
+  uint64_t misses = 0;
+  for (const auto &[pc, s] : pcs_) {
+    accesses += s.accesses;
+    misses += s.misses;
+    if (s.misses > 0) {
+      sorted.emplace_back(pc, &s);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto &a, const auto &b) -> bool {
+              if (a.second->misses != b.second->misses) {
+                return a.second->misses > b.second->misses;
+              }
+              return a.second->latency_sum > b.second->latency_sum;
+            });
+
+  DEMU_INFO("--- D-Cache Miss Attribution ---");
+  DEMU_INFO("  Memory ops:      {} ({} attributed misses, {:.2f}%)", accesses,
+            misses, percent(misses, accesses));
+  DEMU_INFO("  Refill bursts:   {} ({} unattributed)", refills_total_,
+            refills_total_ - misses);
+  for (size_t i = 0; i < std::min<size_t>(10, sorted.size()); ++i) {
+    const auto &[pc, s] = sorted[i];
+    DEMU_INFO("  0x{:08x} {:<28} {:>8} misses  avg {:.1f} cyc ({:.1f} bus)",
+              pc, symbols_.describe(pc), s->misses,
+              static_cast<double>(s->latency_sum) / s->misses,
+              static_cast<double>(s->bus_sum) / s->misses);
+  }
+
+  std::ofstream out(path_);
+  if (!out.is_open()) {
+    DEMU_WARN("Failed to write miss profile: {}", path_);
+    return;
+  }
+
+  out << fmt::format("# DEMU d-cache miss attribution\n");
+  out << fmt::format("# memory_ops {} misses {} refills {} stale {}\n\n",
+                     accesses, misses, refills_total_, refills_stale_);
+  out << fmt::format("{:<10} {:<28} {:<28} {:<2} {:>10} {:>8} {:>7} {:>8} "
+                     "{:>8} {:>8}  {}\n",
+                     "pc", "location", "instruction", "op", "accesses",
+                     "misses", "miss%", "avg_lat", "avg_bus", "max_lat",
+                     "source");
+  const size_t shown = std::min(top_, sorted.size());
+  for (size_t i = 0; i < shown; ++i) {
+    const auto &[pc, s] = sorted[i];
+    out << fmt::format(
+        "0x{:08x} {:<28} {:<28} {:<2} {:>10} {:>8} {:>6.2f}% {:>8.1f} "
+        "{:>8.1f} {:>8}  {}\n",
+        pc, symbols_.describe(pc), Instruction(s->instr).to_string(),
+        s->store ? "st" : "ld", s->accesses, s->misses,
+        percent(s->misses, s->accesses),
+        static_cast<double>(s->latency_sum) / s->misses,
+        static_cast<double>(s->bus_sum) / s->misses, s->latency_max,
+        lines_ ? lines_->describe(pc) : std::string());
+  }
+
+  for (size_t i = 0; i < shown; ++i) {
+    const auto &[pc, s] = sorted[i];
+    out << fmt::format("\n0x{:08x} {}\n", pc, symbols_.describe(pc));
+
+    out << "  latency histogram:\n";
+    for (size_t b = 0; b < HIST_BUCKETS; ++b) {
+      if (s->histogram[b] == 0) {
+        continue;
+      }
+      const uint64_t lo = b == 0 ? 0 : uint64_t{1} << (b - 1);
+      out << fmt::format("    {:>6}{:<8} {:>10} {:>6.2f}%\n", lo,
+                         b + 1 < HIST_BUCKETS
+                             ? fmt::format("-{}", (uint64_t{1} << b) - 1)
+                             : std::string("+"),
+                         s->histogram[b], percent(s->histogram[b], s->misses));
+    }
+
+    std::vector<std::pair<addr_t, uint64_t>> lines(s->lines.begin(),
+                                                   s->lines.end());
+    std::sort(lines.begin(), lines.end(),
+              [](const auto &a, const auto &b) -> bool {
+                return a.second != b.second ? a.second > b.second
+                                            : a.first < b.first;
+              });
+    out << fmt::format("  missing lines ({} distinct{}):\n", lines.size(),
+                       s->other_lines > 0 ? "+" : "");
+    for (size_t l = 0; l < std::min<size_t>(8, lines.size()); ++l) {
+      out << fmt::format("    0x{:08x} {:>10}\n", lines[l].first,
+                         lines[l].second);
+    }
+  }
+
+  DEMU_INFO("  Report: {}", path_);
+  DEMU_INFO("")
+}
+
+} // namespace demu::perf
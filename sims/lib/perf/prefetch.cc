@@ -0,0 +1,220 @@
+#include "demu/perf/prefetch.hh"
+#include "demu/perf/sweep.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr uint32_t MAX_DEGREE = 16;
+
+} // namespace
+
+// Next-line
+auto NextLinePrefetcher::name() const -> std::string {
+  return fmt::format("next-{}", degree_);
+}
+
+void NextLinePrefetcher::train(const Event &event, std::vector<addr_t> &out) {
+  const addr_t line = line_of(event.addr);
+  for (uint32_t k = 1; k <= degree_; ++k) {
+    out.push_back(addr_of(line + k));
+  }
+}
+
+// Stride
+StridePrefetcher::StridePrefetcher(uint32_t line_bytes, uint32_t degree,
+                                   uint32_t entries)
+    : Prefetcher(line_bytes), degree_(degree), table_(entries) {}
+
+auto StridePrefetcher::name() const -> std::string {
+  return fmt::format("stride-{}", degree_);
+}
+
+void StridePrefetcher::reset() {
+  std::fill(table_.begin(), table_.end(), Entry{});
+}
+
+void StridePrefetcher::train(const Event &event, std::vector<addr_t> &out) {
+  Entry &e = table_[(event.pc >> 2) % table_.size()];
+  if (!e.valid || e.pc != event.pc) {
+    e = {event.pc, event.addr, 0, 0, true};
+    return;
+  }
+
+  const auto stride = static_cast<int32_t>(event.addr - e.last);
+  if (stride != 0 && stride == e.stride) {
+    e.confidence = static_cast<uint8_t>(std::min(e.confidence + 1, 3));
+  } else {
+    e.confidence = e.confidence > 0 ? e.confidence - 1 : 0;
+    if (e.confidence == 0) {
+      e.stride = stride;
+    }
+  }
+  e.last = event.addr;
+
+  if (e.confidence < 2) {
+    return;
+  }
+
+  // sub-line strides walk line by line in the stride's direction
+  const int64_t line_bytes = int64_t{1} << line_shift_;
+  const int64_t step =
+      std::abs(static_cast<int64_t>(e.stride)) >= line_bytes
+          ? e.stride
+          : (e.stride > 0 ? line_bytes : -line_bytes);
+  const addr_t line = line_of(event.addr);
+  for (uint32_t k = 1; k <= degree_; ++k) {
+    const auto target = static_cast<addr_t>(event.addr + step * k);
+    if (line_of(target) != line) {
+      out.push_back(addr_of(line_of(target)));
+    }
+  }
+}
+
+// Stream
+StreamPrefetcher::StreamPrefetcher(uint32_t line_bytes, uint32_t degree,
+                                   uint32_t streams)
+    : Prefetcher(line_bytes), degree_(degree), trackers_(streams) {}
+
+auto StreamPrefetcher::name() const -> std::string {
+  return fmt::format("stream-{}", degree_);
+}
+
+void StreamPrefetcher::reset() {
+  std::fill(trackers_.begin(), trackers_.end(), Tracker{});
+  tick_ = 0;
+}
+
+void StreamPrefetcher::train(const Event &event, std::vector<addr_t> &out) {
+  const addr_t line = line_of(event.addr);
+  tick_++;
+
+  Tracker *tracker = nullptr;
+  for (auto &t : trackers_) {
+    const auto distance = static_cast<int64_t>(line) - t.last;
+    if (t.valid && distance != 0 && std::abs(distance) <= WINDOW &&
+        (t.direction == 0 || (distance > 0) == (t.direction > 0))) {
+      tracker = &t;
+      break;
+    }
+  }
+
+  if (!tracker) {
+    auto victim = std::min_element(
+        trackers_.begin(), trackers_.end(), [](const auto &a, const auto &b) {
+          return a.valid != b.valid ? !a.valid : a.stamp < b.stamp;
+        });
+    *victim = {line, 0, tick_, true};
+    return;
+  }
+
+  const int32_t direction = line > tracker->last ? 1 : -1;
+  tracker->direction = direction;
+  tracker->last = line;
+  tracker->stamp = tick_;
+
+  for (uint32_t k = 1; k <= degree_; ++k) {
+    const int64_t target = line + static_cast<int64_t>(direction) * k;
+    out.push_back(addr_of(static_cast<addr_t>(target)));
+  }
+}
+
+// Delta correlation
+DeltaPrefetcher::DeltaPrefetcher(uint32_t line_bytes, uint32_t degree,
+                                 size_t history)
+    : Prefetcher(line_bytes), degree_(degree), history_size_(history) {}
+
+auto DeltaPrefetcher::name() const -> std::string {
+  return fmt::format("delta-{}", degree_);
+}
+
+void DeltaPrefetcher::reset() {
+  deltas_.clear();
+  last_ = 0;
+  valid_ = false;
+}
+
+void DeltaPrefetcher::train(const Event &event, std::vector<addr_t> &out) {
+  const addr_t line = line_of(event.addr);
+  if (!valid_) {
+    last_ = line;
+    valid_ = true;
+    return;
+  }
+
+  const int64_t delta = static_cast<int64_t>(line) - last_;
+  last_ = line;
+  if (delta == 0) {
+    return;
+  }
+  deltas_.push_back(delta);
+  if (deltas_.size() > history_size_) {
+    deltas_.pop_front();
+  }
+
+  const size_t n = deltas_.size();
+  if (n < 3) {
+    return;
+  }
+  const int64_t d1 = deltas_[n - 2];
+  const int64_t d2 = deltas_[n - 1];
+  for (size_t i = n - 1; i-- > 1;) {
+    if (deltas_[i - 1] != d1 || deltas_[i] != d2) {
+      continue;
+    }
+    addr_t target = line;
+    for (size_t j = i + 1; j < n && j <= i + degree_; ++j) {
+      target += deltas_[j];
+      out.push_back(addr_of(target));
+    }
+    return;
+  }
+}
+
+auto parse_prefetchers(const std::string &spec, uint32_t line_bytes,
+                       std::vector<std::unique_ptr<Prefetcher>> &out) -> bool {
+  const auto fields = split_spec(spec, ':');
+  if (fields.empty() || fields.size() > 2 || line_bytes < 4 ||
+      (line_bytes & (line_bytes - 1))) {
+    return false;
+  }
+
+  std::vector<uint32_t> degrees;
+  if (fields.size() == 2) {
+    if (!parse_uint_list(fields[1], degrees)) {
+      return false;
+    }
+  } else {
+    degrees.push_back(1);
+  }
+
+  const std::string &kind = fields[0];
+  const std::vector<std::string> kinds =
+      kind == "all" ? std::vector<std::string>{"next", "stride", "stream",
+                                               "delta"}
+                    : std::vector<std::string>{kind};
+  for (const auto &k : kinds) {
+    for (uint32_t degree : degrees) {
+      if (degree == 0 || degree > MAX_DEGREE) {
+        return false;
+      }
+      if (k == "next") {
+        out.push_back(std::make_unique<NextLinePrefetcher>(line_bytes, degree));
+      } else if (k == "stride") {
+        out.push_back(std::make_unique<StridePrefetcher>(line_bytes, degree));
+      } else if (k == "stream") {
+        out.push_back(std::make_unique<StreamPrefetcher>(line_bytes, degree));
+      } else if (k == "delta") {
+        out.push_back(std::make_unique<DeltaPrefetcher>(line_bytes, degree));
+      } else {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace demu::perf
@@ -0,0 +1,155 @@
+#include "demu/perf/shadow_bpu.hh"
+#include "demu/logger.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <fstream>
+
+namespace demu::perf {
+
+ShadowBpu::ShadowBpu(const risc::BpuConfig &config, std::string report_path,
+                     std::string trace_path)
+    : report_path_(std::move(report_path)),
+      trace_path_(std::move(trace_path)) {
+  const auto &btb = config.btb();
+  const uint32_t sets = btb.sets();
+  const uint32_t ways = btb.ways();
+  const uint32_t width = config.gshare_ghr_width();
+  const CacheGeometry geometry{sets, ways, 4, btb.repl_policy()};
+
+  if (geometry.valid() && width >= 2 && width <= 24) {
+    shadows_.push_back({std::make_unique<RtlPredictor>(
+                            sets, ways, btb.repl_policy(), width),
+                        true});
+  } else {
+    DEMU_WARN("Built BPU (btb {}x{}, ghr {}) cannot be shadowed", sets, ways,
+              width);
+  }
+  reset();
+}
+
+auto ShadowBpu::add_sweep(const std::string &spec) -> bool {
+  std::vector<std::unique_ptr<BranchPredictor>> models;
+  if (!parse_predictors(spec, models)) {
+    return false;
+  }
+  for (auto &model : models) {
+    shadows_.push_back({std::move(model)});
+  }
+  return true;
+}
+
+void ShadowBpu::reset() {
+  for (auto &shadow : shadows_) {
+    shadow.model->reset();
+    shadow.lookups = 0;
+    shadow.mispredicts = 0;
+  }
+  stream_.reset();
+  instret_ = 0;
+  std::fill(std::begin(branches_), std::end(branches_), 0);
+  dut_branches_ = 0;
+  dut_mispredicts_ = 0;
+
+  if (!trace_path_.empty() && !trace_.open(trace_path_)) {
+    DEMU_WARN("Failed to open branch trace: {}", trace_path_);
+  }
+}
+
+void ShadowBpu::on_cycle(const CycleSample &sample) {
+  dut_branches_ += static_cast<uint64_t>(sample.branch_commit);
+  dut_mispredicts_ += static_cast<uint64_t>(sample.bpu_mispredict);
+}
+
+void ShadowBpu::on_retire(const RetireEvent &event) {
+  instret_++;
+
+  BranchRecord br;
+  if (!stream_.on_retire(event, br)) {
+    return;
+  }
+  branches_[static_cast<size_t>(br.kind)]++;
+  trace_.write(br);
+
+  for (auto &shadow : shadows_) {
+    switch (shadow.model->predict(br)) {
+    case BranchPredictor::Outcome::MISPREDICT:
+      shadow.mispredicts++;
+      [[fallthrough]];
+    case BranchPredictor::Outcome::CORRECT:
+      shadow.lookups++;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void ShadowBpu::report() {
+  uint64_t total = 0;
+  for (uint64_t n : branches_) {
+    total += n;
+  }
+
+  DEMU_INFO("--- Shadow Branch Predictors ({} branches) ---", total);
+  for (size_t k = 0; k < NUM_BRANCH_KINDS; ++k) {
+    if (branches_[k] > 0) {
+      DEMU_INFO("  {:<9} {:>10}", branch_kind_name(static_cast<BranchKind>(k)),
+                branches_[k]);
+    }
+  }
+  DEMU_INFO("  DUT:      {} branches, {} mispredicts, MPKI {:.2f}",
+            dut_branches_, dut_mispredicts_,
+            per_kilo(dut_mispredicts_, instret_));
+
+  for (const auto &shadow : shadows_) {
+    std::string note;
+    if (shadow.built) {
+      note = fmt::format(
+          "  [built: {:+.1f}% vs DUT]",
+          dut_mispredicts_ > 0
+              ? 100.0 *
+                    (static_cast<double>(shadow.mispredicts) -
+                     static_cast<double>(dut_mispredicts_)) /
+                    dut_mispredicts_
+              : 0.0);
+    }
+    DEMU_INFO("  {:<28} {:<5} miss {:>6.2f}%  MPKI {:>7.2f}{}",
+              shadow.model->name(), shadow.model->scope(),
+              percent(shadow.mispredicts, shadow.lookups),
+              per_kilo(shadow.mispredicts, instret_), note);
+  }
+
+  if (trace_.is_open()) {
+    DEMU_INFO("  Trace: {} ({} records, {:.2f} bytes/record)", trace_path_,
+              trace_.records(),
+              trace_.records() > 0
+                  ? static_cast<double>(trace_.bytes()) / trace_.records()
+                  : 0.0);
+    trace_.close();
+  }
+
+  if (!report_path_.empty()) {
+    std::ofstream out(report_path_);
+    if (!out.is_open()) {
+      DEMU_WARN("Failed to write shadow BPU report: {}", report_path_);
+    } else {
+      out << "model,scope,lookups,mispredicts,miss_rate,mpki,built,"
+             "dut_branches,dut_mispredicts\n";
+      for (const auto &shadow : shadows_) {
+        out << fmt::format(
+            "{},{},{},{},{:.6f},{:.4f},{},{},{}\n", shadow.model->name(),
+            shadow.model->scope(), shadow.lookups, shadow.mispredicts,
+            shadow.lookups > 0
+                ? static_cast<double>(shadow.mispredicts) / shadow.lookups
+                : 0.0,
+            per_kilo(shadow.mispredicts, instret_), shadow.built ? 1 : 0,
+            shadow.built ? dut_branches_ : 0,
+            shadow.built ? dut_mispredicts_ : 0);
+      }
+      DEMU_INFO("  Report: {}", report_path_);
+    }
+  }
+  DEMU_INFO("")
+}
+
+} // namespace demu::perf
@@ -0,0 +1,211 @@
+#include "demu/perf/shadow_cache.hh"
+#include "demu/logger.hh"
+#include "demu/perf/sweep.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <fstream>
+
+namespace demu::perf {
+
+namespace {
+
+auto side_name(ShadowCaches::Side side) noexcept -> const char * {
+  return side == ShadowCaches::Side::ICACHE ? "l1i" : "l1d";
+}
+
+} // namespace
+
+ShadowCaches::ShadowCaches(const risc::CacheConfig &l1i,
+                           const risc::CacheConfig &l1d,
+                           const risc::BusConfig &bus, std::string path)
+    : path_(std::move(path)),
+      built_policy_{l1i.repl_policy(), l1d.repl_policy()} {
+  for (const auto &region : bus.address_map()) {
+    if (region.type() == risc::DEVICE_TYPE_SRAM) {
+      cacheable_.emplace_back(region.base(), region.base() + region.size());
+    }
+  }
+  for (auto [side, config] : {std::pair{Side::ICACHE, &l1i},
+                              std::pair{Side::DCACHE, &l1d}}) {
+    const auto geometry = CacheGeometry::from_config(*config);
+    if (geometry.valid()) {
+      add(side, geometry, true);
+    } else {
+      DEMU_WARN("Built {} geometry {} cannot be shadowed", side_name(side),
+                geometry.to_string());
+    }
+  }
+}
+
+void ShadowCaches::add(Side side, const CacheGeometry &geometry,
+                       bool built) {
+  shadows_.push_back({side, built, CacheModel(geometry), ~addr_t{0}});
+}
+
+auto ShadowCaches::add_sweep(const std::string &spec) -> bool {
+  const auto fields = split_spec(spec, ':');
+  if (fields.size() < 2 || fields.size() > 3) {
+    return false;
+  }
+
+  Side side;
+  if (fields[0] == "i" || fields[0] == "l1i") {
+    side = Side::ICACHE;
+  } else if (fields[0] == "d" || fields[0] == "l1d") {
+    side = Side::DCACHE;
+  } else {
+    return false;
+  }
+
+  const auto dims = split_spec(fields[1], 'x');
+  std::vector<uint32_t> sets, ways, lines;
+  if (dims.size() != 3 || !parse_uint_list(dims[0], sets) ||
+      !parse_uint_list(dims[1], ways) || !parse_uint_list(dims[2], lines)) {
+    return false;
+  }
+
+  std::vector<risc::ReplPolicy> policies;
+  if (fields.size() < 3) {
+    policies.push_back(built_policy_[static_cast<size_t>(side)]);
+  } else if (fields[2] == "all") {
+    policies = {risc::REPL_POLICY_LRU, risc::REPL_POLICY_PSEUDO_LRU,
+                risc::REPL_POLICY_FIFO, risc::REPL_POLICY_LFU,
+                risc::REPL_POLICY_RANDOM};
+  } else {
+    for (const auto &name : split_spec(fields[2], ',')) {
+      risc::ReplPolicy policy;
+      if (!parse_repl_policy(name, policy)) {
+        return false;
+      }
+      policies.push_back(policy);
+    }
+  }
+
+  // Validate the whole cross product before adding any of it
+  std::vector<CacheGeometry> geometries;
+  for (uint32_t s : sets) {
+    for (uint32_t w : ways) {
+      for (uint32_t l : lines) {
+        for (risc::ReplPolicy p : policies) {
+          const CacheGeometry geometry{s, w, l, p};
+          if (!geometry.valid()) {
+            return false;
+          }
+          geometries.push_back(geometry);
+        }
+      }
+    }
+  }
+  for (const auto &geometry : geometries) {
+    add(side, geometry);
+  }
+  return true;
+}
+
+auto ShadowCaches::is_cacheable(addr_t addr) const noexcept -> bool {
+  if (cacheable_.empty()) {
+    return true;
+  }
+  return std::any_of(cacheable_.begin(), cacheable_.end(),
+                     [addr](const auto &r) -> bool {
+                       return addr >= r.first && addr < r.second;
+                     });
+}
+
+void ShadowCaches::reset() {
+  for (auto &shadow : shadows_) {
+    shadow.model.reset();
+    shadow.last_line = ~addr_t{0};
+  }
+  mem_.reset();
+  instret_ = 0;
+  uncached_ = 0;
+  std::fill(std::begin(real_accesses_), std::end(real_accesses_), 0);
+  std::fill(std::begin(real_misses_), std::end(real_misses_), 0);
+}
+
+void ShadowCaches::on_cycle(const CycleSample &sample) {
+  real_accesses_[0] += static_cast<uint64_t>(sample.l1_icache_access);
+  real_misses_[0] += static_cast<uint64_t>(sample.l1_icache_miss);
+  real_accesses_[1] += static_cast<uint64_t>(sample.l1_dcache_access);
+  real_misses_[1] += static_cast<uint64_t>(sample.l1_dcache_miss);
+}
+
+void ShadowCaches::on_retire(const RetireEvent &event) {
+  instret_++;
+
+  MemStream::Access access;
+  bool is_mem = mem_.on_retire(event, access);
+  if (is_mem && !is_cacheable(access.addr)) {
+    uncached_++;
+    is_mem = false;
+  }
+
+  for (auto &shadow : shadows_) {
+    if (shadow.side == Side::ICACHE) {
+      const addr_t line = event.pc / shadow.model.geometry().line_size;
+      if (line != shadow.last_line) {
+        shadow.last_line = line;
+        shadow.model.access(event.pc);
+      }
+    } else if (is_mem) {
+      shadow.model.access(access.addr);
+    }
+  }
+}
+
+void ShadowCaches::report() {
+  DEMU_INFO("--- Shadow L1 Caches ({} instructions) ---", instret_);
+  if (uncached_ > 0) {
+    DEMU_INFO("  Skipped {} uncacheable data accesses", uncached_);
+  }
+
+  for (const auto &shadow : shadows_) {
+    const auto side = static_cast<size_t>(shadow.side);
+    const CacheModel &m = shadow.model;
+    std::string note;
+    if (shadow.built) {
+      const uint64_t real = real_misses_[side];
+      note = fmt::format("  [built: DUT {} misses, {:+.1f}%]", real,
+                         real > 0 ? 100.0 * (static_cast<double>(m.misses()) -
+                                             static_cast<double>(real)) /
+                                        real
+                                  : 0.0);
+    }
+    DEMU_INFO("  {} {:>7}B {:<18} miss {:>6.2f}%  MPKI {:>7.2f}{}",
+              side_name(shadow.side), m.geometry().bytes(),
+              m.geometry().to_string(), percent(m.misses(), m.accesses()),
+              per_kilo(m.misses(), instret_), note);
+  }
+
+  if (path_.empty()) {
+    DEMU_INFO("")
+    return;
+  }
+
+  std::ofstream out(path_);
+  if (!out.is_open()) {
+    DEMU_WARN("Failed to write shadow cache report: {}", path_);
+    return;
+  }
+  out << "cache,sets,ways,line_size,bytes,policy,accesses,misses,miss_rate,"
+         "mpki,built,dut_accesses,dut_misses\n";
+  for (const auto &shadow : shadows_) {
+    const auto side = static_cast<size_t>(shadow.side);
+    const CacheModel &m = shadow.model;
+    const CacheGeometry &g = m.geometry();
+    const bool built = shadow.built;
+    out << fmt::format(
+        "{},{},{},{},{},{},{},{},{:.6f},{:.4f},{},{},{}\n",
+        side_name(shadow.side), g.sets, g.ways, g.line_size, g.bytes(),
+        repl_policy_name(g.policy), m.accesses(), m.misses(),
+        m.accesses() > 0 ? static_cast<double>(m.misses()) / m.accesses()
+                         : 0.0,
+        per_kilo(m.misses(), instret_), built ? 1 : 0,
+        built ? real_accesses_[side] : 0, built ? real_misses_[side] : 0);
+  }
+  DEMU_INFO("  Report: {}", path_);
+  DEMU_INFO("")
+}
+
+} // namespace demu::perf
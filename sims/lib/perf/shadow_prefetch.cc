@@ -0,0 +1,239 @@
+#include "demu/perf/shadow_prefetch.hh"
+#include "demu/logger.hh"
+#include "demu/perf/sweep.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <fstream>
+
+namespace demu::perf {
+
+namespace {
+
+auto side_name(ShadowPrefetchers::Side side) noexcept -> const char * {
+  return side == ShadowPrefetchers::Side::ICACHE ? "l1i" : "l1d";
+}
+
+// Tag mirror of the built L1; falls back to a 4 KiB cache when the config
+// has no usable geometry
+auto mirror_geometry(const risc::CacheConfig &config) -> CacheGeometry {
+  auto geometry = CacheGeometry::from_config(config);
+  if (geometry.policy == risc::REPL_POLICY_UNKNOWN) {
+    geometry.policy = risc::REPL_POLICY_LRU;
+  }
+  if (!geometry.valid()) {
+    geometry = {32, 4, 32, risc::REPL_POLICY_LRU};
+  }
+  return geometry;
+}
+
+} // namespace
+
+void ShadowPrefetchers::Port::on_read_request(addr_t addr,
+                                               uint32_t /*bytes*/) {
+  requests.push_back(addr);
+}
+
+auto ShadowPrefetchers::SideState::latency() const noexcept -> uint64_t {
+  return responses > 0 ? std::max<uint64_t>(1, latency_sum / responses) : 1;
+}
+
+ShadowPrefetchers::ShadowPrefetchers(const risc::CacheConfig &l1i,
+                                     const risc::CacheConfig &l1d,
+                                     std::string path, uint32_t buffer_lines)
+    : path_(std::move(path)), buffer_lines_(std::max(buffer_lines, 1u)),
+      sides_{SideState(mirror_geometry(l1i)),
+             SideState(mirror_geometry(l1d))} {}
+
+auto ShadowPrefetchers::add_sweep(const std::string &spec) -> bool {
+  const auto colon = spec.find(':');
+  if (colon == std::string::npos) {
+    return false;
+  }
+  const std::string which = spec.substr(0, colon);
+
+  Side side;
+  if (which == "i" || which == "l1i") {
+    side = Side::ICACHE;
+  } else if (which == "d" || which == "l1d") {
+    side = Side::DCACHE;
+  } else {
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Prefetcher>> prefetchers;
+  if (!parse_prefetchers(spec.substr(colon + 1),
+                         sides_[static_cast<size_t>(side)].line_bytes,
+                         prefetchers)) {
+    return false;
+  }
+  bool added = false;
+  for (auto &prefetcher : prefetchers) {
+    // the fetch stream has no load/store PCs to train on
+    if (side == Side::ICACHE &&
+        prefetcher->trigger() == Prefetcher::Trigger::ACCESS) {
+      continue;
+    }
+    Shadow shadow;
+    shadow.side = side;
+    shadow.prefetcher = std::move(prefetcher);
+    shadows_.push_back(std::move(shadow));
+    added = true;
+  }
+  return added;
+}
+
+void ShadowPrefetchers::reset() {
+  for (auto &s : sides_) {
+    s.l1.reset();
+    s.port.requests.clear();
+    s.port.responses = 0;
+    s.in_flight.clear();
+    s.misses = 0;
+    s.latency_sum = 0;
+    s.responses = 0;
+  }
+  for (auto &shadow : shadows_) {
+    shadow.prefetcher->reset();
+    shadow.buffer.clear();
+    shadow.issued = 0;
+    shadow.useful = 0;
+    shadow.timely = 0;
+    shadow.useless = 0;
+    shadow.filtered = 0;
+  }
+  mem_.reset();
+  cycle_ = 0;
+}
+
+void ShadowPrefetchers::on_cycle(const CycleSample &sample) {
+  cycle_ = sample.cycle;
+
+  for (size_t i = 0; i < 2; ++i) {
+    SideState &s = sides_[i];
+    for (const addr_t addr : s.port.requests) {
+      s.in_flight.push_back(cycle_);
+      on_miss(static_cast<Side>(i), addr / s.line_bytes);
+    }
+    s.port.requests.clear();
+
+    for (; s.port.responses > 0 && !s.in_flight.empty(); --s.port.responses) {
+      s.latency_sum += cycle_ - s.in_flight.front();
+      s.responses++;
+      s.in_flight.pop_front();
+    }
+    s.port.responses = 0;
+  }
+}
+
+void ShadowPrefetchers::on_retire(const RetireEvent &event) {
+  MemStream::Access access;
+  if (!mem_.on_retire(event, access)) {
+    return;
+  }
+  for (auto &shadow : shadows_) {
+    if (shadow.side == Side::DCACHE &&
+        shadow.prefetcher->trigger() == Prefetcher::Trigger::ACCESS) {
+      issue(shadow, {cycle_, access.addr, event.pc});
+    }
+  }
+}
+
+void ShadowPrefetchers::on_miss(Side side, addr_t line) {
+  SideState &s = sides_[static_cast<size_t>(side)];
+  const addr_t addr = line * s.line_bytes;
+  s.misses++;
+  s.l1.access(addr);
+
+  for (auto &shadow : shadows_) {
+    if (shadow.side != side) {
+      continue;
+    }
+    auto it = std::find_if(shadow.buffer.begin(), shadow.buffer.end(),
+                           [line](const auto &b) { return b.line == line; });
+    if (it != shadow.buffer.end()) {
+      shadow.useful++;
+      shadow.timely += static_cast<uint64_t>(it->ready <= cycle_);
+      shadow.buffer.erase(it);
+    }
+    if (shadow.prefetcher->trigger() == Prefetcher::Trigger::MISS) {
+      issue(shadow, {cycle_, addr, 0});
+    }
+  }
+}
+
+void ShadowPrefetchers::issue(Shadow &shadow, const Prefetcher::Event &event) {
+  SideState &s = sides_[static_cast<size_t>(shadow.side)];
+
+  candidates_.clear();
+  shadow.prefetcher->train(event, candidates_);
+
+  for (const addr_t candidate : candidates_) {
+    const addr_t line = candidate / s.line_bytes;
+    uint32_t slot;
+    if (line == event.addr / s.line_bytes || s.l1.find(candidate, slot) ||
+        std::any_of(shadow.buffer.begin(), shadow.buffer.end(),
+                    [line](const auto &b) { return b.line == line; })) {
+      shadow.filtered++;
+      continue;
+    }
+    if (shadow.buffer.size() >= buffer_lines_) {
+      shadow.useless++;
+      shadow.buffer.pop_front();
+    }
+    shadow.buffer.push_back({line, cycle_ + s.latency()});
+    shadow.issued++;
+  }
+}
+
+void ShadowPrefetchers::report() {
+  DEMU_INFO("--- Shadow Prefetchers ({}-line buffers) ---", buffer_lines_);
+  for (size_t i = 0; i < 2; ++i) {
+    const SideState &s = sides_[i];
+    if (s.misses > 0) {
+      DEMU_INFO("  {}: {} demand misses, mean refill latency {} cycles",
+                side_name(static_cast<Side>(i)), s.misses, s.latency());
+    }
+  }
+
+  for (const auto &shadow : shadows_) {
+    const SideState &s = sides_[static_cast<size_t>(shadow.side)];
+    const uint64_t extra = (shadow.issued - shadow.useful) * s.line_bytes;
+    DEMU_INFO("  {} {:<10} issued {:>8}  coverage {:>6.2f}%  accuracy "
+              "{:>6.2f}%  timely {:>6.2f}%  traffic {:>+7.2f}%",
+              side_name(shadow.side), shadow.prefetcher->name(), shadow.issued,
+              percent(shadow.useful, s.misses),
+              percent(shadow.useful, shadow.issued),
+              percent(shadow.timely, shadow.useful),
+              percent(extra, s.misses * s.line_bytes));
+  }
+
+  if (path_.empty()) {
+    DEMU_INFO("")
+    return;
+  }
+
+  std::ofstream out(path_);
+  if (!out.is_open()) {
+    DEMU_WARN("Failed to write prefetcher report: {}", path_);
+    return;
+  }
+  out << "cache,prefetcher,misses,issued,useful,timely,late,useless,unused,"
+         "filtered,coverage,accuracy,timeliness,extra_bytes,traffic_overhead\n";
+  for (const auto &shadow : shadows_) {
+    const SideState &s = sides_[static_cast<size_t>(shadow.side)];
+    const uint64_t extra = (shadow.issued - shadow.useful) * s.line_bytes;
+    out << fmt::format(
+        "{},{},{},{},{},{},{},{},{},{},{:.6f},{:.6f},{:.6f},{},{:.6f}\n",
+        side_name(shadow.side), shadow.prefetcher->name(), s.misses,
+        shadow.issued, shadow.useful, shadow.timely,
+        shadow.useful - shadow.timely, shadow.useless, shadow.buffer.size(),
+        shadow.filtered, percent(shadow.useful, s.misses) / 100.0,
+        percent(shadow.useful, shadow.issued) / 100.0,
+        percent(shadow.timely, shadow.useful) / 100.0, extra,
+        percent(extra, s.misses * s.line_bytes) / 100.0);
+  }
+  DEMU_INFO("  Report: {}", path_);
+  DEMU_INFO("")
+}
+
+} // namespace demu::perf
@@ -0,0 +1,33 @@
+#include "demu/perf/sweep.hh"
+#include <sstream>
+
+namespace demu::perf {
+
+auto split_spec(const std::string &s, char sep) -> std::vector<std::string> {
+  std::vector<std::string> parts;
+  std::stringstream ss(s);
+  std::string part;
+  while (std::getline(ss, part, sep)) {
+    parts.push_back(part);
+  }
+  return parts;
+}
+
+auto parse_uint_list(const std::string &s, std::vector<uint32_t> &out)
+    -> bool {
+  for (const auto &item : split_spec(s, ',')) {
+    try {
+      size_t pos = 0;
+      const unsigned long v = std::stoul(item, &pos, 0);
+      if (pos != item.size() || v == 0 || v > UINT32_MAX) {
+        return false;
+      }
+      out.push_back(static_cast<uint32_t>(v));
+    } catch (...) {
+      return false;
+    }
+  }
+  return !out.empty();
+}
+
+} // namespace demu::perf
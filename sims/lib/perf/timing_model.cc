@@ -0,0 +1,619 @@
+#include "demu/perf/timing_model.hh"
+#include "demu/perf/bpu_model.hh"
+#include "demu/perf/cache_model.hh"
+#include "demu/perf/inst_trace.hh"
+#include "demu/perf/sweep.hh"
+#include "demu/perf/util.hh"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fmt/format.h>
+#include <fstream>
+#include <memory>
+
+namespace demu::perf {
+
+namespace {
+
+constexpr uint32_t MAX_MISS_PENALTY = 4096;
+
+void decode(instr_t instr, TimingOp &op) noexcept {
+  const uint8_t opcode = instr & 0x7F;
+  const auto rd = static_cast<uint8_t>((instr >> 7) & 0x1F);
+  const auto rs1 = static_cast<uint8_t>((instr >> 15) & 0x1F);
+  const auto rs2 = static_cast<uint8_t>((instr >> 20) & 0x1F);
+
+  op.unit = risc::FUNCTIONAL_UNIT_TYPE_ALU;
+  switch (opcode) {
+  case OPCODE_OP:
+    if ((instr >> 25) == 1) {
+      op.unit = ((instr >> 12) & 0x7) < 4 ? risc::FUNCTIONAL_UNIT_TYPE_MULT
+                                          : risc::FUNCTIONAL_UNIT_TYPE_DIV;
+    }
+    op.rd = rd;
+    op.rs1 = rs1;
+    op.rs2 = rs2;
+    break;
+  case OPCODE_OP_IMM:
+    op.rd = rd;
+    op.rs1 = rs1;
+    break;
+  case OPCODE_LUI:
+  case OPCODE_AUIPC:
+    op.rd = rd;
+    break;
+  case OPCODE_LOAD:
+    op.unit = risc::FUNCTIONAL_UNIT_TYPE_LD;
+    op.rd = rd;
+    op.rs1 = rs1;
+    break;
+  case OPCODE_STORE:
+    op.unit = risc::FUNCTIONAL_UNIT_TYPE_ST;
+    op.rs1 = rs1;
+    op.rs2 = rs2;
+    break;
+  case OPCODE_BRANCH:
+    op.unit = risc::FUNCTIONAL_UNIT_TYPE_BRU;
+    op.rs1 = rs1;
+    op.rs2 = rs2;
+    break;
+  case OPCODE_JAL:
+    op.unit = risc::FUNCTIONAL_UNIT_TYPE_BRU;
+    op.rd = rd;
+    break;
+  case OPCODE_JALR:
+    op.unit = risc::FUNCTIONAL_UNIT_TYPE_BRU;
+    op.rd = rd;
+    op.rs1 = rs1;
+    break;
+  case OPCODE_SYSTEM:
+    op.unit = risc::FUNCTIONAL_UNIT_TYPE_CSR;
+    op.rd = rd;
+    op.rs1 = rs1;
+    op.serialize = true;
+    break;
+  case OPCODE_MISC_MEM:
+    op.serialize = true;
+    break;
+  default:
+    break;
+  }
+}
+
+auto unit_type(const std::string &key, risc::FunctionalUnitType &type)
+    -> bool {
+  static const std::pair<const char *, risc::FunctionalUnitType> units[] = {
+      {"alu", risc::FUNCTIONAL_UNIT_TYPE_ALU},
+      {"mult", risc::FUNCTIONAL_UNIT_TYPE_MULT},
+      {"ld", risc::FUNCTIONAL_UNIT_TYPE_LD},
+      {"st", risc::FUNCTIONAL_UNIT_TYPE_ST},
+      {"bru", risc::FUNCTIONAL_UNIT_TYPE_BRU},
+      {"csr", risc::FUNCTIONAL_UNIT_TYPE_CSR},
+      {"div", risc::FUNCTIONAL_UNIT_TYPE_DIV},
+  };
+  for (const auto &[name, t] : units) {
+    if (key == name) {
+      type = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto parse_geometry(const std::string &value, size_t fields,
+                    std::vector<uint32_t> &out) -> bool {
+  const auto parts = split_spec(value, 'x');
+  if (parts.size() != fields) {
+    return false;
+  }
+  for (const auto &part : parts) {
+    std::vector<uint32_t> v;
+    if (!parse_uint_list(part, v) || v.size() != 1) {
+      return false;
+    }
+    out.push_back(v[0]);
+  }
+  return true;
+}
+
+// Geometries of configs dumped without a replacement policy default to LRU
+auto geometry_of(uint32_t sets, uint32_t ways, uint32_t line,
+                 risc::ReplPolicy policy) -> CacheGeometry {
+  return {sets, ways, line,
+          policy == risc::REPL_POLICY_UNKNOWN ? risc::REPL_POLICY_LRU
+                                              : policy};
+}
+
+auto geometry_of(const risc::CacheConfig &config) -> CacheGeometry {
+  return geometry_of(config.sets(), config.ways(), config.line_size(),
+                     config.repl_policy());
+}
+
+auto apply(const std::string &key, const std::string &value,
+           risc::RiscConfig &config) -> bool {
+  std::vector<uint32_t> v;
+  risc::FunctionalUnitType type;
+
+  if (key == "scheduler") {
+    if (value == "inorder") {
+      config.mutable_scheduler()->set_policy(risc::SCHEDULE_POLICY_INORDER);
+    } else if (value == "scoreboard") {
+      config.mutable_scheduler()->set_policy(
+          risc::SCHEDULE_POLICY_SCOREBOARD);
+    } else if (value == "tomasulo") {
+      config.mutable_scheduler()->set_policy(risc::SCHEDULE_POLICY_TOMASULO);
+    } else {
+      return false;
+    }
+  } else if (key == "l1i" || key == "l1d") {
+    if (!parse_geometry(value, 3, v)) {
+      return false;
+    }
+    auto *cache = key == "l1i" ? config.mutable_l1i() : config.mutable_l1d();
+    cache->set_sets(v[0]);
+    cache->set_ways(v[1]);
+    cache->set_line_size(v[2]);
+    if (!geometry_of(*cache).valid()) {
+      return false;
+    }
+  } else if (key == "btb") {
+    if (!parse_geometry(value, 2, v)) {
+      return false;
+    }
+    auto *btb = config.mutable_bpu()->mutable_btb();
+    btb->set_sets(v[0]);
+    btb->set_ways(v[1]);
+    if (!geometry_of(btb->sets(), btb->ways(), 4, btb->repl_policy())
+             .valid()) {
+      return false;
+    }
+  } else if (!parse_uint_list(value, v) || v.size() != 1) {
+    return false;
+  } else if (key == "issue_width") {
+    config.mutable_ifu()->set_issue_width(v[0]);
+  } else if (key == "ibuffer") {
+    config.mutable_ifu()->set_ibuffer_size(v[0]);
+  } else if (key == "rob") {
+    config.mutable_rob()->set_size(v[0]);
+  } else if (key == "ghr") {
+    if (v[0] < 2 || v[0] > 24) {
+      return false;
+    }
+    config.mutable_bpu()->set_gshare_ghr_width(v[0]);
+  } else if (unit_type(key, type)) {
+    auto *fus = config.mutable_scheduler()->mutable_fus();
+    fus->erase(std::remove_if(fus->begin(), fus->end(),
+                              [type](const auto &fu) {
+                                return fu.type() == type;
+                              }),
+               fus->end());
+    for (uint32_t k = 0; k < v[0]; ++k) {
+      auto *fu = fus->Add();
+      fu->set_name(fmt::format("{}{}", key, k));
+      fu->set_type(type);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Units of one type; `free` is the first cycle each unit can issue again
+struct UnitPool {
+  std::vector<uint64_t> free;
+  bool pipelined{true};
+};
+
+} // namespace
+
+auto TimingParams::read(const std::string &path) -> bool {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    line = line.substr(0, line.find('#'));
+    line.erase(std::remove_if(line.begin(), line.end(), ::isspace),
+               line.end());
+    if (line.empty()) {
+      continue;
+    }
+    const auto eq = line.find('=');
+    if (eq == std::string::npos) {
+      return false;
+    }
+    // penalties may be fitted to 0, which parse_uint_list() rejects
+    uint32_t value;
+    try {
+      size_t pos = 0;
+      const std::string text = line.substr(eq + 1);
+      const unsigned long v = std::stoul(text, &pos, 0);
+      if (pos != text.size() || v > UINT32_MAX) {
+        return false;
+      }
+      value = static_cast<uint32_t>(v);
+    } catch (...) {
+      return false;
+    }
+    const std::string key = line.substr(0, eq);
+    if (key == "icache_miss") {
+      icache_miss = value;
+    } else if (key == "dcache_miss") {
+      dcache_miss = value;
+    } else if (key == "mispredict") {
+      mispredict = value;
+    } else if (key == "load_use") {
+      load_use = value;
+    } else if (key == "mult") {
+      mult = value;
+    } else if (key == "div") {
+      div = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto TimingParams::write(const std::string &path) const -> bool {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    return false;
+  }
+  out << "# demu-model timing parameters (cycles)\n"
+      << "icache_miss=" << icache_miss << "\n"
+      << "dcache_miss=" << dcache_miss << "\n"
+      << "mispredict=" << mispredict << "\n"
+      << "load_use=" << load_use << "\n"
+      << "mult=" << mult << "\n"
+      << "div=" << div << "\n";
+  return out.good();
+}
+
+auto TimingParams::to_string() const -> std::string {
+  return fmt::format("icache_miss={} dcache_miss={} mispredict={} "
+                     "load_use={} mult={} div={}",
+                     icache_miss, dcache_miss, mispredict, load_use, mult, div);
+}
+
+auto TimingTrace::load(const std::string &path) -> bool {
+  InstTraceReader reader;
+  if (!reader.open(path)) {
+    return false;
+  }
+  ops_.clear();
+
+  BranchStream stream;
+  InstRecord record;
+  while (reader.next(record)) {
+    TimingOp op;
+    op.pc = record.pc;
+    op.addr = record.addr;
+    op.target = record.pc + 4;
+    decode(record.instr, op);
+
+    BranchRecord br;
+    if (stream.on_retire({0, 0, record.pc, record.instr}, br)) {
+      ops_.back().branch = true;
+      ops_.back().kind = br.kind;
+    }
+    if (!ops_.empty()) {
+      ops_.back().target = record.pc;
+    }
+    ops_.push_back(op);
+  }
+  has_reference_ = reader.has_reference();
+  reference_ = reader.reference();
+  return true;
+}
+
+auto TimingModel::run(const TimingTrace &trace) const -> PerfCounters {
+  const auto &ops = trace.ops();
+  const size_t width = std::max(config_.ifu().issue_width(), 1u);
+  const size_t rob = std::max(config_.rob().size(), 1u);
+  const size_t ibuffer = std::max<size_t>(config_.ifu().ibuffer_size(), width);
+  const size_t sb_size = std::max(config_.mem().store_buffer_size(), 1u);
+  const auto policy = config_.scheduler().policy();
+
+  size_t ring = 1;
+  while (ring < std::max(rob, ibuffer) + width + 1) {
+    ring <<= 1;
+  }
+  const size_t mask = ring - 1;
+  std::vector<uint64_t> dispatched(ring, 0);
+  std::vector<uint64_t> committed(ring, 0);
+
+  // Per-cycle issue slots, tagged with the cycle they count
+  constexpr size_t SLOT_RING = 1024;
+  std::vector<std::pair<uint64_t, uint32_t>> slots(SLOT_RING, {~0ull, 0});
+
+  UnitPool pools[risc::FunctionalUnitType_ARRAYSIZE];
+  for (const auto &fu : config_.scheduler().fus()) {
+    if (risc::FunctionalUnitType_IsValid(fu.type())) {
+      pools[fu.type()].free.push_back(0);
+    }
+  }
+  for (auto t : {risc::FUNCTIONAL_UNIT_TYPE_MULT,
+                 risc::FUNCTIONAL_UNIT_TYPE_DIV}) {
+    pools[t].pipelined = false;
+  }
+  // configs without unit lists get one unit of each type
+  for (auto &pool : pools) {
+    if (pool.free.empty()) {
+      pool.free.push_back(0);
+    }
+  }
+
+  const auto l1i_geometry = geometry_of(config_.l1i());
+  const auto l1d_geometry = geometry_of(config_.l1d());
+  std::unique_ptr<CacheModel> l1i;
+  std::unique_ptr<CacheModel> l1d;
+  if (l1i_geometry.valid()) {
+    l1i = std::make_unique<CacheModel>(l1i_geometry);
+  }
+  if (l1d_geometry.valid()) {
+    l1d = std::make_unique<CacheModel>(l1d_geometry);
+  }
+  const auto &btb = config_.bpu().btb();
+  const uint32_t ghr = config_.bpu().gshare_ghr_width();
+  const auto btb_geometry =
+      geometry_of(btb.sets(), btb.ways(), 4, btb.repl_policy());
+  std::unique_ptr<BranchPredictor> bpu;
+  if (btb_geometry.valid() && ghr >= 2 && ghr <= 24) {
+    bpu = std::make_unique<RtlPredictor>(btb.sets(), btb.ways(),
+                                         btb_geometry.policy, ghr);
+  }
+  const uint32_t line_shift =
+      l1i ? static_cast<uint32_t>(__builtin_ctz(l1i_geometry.line_size)) : 2;
+
+  PerfCounters out;
+  uint64_t reg_ready[NUM_GPRS] = {};
+  std::vector<uint64_t> store_buffer;
+  size_t sb_head = 0;
+  uint64_t store_free = 0;
+
+  uint64_t fetch_cycle = 0;
+  size_t fetch_slots = 0;
+  bool group_break = true;
+  addr_t fetch_line = ~addr_t{0};
+  uint64_t redirect = 0;
+  uint64_t last_dispatch = 0;
+  uint64_t last_issue = 0;
+  uint64_t last_commit = 0;
+
+  for (size_t i = 0; i < ops.size(); ++i) {
+    const TimingOp &op = ops[i];
+
+    // fetch
+    uint64_t f = std::max(fetch_cycle + (group_break || fetch_slots >= width),
+                          redirect);
+    if (i >= ibuffer) {
+      f = std::max(f, dispatched[(i - ibuffer) & mask]);
+    }
+    const addr_t line = op.pc >> line_shift;
+    if (line != fetch_line || f != fetch_cycle) {
+      out.l1_icache_access++;
+      if (l1i && !l1i->access(op.pc)) {
+        out.l1_icache_miss++;
+        f += params_.icache_miss;
+      }
+      fetch_line = line;
+    }
+    if (f != fetch_cycle) {
+      fetch_slots = 0;
+    }
+    fetch_cycle = f;
+    fetch_slots++;
+    group_break = false;
+
+    // dispatch into the ROB
+    uint64_t d = std::max(f + 1, last_dispatch);
+    if (i >= width) {
+      d = std::max(d, dispatched[(i - width) & mask] + 1);
+    }
+    if (i >= rob) {
+      d = std::max(d, committed[(i - rob) & mask]);
+    }
+    dispatched[i & mask] = d;
+    last_dispatch = d;
+
+    // issue
+    uint64_t ready = std::max({d + 1, reg_ready[op.rs1], reg_ready[op.rs2]});
+    if (policy == risc::SCHEDULE_POLICY_INORDER) {
+      ready = std::max(ready, last_issue);
+    } else if (policy == risc::SCHEDULE_POLICY_SCOREBOARD) {
+      ready = std::max({ready, last_issue, reg_ready[op.rd]});
+    }
+    if (op.serialize) {
+      ready = std::max(ready, last_commit);
+    }
+    UnitPool &pool = pools[op.unit];
+    auto unit = std::min_element(pool.free.begin(), pool.free.end());
+    uint64_t issue = std::max(ready, *unit);
+    for (;;) {
+      auto &slot = slots[issue % SLOT_RING];
+      if (slot.first != issue) {
+        slot = {issue, 0};
+      }
+      if (slot.second < width) {
+        slot.second++;
+        break;
+      }
+      issue++;
+    }
+    last_issue = issue;
+
+    uint32_t latency = 1;
+    bool store_miss = false;
+    switch (op.unit) {
+    case risc::FUNCTIONAL_UNIT_TYPE_MULT:
+      latency = params_.mult;
+      break;
+    case risc::FUNCTIONAL_UNIT_TYPE_DIV:
+      latency = params_.div;
+      break;
+    case risc::FUNCTIONAL_UNIT_TYPE_LD:
+      latency = params_.load_use;
+      out.l1_dcache_access++;
+      if (l1d && !l1d->access(op.addr)) {
+        out.l1_dcache_miss++;
+        latency += params_.dcache_miss;
+      }
+      break;
+    case risc::FUNCTIONAL_UNIT_TYPE_ST:
+      out.l1_dcache_access++;
+      if (l1d && !l1d->access(op.addr)) {
+        out.l1_dcache_miss++;
+        store_miss = true;
+      }
+      break;
+    default:
+      break;
+    }
+    latency = std::max(latency, 1u);
+    *unit = issue + (pool.pipelined ? 1 : latency);
+    const uint64_t complete = issue + latency;
+    if (op.rd != 0) {
+      reg_ready[op.rd] = complete;
+    }
+
+    // commit; stores then drain through the store buffer one at a time
+    uint64_t c = std::max(complete + 1, last_commit);
+    if (i >= width) {
+      c = std::max(c, committed[(i - width) & mask] + 1);
+    }
+    if (op.unit == risc::FUNCTIONAL_UNIT_TYPE_ST) {
+      while (sb_head < store_buffer.size() && store_buffer[sb_head] <= c) {
+        sb_head++;
+      }
+      if (store_buffer.size() - sb_head >= sb_size) {
+        c = std::max(c, store_buffer[sb_head++]);
+      }
+      store_free = std::max(store_free, c) + 1 +
+                   (store_miss ? params_.dcache_miss : 0);
+      store_buffer.push_back(store_free);
+      if (sb_head > 4096) {
+        store_buffer.erase(store_buffer.begin(),
+                           store_buffer.begin() +
+                               static_cast<std::ptrdiff_t>(sb_head));
+        sb_head = 0;
+      }
+    }
+    committed[i & mask] = c;
+    last_commit = c;
+
+    if (op.branch) {
+      out.branch_commit++;
+      const BranchRecord br{op.pc, op.target, op.target != op.pc + 4, op.kind};
+      const bool mispredict =
+          bpu ? bpu->predict(br) == BranchPredictor::Outcome::MISPREDICT
+              : br.taken;
+      if (mispredict) {
+        out.bpu_mispredict++;
+        redirect = complete + params_.mispredict;
+        out.flush_cycle += params_.mispredict;
+      }
+      group_break = br.taken;
+    }
+  }
+
+  out.instret = ops.size();
+  out.issue_count = ops.size();
+  out.cycles = ops.empty() ? 0 : last_commit + 1;
+  return out;
+}
+
+auto calibrate(const risc::RiscConfig &config, const TimingTrace &trace,
+               TimingParams &params) -> double {
+  if (!trace.has_reference() || trace.ops().empty()) {
+    return -1.0;
+  }
+  const PerfCounters &ref = trace.reference();
+  if (ref.bpu_mispredict > 0 && ref.flush_cycle > 0) {
+    params.mispredict = static_cast<uint32_t>(std::lround(
+        static_cast<double>(ref.flush_cycle) / ref.bpu_mispredict));
+  }
+
+  auto cycles_at = [&](uint32_t penalty) {
+    TimingParams p = params;
+    p.icache_miss = penalty;
+    p.dcache_miss = penalty;
+    return TimingModel(config, p).run(trace).cycles;
+  };
+
+  // cycles are monotonic in the miss penalty; find the first penalty that
+  // reaches the reference, then take the closer of it and its predecessor
+  uint32_t lo = 0;
+  uint32_t hi = MAX_MISS_PENALTY;
+  if (cycles_at(hi) < ref.cycles) {
+    lo = hi;
+  }
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (cycles_at(mid) < ref.cycles) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  uint32_t best = lo;
+  if (lo > 0) {
+    const auto above = static_cast<double>(cycles_at(lo)) - ref.cycles;
+    const auto below = static_cast<double>(ref.cycles) - cycles_at(lo - 1);
+    best = below < above ? lo - 1 : lo;
+  }
+  params.icache_miss = best;
+  params.dcache_miss = best;
+
+  const uint64_t cycles = TimingModel(config, params).run(trace).cycles;
+  return ref.cycles > 0 ? (static_cast<double>(cycles) - ref.cycles) /
+                              static_cast<double>(ref.cycles)
+                        : 0.0;
+}
+
+auto TimingSweep::add_axis(const std::string &spec) -> bool {
+  const auto eq = spec.find('=');
+  if (eq == std::string::npos) {
+    return false;
+  }
+  Axis axis{spec.substr(0, eq), {}};
+  // geometries carry no commas, so every axis splits on them
+  risc::RiscConfig scratch;
+  for (const auto &value : split_spec(spec.substr(eq + 1), ',')) {
+    if (!apply(axis.key, value, scratch)) {
+      return false;
+    }
+    axis.values.push_back(value);
+  }
+  if (axis.values.empty()) {
+    return false;
+  }
+  axes_.push_back(std::move(axis));
+  return true;
+}
+
+auto TimingSweep::expand(const risc::RiscConfig &base) const
+    -> std::vector<Point> {
+  std::vector<Point> points{{base, ""}};
+  for (const auto &axis : axes_) {
+    std::vector<Point> next;
+    next.reserve(points.size() * axis.values.size());
+    for (const auto &point : points) {
+      for (const auto &value : axis.values) {
+        Point p = point;
+        (void)apply(axis.key, value, p.config);
+        p.label += fmt::format("{}{}={}", p.label.empty() ? "" : " ",
+                               axis.key, value);
+        next.push_back(std::move(p));
+      }
+    }
+    points = std::move(next);
+  }
+  if (axes_.empty()) {
+    points.front().label = "base";
+  }
+  return points;
+}
+
+} // namespace demu::perf
@@ -0,0 +1,288 @@
+#include "demu/profiling.hh"
+#include "demu/hal/peripheral/cache/l2.hh"
+#include "demu/perf/branch.hh"
+#include "demu/perf/hotspot.hh"
+#include "demu/perf/inst_trace.hh"
+#include "demu/perf/miss.hh"
+#include "demu/perf/shadow_bpu.hh"
+#include "demu/perf/shadow_cache.hh"
+#include "demu/perf/shadow_prefetch.hh"
+#include "demu/roi.hh"
+#include "demu/sim.hh"
+#include <iostream>
+
+namespace demu {
+
+namespace {
+
+// Rows shown in the per-PC profile reports
+constexpr size_t PROFILE_TOP = 25;
+
+} // namespace
+
+auto ProfilingOptions::parse(int argc, char **argv, int &i) -> OptionMatch {
+  const std::string arg = argv[i];
+  // Value of an option that takes one, or nullptr at the end of argv
+  const auto value = [&]() -> const char * {
+    return i + 1 < argc ? argv[++i] : nullptr;
+  };
+
+  if (arg == "--roi") {
+    uint8_t id = 0;
+    std::string name;
+    const char *spec = value();
+    if (spec && !parse_roi_name(spec, id, name)) {
+      std::cerr << "Invalid ROI name: " << spec << std::endl;
+      return OptionMatch::INVALID;
+    }
+    roi_names.emplace_back(id, name);
+  } else if (arg == "--watchdog") {
+    if (const char *v = value()) {
+      watchdog.stall_cycles = std::stoull(v);
+    }
+  } else if (arg == "--livelock-window") {
+    if (const char *v = value()) {
+      watchdog.livelock_window = std::stoull(v);
+    }
+  } else if (arg == "--profile") {
+    if (const char *v = value()) {
+      profile_prefix = v;
+    }
+  } else if (arg == "--branch-profile") {
+    if (const char *v = value()) {
+      branch_profile = v;
+    }
+  } else if (arg == "--miss-profile") {
+    if (const char *v = value()) {
+      miss_profile = v;
+    }
+  } else if (arg == "--shadow-cache") {
+    shadow_caches = true;
+    if (const char *v = value()) {
+      shadow_specs.emplace_back(v);
+    }
+  } else if (arg == "--shadow-report") {
+    shadow_caches = true;
+    if (const char *v = value()) {
+      shadow_report = v;
+    }
+  } else if (arg == "--shadow-bpu") {
+    shadow_bpu = true;
+    if (const char *v = value()) {
+      bpu_specs.emplace_back(v);
+    }
+  } else if (arg == "--bpu-report") {
+    shadow_bpu = true;
+    if (const char *v = value()) {
+      bpu_report = v;
+    }
+  } else if (arg == "--branch-trace") {
+    shadow_bpu = true;
+    if (const char *v = value()) {
+      branch_trace = v;
+    }
+  } else if (arg == "--inst-trace") {
+    if (const char *v = value()) {
+      inst_trace = v;
+    }
+  } else if (arg == "--prefetch") {
+    if (const char *v = value()) {
+      const std::string spec = v;
+      if (spec.rfind("l2:", 0) == 0) {
+        l2_prefetcher = spec.substr(3);
+      } else {
+        shadow_prefetch = true;
+        prefetch_specs.push_back(spec);
+      }
+    }
+  } else if (arg == "--prefetch-report") {
+    shadow_prefetch = true;
+    if (const char *v = value()) {
+      prefetch_report = v;
+    }
+  } else if (arg == "--l2") {
+    const char *spec = value();
+    if (spec && !hal::cache::parse_l2_spec(spec, l2_config)) {
+      std::cerr << "Invalid L2 spec: " << spec << std::endl;
+      return OptionMatch::INVALID;
+    }
+    l2 = true;
+  } else if (arg == "--topdown-interval") {
+    if (const char *v = value()) {
+      topdown_interval = std::stoull(v);
+    }
+  } else if (arg == "--topdown-report") {
+    if (const char *v = value()) {
+      topdown_report = v;
+    }
+  } else if (arg == "--interval") {
+    const char *spec = value();
+    if (spec && !perf::parse_interval_spec(spec, interval)) {
+      std::cerr << "Invalid interval: " << spec << std::endl;
+      return OptionMatch::INVALID;
+    }
+  } else if (arg == "--interval-report") {
+    if (const char *v = value()) {
+      interval_report = v;
+    }
+  } else if (arg == "--report") {
+    if (const char *v = value()) {
+      report_file = v;
+    }
+  } else if (arg == "--live-stats") {
+    if (const char *v = value()) {
+      live_stats = std::stoull(v);
+    }
+  } else if (arg == "--host-profile") {
+    if (const char *v = value()) {
+      host_profile = std::stoull(v);
+    }
+  } else if (arg == "--host-counters") {
+    host_counters = true;
+  } else {
+    return OptionMatch::NONE;
+  }
+  return OptionMatch::CONSUMED;
+}
+
+void ProfilingOptions::print_usage() {
+  std::cout << "      --roi <id>=<name>         Name a region of interest "
+               "marker id\n";
+  std::cout << "      --profile <prefix>        Write hotspot profile to "
+               "<prefix>.txt and <prefix>.folded\n";
+  std::cout << "      --branch-profile <file>   Write per-branch mispredict "
+               "profile to <file>\n";
+  std::cout << "      --miss-profile <file>     Write per-PC d-cache miss "
+               "attribution to <file>\n";
+  std::cout << "      --shadow-cache <spec>     Model extra L1 configs, "
+               "<i|d>:<sets>x<ways>x<line>[:<policies>]\n";
+  std::cout << "      --shadow-report <file>    Write shadow cache results "
+               "as CSV to <file>\n";
+  std::cout << "      --shadow-bpu <spec>       Model extra predictors "
+               "(gshare:<w>, bimodal:<b>, tage, btb:<s>x<w>, ras:<n>, "
+               "rtl:<s>x<w>:<ghr>)\n";
+  std::cout << "      --bpu-report <file>       Write shadow predictor "
+               "results as CSV to <file>\n";
+  std::cout << "      --branch-trace <file>     Write a compact committed "
+               "branch trace to <file>\n";
+  std::cout << "      --inst-trace <file>       Write the committed "
+               "instruction trace and counters to <file>\n";
+  std::cout << "      --prefetch <spec>         Evaluate prefetchers, "
+               "<i|d|l2>:<next|stride|stream|delta|all>[:<degree>]\n";
+  std::cout << "      --prefetch-report <file>  Write shadow prefetcher "
+               "results as CSV to <file>\n";
+  std::cout << "      --l2 <spec>               Put a shared L2 in front of "
+               "imem/dmem, <sets>x<ways>x<line>[:hit=<n>,miss=<n>,mshr=<n>,"
+               "<policy>,wb|wt,incl|nincl]\n";
+  std::cout << "      --topdown-interval <n>    Top-down breakdown every n "
+               "cycles\n";
+  std::cout << "      --topdown-report <file>   Write the interval breakdown "
+               "as CSV to <file>\n";
+  std::cout << "      --interval <n>[i]         Sample every counter each n "
+               "cycles, or n instructions with 'i' (default: 10000)\n";
+  std::cout << "      --interval-report <file>  Write the samples to <file>, "
+               "CSV for *.csv, binary otherwise\n";
+  std::cout << "      --report <file>           Write a run report as "
+               "<file>.pb and <file>.json\n";
+  std::cout << "      --live-stats <n>          Publish counters to shared "
+               "memory every n cycles (see demu-top)\n";
+  std::cout << "      --host-profile <k>        Time the host phases of one "
+               "cycle in every k\n";
+  std::cout << "      --host-counters           Add host hardware counters "
+               "(perf_event_open, all threads) to --host-profile\n";
+  std::cout << "      --watchdog <n>            Stop with status 120 after n "
+               "cycles without retirement\n";
+  std::cout << "      --livelock-window <n>     Stop with status 121 when 2 "
+               "windows of n retirements add no new state\n";
+}
+
+auto attach_profilers(DemuSimulator &sim, const ProfilingOptions &options)
+    -> bool {
+  for (const auto &[id, name] : options.roi_names) {
+    sim.roi_name(id, name);
+  }
+  sim.watchdog(options.watchdog);
+
+  if (!options.profile_prefix.empty()) {
+    sim.add_probe<perf::HotspotProfiler>(sim.symbols(), options.profile_prefix,
+                                         PROFILE_TOP, &sim.lines());
+  }
+  if (!options.branch_profile.empty()) {
+    sim.add_probe<perf::BranchProfiler>(sim.symbols(), options.branch_profile,
+                                        PROFILE_TOP, &sim.lines());
+  }
+  if (!options.miss_profile.empty()) {
+    auto *misses = sim.add_probe<perf::MissProfiler>(
+        sim.symbols(), options.miss_profile, sim.config().l1d().line_size(),
+        PROFILE_TOP, &sim.lines());
+    sim.observe_master(hal::BusMaster::DCACHE, misses);
+  }
+  if (options.shadow_caches) {
+    auto *shadows = sim.add_probe<perf::ShadowCaches>(
+        sim.config().l1i(), sim.config().l1d(), sim.config().bus(),
+        options.shadow_report);
+    for (const auto &spec : options.shadow_specs) {
+      if (!shadows->add_sweep(spec)) {
+        std::cerr << "Invalid shadow cache spec: " << spec << std::endl;
+        return false;
+      }
+    }
+  }
+  if (options.shadow_bpu) {
+    auto *bpus = sim.add_probe<perf::ShadowBpu>(
+        sim.config().bpu(), options.bpu_report, options.branch_trace);
+    for (const auto &spec : options.bpu_specs) {
+      if (!bpus->add_sweep(spec)) {
+        std::cerr << "Invalid shadow BPU spec: " << spec << std::endl;
+        return false;
+      }
+    }
+  }
+  if (!options.inst_trace.empty()) {
+    sim.add_probe<perf::InstTracer>(options.inst_trace);
+  }
+  if (options.shadow_prefetch) {
+    auto *prefetchers = sim.add_probe<perf::ShadowPrefetchers>(
+        sim.config().l1i(), sim.config().l1d(), options.prefetch_report);
+    for (const auto &spec : options.prefetch_specs) {
+      if (!prefetchers->add_sweep(spec)) {
+        std::cerr << "Invalid prefetcher spec: " << spec << std::endl;
+        return false;
+      }
+    }
+    using Side = perf::ShadowPrefetchers::Side;
+    using hal::BusMaster;
+    sim.observe_master(BusMaster::ICACHE, prefetchers->port(Side::ICACHE));
+    sim.observe_master(BusMaster::DCACHE, prefetchers->port(Side::DCACHE));
+  }
+
+  if (options.topdown_interval > 0 || !options.topdown_report.empty()) {
+    sim.topdown_interval(
+        options.topdown_interval > 0 ? options.topdown_interval : 10000,
+        options.topdown_report);
+  }
+  if (!options.interval_report.empty()) {
+    sim.intervals(options.interval, options.interval_report);
+  }
+  sim.live_stats(options.live_stats);
+  sim.host_profile(options.host_counters && options.host_profile == 0
+                       ? 1000
+                       : options.host_profile,
+                   options.host_counters);
+  if (options.l2) {
+    sim.l2(options.l2_config);
+  }
+  if (!options.l2_prefetcher.empty()) {
+    sim.l2_prefetcher(options.l2_prefetcher);
+  }
+  return true;
+}
+
+void finish_profilers(const DemuSimulator &sim,
+                      const ProfilingOptions &options) {
+  if (!options.report_file.empty()) {
+    (void)sim.write_report(options.report_file);
+  }
+}
+
+} // namespace demu
@@ -0,0 +1,154 @@
+#include "demu/roi.hh"
+#include "demu/logger.hh"
+#include "demu/topdown.hh"
+
+namespace demu {
+
+namespace {
+
+auto ratio(uint64_t num, uint64_t den) noexcept -> double {
+  return den > 0 ? static_cast<double>(num) / static_cast<double>(den) : 0.0;
+}
+
+auto hit_rate(uint64_t misses, uint64_t accesses) noexcept -> double {
+  return accesses > 0 ? 1.0 - ratio(misses, accesses) : 0.0;
+}
+
+} // namespace
+
+auto parse_roi_name(const std::string &spec, uint8_t &id, std::string &name)
+    -> bool {
+  const size_t eq = spec.find('=');
+  if (eq == 0 || eq == std::string::npos || eq + 1 == spec.size()) {
+    return false;
+  }
+  try {
+    size_t used = 0;
+    const unsigned long value = std::stoul(spec.substr(0, eq), &used, 0);
+    if (used != eq || value > 0xFF) {
+      return false;
+    }
+    id = static_cast<uint8_t>(value);
+  } catch (...) {
+    return false;
+  }
+  name = spec.substr(eq + 1);
+  return true;
+}
+
+auto PerfCounters::operator+=(const PerfCounters &rhs) noexcept
+    -> PerfCounters & {
+  for (const auto &field : PERF_COUNTER_FIELDS) {
+    this->*field.member += rhs.*field.member;
+  }
+  return *this;
+}
+
+auto PerfCounters::operator-(const PerfCounters &rhs) const noexcept
+    -> PerfCounters {
+  PerfCounters d;
+  for (const auto &field : PERF_COUNTER_FIELDS) {
+    d.*field.member = this->*field.member - rhs.*field.member;
+  }
+  return d;
+}
+
+void PerfCounters::dump() const {
+  DEMU_INFO("--- Memory Performance ---");
+  DEMU_INFO("  L1 Icache Hit Rate: {:.2f} % ({} misses / {} accesses)",
+            hit_rate(l1_icache_miss, l1_icache_access) * 100,
+            l1_icache_miss, l1_icache_access);
+  DEMU_INFO("  L1 Dcache Hit Rate: {:.2f} % ({} misses / {} accesses)",
+            hit_rate(l1_dcache_miss, l1_dcache_access) * 100,
+            l1_dcache_miss, l1_dcache_access);
+
+  DEMU_INFO("")
+  DEMU_INFO("--- Pipeline Profiling ---");
+  DEMU_INFO("  BPU Hit Rate:       {:.2f} % ({} misses / {} branches)",
+            hit_rate(bpu_mispredict, branch_commit) * 100,
+            bpu_mispredict, branch_commit);
+  DEMU_INFO("  Issue Rate:         {:.3f} uOps/cycle",
+            ratio(issue_count, cycles));
+  DEMU_INFO("  ROB Empty:          {:.2f} % of cycles",
+            ratio(rob_empty, cycles) * 100);
+  DEMU_INFO("")
+  if (slots > 0) {
+    TopDown::from(*this).dump();
+  }
+}
+
+auto RoiTracker::region(uint8_t id) -> Region & {
+  auto [it, inserted] = regions_.try_emplace(id);
+  if (inserted) {
+    auto name = names_.find(id);
+    it->second.name = name != names_.end() ? name->second
+                                           : "roi" + std::to_string(id);
+  }
+  return it->second;
+}
+
+void RoiTracker::on_marker(RoiOp op, uint8_t id, const PerfCounters &now,
+                           addr_t pc) {
+  Region &r = region(id);
+
+  switch (op) {
+  case RoiOp::START:
+    if (r.active) {
+      DEMU_WARN("ROI '{}' started twice (PC=0x{:08x})", r.name, pc);
+      return;
+    }
+    r.active = true;
+    r.entries++;
+    r.start = now;
+    break;
+  case RoiOp::STOP:
+    if (!r.active) {
+      DEMU_WARN("ROI '{}' stopped while inactive (PC=0x{:08x})", r.name, pc);
+      return;
+    }
+    r.active = false;
+    r.total += now - r.start;
+    break;
+  case RoiOp::RESET:
+    r.total = {};
+    r.entries = r.active ? 1 : 0;
+    r.start = now;
+    break;
+  case RoiOp::DUMP: {
+    PerfCounters c = r.total;
+    if (r.active) {
+      c += now - r.start;
+    }
+    DEMU_INFO("--- ROI '{}' @ cycle {} ---", r.name, now.cycles);
+    DEMU_INFO("  {} cycles, {} instructions, IPC: {:.3f}", c.cycles,
+              c.instret, ratio(c.instret, c.cycles));
+    c.dump();
+    break;
+  }
+  }
+
+  DEMU_DEBUG("ROI '{}' op {} at cycle {} (PC=0x{:08x})", r.name,
+             static_cast<int>(op), now.cycles, pc);
+}
+
+void RoiTracker::finish(const PerfCounters &now) {
+  for (auto &[id, r] : regions_) {
+    if (r.active) {
+      r.active = false;
+      r.total += now - r.start;
+    }
+  }
+}
+
+void RoiTracker::report() const {
+  for (const auto &[id, r] : regions_) {
+    const PerfCounters &c = r.total;
+    DEMU_INFO("--- Region of Interest '{}' ({} entries) ---", r.name,
+              r.entries);
+    DEMU_INFO("  {} cycles, {} instructions, IPC: {:.3f}", c.cycles,
+              c.instret, ratio(c.instret, c.cycles));
+    c.dump();
+  }
+}
+
+} // namespace demu
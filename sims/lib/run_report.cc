@@ -0,0 +1,155 @@
+#include "demu/sim.hh"
+#include <fstream>
+#include <google/protobuf/util/json_util.h>
+
+namespace demu {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+auto fnv1a(const char *data, size_t size, uint64_t hash = FNV_OFFSET) noexcept
+    -> uint64_t {
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+  }
+  return hash;
+}
+
+auto hash_file(const std::string &path) -> std::string {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    return "";
+  }
+  uint64_t hash = FNV_OFFSET;
+  char buffer[1 << 16];
+  while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+    hash = fnv1a(buffer, static_cast<size_t>(in.gcount()), hash);
+  }
+  return fmt::format("{:016x}", hash);
+}
+
+void fill_counters(const PerfCounters &c,
+                   google::protobuf::Map<std::string, uint64_t> *out) {
+  for (const auto &field : PERF_COUNTER_FIELDS) {
+    (*out)[field.name] = c.*field.member;
+  }
+}
+
+auto ratio(uint64_t a, uint64_t b) noexcept -> double {
+  return b > 0 ? static_cast<double>(a) / static_cast<double>(b) : 0.0;
+}
+
+} // namespace
+
+auto DemuSimulator::run_report() const -> report::RunReport {
+  report::RunReport r;
+  r.set_isa(model_->name);
+  r.set_config(config_->path());
+  std::string config_bytes;
+  (void)config_->proto().SerializeToString(&config_bytes);
+  r.set_config_hash(fmt::format(
+      "{:016x}", fnv1a(config_bytes.data(), config_bytes.size())));
+  r.set_program(program_path_);
+  r.set_program_hash(hash_file(program_path_));
+  r.set_exit_reason(exit_reason_ == report::EXIT_REASON_UNKNOWN
+                        ? report::EXIT_REASON_STOPPED
+                        : exit_reason_);
+  r.set_exit_code(_exit_code);
+
+  const PerfCounters c = counters();
+  const double seconds =
+      host_seconds_ > 0
+          ? host_seconds_
+          : std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          host_start_)
+                .count();
+  r.set_cycles(c.cycles);
+  r.set_instret(c.instret);
+  r.set_ipc(ratio(c.instret, c.cycles));
+  r.set_host_seconds(seconds);
+  r.set_khz(seconds > 0 ? c.cycles / seconds / 1000.0 : 0.0);
+  fill_counters(c, r.mutable_counters());
+
+  debug_counters_.for_each([&](const CounterInfo &info, size_t k) {
+    auto *counter = r.add_dut_counters();
+    counter->set_name(std::string(info.name));
+    counter->set_unit(std::string(info.unit));
+    counter->set_kind(counter_kind_name(info.kind));
+    counter->set_description(std::string(info.description));
+    counter->set_total(debug_counters_.total(k));
+    counter->set_peak(debug_counters_.peak(k));
+    if (info.kind == CounterKind::HISTOGRAM) {
+      for (const uint64_t cycles : debug_counters_.histogram(k)) {
+        counter->add_histogram(cycles);
+      }
+    }
+  });
+
+  for (const auto &[id, region] : roi_.regions()) {
+    auto *roi = r.add_rois();
+    roi->set_id(id);
+    roi->set_name(region.name);
+    roi->set_entries(region.entries);
+    roi->set_ipc(ratio(region.total.instret, region.total.cycles));
+    fill_counters(region.total, roi->mutable_counters());
+  }
+
+  if (host_profile_.enabled()) {
+    auto *host = r.mutable_host_profile();
+    host->set_sampled_cycles(host_profile_.samples());
+    for (size_t p = 0; p < static_cast<size_t>(HostPhase::COUNT); ++p) {
+      const auto phase = static_cast<HostPhase>(p);
+      (*host->mutable_phase_ns())[host_phase_name(phase)] =
+          host_profile_.phase_ns(phase);
+    }
+    const HostCounters &hw = host_profile_.counters();
+    if (hw.valid) {
+      host->set_host_cycles(hw.cycles);
+      host->set_host_instructions(hw.instructions);
+      host->set_llc_misses(hw.llc_misses);
+      host->set_branch_misses(hw.branch_misses);
+      host->set_host_ipc(ratio(hw.instructions, hw.cycles));
+      host->set_host_threads(hw.threads);
+    }
+  }
+  return r;
+}
+
+auto DemuSimulator::write_report(const std::string &path) const -> bool {
+  std::string base = path;
+  for (const std::string ext : {".pb", ".json"}) {
+    if (base.size() > ext.size() &&
+        base.compare(base.size() - ext.size(), ext.size(), ext) == 0) {
+      base.resize(base.size() - ext.size());
+      break;
+    }
+  }
+
+  const report::RunReport r = run_report();
+
+  std::ofstream pb(base + ".pb", std::ios::binary);
+  if (!pb.is_open() || !r.SerializeToOstream(&pb)) {
+    DEMU_WARN("Failed to write run report: {}.pb", base);
+    return false;
+  }
+
+  google::protobuf::util::JsonPrintOptions options;
+  options.add_whitespace = true;
+  options.preserve_proto_field_names = true;
+  std::string json;
+  const auto status =
+      google::protobuf::util::MessageToJsonString(r, &json, options);
+  std::ofstream out(base + ".json");
+  if (!status.ok() || !out.is_open()) {
+    DEMU_WARN("Failed to write run report: {}.json", base);
+    return false;
+  }
+  out << json;
+
+  DEMU_INFO("Run report: {}.pb, {}.json", base, base);
+  return true;
+}
+
+} // namespace demu
@@ -1,48 +1,104 @@
 #include "demu/sim.hh"
 #include "demu/elf_loader.hh"
 #include "demu/logger.hh"
+#include <filesystem>
 
 namespace demu {
 
+#ifdef ENABLE_TRACE
+namespace {
+
+// Only the instrumented models are built with --trace
+template <typename DUT, typename = void> struct Traceable : std::false_type {};
+template <typename DUT>
+struct Traceable<DUT, std::void_t<decltype(std::declval<DUT &>().trace(
+                          std::declval<wave_file_t *>(), 0))>>
+    : std::true_type {};
+
+} // namespace
+#endif
+
 DemuSimulator::DemuSimulator(bool enabled_trace, int threads, int argc,
-                             char **argv)
-    : trace_enabled_(enabled_trace) {
+                             char **argv, bool coverage,
+                             const std::string &model)
+    : trace_enabled_(enabled_trace), coverage_enabled_(coverage) {
 
   context_ = std::make_unique<VerilatedContext>();
   context_->debug(0);
   context_->randReset(2);
+  // The model's partitioning is fixed by --threads at Verilation time
+  if (threads != NUM_THREADS) {
+    DEMU_WARN("Model was built with NUM_THREADS={}, ignoring {} threads",
+              NUM_THREADS, threads);
+    threads = NUM_THREADS;
+  }
   context_->threads(threads);
   context_->commandArgs(argc, argv);
 
+#ifndef ENABLE_TRACE
+  if (trace_enabled_) {
+    DEMU_WARN("Built without ENABLE_TRACE, not tracing");
+    trace_enabled_ = false;
+  }
+#endif
+#ifndef ENABLE_COVERAGE
+  if (coverage_enabled_) {
+    DEMU_WARN("Built without ENABLE_COVERAGE, not collecting coverage");
+    coverage_enabled_ = false;
+  }
+#endif
+
   if (trace_enabled_) {
     context_->traceEverOn(true);
   }
 
-  dut_ = std::make_unique<system_t>(context_.get(), "TOP");
+  model_ = find_model(model, trace_enabled_ || coverage_enabled_);
+  if (!model_) {
+    DEMU_ERROR("Model '{}' is not linked into this build (available: {})",
+               model, model_names());
+  }
+  dut_ = model_->make(context_.get());
+  DEMU_INFO("Running the {} {} model", model_->name,
+            instrumented() ? "instrumented" : "lean");
 
   device_manager_ = std::make_unique<hal::DeviceManager>();
 
   timer_irq_ = std::make_unique<demu::hal::InterruptLine>();
   soft_irq_ = std::make_unique<demu::hal::InterruptLine>();
 
-  config_ = std::make_unique<RiscConfig>();
+  config_ = std::make_unique<RiscConfig>(model_config_path(*model_));
   config_->dump();
   config_->validate();
+
+  observe_master(hal::BusMaster::ICACHE, &icache_refills_);
+  observe_master(hal::BusMaster::DCACHE, &dcache_refills_);
 }
 
 DemuSimulator::~DemuSimulator() {
-  dut_->final();
+  with_dut([](auto *dut) { dut->final(); });
 
 #ifdef ENABLE_TRACE
-  if (vcd_) {
-    vcd_->close();
+  if (wave_ && !wave_kept_) {
+    wave_->close();
+    if (wave_trigger_.config().mismatch) {
+      // No mismatch, nothing worth keeping
+      std::filesystem::remove(wave_segment_path(0));
+      std::filesystem::remove(wave_segment_path(1));
+    } else if (wave_trigger_.config().triggered()) {
+      DEMU_INFO("Waveform written to {} ({} windows)", wave_path_,
+                wave_trigger_.windows());
+    } else {
+      DEMU_INFO("Waveform written to {}", wave_path_);
+    }
   }
 #endif
 
-#ifdef VM_COVERAGE
-  Verilated::mkdir("logs");
-  context_->coveragep()->write("logs/coverage.dat");
-  DEMU_INFO("Coverage written to logs/coverage.dat");
+#ifdef ENABLE_COVERAGE
+  if (coverage_enabled_) {
+    Verilated::mkdir("logs");
+    context_->coveragep()->write("logs/coverage.dat");
+    DEMU_INFO("Coverage written to logs/coverage.dat");
+  }
 #endif
 }
 
@@ -61,6 +117,7 @@ auto DemuSimulator::load_bin(const std::string &filename, addr_t base_addr)
   }
 
   if (alloc->load_binary(filename, base_addr)) {
+    program_path_ = filename;
     return true;
   }
 
@@ -108,6 +165,10 @@ auto DemuSimulator::load_elf(const std::string &filename) -> bool {
               section.addr, section.data.size());
   }
 
+  symbols_.load(filename);
+  lines_.open(filename);
+  program_path_ = filename;
+
   DEMU_INFO("ELF loaded successfully. Entry: 0x{:08x}", entry_point);
   return true;
 }
@@ -115,47 +176,132 @@ auto DemuSimulator::load_elf(const std::string &filename) -> bool {
 void DemuSimulator::init() {
   DEMU_INFO("DEMU Simulator Initializing...");
 
+  const auto &l2_config = l2_config_ ? *l2_config_ : config_->l2();
+  if (l2_config.cache().sets() > 0) {
+    l2_ = std::make_unique<hal::cache::L2Cache>(l2_config);
+  }
+  if (!l2_prefetcher_.empty()) {
+    std::vector<std::unique_ptr<perf::Prefetcher>> prefetchers;
+    if (!l2_) {
+      DEMU_WARN("L2 prefetcher '{}' ignored: no L2 configured",
+                l2_prefetcher_);
+    } else if (!perf::parse_prefetchers(l2_prefetcher_,
+                                        l2_config.cache().line_size(),
+                                        prefetchers) ||
+               prefetchers.size() != 1) {
+      DEMU_ERROR("Invalid L2 prefetcher: {}", l2_prefetcher_);
+    } else {
+      l2_->prefetcher(std::move(prefetchers.front()));
+    }
+  }
+
   register_devices();
   device_manager_->dump_device_map();
 
+  for (const auto &[region, observer, master] : bus_observers_) {
+    auto *slave =
+        device_manager_->get_device_by_name<hal::axif::AXIFullSlave>(region);
+    if (!slave) {
+      DEMU_WARN("Cannot observe '{}': not an AXI4-Full slave", region);
+      continue;
+    }
+    slave->observe(observer, master);
+  }
+
+  if (topdown_interval_ > 0 && !topdown_path_.empty()) {
+    topdown_out_.open(topdown_path_);
+    if (!topdown_out_.is_open()) {
+      DEMU_WARN("Failed to open top-down report: {}", topdown_path_);
+    } else {
+      topdown_out_ << "cycle,cycles,instret," << TopDown::csv_header()
+                   << "\n";
+    }
+  }
+
+  if (interval_spec_.period > 0 && !interval_path_.empty() &&
+      !intervals_.open(interval_path_)) {
+    DEMU_WARN("Failed to open interval report: {}", interval_path_);
+  }
+
 #ifdef ENABLE_TRACE
   if (trace_enabled_) {
+    const auto &wave = wave_trigger_.config();
     Verilated::mkdir("logs");
-    vcd_ = std::make_unique<VerilatedVcdC>();
-    dut_->trace(vcd_.get(), 99);
-    vcd_->open(("logs/demu_" + std::string(ISA_NAME) + "_trace.vcd").c_str());
-    DEMU_DEBUG("VCD tracing enabled: logs/demu_{}_trace.vcd", ISA_NAME);
+    wave_path_ = wave.path.empty() ? fmt::format("logs/demu_{}_trace.{}",
+                                                 model_->name, WAVE_EXT)
+                                   : wave.path;
+    wave_ = std::make_unique<wave_file_t>();
+    if (!wave.scope.empty()) {
+      wave_->dumpvars(0, wave.scope);
+    }
+    with_dut([&](auto *dut) {
+      if constexpr (Traceable<std::remove_pointer_t<decltype(dut)>>::value) {
+        dut->trace(wave_.get(), wave.depth);
+      }
+    });
+    if (wave.mismatch) {
+      std::filesystem::remove(wave_segment_path(1));
+    }
+    const std::string path =
+        wave.mismatch ? wave_segment_path(wave_segment_) : wave_path_;
+    wave_->open(path.c_str());
+    wave_rotate_at_ = wave.window;
+    DEMU_DEBUG("Waveform tracing enabled: {}", path);
+  }
+#else
+  if (wave_trigger_.config().triggered()) {
+    DEMU_WARN("Built without ENABLE_TRACE, ignoring waveform triggers");
   }
 #endif
 }
 
 void DemuSimulator::reset() {
   DEMU_INFO("Resetting...");
-  dut_->reset = 1;
-  dut_->clock = 0;
-  dut_->eval();
-  dut_->clock = 1;
-  dut_->eval();
-  dut_->reset = 0;
-  dut_->eval();
+  with_dut([](auto *dut) {
+    dut->reset = 1;
+    dut->clock = 0;
+    dut->eval();
+    dut->clock = 1;
+    dut->eval();
+    dut->reset = 0;
+    dut->eval();
+  });
 
   device_manager_->reset();
+  if (l2_) {
+    l2_->reset();
+  }
 
-  _l1_icache_accesses = 0;
-  _l1_icache_misses = 0;
-  _l1_dcache_accesses = 0;
-  _l1_dcache_misses = 0;
-
-  _bpu_mispredicts = 0;
-  _branches_committed = 0;
-  _flush_cycles = 0;
-  _rob_empty_cycles = 0;
-  _issue_count = 0;
-  _frontend_stalls = 0;
-  _backend_stalls = 0;
+  debug_counters_.reset();
+  _slots = 0;
+  _recovery_slots = 0;
+  _fetch_latency_slots = 0;
+  _fetch_bandwidth_slots = 0;
+  _memory_bound_slots = 0;
+  _core_bound_slots = 0;
+  icache_refills_.pending = 0;
+  dcache_refills_.pending = 0;
+  topdown_last_ = {};
+  interval_last_ = {};
+  interval_next_ = interval_spec_.period;
 
   _terminate = false;
+  _halted = false;
+  _exit_code = 0;
+  exit_reason_ = report::EXIT_REASON_UNKNOWN;
+  host_seconds_ = 0;
+  host_start_ = std::chrono::steady_clock::now();
   _register_values.fill(0);
+  roi_.clear();
+  watchdog_.reset();
+  watchdog_loads_.reset();
+  wave_trigger_.reset();
+#ifdef ENABLE_TRACE
+  wave_rotate_at_ = wave_trigger_.config().window;
+#endif
+  for (auto &probe : probes_) {
+    probe->reset();
+  }
 
   on_reset();
   DEMU_INFO("System Reset Complete. PC: 0x{:08x}",
@@ -163,9 +309,11 @@ void DemuSimulator::reset() {
 }
 
 void DemuSimulator::step(uint64_t cycles) {
-  for (uint64_t i = 0; i < cycles; i++) {
-    clock_tick();
-  }
+  with_dut([&](auto *dut) {
+    for (uint64_t i = 0; i < cycles; i++) {
+      clock_tick(dut);
+    }
+  });
 }
 
 void DemuSimulator::run(uint64_t max_cycles) {
@@ -173,9 +321,20 @@ void DemuSimulator::run(uint64_t max_cycles) {
   uint64_t target = max_cycles > 0 ? max_cycles : timeout_;
 
   auto start_time = std::chrono::high_resolution_clock::now();
+  if (live_period_ > 0) {
+    handle_live_stats();
+  }
   on_init();
-  while (cycle_count() < target && !_terminate) {
-    clock_tick();
+  if (host_profile_.enabled()) {
+    host_profile_.start();
+  }
+  with_dut([&](auto *dut) {
+    while (dut->debug_cycle_count < target && !_terminate) {
+      clock_tick(dut);
+    }
+  });
+  if (host_profile_.enabled()) {
+    host_profile_.stop();
   }
   on_exit();
   auto end_time = std::chrono::high_resolution_clock::now();
@@ -183,36 +342,96 @@ void DemuSimulator::run(uint64_t max_cycles) {
   auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
                       end_time - start_time)
                       .count();
+  host_seconds_ = duration / 1e6;
 
-  if (cycle_count() >= target) {
+  if (_halted) {
+    DEMU_INFO("Program exited with code {} at cycle {}", _exit_code,
+              cycle_count())
+  } else if (cycle_count() >= target) {
     DEMU_WARN("Simulation TIME OUT after {} cycles", cycle_count())
+    exit_reason_ = report::EXIT_REASON_TIMEOUT;
   }
 
+  finish();
+}
+
+void DemuSimulator::finish() {
+  if (host_seconds_ <= 0) {
+    host_seconds_ = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - host_start_)
+                        .count();
+  }
+  if (topdown_interval_ > 0 && cycle_count() > topdown_last_.cycles) {
+    handle_topdown_interval();
+  }
+  if (intervals_.is_open()) {
+    if (cycle_count() > interval_last_.cycles) {
+      handle_interval();
+    }
+    DEMU_INFO("Intervals: {} rows written to {}", intervals_.rows(),
+              interval_path_);
+    intervals_.close();
+  }
+  if (live_.is_open()) {
+    live_.publish(counters(), LiveState::EXITED, _exit_code);
+    live_.close();
+  }
+
+  const double ms = host_seconds_ * 1000.0;
   DEMU_INFO("Simulation completed with: ");
   DEMU_INFO("  {} cycles, {} instructions, IPC: {:.3f} after {:.3f} ms",
-            cycle_count(), instret_count(), ipc(), duration / 1000.0);
+            cycle_count(), instret_count(), ipc(), ms);
   DEMU_INFO("  simulation speed: {:.3f} kHz",
-            static_cast<float>(cycle_count()) / (duration / 1000.0f))
+            ms > 0 ? static_cast<double>(cycle_count()) / ms : 0.0)
 
   DEMU_INFO("")
-  DEMU_INFO("--- Memory Performance ---");
-  DEMU_INFO("  L1 Icache Hit Rate: {:.2f} % ({} misses / {} accesses)",
-            l1_icache_hit_rate() * 100, _l1_icache_misses, _l1_icache_accesses);
-  DEMU_INFO("  L1 Dcache Hit Rate: {:.2f} % ({} misses / {} accesses)",
-            l1_dcache_hit_rate() * 100, _l1_dcache_misses, _l1_dcache_accesses);
+  counters().dump();
+  debug_counters_.report(cycle_count());
+  if (l2_) {
+    l2_->report();
+  }
+  if (host_profile_.enabled()) {
+    host_profile_.report();
+  }
 
-  DEMU_INFO("")
-  DEMU_INFO("--- Pipeline Profiling ---");
-  DEMU_INFO("  BPU Hit Rate:       {:.2f} % ({} misses / {} branches)",
-            bpu_hit_rate() * 100, _bpu_mispredicts, _branches_committed);
-  DEMU_INFO("  Issue Rate:         {:.3f} uOps/cycle", issue_rate());
-  DEMU_INFO("  Frontend Starved:   {:.2f} % of cycles (ROB Empty)",
-            frontend_starvation_rate() * 100);
-  DEMU_INFO("  Frontend Stalled:   {:.2f} % of cycles (Hazards/Full)",
-            frontend_stall_rate() * 100);
-  DEMU_INFO("  Backend Stalled:    {:.2f} % of cycles (Waiting Exe/Mem)",
-            backend_stall_rate() * 100);
-  DEMU_INFO("")
+  if (roi_.used()) {
+    roi_.finish(counters());
+    roi_.report();
+  }
+
+  for (auto &probe : probes_) {
+    probe->report();
+  }
+}
+
+auto DemuSimulator::counters() const noexcept -> PerfCounters {
+  PerfCounters c;
+  c.cycles = cycle_count();
+  c.instret = instret_count();
+  debug_counters_.totals_to(c);
+  c.slots = _slots;
+  c.recovery_slots = _recovery_slots;
+  c.fetch_latency_slots = _fetch_latency_slots;
+  c.fetch_bandwidth_slots = _fetch_bandwidth_slots;
+  c.memory_bound_slots = _memory_bound_slots;
+  c.core_bound_slots = _core_bound_slots;
+  return c;
+}
+
+auto DemuSimulator::describe_pc(addr_t pc) const -> std::string {
+  std::string desc = symbols_.describe(pc);
+  const std::string line = lines_.describe(pc);
+  if (!line.empty()) {
+    desc += fmt::format(" ({})", line);
+  }
+  return desc;
+}
+
+void DemuSimulator::halt(int code) noexcept {
+  _halted = true;
+  _exit_code = code;
+  exit_reason_ = report::EXIT_REASON_HALT;
+  _terminate = true;
 }
 
 void DemuSimulator::dump_registers() const {
@@ -233,45 +452,93 @@ void DemuSimulator::dump_memory(addr_t start, size_t size) const {
   device->dump(start, size);
 }
 
-void DemuSimulator::clock_tick() {
-  DEMU_CPU_TICK(cycle_count());
+template <typename DUT> void DemuSimulator::clock_tick(DUT *dut) {
+  DEMU_CPU_TICK(dut->debug_cycle_count);
+
+  const bool timed = host_profile_.enabled() && host_profile_.sample();
 
   context_->timeInc(1);
 
-  dut_->clock = 0;
+  dut->clock = 0;
   device_manager_->handle_ports();
-  dut_->eval();
+  if (timed) {
+    host_profile_.mark(HostPhase::PORTS);
+  }
+  dut->eval();
+  if (timed) {
+    host_profile_.mark(HostPhase::EVAL_NEGEDGE);
+  }
 
 #ifdef ENABLE_TRACE
-  if (vcd_) {
-    vcd_->dump(context_->time());
+  if (wave_) {
+    dump_wave(dut->debug_cycle_count);
+  }
+  if (timed) {
+    host_profile_.mark(HostPhase::TRACE);
   }
 #endif
 
   context_->timeInc(1);
-  dut_->clock = 1;
-  dut_->eval();
+  dut->clock = 1;
+  dut->eval();
+  if (timed) {
+    host_profile_.mark(HostPhase::EVAL_POSEDGE);
+  }
 
+  if (l2_) {
+    l2_->clock_tick();
+  }
+  if (timed) {
+    host_profile_.mark(HostPhase::L2);
+  }
   device_manager_->clock_tick();
-  handle_retirements();
-  handle_interrupt();
-  handle_cache_profiling();
-  handle_performance_profiling();
+  if (timed) {
+    host_profile_.mark(HostPhase::DEVICES);
+  }
+  // Sampled ahead of the probes, which see this cycle's values
+  debug_counters_.sample(dut);
+  if (timed) {
+    host_profile_.mark(HostPhase::PROFILING);
+  }
+  if (!probes_.empty()) {
+    handle_probes(dut);
+  }
+  if (timed) {
+    host_profile_.mark(HostPhase::PROBES);
+  }
+  handle_retirements(dut);
+  handle_interrupt(dut);
+  if (timed) {
+    host_profile_.mark(HostPhase::RETIRE);
+  }
+  handle_performance_profiling(dut);
+  if (watchdog_.enabled()) {
+    handle_watchdog();
+  }
+  if (timed) {
+    host_profile_.mark(HostPhase::PROFILING);
+  }
 
   on_clock_tick();
+  if (timed) {
+    host_profile_.mark(HostPhase::HOOK);
+  }
 
 #ifdef ENABLE_TRACE
-  if (vcd_) {
-    vcd_->dump(context_->time());
+  if (wave_) {
+    dump_wave(dut->debug_cycle_count);
+  }
+  if (timed) {
+    host_profile_.mark(HostPhase::TRACE);
   }
 #endif
 }
 
-void DemuSimulator::handle_retirements() {
+template <typename DUT> void DemuSimulator::handle_retirements(DUT *dut) {
   const uint32_t lanes = active_retire_lanes();
 
   for (uint32_t lane = 0; lane < lanes; ++lane) {
-    const RetirePacket retire = read_retire_lane(lane);
+    const RetirePacket retire = RetireSignalInfo<DUT>::read(dut, lane);
 
     if (!retire.valid) {
       continue;
@@ -284,34 +551,236 @@ void DemuSimulator::handle_retirements() {
       DEMU_REG_WRITE(retire.reg_addr, retire.reg_data);
     }
 
+    if (wave_trigger_.watches_retire()) {
+      wave_trigger_.on_retire(cycle_count(), retire.pc);
+    }
+
+    if (watchdog_.enabled()) {
+      perf::MemStream::Access access{};
+      if (watchdog_loads_.on_retire({cycle_count(), lane, retire.pc,
+                                     retire.instr, retire.reg_we,
+                                     retire.reg_addr, retire.reg_data},
+                                    access) &&
+          !access.store && is_device_register(access.addr)) {
+        watchdog_.on_device_read();
+      }
+      watchdog_.on_retire(retire.pc, retire.instr, retire.reg_we,
+                          retire.reg_addr, retire.reg_data);
+    }
+
+    for (auto &probe : probes_) {
+      probe->on_retire({cycle_count(), lane, retire.pc, retire.instr,
+                        retire.reg_we, retire.reg_addr, retire.reg_data});
+    }
+
+    RoiOp roi_op;
+    uint8_t roi_id;
+    if (decode_roi_marker(retire.instr, roi_op, roi_id)) {
+      roi_.on_marker(roi_op, roi_id, counters(), retire.pc);
+      wave_trigger_.on_roi(roi_op, roi_id, cycle_count());
+    }
+
     Instruction inst(retire.instr);
     DEMU_DEBUG("RETIRE[{}] | Cycle {:6d} | PC=0x{:08x} | Inst=0x{:08x} ({})",
                lane, cycle_count(), retire.pc, retire.instr, inst.to_string());
   }
 }
 
-void DemuSimulator::handle_interrupt() {
-  dut_->irq_timer_irq = timer_irq_->get_level();
-  dut_->irq_soft_irq = soft_irq_->get_level();
+template <typename DUT> void DemuSimulator::handle_interrupt(DUT *dut) {
+  dut->irq_timer_irq = timer_irq_->get_level();
+  dut->irq_soft_irq = soft_irq_->get_level();
+}
+
+template <typename DUT>
+void DemuSimulator::handle_performance_profiling(DUT *dut) {
+  // Unfilled dispatch slots by cause. A flush is recovery; a decoded
+  // instruction held back at dispatch is backend-bound, as is a ROB that
+  // is occupied but not committing, and memory-bound while the L1D has a
+  // refill in flight. Otherwise the frontend under-delivered: a whole
+  // cycle, or any cycle with an L1I refill in flight, is fetch latency,
+  // part of one is bandwidth.
+  const uint32_t width = active_retire_lanes();
+  const auto issued = static_cast<uint32_t>(dut->debug_issue_count);
+  const uint64_t unfilled = width > issued ? width - issued : 0;
+  _slots += width;
+  if (dut->debug_flush_cycle) {
+    _recovery_slots += unfilled;
+  } else if (dut->debug_frontend_stall || dut->debug_backend_stall) {
+    (dcache_refills_.pending > 0 ? _memory_bound_slots : _core_bound_slots) +=
+        unfilled;
+  } else if (icache_refills_.pending > 0 || issued == 0) {
+    _fetch_latency_slots += unfilled;
+  } else {
+    _fetch_bandwidth_slots += unfilled;
+  }
+
+  const uint64_t cycles = dut->debug_cycle_count;
+  if (topdown_interval_ > 0 && cycles % topdown_interval_ == 0) {
+    handle_topdown_interval();
+  }
+  if (intervals_.is_open() &&
+      (interval_spec_.instructions ? dut->debug_instret_count : cycles) >=
+          interval_next_) {
+    handle_interval();
+  }
+  if (live_period_ > 0 && cycles % live_period_ == 0) {
+    handle_live_stats();
+  }
+}
+
+void DemuSimulator::handle_live_stats() {
+  if (!live_.is_open()) {
+    if (!live_.open(program_path_, model_->name, live_period_)) {
+      DEMU_WARN("Failed to create live statistics segment");
+      live_period_ = 0;
+      return;
+    }
+    DEMU_INFO("Live statistics: {} every {} cycles", live_.name(),
+              live_period_);
+  }
+  live_.publish(counters());
+}
+
+void DemuSimulator::handle_interval() {
+  const PerfCounters now = counters();
+  intervals_.append(now.cycles, now - interval_last_);
+  interval_last_ = now;
+  const uint64_t progress =
+      interval_spec_.instructions ? now.instret : now.cycles;
+  interval_next_ =
+      (progress / interval_spec_.period + 1) * interval_spec_.period;
 }
 
-void DemuSimulator::handle_cache_profiling() {
-  _l1_icache_accesses += static_cast<uint64_t>(dut_->debug_l1_icache_access);
-  _l1_icache_misses += static_cast<uint64_t>(dut_->debug_l1_icache_access &&
-                                             dut_->debug_l1_icache_miss);
-  _l1_dcache_accesses += static_cast<uint64_t>(dut_->debug_l1_dcache_access);
-  _l1_dcache_misses += static_cast<uint64_t>(dut_->debug_l1_dcache_access &&
-                                             dut_->debug_l1_dcache_miss);
+void DemuSimulator::handle_topdown_interval() {
+  const PerfCounters now = counters();
+  const PerfCounters delta = now - topdown_last_;
+  topdown_last_ = now;
+  const TopDown t = TopDown::from(delta);
+
+  if (topdown_out_.is_open()) {
+    topdown_out_ << now.cycles << "," << delta.cycles << "," << delta.instret
+                 << "," << t.csv() << "\n";
+    return;
+  }
+  DEMU_INFO("[topdown] cycle {:>10}  IPC {:.3f}  retiring {:5.1f}%  bad-spec "
+            "{:5.1f}%  frontend {:5.1f}% ({:.1f}/{:.1f})  backend {:5.1f}% "
+            "({:.1f}/{:.1f})",
+            now.cycles,
+            delta.cycles > 0 ? static_cast<double>(delta.instret) /
+                                   static_cast<double>(delta.cycles)
+                             : 0.0,
+            t.retiring * 100, t.bad_speculation * 100, t.frontend_bound * 100,
+            t.fetch_latency * 100, t.fetch_bandwidth * 100,
+            t.backend_bound * 100, t.memory_bound * 100, t.core_bound * 100);
 }
 
-void DemuSimulator::handle_performance_profiling() {
-  _bpu_mispredicts += static_cast<uint64_t>(dut_->debug_bpu_mispredict);
-  _branches_committed += static_cast<uint64_t>(dut_->debug_branch_commit);
-  _flush_cycles += static_cast<uint64_t>(dut_->debug_flush_cycle);
-  _rob_empty_cycles += static_cast<uint64_t>(dut_->debug_rob_empty);
-  _issue_count += static_cast<uint64_t>(dut_->debug_issue_count);
-  _frontend_stalls += static_cast<uint64_t>(dut_->debug_frontend_stall);
-  _backend_stalls += static_cast<uint64_t>(dut_->debug_backend_stall);
+#ifdef ENABLE_TRACE
+void DemuSimulator::dump_wave(uint64_t cycle) {
+  if (wave_kept_) {
+    return;
+  }
+  const auto &config = wave_trigger_.config();
+  if (config.mismatch && cycle >= wave_rotate_at_) {
+    on_wave_rotate();
+    wave_->close();
+    wave_segment_ ^= 1;
+    wave_->open(wave_segment_path(wave_segment_).c_str());
+    wave_rotate_at_ = cycle + config.window;
+  }
+  if (wave_trigger_.active(cycle)) {
+    wave_->dump(context_->time());
+  }
+}
+
+auto DemuSimulator::wave_segment_path(uint32_t segment) const
+    -> std::string {
+  std::filesystem::path path(wave_path_);
+  path.replace_extension(
+      fmt::format(".{}{}", segment, path.extension().string()));
+  return path.string();
+}
+#endif
+
+void DemuSimulator::keep_wave() {
+#ifdef ENABLE_TRACE
+  if (!wave_ || !wave_trigger_.config().mismatch || wave_kept_) {
+    return;
+  }
+  wave_->close();
+  wave_kept_ = true;
+  const std::string previous = wave_segment_path(wave_segment_ ^ 1);
+  const std::string current = wave_segment_path(wave_segment_);
+  if (std::filesystem::exists(previous)) {
+    DEMU_INFO("Waveform up to cycle {} kept in {} and {}", cycle_count(),
+              previous, current);
+  } else {
+    DEMU_INFO("Waveform up to cycle {} kept in {}", cycle_count(), current);
+  }
+#endif
+}
+
+template <typename DUT> void DemuSimulator::handle_probes(DUT *dut) {
+  perf::CycleSample sample;
+  sample.cycle = dut->debug_cycle_count;
+  debug_counters_.values_to(sample);
+
+  for (auto &probe : probes_) {
+    probe->on_cycle(sample);
+  }
+}
+
+auto DemuSimulator::is_device_register(addr_t addr) noexcept -> bool {
+  const auto *device = device_manager_->find_device_for_address(addr);
+  return device != nullptr &&
+         dynamic_cast<const hal::axif::AXIFullSRAM *>(device) == nullptr;
+}
+
+void DemuSimulator::handle_watchdog() {
+  switch (watchdog_.check(cycle_count())) {
+  case WatchdogVerdict::NONE:
+    return;
+  case WatchdogVerdict::SAFE_LOOP:
+    DEMU_INFO("Watchdog: program parked in SAFE_LOOP at PC=0x{:08x}",
+              last_retire_pc_)
+    exit_reason_ = report::EXIT_REASON_SAFE_LOOP;
+    _terminate = true;
+    return;
+  case WatchdogVerdict::DEADLOCK:
+    DEMU_WARN("Watchdog: DEADLOCK, nothing retired since cycle {} ({} cycles)",
+              watchdog_.last_retire_cycle(),
+              cycle_count() - watchdog_.last_retire_cycle())
+    _exit_code = WATCHDOG_EXIT_DEADLOCK;
+    exit_reason_ = report::EXIT_REASON_DEADLOCK;
+    break;
+  case WatchdogVerdict::LIVELOCK:
+    DEMU_WARN("Watchdog: LIVELOCK, no new state in {} retirements from "
+              "PC=0x{:08x}",
+              watchdog_.config().livelock_window * 2,
+              watchdog_.window_start_pc())
+    _exit_code = WATCHDOG_EXIT_LIVELOCK;
+    exit_reason_ = report::EXIT_REASON_LIVELOCK;
+    break;
+  }
+
+  DEMU_WARN("--- Pipeline Debug State @ cycle {} ---", cycle_count())
+  DEMU_WARN("  Last Retire PC:   0x{:08x}", last_retire_pc_)
+  with_dut([](const auto *dut) {
+    DEMU_WARN("  ROB Empty:        {}", static_cast<int>(dut->debug_rob_empty))
+    DEMU_WARN("  Issue / Commit:   {} / {}",
+              static_cast<int>(dut->debug_issue_count),
+              static_cast<int>(dut->debug_commit_count))
+    DEMU_WARN("  Frontend Stall:   {}",
+              static_cast<int>(dut->debug_frontend_stall))
+    DEMU_WARN("  Backend Stall:    {}",
+              static_cast<int>(dut->debug_backend_stall))
+    DEMU_WARN("  Flush:            {}",
+              static_cast<int>(dut->debug_flush_cycle))
+  });
+  DEMU_WARN("")
+  counters().dump();
+  dump_registers();
+
+  _terminate = true;
 }
 
 } // namespace demu
@@ -0,0 +1,101 @@
+#include "demu/symbols.hh"
+#include "demu/logger.hh"
+#include <algorithm>
+
+namespace demu {
+
+auto SymbolTable::load(const std::string &filename) -> bool {
+  entries_.clear();
+
+  std::vector<ELFSymbol> symbols;
+  if (!ELFLoader::load_symbols(symbols, filename)) {
+    DEMU_WARN("No symbol table in {}, profiles will use raw PCs", filename);
+    return false;
+  }
+
+  // Keep functions and global labels in code; drop local asm labels and
+  // mapping/compiler-local symbols which would fragment their functions.
+  symbols.erase(
+      std::remove_if(symbols.begin(), symbols.end(),
+                     [](const ELFSymbol &s) -> bool {
+                       if (!s.code || s.name.empty() || s.name[0] == '$' ||
+                           s.name.rfind(".L", 0) == 0) {
+                         return true;
+                       }
+                       if (s.type == STT_FUNC) {
+                         return false;
+                       }
+                       return s.type != STT_NOTYPE || s.bind == STB_LOCAL;
+                     }),
+      symbols.end());
+
+  // Prefer sized function symbols over aliases at the same address
+  std::sort(symbols.begin(), symbols.end(),
+            [](const ELFSymbol &a, const ELFSymbol &b) -> bool {
+              if (a.addr != b.addr) {
+                return a.addr < b.addr;
+              }
+              if (a.type != b.type) {
+                return a.type == STT_FUNC;
+              }
+              return a.size > b.size;
+            });
+
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    const ELFSymbol &s = symbols[i];
+    if (!entries_.empty() && entries_.back().start == s.addr) {
+      continue;
+    }
+
+    addr_t next = UINT32_MAX;
+    for (size_t j = i + 1; j < symbols.size(); ++j) {
+      if (symbols[j].addr != s.addr) {
+        next = symbols[j].addr;
+        break;
+      }
+    }
+
+    addr_t end = s.size > 0 ? s.addr + s.size : next;
+    end = std::min(end, next);
+
+    if (!entries_.empty() && entries_.back().end > s.addr) {
+      entries_.back().end = s.addr;
+    }
+    entries_.push_back({s.addr, end, s.name});
+  }
+
+  DEMU_INFO("Loaded {} code symbols from {}", entries_.size(), filename);
+  return true;
+}
+
+auto SymbolTable::find(addr_t addr) const noexcept -> uint32_t {
+  auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), addr,
+      [](addr_t a, const Entry &e) -> bool { return a < e.start; });
+  if (it == entries_.begin()) {
+    return npos;
+  }
+  --it;
+  if (addr >= it->end) {
+    return npos;
+  }
+  return static_cast<uint32_t>(it - entries_.begin());
+}
+
+auto SymbolTable::lookup(addr_t addr) const noexcept -> const Entry * {
+  const uint32_t idx = find(addr);
+  return idx == npos ? nullptr : &entries_[idx];
+}
+
+auto SymbolTable::describe(addr_t addr) const -> std::string {
+  const Entry *e = lookup(addr);
+  if (!e) {
+    return fmt::format("0x{:08x}", addr);
+  }
+  if (addr == e->start) {
+    return e->name;
+  }
+  return fmt::format("{}+0x{:x}", e->name, addr - e->start);
+}
+
+} // namespace demu
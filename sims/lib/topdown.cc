@@ -0,0 +1,68 @@
+#include "demu/topdown.hh"
+#include "demu/logger.hh"
+#include <algorithm>
+
+namespace demu {
+
+namespace {
+
+auto fraction(uint64_t part, uint64_t whole) noexcept -> double {
+  return whole > 0 ? static_cast<double>(part) / static_cast<double>(whole)
+                   : 0.0;
+}
+
+} // namespace
+
+auto TopDown::from(const PerfCounters &c) noexcept -> TopDown {
+  TopDown t;
+  t.slots = c.slots;
+  if (c.slots == 0) {
+    return t;
+  }
+  // ROI and interval deltas can split a dispatch from its retirement
+  const uint64_t retired = std::min(c.instret, c.issue_count);
+
+  t.retiring = fraction(retired, c.slots);
+  t.squashed = fraction(c.issue_count - retired, c.slots);
+  t.recovery = fraction(c.recovery_slots, c.slots);
+  t.fetch_latency = fraction(c.fetch_latency_slots, c.slots);
+  t.fetch_bandwidth = fraction(c.fetch_bandwidth_slots, c.slots);
+  t.memory_bound = fraction(c.memory_bound_slots, c.slots);
+  t.core_bound = fraction(c.core_bound_slots, c.slots);
+
+  t.bad_speculation = t.squashed + t.recovery;
+  t.frontend_bound = t.fetch_latency + t.fetch_bandwidth;
+  t.backend_bound = t.memory_bound + t.core_bound;
+  return t;
+}
+
+void TopDown::dump() const {
+  DEMU_INFO("--- Top-Down ({} dispatch slots) ---", slots);
+  DEMU_INFO("  Retiring:           {:6.2f} %", retiring * 100);
+  DEMU_INFO("  Bad Speculation:    {:6.2f} %", bad_speculation * 100);
+  DEMU_INFO("    Squashed:         {:6.2f} %", squashed * 100);
+  DEMU_INFO("    Recovery:         {:6.2f} %", recovery * 100);
+  DEMU_INFO("  Frontend Bound:     {:6.2f} %", frontend_bound * 100);
+  DEMU_INFO("    Fetch Latency:    {:6.2f} %", fetch_latency * 100);
+  DEMU_INFO("    Fetch Bandwidth:  {:6.2f} %", fetch_bandwidth * 100);
+  DEMU_INFO("  Backend Bound:      {:6.2f} %", backend_bound * 100);
+  DEMU_INFO("    Memory Bound:     {:6.2f} %", memory_bound * 100);
+  DEMU_INFO("    Core Bound:       {:6.2f} %", core_bound * 100);
+  DEMU_INFO("")
+}
+
+auto TopDown::csv_header() -> std::string {
+  return "slots,retiring,bad_speculation,squashed,recovery,frontend_bound,"
+         "fetch_latency,fetch_bandwidth,backend_bound,memory_bound,"
+         "core_bound";
+}
+
+auto TopDown::csv() const -> std::string {
+  return fmt::format("{},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},"
+                     "{:.6f},{:.6f},{:.6f}",
+                     slots, retiring, bad_speculation, squashed, recovery,
+                     frontend_bound, fetch_latency, fetch_bandwidth,
+                     backend_bound, memory_bound, core_bound);
+}
+
+} // namespace demu
@@ -0,0 +1,156 @@
+#include "demu/watchdog.hh"
+#include <algorithm>
+#include <utility>
+
+namespace demu {
+
+namespace {
+
+constexpr uint32_t STALE_WINDOWS_TO_FIRE = 2;
+
+// splitmix64 finalizer
+inline auto mix(uint64_t x) noexcept -> uint64_t {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+} // namespace
+
+void Watchdog::KeySet::resize(uint64_t keys) {
+  // At most half full, so probe sequences stay short
+  uint64_t capacity = 16;
+  while (capacity < 2 * keys) {
+    capacity <<= 1;
+  }
+  slots_.assign(capacity, 0);
+  mask_ = capacity - 1;
+  size_ = 0;
+}
+
+void Watchdog::KeySet::clear() noexcept {
+  if (size_ > 0) {
+    std::fill(slots_.begin(), slots_.end(), 0);
+    size_ = 0;
+  }
+}
+
+auto Watchdog::KeySet::insert(uint64_t key) noexcept -> bool {
+  for (uint64_t i = key & mask_;; i = (i + 1) & mask_) {
+    if (slots_[i] == key) {
+      return false;
+    }
+    if (slots_[i] == 0) {
+      slots_[i] = key;
+      size_++;
+      return true;
+    }
+  }
+}
+
+auto Watchdog::KeySet::contains(uint64_t key) const noexcept -> bool {
+  for (uint64_t i = key & mask_;; i = (i + 1) & mask_) {
+    if (slots_[i] == key) {
+      return true;
+    }
+    if (slots_[i] == 0) {
+      return false;
+    }
+  }
+}
+
+void Watchdog::KeySet::swap(KeySet &other) noexcept {
+  slots_.swap(other.slots_);
+  std::swap(mask_, other.mask_);
+  std::swap(size_, other.size_);
+}
+
+void Watchdog::configure(const WatchdogConfig &config) {
+  config_ = config;
+  reset();
+}
+
+void Watchdog::reset() {
+  retired_ = false;
+  last_retire_cycle_ = 0;
+
+  if (config_.livelock_window > 0) {
+    prev_window_.resize(config_.livelock_window);
+    curr_window_.resize(config_.livelock_window);
+  }
+  window_retired_ = 0;
+  novel_ = 0;
+  stale_windows_ = 0;
+  device_read_ = false;
+  only_safe_loop_ = true;
+  window_start_pc_ = 0;
+  livelocked_ = false;
+}
+
+void Watchdog::on_retire(addr_t pc, instr_t instr, bool reg_we,
+                         uint8_t reg_addr, word_t reg_data) {
+  retired_ = true;
+
+  if (config_.livelock_window == 0) {
+    return;
+  }
+
+  if (window_retired_ == 0) {
+    window_start_pc_ = pc;
+  }
+
+  uint64_t key = static_cast<uint64_t>(pc) << 32;
+  if (reg_we && reg_addr != 0) {
+    key ^= mix((static_cast<uint64_t>(reg_addr) << 32) | reg_data);
+  }
+  // 0 marks an empty slot
+  key = mix(key) | 1;
+
+  if (curr_window_.insert(key) && !prev_window_.contains(key)) {
+    novel_++;
+  }
+  only_safe_loop_ = only_safe_loop_ && instr == SAFE_LOOP;
+
+  if (++window_retired_ < config_.livelock_window) {
+    return;
+  }
+
+  // The very first window has nothing to compare against
+  const bool first = prev_window_.empty();
+  const bool stale = !first && novel_ == 0 && !device_read_;
+  stale_windows_ = stale ? stale_windows_ + 1 : 0;
+  livelocked_ = stale_windows_ >= STALE_WINDOWS_TO_FIRE;
+
+  prev_window_.swap(curr_window_);
+  curr_window_.clear();
+  window_retired_ = 0;
+  novel_ = 0;
+  device_read_ = false;
+  if (!livelocked_) {
+    only_safe_loop_ = true;
+  }
+}
+
+auto Watchdog::check(uint64_t cycle) noexcept -> WatchdogVerdict {
+  if (retired_) {
+    retired_ = false;
+    last_retire_cycle_ = cycle;
+  }
+
+  if (livelocked_) {
+    return only_safe_loop_ ? WatchdogVerdict::SAFE_LOOP
+                           : WatchdogVerdict::LIVELOCK;
+  }
+
+  if (config_.stall_cycles > 0 &&
+      cycle - last_retire_cycle_ >= config_.stall_cycles) {
+    return WatchdogVerdict::DEADLOCK;
+  }
+
+  return WatchdogVerdict::NONE;
+}
+
+} // namespace demu
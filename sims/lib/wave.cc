@@ -0,0 +1,125 @@
+#include "demu/wave.hh"
+#include "demu/logger.hh"
+#include "demu/perf/sweep.hh"
+
+namespace demu {
+
+namespace {
+
+auto parse_u64(const std::string &s, uint64_t &value) -> bool {
+  try {
+    size_t pos = 0;
+    value = std::stoull(s, &pos, 0);
+    return pos == s.size();
+  } catch (...) {
+    return false;
+  }
+}
+
+} // namespace
+
+auto parse_wave_spec(const std::string &spec, WaveConfig &config) -> bool {
+  WaveConfig parsed = config;
+  for (const auto &option : perf::split_spec(spec, ',')) {
+    const auto eq = option.find('=');
+    if (option == "mismatch") {
+      parsed.mismatch = true;
+      continue;
+    }
+    if (eq == std::string::npos) {
+      return false;
+    }
+    const auto key = option.substr(0, eq);
+    const auto value = option.substr(eq + 1);
+    uint64_t n = 0;
+    if (key == "cycles") {
+      const auto colon = value.find(':');
+      if (colon == std::string::npos ||
+          !parse_u64(value.substr(0, colon), parsed.from_cycle)) {
+        return false;
+      }
+      const auto to = value.substr(colon + 1);
+      parsed.to_cycle = std::numeric_limits<uint64_t>::max();
+      if ((!to.empty() && !parse_u64(to, parsed.to_cycle)) ||
+          parsed.to_cycle <= parsed.from_cycle) {
+        return false;
+      }
+      parsed.cycles = true;
+    } else if (key == "pc") {
+      if (!parse_u64(value, n) || n > std::numeric_limits<addr_t>::max()) {
+        return false;
+      }
+      parsed.pc = static_cast<addr_t>(n);
+    } else if (key == "instret") {
+      if (!parse_u64(value, n) || n == 0) {
+        return false;
+      }
+      parsed.instret = n;
+    } else if (key == "roi") {
+      if (!parse_u64(value, n) || n > 0xFF) {
+        return false;
+      }
+      parsed.roi = static_cast<uint8_t>(n);
+    } else if (key == "window") {
+      if (!parse_u64(value, n) || n == 0) {
+        return false;
+      }
+      parsed.window = n;
+    } else if (key == "depth") {
+      if (!parse_u64(value, n) || n == 0 || n > 99) {
+        return false;
+      }
+      parsed.depth = static_cast<int>(n);
+    } else if (key == "scope" && !value.empty()) {
+      parsed.scope = value;
+    } else if (key == "out" && !value.empty()) {
+      parsed.path = value;
+    } else {
+      return false;
+    }
+  }
+  config = std::move(parsed);
+  return true;
+}
+
+void WaveTrigger::reset() noexcept {
+  open_until_ = 0;
+  retired_ = 0;
+  roi_open_ = false;
+  windows_ = 0;
+}
+
+void WaveTrigger::on_retire(uint64_t cycle, addr_t pc) {
+  retired_++;
+  if (config_.pc && pc == *config_.pc) {
+    open(cycle, "pc");
+  }
+  if (retired_ == config_.instret) {
+    open(cycle, "instret");
+  }
+}
+
+void WaveTrigger::on_roi(RoiOp op, uint8_t id, uint64_t cycle) {
+  if (!config_.roi || id != *config_.roi) {
+    return;
+  }
+  if (op == RoiOp::START && !roi_open_) {
+    roi_open_ = true;
+    windows_++;
+    DEMU_INFO("Waveform: ROI {} opened at cycle {}", id, cycle);
+  } else if (op == RoiOp::STOP) {
+    roi_open_ = false;
+  }
+}
+
+void WaveTrigger::open(uint64_t cycle, const char *cause) {
+  // A trigger inside an open window extends it
+  if (cycle >= open_until_) {
+    windows_++;
+    DEMU_INFO("Waveform: {} trigger at cycle {}, dumping {} cycles", cause,
+              cycle, config_.window);
+  }
+  open_until_ = cycle + config_.window;
+}
+
+} // namespace demu
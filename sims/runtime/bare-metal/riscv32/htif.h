@@ -0,0 +1,70 @@
+// htif.h - Host-target interface helpers for DEMU bare-metal programs
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTIF_BASE 0x30000000u
+#define HTIF_TOHOST (*(volatile uint32_t *)(HTIF_BASE + 0x00))
+#define HTIF_FROMHOST (*(volatile uint32_t *)(HTIF_BASE + 0x08))
+#define HTIF_MAGIC ((volatile uint32_t *)(HTIF_BASE + 0x40))
+
+#define HTIF_SYS_OPENAT 56
+#define HTIF_SYS_CLOSE 57
+#define HTIF_SYS_LSEEK 62
+#define HTIF_SYS_READ 63
+#define HTIF_SYS_WRITE 64
+#define HTIF_SYS_EXIT 93
+#define HTIF_SYS_CLOCK_GETTIME 113
+
+// The syscall block lives in the (uncached) HTIF window itself, so only the
+// payload buffers are read from or written to main memory.
+static inline long htif_syscall(uint32_t n, uint32_t a0, uint32_t a1,
+                                uint32_t a2, uint32_t a3) {
+  volatile uint32_t *magic = HTIF_MAGIC;
+  magic[0] = n;
+  magic[1] = a0;
+  magic[2] = a1;
+  magic[3] = a2;
+  magic[4] = a3;
+
+  HTIF_TOHOST = (uint32_t)(uintptr_t)magic;
+  while (HTIF_FROMHOST == 0) {
+  }
+  HTIF_FROMHOST = 0;
+
+  return (long)(int32_t)magic[0];
+}
+
+static inline __attribute__((noreturn)) void htif_exit(int code) {
+  HTIF_TOHOST = ((uint32_t)code << 1) | 1u;
+  for (;;) {
+  }
+}
+
+static inline long htif_write(int fd, const void *buf, size_t len) {
+  return htif_syscall(HTIF_SYS_WRITE, (uint32_t)fd, (uint32_t)(uintptr_t)buf,
+                      (uint32_t)len, 0);
+}
+
+static inline long htif_read(int fd, void *buf, size_t len) {
+  return htif_syscall(HTIF_SYS_READ, (uint32_t)fd, (uint32_t)(uintptr_t)buf,
+                      (uint32_t)len, 0);
+}
+
+static inline long htif_open(const char *path) {
+  return htif_syscall(HTIF_SYS_OPENAT, (uint32_t)-100,
+                      (uint32_t)(uintptr_t)path, 0, 0);
+}
+
+static inline long htif_close(int fd) {
+  return htif_syscall(HTIF_SYS_CLOSE, (uint32_t)fd, 0, 0, 0);
+}
+
+// Host wall-clock time in nanoseconds (CLOCK_MONOTONIC)
+static inline uint64_t htif_time_ns(void) {
+  uint32_t ts[4];
+  htif_syscall(HTIF_SYS_CLOCK_GETTIME, 1, (uint32_t)(uintptr_t)ts, 0, 0);
+  uint64_t sec = ((uint64_t)ts[1] << 32) | ts[0];
+  return sec * 1000000000ull + ts[2];
+}
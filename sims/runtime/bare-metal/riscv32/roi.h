@@ -0,0 +1,11 @@
+// roi.h - Region-of-interest markers recognized by DEMU
+#pragma once
+
+// Hint-encoded `addi x0, x0, (op << 8) | id`; a plain nop everywhere else.
+#define DEMU_ROI_MARKER(op, id)                                                \
+  __asm__ volatile("addi x0, x0, %0" ::"i"(((op) << 8) | ((id) & 0xFF)))
+
+#define DEMU_ROI_START(id) DEMU_ROI_MARKER(1, id)
+#define DEMU_ROI_STOP(id) DEMU_ROI_MARKER(2, id)
+#define DEMU_ROI_RESET(id) DEMU_ROI_MARKER(3, id)
+#define DEMU_ROI_DUMP(id) DEMU_ROI_MARKER(4, id)
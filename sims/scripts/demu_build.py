@@ -0,0 +1,86 @@
+"""Helpers shared by the demu-* build scripts."""
+
+import json
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+SIMS_DIR = Path(__file__).resolve().parent.parent
+
+
+def set_config(text, name, value):
+    """Rewrites a set(<name> ...) or option(<name> ...) line."""
+    if isinstance(value, bool):
+        pattern = rf'^(option\({name} ".*") (ON|OFF)\)'
+        repl = rf'\1 {"ON" if value else "OFF"})'
+    else:
+        pattern = rf"^set\({name} .*\)"
+        repl = f"set({name} {value})"
+    text, count = re.subn(pattern, repl, text, flags=re.M)
+    if count == 0:
+        line = (f'option({name} "" {"ON" if value else "OFF"})'
+                if isinstance(value, bool) else f"set({name} {value})")
+        text += line + "\n"
+    return text
+
+
+def base_config(path):
+    """The build config at `path`, or the default one."""
+    path = Path(path)
+    if not path.exists():
+        path = SIMS_DIR / "cmake" / "config.cmake"
+    return path.read_text()
+
+
+def target_arch(config):
+    match = re.search(r'^set\(TARGET_ARCH "(\w+)"\)', config, re.M)
+    return match.group(1) if match else "rv32im"
+
+
+def run(cmd, verbose, cwd=None, check=True, env=None):
+    if verbose:
+        print("+ " + " ".join(cmd), file=sys.stderr)
+    output = None if verbose else subprocess.DEVNULL
+    result = subprocess.run(cmd, cwd=cwd, stdout=output, stderr=output,
+                            env=env)
+    if check and result.returncode != 0:
+        sys.exit(f"{Path(sys.argv[0]).name}: {' '.join(cmd)} failed "
+                 f"({result.returncode})")
+    return result.returncode
+
+
+def build(build_dir, config, targets, verbose):
+    """Configures `build_dir` with `config` and builds `targets`."""
+    build_dir = Path(build_dir)
+    build_dir.mkdir(parents=True, exist_ok=True)
+    config_path = build_dir / "config.cmake"
+    if not config_path.exists() or config_path.read_text() != config:
+        config_path.write_text(config)
+
+    if not (build_dir / "CMakeCache.txt").exists():
+        generator = ["-G", "Ninja"] if shutil.which("ninja") else []
+        run(["cmake", "-S", str(SIMS_DIR), "-B", str(build_dir),
+             "-DCMAKE_BUILD_TYPE=Release"] + generator, verbose)
+    cmd = ["cmake", "--build", str(build_dir)]
+    for target in targets:
+        cmd += ["--target", target]
+    run(cmd, verbose)
+    return build_dir / "bin"
+
+
+def simulate(binary, program, cycles, verbose, args=(), cwd=None):
+    """Runs `program` for `cycles` and returns the simulated kHz."""
+    with tempfile.TemporaryDirectory() as tmp:
+        report = Path(tmp) / "run"
+        cmd = [str(binary), "-c", str(cycles), "--report", str(report),
+               "-L4"] + list(args) + [str(program)]
+        # The program's own exit status does not matter, only its speed
+        run(cmd, verbose, cwd=cwd, check=False)
+        if not report.with_suffix(".json").exists():
+            sys.exit(f"{Path(sys.argv[0]).name}: {binary} wrote no run "
+                     "report")
+        with open(report.with_suffix(".json")) as f:
+            return float(json.load(f).get("khz", 0.0))
@@ -7,6 +7,8 @@ config.test_format = lit.formats.ShTest(not bool(os.environ.get('LIT_USE_INTERNA
 config.suffixes = ['.c', '.S', '.asm']
 
 config.available_features.add(config.arch)
+if config.enable_trace.upper() in ("ON", "1", "TRUE", "YES"):
+    config.available_features.add("trace")
 
 TOOLCHAINS = {
     "rv32i": {
@@ -15,7 +17,8 @@ TOOLCHAINS = {
         "cc": "riscv64-unknown-elf-gcc",
         "cflags": f"-march=rv32i_zicsr -mabi=ilp32 -mcmodel=medany -static -nostartfiles -nostdlib",
         "linker": f"{config.src_root}/runtime/bare-metal/riscv32/linker.ld",
-        "start": f"{config.src_root}/runtime/bare-metal/riscv32/start.S"
+        "start": f"{config.src_root}/runtime/bare-metal/riscv32/start.S",
+        "include": f"{config.src_root}/runtime/bare-metal/riscv32"
     },
     "rv32im": {
         "family": "riscv32",
@@ -23,7 +26,8 @@ TOOLCHAINS = {
         "cc": "riscv64-unknown-elf-gcc",
         "cflags": f"-march=rv32im_zicsr -mabi=ilp32 -mcmodel=medany -static -nostartfiles -nostdlib",
         "linker": f"{config.src_root}/runtime/bare-metal/riscv32/linker.ld",
-        "start": f"{config.src_root}/runtime/bare-metal/riscv32/start.S"
+        "start": f"{config.src_root}/runtime/bare-metal/riscv32/start.S",
+        "include": f"{config.src_root}/runtime/bare-metal/riscv32"
     },
 }
 
@@ -32,16 +36,32 @@ if config.arch not in TOOLCHAINS:
 
 tc = TOOLCHAINS[config.arch]
 
-bare_c = f"{tc['cc']} {tc['cflags']} -T {tc['linker']} {tc['start']} %s -o %t.elf"
+bare_c = f"{tc['cc']} {tc['cflags']} -I {tc['include']} -T {tc['linker']} {tc['start']} %s -o %t.elf"
 bare_asm = f"{tc['cc']} {tc['cflags']} -T {tc['linker']} -x assembler-with-cpp %s -o %t.elf"
 
 config.substitutions.append(('%bare_c', bare_c))
 config.substitutions.append(('%bare_asm', bare_asm))
+config.substitutions.append(('%arch', config.arch))
 
-difftest_cmd = f"{config.difftest} -R gdb %t.elf -L5"
+# Extra difftest arguments, e.g. Verilator plusargs for PGO training runs
+difftest_args = os.environ.get("DEMU_DIFFTEST_ARGS", "")
+difftest_cmd = f"{config.difftest} -R gdb %t.elf -L5 {difftest_args}"
 config.substitutions.append(('%difftest', difftest_cmd))
 
+# Programs that read devices the reference does not model run without it
+if os.path.exists(config.simulator):
+    config.available_features.add("sim")
+config.substitutions.append(('%sim', f"{config.simulator} %t.elf -L5 {difftest_args}"))
+
+# Offline tools that read the traces and reports a run writes
+if os.path.exists(config.interval_tool):
+    config.available_features.add("interval")
+config.substitutions.append(('%interval', config.interval_tool))
+if os.path.exists(config.model_tool):
+    config.available_features.add("model")
+config.substitutions.append(('%model', config.model_tool))
+
 config.test_source_root = os.path.join(config.src_root, "tests/difftest", tc["family"])
-config.excludes = []
+config.excludes = ["Inputs"]
 for exclude_dir in tc['excludes']:
     config.excludes.append(exclude_dir)
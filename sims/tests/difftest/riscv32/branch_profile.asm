@@ -0,0 +1,37 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --branch-profile %t.branch -L3 | FileCheck %s
+// RUN: FileCheck %s --check-prefix=BRANCH --input-file %t.branch
+
+// A 1000-iteration loop with two conditional branches: beqz is taken on
+// every other iteration, the loop-closing bnez on all but the last. Both
+// must show 1000 executions with the exact taken rate, and the loop
+// branch, trivially predictable, only a handful of mispredicts.
+
+.section .text.entry, "ax"
+
+.globl _start
+.type _start, @function
+_start:
+    addi x5, x0, 1000
+    addi x7, x0, 0
+loop:
+    andi x8, x5, 1
+    beqz x8, skip
+    addi x7, x7, 1
+skip:
+    addi x5, x5, -1
+    bnez x5, loop
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+.size _start, .-_start
+
+// CHECK: --- Branch Profile ({{[0-9]+}} static branches) ---
+// CHECK-NEXT: cond 2000 executed
+
+// BRANCH: # DEMU branch profile
+// BRANCH: pc {{.*}}kind
+// BRANCH-DAG: {{^0x[0-9a-f]{8}}} _start+0xc {{.*}} cond 1000 50.00% {{[0-9]+}} {{[0-9.]+}}%
+// BRANCH-DAG: {{^0x[0-9a-f]{8}}} _start+0x18 {{.*}} cond 1000 99.90% {{[0-9]}} {{[0-9.]+}}%
@@ -0,0 +1,46 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --profile %t.hot -L3 | FileCheck %s
+// RUN: FileCheck %s --check-prefix=HOT --input-file %t.hot.txt
+// RUN: FileCheck %s --check-prefix=FOLDED --input-file %t.hot.folded
+
+// _start calls hot, whose three-instruction loop runs 2000 times. hot
+// must lead the function table, with every one of its retirements. Its
+// three loop instructions must be the hottest PCs, 2000 retirements each.
+// The collapsed stacks must show hot called from _start.
+
+.section .text.entry, "ax"
+
+.globl _start
+.type _start, @function
+_start:
+    addi x5, x0, 2000
+    call hot
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+.size _start, .-_start
+
+.globl hot
+.type hot, @function
+hot:
+    addi x6, x6, 1
+    addi x5, x5, -1
+    bnez x5, hot
+    ret
+.size hot, .-hot
+
+// CHECK: --- Hotspot Profile ({{[1-9][0-9]*}} cycles, {{[1-9][0-9]*}} instructions) ---
+// CHECK: hot excl
+
+// HOT: # DEMU hotspot profile
+// HOT: function {{.*}}incl
+// HOT-NEXT: {{^}}hot {{[0-9]+}} {{[0-9.]+}}% {{[0-9]+}} {{[0-9.]+}}% 6001 {{.*}}
+
+// HOT: pc {{.*}}location
+// HOT-NEXT: {{^0x[0-9a-f]{8}}} hot{{(\+0x[48])?}} {{.*}} {{[0-9.]+}}% 2000 {{.*}}
+// HOT-NEXT: {{^0x[0-9a-f]{8}}} hot{{(\+0x[48])?}} {{.*}} {{[0-9.]+}}% 2000 {{.*}}
+// HOT-NEXT: {{^0x[0-9a-f]{8}}} hot{{(\+0x[48])?}} {{.*}} {{[0-9.]+}}% 2000 {{.*}}
+
+// FOLDED: {{^}}_start;hot {{[1-9][0-9]*}}
@@ -0,0 +1,14 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 3000; test $? -eq 3
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x1, x0, 3
+    slli x1, x1, 1
+    ori x1, x1, 1
+    lui x2, 0x30000
+    sw x1, 0(x2)
+
+    j .
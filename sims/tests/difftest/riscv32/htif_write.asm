@@ -0,0 +1,29 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 3000 | FileCheck %s
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    lui x2, 0x30000
+    addi x3, x0, 64
+    sw x3, 0x40(x2)
+    addi x3, x0, 1
+    sw x3, 0x44(x2)
+    la x3, msg
+    sw x3, 0x48(x2)
+    addi x3, x0, 11
+    sw x3, 0x4c(x2)
+    addi x3, x2, 0x40
+    sw x3, 0(x2)
+
+    addi x1, x0, 1
+    sw x1, 0(x2)
+
+    j .
+
+.section .data
+msg:
+    .ascii "htif write\n"
+
+// CHECK: htif write
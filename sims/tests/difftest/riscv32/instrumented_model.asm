@@ -0,0 +1,20 @@
+// REQUIRES: trace
+// RUN: %bare_asm
+// RUN: rm -f %t.wave
+// RUN: %difftest -c 100000 --wave out=%t.wave -L3 | FileCheck %s
+// RUN: test -s %t.wave
+
+// A waveform request switches to the instrumented model, which writes the
+// dump where --wave asked.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// CHECK: Running the {{rv32im?}} instrumented model
+// CHECK: Waveform written to {{.*}}.wave
@@ -0,0 +1,46 @@
+// REQUIRES: interval
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --interval 500 --interval-report %t.iv -L3 > %t.sim
+// RUN: %interval %t.iv --csv %t.iv.csv -L3 > %t.tool
+// RUN: cat %t.sim %t.tool | FileCheck %s
+// RUN: FileCheck %s --check-prefix=CYCLES --input-file %t.iv.csv
+// RUN: %difftest -c 100000 --interval 1000i --interval-report %t.csv
+// RUN: FileCheck %s --check-prefix=INSTS --input-file %t.csv
+
+// 1000 iterations of a three-instruction loop, about 3000 retirements.
+// Cycle intervals end exactly 500 cycles apart. Instruction intervals end
+// on the first cycle that reaches the next multiple of 1000, so each full
+// one is within an issue group of 1000 and the tail holds the exit code.
+// demu-interval must add the rows back up to the run's own totals.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x5, x0, 1000
+loop:
+    addi x6, x6, 3
+    addi x5, x5, -1
+    bnez x5, loop
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// CHECK: Intervals: [[#ROWS:]] rows written to
+// CHECK: [[#CYCLES:]] cycles, [[#INSTRET:]] instructions, IPC:
+// CHECK: --- Intervals ---
+// CHECK-NEXT: [[#ROWS]] intervals, [[#CYCLES]] cycles, [[#INSTRET]] instructions, IPC
+
+// CYCLES: cycle,cycles,instret,
+// CYCLES-NEXT: [[#%u,FIRST:]],[[#FIRST]],{{[0-9]+}},
+// CYCLES-NEXT: [[#FIRST+500]],500,{{[0-9]+}},
+// CYCLES-NEXT: [[#FIRST+1000]],500,{{[0-9]+}},
+
+// INSTS: cycle,cycles,instret,
+// INSTS-NEXT: {{[0-9]+,[0-9]+}},{{(99[0-9]|100[0-9])}},
+// INSTS-NEXT: {{[0-9]+,[0-9]+}},{{(99[0-9]|100[0-9])}},
+// INSTS-NEXT: {{[0-9]+,[0-9]+}},{{(99[0-9]|100[0-9])}},
+// INSTS-NEXT: {{[0-9]+,[0-9]+}},{{[0-9]}},
+// INSTS-NOT: {{.}}
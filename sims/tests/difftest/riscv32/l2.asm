@@ -0,0 +1,51 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 200000 > %t.none 2>&1
+// RUN: %difftest -c 200000 --l2 64x4x64 > %t.fits 2>&1
+// RUN: %difftest -c 200000 --l2 8x4x64 > %t.spills 2>&1
+// RUN: FileCheck %s --check-prefix=NONE < %t.none
+// RUN: FileCheck %s --check-prefix=FITS < %t.fits
+// RUN: FileCheck %s --check-prefix=SPILLS < %t.spills
+// RUN: test $(awk '$(NF-6) == "dmem" { print $(NF-4) }' %t.spills) -gt 48
+// RUN: test $(sed -n 's/.* \([0-9]*\) cycles, .*/\1/p' %t.none) -lt $(sed -n 's/.* \([0-9]*\) cycles, .*/\1/p' %t.fits)
+// RUN: test $(sed -n 's/.* \([0-9]*\) cycles, .*/\1/p' %t.fits) -lt $(sed -n 's/.* \([0-9]*\) cycles, .*/\1/p' %t.spills)
+
+// Loads one word from each of 48 lines (3 KiB) four times over. That is
+// more than the 2 KiB L1D, so every pass refills lines the L1D dropped.
+// A 16 KiB L2 holds the whole set and misses only on the first touch of
+// each line. A 2 KiB L2 cannot hold it and keeps missing on later passes.
+// The walk is unrolled, so no mispredicted branch loads extra lines.
+// Memory answers at once without an L2, so each L2 adds cycles, and the
+// one that misses adds the most.
+
+#define LINES 48
+#define PASSES 4
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    .rept PASSES
+    la x2, array
+    .rept LINES
+    lw x5, 0(x2)
+    addi x2, x2, 64
+    .endr
+    .endr
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+.section .bss
+.balign 64
+array:
+    .space LINES * 64
+
+// NONE-NOT: L2 Cache
+
+// FITS: L2 Cache (64x4x64
+// FITS: dmem {{[1-9][0-9]*}} 48 0 0 {{[0-9.]+}}%
+
+// SPILLS: L2 Cache (8x4x64
+// SPILLS: dmem {{[1-9][0-9]*}} {{[1-9][0-9]*}} 0 0 {{[0-9.]+}}%
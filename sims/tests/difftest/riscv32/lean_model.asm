@@ -0,0 +1,16 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 -L3 | FileCheck %s
+
+// Without -t, --wave or --coverage the lean model runs.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// CHECK: Running the {{rv32im?}} lean model
+// CHECK-NOT: instrumented
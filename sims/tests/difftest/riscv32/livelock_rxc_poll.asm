@@ -0,0 +1,31 @@
+// REQUIRES: sim
+// RUN: %bare_asm
+// RUN: %sim -c 20000 --livelock-window 64 --uart-in script:%S/Inputs/livelock_rxc_poll.script 2>&1 | FileCheck %s
+
+// Spinning on the UART RXC flag repeats the same state until a byte
+// arrives, which is waiting on a device rather than a livelock. The line
+// lands long after two windows; it is echoed and the run exits cleanly.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    lui x2, 0x10000
+
+wait:
+    lw x4, 0xc(x2)
+    andi x4, x4, 1
+    beqz x4, wait
+    lw x6, 0(x2)
+    sw x6, 4(x2)
+    addi x5, x0, 10
+    bne x6, x5, wait
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// CHECK-NOT: LIVELOCK
+// CHECK: rxc poll ok
+// CHECK-NOT: LIVELOCK
@@ -0,0 +1,18 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 20000 --livelock-window 64 > %t.log 2>&1; test $? -eq 121
+// RUN: FileCheck %s < %t.log
+
+// A loop that rewrites the same value forever adds no new state, so the
+// watchdog stops it with the livelock status.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x5, x0, 1
+spin:
+    addi x6, x0, 7
+    bnez x5, spin
+    j .
+
+// CHECK: Watchdog: LIVELOCK
@@ -0,0 +1,61 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --miss-profile %t.miss -L3 | FileCheck %s
+// RUN: FileCheck %s --check-prefix=MISS --input-file %t.miss
+
+// One load walks 16 lines of .bss twice with a 64-byte stride. The lines
+// fit in the L1D, so only the first pass misses: 32 accesses, 16 misses.
+// A second load walks 8 lines of .rodata once. .rodata lives in IMEM, so
+// those refills are served by imem and must still count: 8 of 8. With
+// the HTIF store, 41 memory ops retire.
+
+.option norelax
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x9, x0, 2
+pass:
+    lui x2, %hi(array)
+    addi x2, x2, %lo(array)
+    addi x5, x0, 16
+walk:
+    lw x6, 0(x2)
+    addi x2, x2, 64
+    addi x5, x5, -1
+    bnez x5, walk
+    addi x9, x9, -1
+    bnez x9, pass
+
+    lui x2, %hi(table)
+    addi x2, x2, %lo(table)
+    addi x5, x0, 8
+rodata:
+    lw x6, 0(x2)
+    addi x2, x2, 64
+    addi x5, x5, -1
+    bnez x5, rodata
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+.section .rodata
+.balign 64
+table:
+    .space 8 * 64, 1
+
+.section .bss
+.balign 64
+array:
+    .space 16 * 64
+
+// CHECK: --- D-Cache Miss Attribution ---
+// CHECK-NEXT: Memory ops: 41 (24 attributed misses,
+
+// MISS: # DEMU d-cache miss attribution
+// MISS-NEXT: # memory_ops 41 misses 24 refills {{[0-9]+}} stale
+// MISS: pc {{.*}}avg_bus
+// MISS-DAG: {{^0x[0-9a-f]{8}}} {{.*}} ld 32 16 50.00%
+// MISS-DAG: {{^0x[0-9a-f]{8}}} {{.*}} ld 8 8 100.00%
@@ -0,0 +1,41 @@
+// REQUIRES: model
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --inst-trace %t.it --branch-trace %t.bt -L3 > %t.sim
+// RUN: %model %t.it -j 1 -L3 > %t.model
+// RUN: %model -b %t.bt --bpu bimodal:10 -L3 >> %t.model
+// RUN: cat %t.sim %t.model | FileCheck %s
+// RUN: FileCheck %s --check-prefix=TRACE --input-file %t.sim
+
+// 1000 iterations of a three-instruction loop. The model replays exactly
+// the instructions the run traced, and the branch replay sees the same
+// branches; its bimodal counter mispredicts only the final loop exit.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x5, x0, 1000
+loop:
+    addi x6, x6, 3
+    addi x5, x5, -1
+    bnez x5, loop
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// TRACE: --- Shadow Branch Predictors ({{100[0-9]}} branches) ---
+// TRACE-NEXT: cond 1000
+// TRACE: --- Instruction Trace ---
+// TRACE-NEXT: .it: {{300[4-9]}} records
+
+// CHECK: --- Shadow Branch Predictors ([[#BRANCHES:]] branches) ---
+// CHECK: --- Instruction Trace ---
+// CHECK-NEXT: .it: [[#RECORDS:]] records
+// CHECK: Trace loaded: {{.*}}.it ([[#RECORDS]] instructions,
+// CHECK: --- Model vs Reference ---
+// CHECK: instret [[#RECORDS]] {{[0-9]+}}
+// CHECK: --- Timing Model (1 points,
+// CHECK: --- Branch Trace Replay ([[#BRANCHES]] branches) ---
+// CHECK-NEXT: bimodal-10 cond miss 0.10%
@@ -0,0 +1,20 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --model %arch -L3 | FileCheck %s -DARCH=%arch
+// RUN: %difftest -c 100000 --model rv64gc > %t.log 2>&1; test $? -ne 0
+// RUN: FileCheck %s --check-prefix=UNKNOWN < %t.log
+
+// --model runs the named variant; a name not linked into the build is
+// refused with the list of ones that are.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// CHECK: Running the [[ARCH]] lean model
+
+// UNKNOWN: Model 'rv64gc' is not linked into this build (available: {{.*}}rv32i
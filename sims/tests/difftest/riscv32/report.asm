@@ -0,0 +1,32 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --report %t.run.json -L3 > %t.sim
+// RUN: test -s %t.run.pb
+// RUN: cat %t.sim %t.run.json | FileCheck %s
+
+// A short loop that exits through HTIF. Both report files are written
+// under the one base name, and the JSON one carries the exit reason and
+// the same totals the run printed.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x5, x0, 100
+loop:
+    addi x5, x5, -1
+    bnez x5, loop
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+// CHECK: [[#CYCLES:]] cycles, [[#INSTRET:]] instructions, IPC:
+// CHECK: Run report: [[BASE:.*]].run.pb, [[BASE]].run.json
+// CHECK: "isa": "{{rv32im?}}",
+// CHECK: "program": "{{.*}}.elf",
+// CHECK-NEXT: "program_hash": "{{[0-9a-f]{16}}}",
+// CHECK-NEXT: "exit_reason": "EXIT_REASON_HALT",
+// CHECK-NEXT: "cycles": "[[#CYCLES]]",
+// CHECK-NEXT: "instret": "[[#INSTRET]]",
+// CHECK: "counters": {
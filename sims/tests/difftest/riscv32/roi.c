@@ -0,0 +1,28 @@
+// RUN: %bare_c -DDEMU_HTIF
+// RUN: %difftest -c 20000 --roi 1=sum --roi 2=outer -L3 | FileCheck %s
+
+#include "roi.h"
+
+volatile int sink;
+
+int main() {
+  int sum = 0;
+  DEMU_ROI_START(2);
+  for (int r = 0; r < 3; r++) {
+    DEMU_ROI_START(1);
+    for (int i = 1; i <= 20; i++) {
+      sum += i;
+    }
+    DEMU_ROI_STOP(1);
+  }
+  DEMU_ROI_STOP(2);
+  DEMU_ROI_DUMP(1);
+  sink = sum;
+  return 0;
+}
+
+// CHECK: --- ROI 'sum' @ cycle
+// CHECK: Program exited with code 0
+// CHECK: --- Region of Interest 'sum' (3 entries) ---
+// CHECK-NEXT: {{[1-9][0-9]*}} cycles, {{[1-9][0-9]*}} instructions, IPC:
+// CHECK: --- Region of Interest 'outer' (1 entries) ---
@@ -0,0 +1,52 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --shadow-bpu bimodal:10 --shadow-bpu ras:4 --shadow-bpu btb:16x4 --bpu-report %t.csv -L3 | FileCheck %s
+// RUN: FileCheck %s --check-prefix=BPU --input-file %t.csv
+
+// A 1000-iteration loop with a beqz taken on every other iteration, a
+// call to a leaf function and the loop-closing bnez. From weakly taken, a
+// bimodal counter mispredicts every not-taken beqz and the final bnez:
+// 501 of 2000. Every return goes back to its call, so the RAS never
+// misses, and the BTB only misses on the first visit to each target.
+
+.option norelax
+
+.section .text.entry, "ax"
+
+.globl _start
+.type _start, @function
+_start:
+    addi x5, x0, 1000
+    addi x7, x0, 0
+loop:
+    andi x8, x5, 1
+    beqz x8, skip
+    addi x7, x7, 1
+skip:
+    jal ra, leaf
+    addi x5, x5, -1
+    bnez x5, loop
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+.size _start, .-_start
+
+.globl leaf
+.type leaf, @function
+leaf:
+    ret
+.size leaf, .-leaf
+
+// CHECK: --- Shadow Branch Predictors ({{[0-9]+}} branches) ---
+// CHECK-NEXT: cond 2000
+// CHECK: call 1000
+// CHECK-NEXT: ret 1000
+// CHECK: bimodal-10 cond miss 25.05%
+// CHECK: ras-4 ret miss 0.00%
+
+// BPU: model,scope,lookups,mispredicts,miss_rate,mpki,built,dut_branches,dut_mispredicts
+// BPU-DAG: {{^}}rtl-{{[^,]*}},all,{{[0-9]+}},{{[0-9]+}},{{[0-9.]+}},{{[0-9.]+}},1,{{[0-9]+}},{{[0-9]+}}
+// BPU-DAG: {{^}}bimodal-10,cond,2000,501,0.250500,{{[0-9.]+}},0,0,0
+// BPU-DAG: {{^}}ras-4,ret,1000,0,0.000000,0.0000,0,0,0
+// BPU-DAG: {{^}}btb-16x4-plru,taken,{{[0-9]+}},{{[1-9]}},{{[0-9.]+}},{{[0-9.]+}},0,0,0
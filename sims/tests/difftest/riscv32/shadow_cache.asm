@@ -0,0 +1,44 @@
+// RUN: %bare_asm
+// RUN: %difftest -c 100000 --shadow-cache d:8,2x4x64:lru --shadow-report %t.csv -L3 | FileCheck %s
+// RUN: FileCheck %s --check-prefix=CACHE --input-file %t.csv
+
+// Four passes of one load per line over 16 lines of .bss: 64 cacheable
+// loads; the HTIF store is uncacheable and not counted. A 2 KiB LRU
+// cache holds all 16 lines and misses only on the first pass. A 512 B one
+// gives each of its 2 sets 8 lines for 4 ways, so LRU misses every time.
+
+.option norelax
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    addi x9, x0, 4
+pass:
+    lui x2, %hi(array)
+    addi x2, x2, %lo(array)
+    addi x5, x0, 16
+walk:
+    lw x6, 0(x2)
+    addi x2, x2, 64
+    addi x5, x5, -1
+    bnez x5, walk
+    addi x9, x9, -1
+    bnez x9, pass
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+.section .bss
+.balign 64
+array:
+    .space 16 * 64
+
+// CHECK: --- Shadow L1 Caches ({{[1-9][0-9]*}} instructions) ---
+// CHECK: l1d 512B 2x4x64B lru miss 100.00%
+
+// CACHE: cache,sets,ways,line_size,bytes,policy,accesses,misses,miss_rate,mpki,built,dut_accesses,dut_misses
+// CACHE-DAG: l1d,8,4,64,2048,lru,64,16,0.250000,{{[0-9.]+}},0,0,0
+// CACHE-DAG: l1d,2,4,64,512,lru,64,64,1.000000,{{[0-9.]+}},0,0,0
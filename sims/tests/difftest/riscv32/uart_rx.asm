@@ -0,0 +1,40 @@
+// REQUIRES: sim
+// RUN: %bare_asm
+// RUN: %sim -c 20000 --uart-in script:%S/Inputs/uart_rx.script | FileCheck %s
+
+// The reference does not model the UART, so this runs without difftest.
+// A byte store to RXC must set IE alone and leave VALID to the receiver;
+// each received byte is then echoed to TXD up to the newline.
+
+.section .text.entry, "ax"
+.globl _start
+
+_start:
+    lui x2, 0x10000
+    addi x3, x0, 3
+    sb x3, 0xc(x2)
+    lw x4, 0xc(x2)
+    addi x5, x0, 2
+    bne x4, x5, fail
+
+wait:
+    lw x4, 0xc(x2)
+    andi x4, x4, 1
+    beqz x4, wait
+    lw x6, 0(x2)
+    sw x6, 4(x2)
+    addi x5, x0, 10
+    bne x6, x5, wait
+
+    lui x2, 0x30000
+    addi x1, x0, 1
+    sw x1, 0(x2)
+    j .
+
+fail:
+    lui x2, 0x30000
+    addi x1, x0, 5
+    sw x1, 0(x2)
+    j .
+
+// CHECK: uart rx ok
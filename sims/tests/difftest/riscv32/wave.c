@@ -0,0 +1,29 @@
+// REQUIRES: trace
+// RUN: %bare_c -DDEMU_HTIF
+// RUN: rm -f %t.cycles.wave %t.roi.wave
+// RUN: %difftest -c 20000 --wave cycles=100:600,out=%t.cycles.wave -L3 | FileCheck %s --check-prefix=CYCLES
+// RUN: test -s %t.cycles.wave
+// RUN: %difftest -c 20000 --wave roi=1,out=%t.roi.wave -L3 | FileCheck %s --check-prefix=ROI
+// RUN: test -s %t.roi.wave
+
+#include "roi.h"
+
+volatile int sink;
+
+int main() {
+  int sum = 0;
+  for (int r = 0; r < 2; r++) {
+    DEMU_ROI_START(1);
+    for (int i = 1; i <= 20; i++) {
+      sum += i;
+    }
+    DEMU_ROI_STOP(1);
+  }
+  sink = sum;
+  return 0;
+}
+
+// CYCLES: Waveform written to {{.*}}.cycles.wave
+
+// ROI: Waveform: ROI 1 opened at cycle
+// ROI: Waveform written to {{.*}}.roi.wave (2 windows)
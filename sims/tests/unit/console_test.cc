@@ -0,0 +1,111 @@
+#include "demu/hal/peripheral/uart/console.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// LINE policy: a complete line is written at once, a partial line is held
+// until its first byte is flush_interval_ms old, however long the console
+// had been idle before it arrived.
+
+namespace {
+
+using namespace std::chrono_literals;
+using clock_type = std::chrono::steady_clock;
+using demu::hal::uart::Console;
+using demu::hal::uart::ConsoleConfig;
+using demu::hal::uart::FlushPolicy;
+
+constexpr uint32_t INTERVAL_MS = 400;
+
+int failures = 0;
+
+void expect(bool ok, const std::string &what) {
+  if (!ok) {
+    std::cerr << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+
+auto contents(const std::string &path) -> std::string {
+  std::ifstream in(path, std::ios::binary);
+  std::ostringstream out;
+  out << in.rdbuf();
+  return out.str();
+}
+
+// Polls until `path` holds `want`, for at most `timeout`
+auto wait_for(const std::string &path, const std::string &want,
+              clock_type::duration timeout) -> bool {
+  const auto deadline = clock_type::now() + timeout;
+  while (clock_type::now() < deadline) {
+    if (contents(path) == want) {
+      return true;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return contents(path) == want;
+}
+
+void put(Console &console, const std::string &text) {
+  for (const char c : text) {
+    console.put(static_cast<demu::isa::byte_t>(c));
+  }
+}
+
+} // namespace
+
+int main() {
+  char path[] = "/tmp/demu-console-XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    std::perror("mkstemp");
+    return 1;
+  }
+  ::close(fd);
+
+  {
+    ConsoleConfig config;
+    config.path = path;
+    config.policy = FlushPolicy::LINE;
+    config.flush_interval_ms = INTERVAL_MS;
+    Console console(config);
+
+    // Newline-terminated output goes out without waiting for the interval
+    put(console, "line\n");
+    expect(wait_for(path, "line\n", 1s), "complete line is written");
+
+    // Idle for longer than the interval, so a timer started at the last
+    // write would already have expired when the prompt arrives
+    std::this_thread::sleep_for(std::chrono::milliseconds(INTERVAL_MS * 2));
+
+    put(console, "prompt> ");
+    std::this_thread::sleep_for(std::chrono::milliseconds(INTERVAL_MS / 4));
+    expect(contents(path) == "line\n", "partial line is held");
+
+    // Times out once the prompt has been pending for the interval
+    expect(wait_for(path, "line\nprompt> ",
+                    std::chrono::milliseconds(INTERVAL_MS * 4)),
+           "partial line is written after the interval");
+
+    // A newline flushes the bytes held before it and keeps the rest
+    put(console, "a\nb");
+    expect(wait_for(path, "line\nprompt> a\n", 100ms),
+           "line is written up to its newline");
+    expect(contents(path) == "line\nprompt> a\n", "trailing bytes are held");
+
+    console.flush();
+    expect(contents(path) == "line\nprompt> a\nb", "flush() writes the rest");
+  }
+
+  std::remove(path);
+  if (failures == 0) {
+    std::cout << "console_test: ok" << std::endl;
+  }
+  return failures == 0 ? 0 : 1;
+}
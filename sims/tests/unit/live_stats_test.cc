@@ -0,0 +1,103 @@
+#include "demu/live_stats.hh"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A writer's counters read back through LiveStatsReader, and a segment
+// left behind by a dead writer dropped from list().
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string &what) {
+  if (!ok) {
+    std::cerr << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+
+auto listed(const std::string &name) -> bool {
+  const auto names = demu::LiveStatsReader::list();
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// Pid of a process that has already exited and been reaped
+auto dead_pid() -> pid_t {
+  const pid_t pid = fork();
+  if (pid == 0) {
+    _exit(0);
+  }
+  waitpid(pid, nullptr, 0);
+  return pid;
+}
+
+void test_round_trip() {
+  demu::LiveStatsWriter writer;
+  expect(writer.open("round_trip.elf", "rv32i", 1000), "writer opens");
+  expect(writer.name() == "/demu-" + std::to_string(getpid()),
+         "segment is named after the pid");
+
+  demu::PerfCounters counters;
+  counters.cycles = 123456;
+  counters.instret = 7890;
+  writer.publish(counters);
+
+  expect(listed(writer.name()), "live segment is listed");
+
+  demu::LiveStatsReader reader;
+  expect(reader.attach(writer.name()), "reader attaches");
+  demu::LiveSnapshot snapshot;
+  expect(reader.read(snapshot), "reader copies a snapshot");
+  expect(snapshot.pid == getpid(), "pid");
+  expect(snapshot.state == demu::LiveState::RUNNING, "state");
+  expect(snapshot.period == 1000, "period");
+  expect(std::strcmp(snapshot.isa, "rv32i") == 0, "isa");
+  expect(std::strcmp(snapshot.program, "round_trip.elf") == 0, "program");
+  expect(snapshot.counter(&demu::PerfCounters::cycles) == 123456, "cycles");
+  expect(snapshot.counter(&demu::PerfCounters::instret) == 7890, "instret");
+
+  writer.publish(counters, demu::LiveState::EXITED, 3);
+  expect(reader.read(snapshot), "reader copies the final snapshot");
+  expect(snapshot.state == demu::LiveState::EXITED, "final state");
+  expect(snapshot.exit_code == 3, "exit code");
+
+  reader.detach();
+  const std::string name = writer.name();
+  writer.close();
+  expect(!listed(name), "closed segment is gone");
+}
+
+void test_stale_segment() {
+  const std::string name = "/demu-" + std::to_string(dead_pid());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    expect(false, "create a stale segment");
+    return;
+  }
+  close(fd);
+
+  expect(!listed(name), "stale segment is skipped");
+  const int again = shm_open(name.c_str(), O_RDONLY, 0);
+  expect(again < 0, "stale segment is unlinked");
+  if (again >= 0) {
+    close(again);
+    shm_unlink(name.c_str());
+  }
+}
+
+} // namespace
+
+int main() {
+  test_round_trip();
+  test_stale_segment();
+  if (failures == 0) {
+    std::cout << "live_stats_test: ok" << std::endl;
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -124,7 +124,13 @@ auto Debugger::parse_reg(const std::string &s) -> int {
   return -1;
 }
 
-void Debugger::print_stop_banner() { print_auto_display(); }
+void Debugger::print_stop_banner() {
+  if (sim_.halted()) {
+    fmt::print("[PROGRAM EXITED] code {} at cycle {}\n", sim_.exit_code(),
+               sim_.cycle_count());
+  }
+  print_auto_display();
+}
 
 void Debugger::print_registers() {
   fmt::print("\n  PC = 0x{:08x}\n\n", sim_.pc());
@@ -156,9 +162,14 @@ void Debugger::repl() {
   fmt::print("║  Type 'help' for available commands.     ║\n");
   fmt::print("╚══════════════════════════════════════════╝\n\n");
 
-  while (true) {
-    std::string prompt = fmt::format("(demu|pc=0x{:08x}|cyc={}) ", sim_.pc(),
-                                     sim_.cycle_count());
+  while (!quit_) {
+    const std::string where = sim_.lines().describe(sim_.pc());
+    std::string prompt =
+        where.empty()
+            ? fmt::format("(demu|pc=0x{:08x}|cyc={}) ", sim_.pc(),
+                          sim_.cycle_count())
+            : fmt::format("(demu|pc=0x{:08x}|{}|cyc={}) ", sim_.pc(), where,
+                          sim_.cycle_count());
 
     char *raw = readline(prompt.c_str());
     if (!raw) {
@@ -227,7 +238,7 @@ void Debugger::cmd_run(const std::vector<std::string> &args) {
   uint64_t target = max_cycles > 0 ? max_cycles : 1000000;
   uint64_t start = sim_.cycle_count();
 
-  while (sim_.cycle_count() - start < target && running_) {
+  while (sim_.cycle_count() - start < target && running_ && !sim_.halted()) {
     sim_.step(1);
     if (bp_mgr_.check_breakpoint(sim_.pc(), sim_.cycle_count(),
                                  sim_.instret_count())) {
@@ -254,7 +265,8 @@ void Debugger::cmd_continue(const std::vector<std::string> &args) {
   running_ = true;
   uint64_t start = sim_.cycle_count();
 
-  while (sim_.cycle_count() - start < max_cycles && running_) {
+  while (sim_.cycle_count() - start < max_cycles && running_ &&
+         !sim_.halted()) {
     sim_.step(1);
     if (bp_mgr_.check_breakpoint(sim_.pc(), sim_.cycle_count(),
                                  sim_.instret_count())) {
@@ -278,7 +290,7 @@ void Debugger::cmd_step(const std::vector<std::string> &args) {
     }
   }
 
-  for (uint64_t i = 0; i < n; i++) {
+  for (uint64_t i = 0; i < n && !sim_.halted(); i++) {
     sim_.step(1);
     if (bp_mgr_.check_breakpoint(sim_.pc(), sim_.cycle_count(),
                                  sim_.instret_count())) {
@@ -305,7 +317,7 @@ void Debugger::cmd_stepi(const std::vector<std::string> &args) {
   uint64_t safety = sim_.cycle_count() + 1000000;
 
   while (sim_.instret_count() - start_instret < n &&
-         sim_.cycle_count() < safety) {
+         sim_.cycle_count() < safety && !sim_.halted()) {
     sim_.step(1);
     if (bp_mgr_.check_breakpoint(sim_.pc(), sim_.cycle_count(),
                                  sim_.instret_count())) {
@@ -624,7 +636,8 @@ void Debugger::cmd_reset(const std::vector<std::string> &) {
 
 void Debugger::cmd_quit(const std::vector<std::string> &) {
   fmt::print("Goodbye.\n");
-  std::exit(0);
+  // Leave the loop so main() can write the end-of-run reports
+  quit_ = true;
 }
 
 } // namespace demu::dbg
@@ -21,6 +21,7 @@ private:
   BreakpointManager bp_mgr_;
   std::set<uint8_t> auto_display_regs_;
   bool running_{false};
+  bool quit_{false};
 
   struct Command {
     std::string name;
@@ -1,6 +1,7 @@
 #include "debugger.hh"
 #include <cstdlib>
 #include <demu/logger.hh>
+#include <demu/profiling.hh>
 #include <demu/sim.hh>
 #include <iostream>
 #include <string>
@@ -11,23 +12,27 @@ class DemuDebuggerTop final : public demu::DemuSimulator {
 public:
   explicit DemuDebuggerTop(bool enabled_trace = false,
                            int threads = NUM_THREADS, int argc = 0,
-                           char **argv = nullptr)
-      : DemuSimulator(enabled_trace, threads, argc, argv) {}
+                           char **argv = nullptr, bool coverage = false,
+                           const std::string &model = "")
+      : DemuSimulator(enabled_trace, threads, argc, argv, coverage, model) {}
 
 protected:
   void register_devices() override {
-    register_port<0, demu::hal::axif::AXIFullPortHandler,
-                  demu::hal::axif::AXIFullSRAM>("imem");
-    register_port<1, demu::hal::axif::AXIFullPortHandler,
-                  demu::hal::axif::AXIFullSRAM>("dmem");
+    register_memory<0>("imem");
+    register_memory<1>("dmem");
     register_port<2, demu::hal::axif::AXIFullPortHandler,
-                  demu::hal::axif::AXIFullUART>("uart");
+                  demu::hal::axif::AXIFullUART>("uart", uart_console_,
+                                                uart_input_);
 
 #if defined(__ISA_RV32I__) || defined(__ISA_RV32IM__)
     register_port<3, demu::hal::axif::AXIFullPortHandler,
                   demu::hal::axif::AXIFullCLINT>(
         "clint", config_->freq(), timer_irq_.get(), soft_irq_.get());
 #endif
+
+    register_port<4, demu::hal::axif::AXIFullPortHandler,
+                  demu::hal::axif::AXIFullHTIF>(
+        "htif", device_manager_.get(), [this](int code) { halt(code); });
   };
 
   void on_init() override {}
@@ -42,11 +47,27 @@ void print_usage(const char *prog) {
   std::cout << "Usage: " << prog << " [options] <program_file>\n\n";
   std::cout << "Options:\n";
   std::cout << "  -h, --help                    Show this help message\n";
-  std::cout << "  -t, --trace                   Enable VCD trace\n";
-  std::cout << "  -T, --threads <n>             Number of Verilator threads "
-               "(default: NUM_THREADS)\n";
+  std::cout << "  -t, --trace                   Dump waveforms for the whole "
+               "run\n";
+  std::cout << "      --wave <spec>             Dump waveforms only in "
+               "triggered windows, cycles=<from>:[<to>],pc=<addr>,"
+               "instret=<n>,roi=<id>,window=<n>,depth=<n>,scope=<hier>,"
+               "out=<path>\n";
+  std::cout << "  --coverage                    Collect coverage with the "
+               "instrumented model\n";
+  std::cout << "  --model <name>                Model to run: "
+            << demu::model_names() << " (default: " DEMU_DEFAULT_MODEL ")\n";
+  std::cout << "  -T, --threads <n>             Deprecated and ignored, the "
+               "thread count is fixed at build time (NUM_THREADS)\n";
   std::cout
       << "  -b, --base <addr>             Binary load base address (hex)\n";
+  std::cout << "      --uart-out <path>         UART console sink (-, stderr, "
+               "|<cmd> or file)\n";
+  std::cout << "      --uart-in <source>        UART RX source (stdin, pty, "
+               "file:<path>, fifo:<path>, script:<path>)\n";
+  std::cout << "      --uart-flush <policy>     UART flush policy (line, "
+               "size[:N], time[:MS])\n";
+  demu::ProfilingOptions::print_usage();
   std::cout << "  -L12345,                      Set log level (5=error, "
                "4=warn, 3=info, 2=debug, 1=trace)\n";
   std::cout << "  +<arg>                        Native Verilator arguments "
@@ -76,26 +97,73 @@ auto main(int argc, char **argv) -> int {
 
   std::string program_file;
   bool enable_trace = false;
-  int threads = NUM_THREADS;
+  bool coverage = false;
+  std::string model;
+  demu::WaveConfig wave;
   uint32_t base_addr = 0;
+  demu::hal::uart::ConsoleConfig uart_console;
+  demu::hal::uart::InputConfig uart_input;
+  demu::ProfilingOptions profiling;
   spdlog::level::level_enum spdlog_level = spdlog::level::warn;
 
   for (int i = 1; i < argc; i++) {
     std::string arg = argv[i];
 
+    const auto match = profiling.parse(argc, argv, i);
+    if (match == demu::OptionMatch::INVALID) {
+      return 1;
+    }
+    if (match == demu::OptionMatch::CONSUMED) {
+      continue;
+    }
+
     if (arg == "-h" || arg == "--help") {
       print_usage(argv[0]);
       return 0;
     } else if (arg == "-t" || arg == "--trace") {
       enable_trace = true;
+    } else if (arg == "--coverage") {
+      coverage = true;
+    } else if (arg == "--model") {
+      if (i + 1 < argc) {
+        model = argv[++i];
+      }
+    } else if (arg == "--wave") {
+      if (i + 1 < argc && !demu::parse_wave_spec(argv[++i], wave)) {
+        std::cerr << "Invalid wave spec: " << argv[i] << std::endl;
+        return 1;
+      }
+      if (wave.mismatch) {
+        std::cerr << "Mismatch triggers need the difftest" << std::endl;
+        return 1;
+      }
+      enable_trace = true;
     } else if (arg == "-T" || arg == "--threads") {
       if (i + 1 < argc) {
-        threads = std::stoi(argv[++i]);
+        ++i;
       }
+      std::cerr << "Warning: " << arg << " is deprecated and ignored, the "
+                << "model runs with NUM_THREADS=" << NUM_THREADS << std::endl;
     } else if (arg == "-b" || arg == "--base") {
       if (i + 1 < argc) {
         base_addr = std::stoul(argv[++i], nullptr, 16);
       }
+    } else if (arg == "--uart-out") {
+      if (i + 1 < argc) {
+        uart_console.path = argv[++i];
+      }
+    } else if (arg == "--uart-in") {
+      if (i + 1 < argc &&
+          !demu::hal::uart::parse_input_source(argv[++i], uart_input)) {
+        std::cerr << "Invalid UART input source: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--uart-flush") {
+      if (i + 1 < argc &&
+          !demu::hal::uart::parse_flush_policy(argv[++i], uart_console)) {
+        std::cerr << "Invalid UART flush policy: " << argv[i] << std::endl;
+        return 1;
+      }
     } else if (arg[0] == '-' && arg.length() > 1 && arg[1] == 'L') {
       int log_level = std::stoi(arg.substr(2));
       switch (log_level) {
@@ -135,7 +203,13 @@ auto main(int argc, char **argv) -> int {
 
   demu::Logger::init(spdlog_level);
 
-  DemuDebuggerTop sim(enable_trace, threads, argc, argv);
+  DemuDebuggerTop sim(enable_trace, NUM_THREADS, argc, argv, coverage, model);
+  sim.uart_console(uart_console);
+  sim.uart_input(uart_input);
+  sim.wave(wave);
+  if (!demu::attach_profilers(sim, profiling)) {
+    return 1;
+  }
 
   sim.init();
   sim.reset();
@@ -160,5 +234,8 @@ auto main(int argc, char **argv) -> int {
   demu::dbg::Debugger dbg(sim);
   dbg.repl();
 
+  sim.finish();
+  demu::finish_profilers(sim, profiling);
+
   return 0;
 }
@@ -1,6 +1,7 @@
 #include "demu/elf_loader.hh"
 #include "gdb_ref_model.hh"
 #include "ref_model.hh"
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdlib>
@@ -29,8 +30,9 @@ public:
       std::unique_ptr<demu::difftest::IRefModel> ref_model,
       bool enabled_trace = false, int threads = NUM_THREADS,
       size_t batch_size = 1024, size_t max_queue_batches = 10,
-      bool safe_loop_terminate = false, int argc = 0, char **argv = nullptr)
-      : DemuSimulator(enabled_trace, threads, argc, argv),
+      bool safe_loop_terminate = false, int argc = 0, char **argv = nullptr,
+      bool coverage = false, const std::string &model = "")
+      : DemuSimulator(enabled_trace, threads, argc, argv, coverage, model),
         ref_model_(std::move(ref_model)),
         batch_size_(batch_size > 0 ? batch_size : 1),
         max_queue_batches_(max_queue_batches > 0 ? max_queue_batches : 1),
@@ -74,50 +76,22 @@ public:
   }
 
 protected:
-  struct RetirePacket {
-    bool valid{false};
-    addr_t pc{0};
-    instr_t instr{0};
-    bool reg_we{false};
-    uint8_t reg_addr{0};
-    word_t reg_data{0};
-  };
-
-  auto read_retire_lane0() const noexcept -> RetirePacket {
-    return RetirePacket{
-        .valid = static_cast<bool>(dut_->debug_instret_0),
-        .pc = static_cast<addr_t>(dut_->debug_pc_0),
-        .instr = static_cast<instr_t>(dut_->debug_instr_0),
-        .reg_we = static_cast<bool>(dut_->debug_reg_we_0),
-        .reg_addr = static_cast<uint8_t>(dut_->debug_reg_addr_0),
-        .reg_data = static_cast<word_t>(dut_->debug_reg_data_0),
-    };
-  }
-
-  auto read_retire_lane1() const noexcept -> RetirePacket {
-    return RetirePacket{
-        .valid = static_cast<bool>(dut_->debug_instret_1),
-        .pc = static_cast<addr_t>(dut_->debug_pc_1),
-        .instr = static_cast<instr_t>(dut_->debug_instr_1),
-        .reg_we = static_cast<bool>(dut_->debug_reg_we_1),
-        .reg_addr = static_cast<uint8_t>(dut_->debug_reg_addr_1),
-        .reg_data = static_cast<word_t>(dut_->debug_reg_data_1),
-    };
-  }
-
   void register_devices() override {
-    register_port<0, demu::hal::axif::AXIFullPortHandler,
-                  demu::hal::axif::AXIFullSRAM>("imem");
-    register_port<1, demu::hal::axif::AXIFullPortHandler,
-                  demu::hal::axif::AXIFullSRAM>("dmem");
+    register_memory<0>("imem");
+    register_memory<1>("dmem");
     register_port<2, demu::hal::axif::AXIFullPortHandler,
-                  demu::hal::axif::AXIFullUART>("uart");
+                  demu::hal::axif::AXIFullUART>("uart", uart_console_,
+                                                uart_input_);
 
 #if defined(__ISA_RV32I__) || defined(__ISA_RV32IM__)
     register_port<3, demu::hal::axif::AXIFullPortHandler,
                   demu::hal::axif::AXIFullCLINT>(
         "clint", config_->freq(), timer_irq_.get(), soft_irq_.get());
 #endif
+
+    register_port<4, demu::hal::axif::AXIFullPortHandler,
+                  demu::hal::axif::AXIFullHTIF>(
+        "htif", device_manager_.get(), [this](int code) { halt(code); });
   };
 
   void on_init() override {
@@ -135,6 +109,7 @@ protected:
       if (!local_batch_.empty()) {
         state_queue_.push(std::move(local_batch_));
         local_batch_.clear();
+        batches_pushed_++;
       }
       sim_running_.store(false);
     }
@@ -143,10 +118,33 @@ protected:
     if (difftest_thread_.joinable()) {
       difftest_thread_.join();
     }
+    if (difftest_error_.load()) {
+      exit_reason_ = report::EXIT_REASON_MISMATCH;
+      _exit_code = EXIT_FAILURE;
+      keep_wave();
+    }
   }
 
   void on_reset() override {}
 
+  // The reference may lag the model by the whole queue, which at low IPC
+  // spans more cycles than the two wave segments hold. Drain it before a
+  // segment is dropped so a mismatch always lands in the kept ones.
+  void on_wave_rotate() override {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (!local_batch_.empty()) {
+      state_queue_.push(std::move(local_batch_));
+      local_batch_.clear();
+      local_batch_.reserve(batch_size_);
+      batches_pushed_++;
+      cv_consume_.notify_one();
+    }
+    cv_produce_.wait(lock, [this]() {
+      return batches_checked_ == batches_pushed_ ||
+             difftest_error_.load(std::memory_order_relaxed);
+    });
+  }
+
   void on_clock_tick() override {
     if (__builtin_expect(difftest_error_.load(std::memory_order_relaxed), 0)) {
       _terminate = true;
@@ -188,6 +186,7 @@ protected:
         state_queue_.push(std::move(local_batch_));
         local_batch_.clear();
         local_batch_.reserve(batch_size_);
+        batches_pushed_++;
 
         lock.unlock();
         cv_consume_.notify_one();
@@ -218,12 +217,25 @@ private:
   std::vector<CommitState> local_batch_;
   size_t batch_size_;
   size_t max_queue_batches_;
+  // Guarded by mtx_; equal once the worker has checked every commit
+  uint64_t batches_pushed_{0};
+  uint64_t batches_checked_{0};
   bool safe_loop_terminate_;
   size_t safe_loop_counter_;
 
   std::atomic<bool> sim_running_{false};
   std::atomic<bool> difftest_error_{false};
 
+  // Ends the run from the worker; the simulation thread may be waiting for
+  // queue space, so wake it
+  void stop_on_mismatch() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      difftest_error_.store(true, std::memory_order_relaxed);
+    }
+    cv_produce_.notify_one();
+  }
+
   void difftest_worker() {
     addr_t expected_qemu_pc = entry_point_;
 
@@ -247,10 +259,11 @@ private:
 
       for (const auto &dut_state : batch) {
         if (expected_qemu_pc != dut_state.pc) {
-          DEMU_ERROR("Difftest PC Mismatch at Cycle {}! | DUT: 0x{:08x} | REF: "
-                     "0x{:08x}",
-                     dut_state.cycle, dut_state.pc, expected_qemu_pc);
-          difftest_error_.store(true, std::memory_order_relaxed);
+          DEMU_CRIT("Difftest PC Mismatch at Cycle {}! | DUT: 0x{:08x} {} | "
+                    "REF: 0x{:08x} {}",
+                    dut_state.cycle, dut_state.pc, describe_pc(dut_state.pc),
+                    expected_qemu_pc, describe_pc(expected_qemu_pc));
+          stop_on_mismatch();
           return;
         }
 
@@ -264,14 +277,21 @@ private:
           word_t dut_val = dut_state.reg_data;
 
           if (ref_val != dut_val) {
-            DEMU_ERROR("Difftest GPR[x{:02d}] Mismatch at Cycle {}! | DUT: "
-                       "0x{:08x} | REF: 0x{:08x}",
-                       dut_state.reg_addr, dut_state.cycle, dut_val, ref_val);
-            difftest_error_.store(true, std::memory_order_relaxed);
+            DEMU_CRIT("Difftest GPR[x{:02d}] Mismatch at Cycle {}! | DUT: "
+                      "0x{:08x} | REF: 0x{:08x} | PC: 0x{:08x} {}",
+                      dut_state.reg_addr, dut_state.cycle, dut_val, ref_val,
+                      dut_state.pc, describe_pc(dut_state.pc));
+            stop_on_mismatch();
             return;
           }
         }
       }
+
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        batches_checked_++;
+      }
+      cv_produce_.notify_one();
     }
   }
 };
@@ -299,9 +319,18 @@ void print_usage(const char *prog) {
   std::cout
       << "  -Q --max-batches <n>                Max batches in async queue "
          "(default: 10)\n";
-  std::cout << "  -t, --trace                   Enable VCD trace\n";
-  std::cout << "  -T, --threads <n>             Number of Verilator threads "
-               "(default: NUM_THREADS)\n";
+  std::cout << "  -t, --trace                   Dump waveforms for the whole "
+               "run\n";
+  std::cout << "      --wave <spec>             Dump waveforms only in "
+               "triggered windows, cycles=<from>:[<to>],pc=<addr>,"
+               "instret=<n>,roi=<id>,mismatch,window=<n>,depth=<n>,"
+               "scope=<hier>,out=<path>\n";
+  std::cout << "  --coverage                    Collect coverage with the "
+               "instrumented model\n";
+  std::cout << "  --model <name>                Model to run: "
+            << demu::model_names() << " (default: " DEMU_DEFAULT_MODEL ")\n";
+  std::cout << "  -T, --threads <n>             Deprecated and ignored, the "
+               "thread count is fixed at build time (NUM_THREADS)\n";
   std::cout << "  -SLT, --safe-loop-terminate               Safe return when "
                "stucking at infinite loop (default: false)\n";
   std::cout
@@ -309,6 +338,13 @@ void print_usage(const char *prog) {
   std::cout
       << "  -d, --dump-regs               Dump registers after execution\n";
   std::cout << "  -m, --dump-mem <addr> <size>  Dump memory region\n";
+  std::cout << "      --uart-out <path>         UART console sink (-, stderr, "
+               "|<cmd> or file)\n";
+  std::cout << "      --uart-in <source>        UART RX source (stdin, pty, "
+               "file:<path>, fifo:<path>, script:<path>)\n";
+  std::cout << "      --uart-flush <policy>     UART flush policy (line, "
+               "size[:N], time[:MS])\n";
+  demu::ProfilingOptions::print_usage();
   std::cout << "  -L12345,                      Set log level (5=err, 4=warn, "
                "3=info, 2=debug, 1=trace)\n";
 }
@@ -322,9 +358,11 @@ auto main(int argc, char **argv) -> int {
   std::string program_file;
   std::string ref_so_path;
   bool enable_trace = false;
+  bool coverage = false;
+  std::string model;
+  demu::WaveConfig wave;
   bool dump_regs = false;
   bool dump_mem = false;
-  int threads = NUM_THREADS;
   uint64_t max_cycles = 0;
   uint32_t base_addr = 0;
   uint32_t dump_mem_addr = 0;
@@ -332,11 +370,22 @@ auto main(int argc, char **argv) -> int {
   size_t batch_size = 1024;
   size_t max_batches = 10;
   bool safe_loop_terminate = false;
+  demu::hal::uart::ConsoleConfig uart_console;
+  demu::hal::uart::InputConfig uart_input;
+  demu::ProfilingOptions profiling;
   spdlog::level::level_enum spdlog_level = spdlog::level::info;
 
   for (int i = 1; i < argc; i++) {
     std::string arg = argv[i];
 
+    const auto match = profiling.parse(argc, argv, i);
+    if (match == demu::OptionMatch::INVALID) {
+      return 1;
+    }
+    if (match == demu::OptionMatch::CONSUMED) {
+      continue;
+    }
+
     if (arg == "-h" || arg == "--help") {
       print_usage(argv[0]);
       return 0;
@@ -354,10 +403,24 @@ auto main(int argc, char **argv) -> int {
       }
     } else if (arg == "-t" || arg == "--trace") {
       enable_trace = true;
+    } else if (arg == "--coverage") {
+      coverage = true;
+    } else if (arg == "--model") {
+      if (i + 1 < argc) {
+        model = argv[++i];
+      }
+    } else if (arg == "--wave") {
+      if (i + 1 < argc && !demu::parse_wave_spec(argv[++i], wave)) {
+        std::cerr << "Invalid wave spec: " << argv[i] << std::endl;
+        return 1;
+      }
+      enable_trace = true;
     } else if (arg == "-T" || arg == "--threads") {
       if (i + 1 < argc) {
-        threads = std::stoi(argv[++i]);
+        ++i;
       }
+      std::cerr << "Warning: " << arg << " is deprecated and ignored, the "
+                << "model runs with NUM_THREADS=" << NUM_THREADS << std::endl;
     } else if (arg == "-SLT" || arg == "--safe-loop-terminate") {
       safe_loop_terminate = true;
     } else if (arg == "-d" || arg == "--dump-regs") {
@@ -376,6 +439,22 @@ auto main(int argc, char **argv) -> int {
         dump_mem_size = std::stoul(argv[++i], nullptr, 16);
         dump_mem = true;
       }
+    } else if (arg == "--uart-out") {
+      if (i + 1 < argc) {
+        uart_console.path = argv[++i];
+      }
+    } else if (arg == "--uart-in") {
+      if (i + 1 < argc &&
+          !demu::hal::uart::parse_input_source(argv[++i], uart_input)) {
+        std::cerr << "Invalid UART input source: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--uart-flush") {
+      if (i + 1 < argc &&
+          !demu::hal::uart::parse_flush_policy(argv[++i], uart_console)) {
+        std::cerr << "Invalid UART flush policy: " << argv[i] << std::endl;
+        return 1;
+      }
     } else if (arg[0] == '-' && arg.length() > 1 && arg[1] == 'L') {
       int log_level = std::stoi(arg.substr(2));
       switch (log_level) {
@@ -429,8 +508,29 @@ auto main(int argc, char **argv) -> int {
     return 1;
   }
 
-  DemuSimulatorDiff sim(std::move(ref), enable_trace, threads, batch_size,
-                        max_batches, safe_loop_terminate, argc, argv);
+  DemuSimulatorDiff sim(std::move(ref), enable_trace, NUM_THREADS, batch_size,
+                        max_batches, safe_loop_terminate, argc, argv,
+                        coverage, model);
+  sim.uart_console(uart_console);
+  sim.uart_input(uart_input);
+  // The reference trails the model by up to the whole queue. Mismatch
+  // segments default to covering it; a shorter window still works but the
+  // model waits for the reference at every segment (see on_wave_rotate).
+  const uint64_t queue_commits = (std::max<size_t>(max_batches, 1) + 2) *
+                                 std::max<size_t>(batch_size, 1);
+  if (wave.mismatch && wave.window < queue_commits) {
+    if (wave.window == demu::WaveConfig{}.window) {
+      wave.window = queue_commits;
+    } else {
+      DEMU_WARN("Wave window of {} cycles is shorter than the difftest queue "
+                "({} commits); the model will stall at every segment",
+                wave.window, queue_commits);
+    }
+  }
+  sim.wave(wave);
+  if (!demu::attach_profilers(sim, profiling)) {
+    return 1;
+  }
 
   sim.init();
   sim.reset();
@@ -452,6 +552,7 @@ auto main(int argc, char **argv) -> int {
 
   sim.sync_ref_state();
   sim.run(max_cycles);
+  demu::finish_profilers(sim, profiling);
 
   if (dump_regs) {
     sim.dump_registers();
@@ -460,5 +561,5 @@ auto main(int argc, char **argv) -> int {
     sim.dump_memory(dump_mem_addr, dump_mem_size);
   }
 
-  return 0;
+  return sim.exit_code();
 }
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <demu.hh>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+auto ratio(uint64_t a, uint64_t b) -> double {
+  return b > 0 ? static_cast<double>(a) / static_cast<double>(b) : 0.0;
+}
+
+// Per-interval value of `metric`: "ipc", or any column per cycle
+auto metric_series(const demu::perf::IntervalTable &table,
+                   const std::string &metric) -> std::vector<double> {
+  const auto *cycles = table.column("cycles");
+  const auto *values =
+      table.column(metric == "ipc" ? std::string("instret") : metric);
+  std::vector<double> series;
+  if (!cycles || !values) {
+    return series;
+  }
+  for (size_t r = 0; r < table.rows(); ++r) {
+    series.push_back(ratio((*values)[r], (*cycles)[r]));
+  }
+  return series;
+}
+
+void summarize(const demu::perf::IntervalTable &table,
+               const std::vector<double> &ipc) {
+  const demu::PerfCounters total =
+      table.rows() > 0 ? table.sum(0, table.rows() - 1) : demu::PerfCounters{};
+  DEMU_INFO("--- Intervals ---");
+  DEMU_INFO("  {} intervals, {} cycles, {} instructions, IPC {:.3f}",
+            table.rows(), total.cycles, total.instret,
+            ratio(total.instret, total.cycles));
+  if (!ipc.empty()) {
+    const auto [lo, hi] = std::minmax_element(ipc.begin(), ipc.end());
+    DEMU_INFO("  interval IPC: min {:.3f}  max {:.3f}", *lo, *hi);
+  }
+  DEMU_INFO("")
+}
+
+void print_phases(const std::vector<demu::perf::Phase> &phases) {
+  DEMU_INFO("--- Phases ({}) ---", phases.size());
+  DEMU_INFO("  {:>3} {:>12} {:>12} {:>6} {:>6} {:>8} {:>8} {:>8}  {:>6} "
+            "{:>6} {:>6} {:>6}",
+            "#", "start", "end", "rows", "IPC", "l1i MPKI", "l1d MPKI",
+            "bpu MPKI", "ret%", "bad%", "fe%", "be%");
+  for (size_t p = 0; p < phases.size(); ++p) {
+    const auto &phase = phases[p];
+    const auto &c = phase.total;
+    const auto td = demu::TopDown::from(c);
+    DEMU_INFO("  {:>3} {:>12} {:>12} {:>6} {:>6.3f} {:>8.2f} {:>8.2f} "
+              "{:>8.2f}  {:>6.1f} {:>6.1f} {:>6.1f} {:>6.1f}",
+              p, phase.start_cycle, phase.end_cycle,
+              phase.last - phase.first + 1, ratio(c.instret, c.cycles),
+              1000.0 * ratio(c.l1_icache_miss, c.instret),
+              1000.0 * ratio(c.l1_dcache_miss, c.instret),
+              1000.0 * ratio(c.bpu_mispredict, c.instret),
+              100.0 * td.retiring, 100.0 * td.bad_speculation,
+              100.0 * td.frontend_bound, 100.0 * td.backend_bound);
+  }
+  DEMU_INFO("")
+}
+
+// One sparkline column per bucket of rows, with the phase starts marked
+void plot(const std::string &metric, const std::vector<double> &series,
+          const std::vector<demu::perf::Phase> &phases, size_t width) {
+  if (series.empty()) {
+    DEMU_WARN("Nothing to plot for '{}'", metric);
+    return;
+  }
+  static const char *const BARS[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+  width = std::max<size_t>(std::min(width, series.size()), 1);
+  const double hi = *std::max_element(series.begin(), series.end());
+
+  std::string line;
+  std::string marks(width, ' ');
+  for (size_t b = 0; b < width; ++b) {
+    const size_t first = b * series.size() / width;
+    const size_t last = std::max((b + 1) * series.size() / width, first + 1);
+    double sum = 0;
+    for (size_t r = first; r < last; ++r) {
+      sum += series[r];
+    }
+    const double value = sum / static_cast<double>(last - first);
+    const auto level =
+        hi > 0 ? static_cast<size_t>(value / hi * 7.0 + 0.5) : 0;
+    line += BARS[std::min<size_t>(level, 7)];
+    for (const auto &phase : phases) {
+      if (phase.first >= first && phase.first < last) {
+        marks[b] = '^';
+      }
+    }
+  }
+  DEMU_INFO("--- {} per interval (max {:.3f}) ---", metric, hi);
+  DEMU_INFO("  {}", line);
+  DEMU_INFO("  {}", marks);
+  DEMU_INFO("")
+}
+
+auto write_csv(const demu::perf::IntervalTable &table, const std::string &path)
+    -> bool {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    return false;
+  }
+  for (size_t c = 0; c < table.columns.size(); ++c) {
+    out << table.columns[c] << (c + 1 < table.columns.size() ? "," : "\n");
+  }
+  for (size_t r = 0; r < table.rows(); ++r) {
+    for (size_t c = 0; c < table.columns.size(); ++c) {
+      out << table.data[c][r] << (c + 1 < table.columns.size() ? "," : "\n");
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void print_usage(const char *prog) {
+  std::cout << "Usage: " << prog << " [options] <interval_file>\n\n";
+  std::cout << "Summarizes an interval report written with --interval-report "
+               "and splits it into phases.\n\n";
+  std::cout << "Options:\n";
+  std::cout << "  -h, --help                Show this help message\n";
+  std::cout << "  -t, --threshold <f>       Relative IPC change that starts "
+               "a phase (default: 0.15)\n";
+  std::cout << "      --hold <n>            Intervals the change must last "
+               "(default: 3)\n";
+  std::cout << "  -p, --plot <metric>       Plot ipc or any column per cycle "
+               "(default: ipc)\n";
+  std::cout << "  -w, --width <n>           Plot width (default: 72)\n";
+  std::cout << "      --csv <file>          Convert the report to CSV\n";
+  std::cout << "  -L12345,                  Set log level (5=error, 4=warn, "
+               "3=info, 2=debug, 1=trace)\n";
+  std::cout << std::endl;
+}
+
+auto main(int argc, char **argv) -> int {
+  if (argc < 2) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  std::string interval_file;
+  std::string csv_file;
+  std::string metric = "ipc";
+  double threshold = 0.15;
+  size_t hold = 3;
+  size_t width = 72;
+  spdlog::level::level_enum spdlog_level = spdlog::level::info;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-h" || arg == "--help") {
+      print_usage(argv[0]);
+      return 0;
+    } else if (arg == "-t" || arg == "--threshold") {
+      if (i + 1 < argc) {
+        threshold = std::stod(argv[++i]);
+      }
+    } else if (arg == "--hold") {
+      if (i + 1 < argc) {
+        hold = std::stoul(argv[++i]);
+      }
+    } else if (arg == "-p" || arg == "--plot") {
+      if (i + 1 < argc) {
+        metric = argv[++i];
+      }
+    } else if (arg == "-w" || arg == "--width") {
+      if (i + 1 < argc) {
+        width = std::stoul(argv[++i]);
+      }
+    } else if (arg == "--csv") {
+      if (i + 1 < argc) {
+        csv_file = argv[++i];
+      }
+    } else if (arg[0] == '-' && arg.length() > 1 && arg[1] == 'L') {
+      int log_level = std::stoi(arg.substr(2));
+      switch (log_level) {
+      case 1:
+        spdlog_level = spdlog::level::trace;
+        break;
+      case 2:
+        spdlog_level = spdlog::level::debug;
+        break;
+      case 3:
+        spdlog_level = spdlog::level::info;
+        break;
+      case 4:
+        spdlog_level = spdlog::level::warn;
+        break;
+      case 5:
+        spdlog_level = spdlog::level::err;
+        break;
+      default:
+        std::cerr << "Unknown log level: " << log_level << std::endl;
+      }
+    } else if (arg[0] != '-') {
+      interval_file = arg;
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  if (interval_file.empty()) {
+    std::cerr << "Error: No interval file specified\n";
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  demu::Logger::init(spdlog_level);
+
+  demu::perf::IntervalTable table;
+  if (!table.load(interval_file)) {
+    std::cerr << "Error: Failed to load intervals: " << interval_file
+              << std::endl;
+    return 1;
+  }
+
+  const auto phases = demu::perf::detect_phases(table, threshold, hold);
+  summarize(table, metric_series(table, "ipc"));
+  print_phases(phases);
+  plot(metric, metric_series(table, metric), phases, width);
+
+  if (!csv_file.empty()) {
+    if (!write_csv(table, csv_file)) {
+      DEMU_WARN("Failed to write CSV: {}", csv_file);
+      return 1;
+    }
+    DEMU_INFO("CSV: {}", csv_file);
+  }
+
+  return 0;
+}
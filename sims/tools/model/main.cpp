@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <demu.hh>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+auto ratio(uint64_t a, uint64_t b) -> double {
+  return b > 0 ? static_cast<double>(a) / static_cast<double>(b) : 0.0;
+}
+
+auto error(uint64_t model, uint64_t ref) -> double {
+  return ref > 0 ? 100.0 * (static_cast<double>(model) - ref) / ref : 0.0;
+}
+
+void compare(const demu::PerfCounters &model, const demu::PerfCounters &ref) {
+  DEMU_INFO("--- Model vs Reference ---");
+  DEMU_INFO("  {:<18} {:>12} {:>12} {:>8}", "", "model", "rtl", "error");
+  const std::pair<const char *, uint64_t demu::PerfCounters::*> rows[] = {
+      {"cycles", &demu::PerfCounters::cycles},
+      {"instret", &demu::PerfCounters::instret},
+      {"l1i misses", &demu::PerfCounters::l1_icache_miss},
+      {"l1d misses", &demu::PerfCounters::l1_dcache_miss},
+      {"branches", &demu::PerfCounters::branch_commit},
+      {"bpu mispredicts", &demu::PerfCounters::bpu_mispredict},
+      {"flush cycles", &demu::PerfCounters::flush_cycle},
+  };
+  for (const auto &[name, field] : rows) {
+    DEMU_INFO("  {:<18} {:>12} {:>12} {:>+7.2f}%", name, model.*field,
+              ref.*field, error(model.*field, ref.*field));
+  }
+  DEMU_INFO("")
+}
+
+// Scores predictors over a branch trace; without specs, the built BPU
+auto replay_branches(const std::string &path,
+                     const std::vector<std::string> &specs,
+                     const risc::BpuConfig &bpu) -> bool {
+  std::vector<std::unique_ptr<demu::perf::BranchPredictor>> models;
+  for (const auto &spec : specs) {
+    if (!demu::perf::parse_predictors(spec, models)) {
+      std::cerr << "Invalid predictor: " << spec << std::endl;
+      return false;
+    }
+  }
+  if (specs.empty()) {
+    const auto &btb = bpu.btb();
+    const uint32_t width = bpu.gshare_ghr_width();
+    if (!demu::perf::CacheGeometry{btb.sets(), btb.ways(), 4,
+                                   btb.repl_policy()}
+             .valid() ||
+        width < 2 || width > 24) {
+      std::cerr << "Error: Built BPU cannot be modelled, pass --bpu"
+                << std::endl;
+      return false;
+    }
+    models.push_back(std::make_unique<demu::perf::RtlPredictor>(
+        btb.sets(), btb.ways(), btb.repl_policy(), width));
+  }
+
+  demu::perf::BranchTraceReader reader;
+  if (!reader.open(path)) {
+    std::cerr << "Error: Failed to open branch trace: " << path << std::endl;
+    return false;
+  }
+
+  std::vector<uint64_t> lookups(models.size());
+  std::vector<uint64_t> mispredicts(models.size());
+  uint64_t branches = 0;
+  demu::perf::BranchRecord br;
+  while (reader.next(br)) {
+    branches++;
+    for (size_t k = 0; k < models.size(); ++k) {
+      switch (models[k]->predict(br)) {
+      case demu::perf::BranchPredictor::Outcome::MISPREDICT:
+        mispredicts[k]++;
+        [[fallthrough]];
+      case demu::perf::BranchPredictor::Outcome::CORRECT:
+        lookups[k]++;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  DEMU_INFO("--- Branch Trace Replay ({} branches) ---", branches);
+  for (size_t k = 0; k < models.size(); ++k) {
+    DEMU_INFO("  {:<28} {:<5} miss {:>6.2f}%  per 1k branches {:>7.2f}",
+              models[k]->name(), models[k]->scope(),
+              demu::perf::percent(mispredicts[k], lookups[k]),
+              demu::perf::per_kilo(mispredicts[k], branches));
+  }
+  DEMU_INFO("")
+  return true;
+}
+
+} // namespace
+
+void print_usage(const char *prog) {
+  std::cout << "Usage: " << prog << " [options] <trace_file>\n\n";
+  std::cout << "Replays an instruction trace written with --inst-trace "
+               "through a timing model of the core.\n\n";
+  std::cout << "Options:\n";
+  std::cout << "  -h, --help                Show this help message\n";
+  std::cout << "  -C, --config <file>       RiscConfig to model (JSON or .pb, "
+               "default: the built RTL's)\n";
+  std::cout << "  -p, --params <file>       Load timing parameters\n";
+  std::cout << "      --calibrate <file>    Fit timing parameters to the "
+               "trace's RTL counters and save them\n";
+  std::cout << "  -s, --sweep <key>=<v,..>  Sweep a config field (issue_width, "
+               "ibuffer, rob, scheduler, l1i, l1d, btb, ghr, alu, mult, ld, "
+               "st, bru, csr, div)\n";
+  std::cout << "  -o, --report <file>       Write every swept point as CSV "
+               "to <file>\n";
+  std::cout << "  -n, --top <n>             Print the n fastest points "
+               "(default: 10)\n";
+  std::cout << "  -j, --jobs <n>            Worker threads (default: all "
+               "cores)\n";
+  std::cout << "  -b, --branch-trace <file> Replay a trace written with "
+               "--branch-trace through the --bpu predictors\n";
+  std::cout << "      --bpu <spec>          Predictors to replay (see "
+               "--shadow-bpu, default: the built BPU)\n";
+  std::cout << "  -L12345,                  Set log level (5=error, 4=warn, "
+               "3=info, 2=debug, 1=trace)\n";
+  std::cout << std::endl;
+}
+
+auto main(int argc, char **argv) -> int {
+  if (argc < 2) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  std::string trace_file;
+  std::string config_file;
+  std::string params_file;
+  std::string calibrate_file;
+  std::string report_file;
+  std::string branch_trace;
+  std::vector<std::string> bpu_specs;
+  size_t top = 10;
+  unsigned jobs = std::max(std::thread::hardware_concurrency(), 1u);
+  demu::perf::TimingSweep sweep;
+  spdlog::level::level_enum spdlog_level = spdlog::level::info;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-h" || arg == "--help") {
+      print_usage(argv[0]);
+      return 0;
+    } else if (arg == "-C" || arg == "--config") {
+      if (i + 1 < argc) {
+        config_file = argv[++i];
+      }
+    } else if (arg == "-p" || arg == "--params") {
+      if (i + 1 < argc) {
+        params_file = argv[++i];
+      }
+    } else if (arg == "--calibrate") {
+      if (i + 1 < argc) {
+        calibrate_file = argv[++i];
+      }
+    } else if (arg == "-s" || arg == "--sweep") {
+      if (i + 1 < argc && !sweep.add_axis(argv[++i])) {
+        std::cerr << "Invalid sweep: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "-o" || arg == "--report") {
+      if (i + 1 < argc) {
+        report_file = argv[++i];
+      }
+    } else if (arg == "-n" || arg == "--top") {
+      if (i + 1 < argc) {
+        top = std::stoul(argv[++i]);
+      }
+    } else if (arg == "-j" || arg == "--jobs") {
+      if (i + 1 < argc) {
+        jobs = std::max(std::stoi(argv[++i]), 1);
+      }
+    } else if (arg == "-b" || arg == "--branch-trace") {
+      if (i + 1 < argc) {
+        branch_trace = argv[++i];
+      }
+    } else if (arg == "--bpu") {
+      if (i + 1 < argc) {
+        bpu_specs.emplace_back(argv[++i]);
+      }
+    } else if (arg[0] == '-' && arg.length() > 1 && arg[1] == 'L') {
+      int log_level = std::stoi(arg.substr(2));
+      switch (log_level) {
+      case 1:
+        spdlog_level = spdlog::level::trace;
+        break;
+      case 2:
+        spdlog_level = spdlog::level::debug;
+        break;
+      case 3:
+        spdlog_level = spdlog::level::info;
+        break;
+      case 4:
+        spdlog_level = spdlog::level::warn;
+        break;
+      case 5:
+        spdlog_level = spdlog::level::err;
+        break;
+      default:
+        std::cerr << "Unknown log level: " << log_level << std::endl;
+      }
+    } else if (arg[0] != '-') {
+      trace_file = arg;
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  if (trace_file.empty() && branch_trace.empty()) {
+    std::cerr << "Error: No trace file specified\n";
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  demu::Logger::init(spdlog_level);
+
+  const demu::RiscConfig config = config_file.empty()
+                                      ? demu::RiscConfig()
+                                      : demu::RiscConfig(config_file);
+  if (!config.is_valid()) {
+    return 1;
+  }
+
+  if (!branch_trace.empty()) {
+    if (!replay_branches(branch_trace, bpu_specs, config.proto().bpu())) {
+      return 1;
+    }
+    if (trace_file.empty()) {
+      return 0;
+    }
+  }
+
+  demu::perf::TimingParams params;
+  if (!params_file.empty() && !params.read(params_file)) {
+    std::cerr << "Invalid timing parameters: " << params_file << std::endl;
+    return 1;
+  }
+
+  using clock = std::chrono::steady_clock;
+  const auto loading = clock::now();
+  demu::perf::TimingTrace trace;
+  if (!trace.load(trace_file)) {
+    std::cerr << "Error: Failed to load trace: " << trace_file << std::endl;
+    return 1;
+  }
+  DEMU_INFO("Trace loaded: {} ({} instructions, {:.2f}s)", trace_file,
+            trace.ops().size(),
+            std::chrono::duration<double>(clock::now() - loading).count());
+  if (!trace.has_reference()) {
+    DEMU_WARN("Trace has no reference counters; calibration is unavailable");
+  }
+
+  if (!calibrate_file.empty()) {
+    const double err = demu::perf::calibrate(config.proto(), trace, params);
+    if (err < 0) {
+      std::cerr << "Error: Cannot calibrate without reference counters"
+                << std::endl;
+      return 1;
+    }
+    DEMU_INFO("Calibrated: {} (cycle error {:+.2f}%)", params.to_string(),
+              100.0 * err);
+    if (!params.write(calibrate_file)) {
+      DEMU_WARN("Failed to write timing parameters: {}", calibrate_file);
+    }
+  }
+
+  if (trace.has_reference()) {
+    compare(demu::perf::TimingModel(config.proto(), params).run(trace),
+            trace.reference());
+  }
+
+  const auto points = sweep.expand(config.proto());
+  std::vector<demu::PerfCounters> results(points.size());
+  std::atomic<size_t> next{0};
+
+  const auto start = clock::now();
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < std::min<size_t>(jobs, points.size()); ++w) {
+    workers.emplace_back([&] {
+      for (size_t i = next++; i < points.size(); i = next++) {
+        results[i] =
+            demu::perf::TimingModel(points[i].config, params).run(trace);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - start).count();
+
+  std::vector<size_t> order(points.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return results[a].cycles < results[b].cycles;
+  });
+
+  DEMU_INFO("--- Timing Model ({} points, {:.2f}s, {:.1f} M instr/s) ---",
+            points.size(), seconds,
+            seconds > 0 ? 1e-6 * static_cast<double>(trace.ops().size()) *
+                              points.size() / seconds
+                        : 0.0);
+  DEMU_INFO("  {:>12} {:>6} {:>9} {:>9} {:>9}  {}", "cycles", "IPC",
+            "l1i MPKI", "l1d MPKI", "bpu MPKI", "config");
+  for (size_t k = 0; k < std::min(top, order.size()); ++k) {
+    const auto &r = results[order[k]];
+    DEMU_INFO("  {:>12} {:>6.3f} {:>9.2f} {:>9.2f} {:>9.2f}  {}", r.cycles,
+              ratio(r.instret, r.cycles),
+              1000.0 * ratio(r.l1_icache_miss, r.instret),
+              1000.0 * ratio(r.l1_dcache_miss, r.instret),
+              1000.0 * ratio(r.bpu_mispredict, r.instret),
+              points[order[k]].label);
+  }
+  DEMU_INFO("")
+
+  if (!report_file.empty()) {
+    std::ofstream out(report_file);
+    if (!out.is_open()) {
+      DEMU_WARN("Failed to write model report: {}", report_file);
+      return 1;
+    }
+    out << "config,cycles,instret,ipc,l1i_accesses,l1i_misses,l1d_accesses,"
+           "l1d_misses,branches,mispredicts\n";
+    for (const size_t i : order) {
+      const auto &r = results[i];
+      out << fmt::format("\"{}\",{},{},{:.6f},{},{},{},{},{},{}\n",
+                         points[i].label, r.cycles, r.instret,
+                         ratio(r.instret, r.cycles), r.l1_icache_access,
+                         r.l1_icache_miss, r.l1_dcache_access,
+                         r.l1_dcache_miss, r.branch_commit,
+                         r.bpu_mispredict);
+    }
+    DEMU_INFO("Report: {}", report_file);
+  }
+
+  return 0;
+}
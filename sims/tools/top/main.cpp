@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <demu.hh>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Job {
+  std::unique_ptr<demu::LiveStatsReader> reader;
+  demu::LiveSnapshot snapshot;
+  uint64_t last_instret{0};
+  std::chrono::steady_clock::time_point progress; // instret last advanced
+  bool gone{false}; // segment removed; shown once more, then dropped
+};
+
+auto alive(int32_t pid) -> bool {
+  return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+auto hit_percent(uint64_t misses, uint64_t accesses) -> double {
+  return accesses > 0
+             ? 100.0 - 100.0 * static_cast<double>(misses) / accesses
+             : 0.0;
+}
+
+auto elapsed(uint64_t from_ns, uint64_t to_ns) -> std::string {
+  const uint64_t s = to_ns > from_ns ? (to_ns - from_ns) / 1000000000ULL : 0;
+  return fmt::format("{}:{:02d}:{:02d}", s / 3600, s / 60 % 60, s % 60);
+}
+
+auto basename(const char *path) -> std::string {
+  const std::string p(path);
+  const size_t slash = p.find_last_of('/');
+  return slash == std::string::npos ? p : p.substr(slash + 1);
+}
+
+void refresh(std::map<std::string, Job> &jobs) {
+  const auto now = std::chrono::steady_clock::now();
+  for (auto &[name, job] : jobs) {
+    job.gone = true;
+  }
+  for (const auto &name : demu::LiveStatsReader::list()) {
+    auto it = jobs.find(name);
+    if (it == jobs.end()) {
+      Job job;
+      job.reader = std::make_unique<demu::LiveStatsReader>();
+      if (!job.reader->attach(name)) {
+        continue;
+      }
+      job.progress = now;
+      it = jobs.emplace(name, std::move(job)).first;
+    }
+    it->second.gone = false;
+  }
+
+  for (auto &[name, job] : jobs) {
+    if (!job.reader->read(job.snapshot)) {
+      continue;
+    }
+    const uint64_t instret = job.snapshot.counter(&demu::PerfCounters::instret);
+    if (instret != job.last_instret) {
+      job.last_instret = instret;
+      job.progress = now;
+    }
+  }
+}
+
+void render(const std::map<std::string, Job> &jobs, double stuck_seconds,
+            bool clear) {
+  const auto now = std::chrono::steady_clock::now();
+  const uint64_t now_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+
+  std::vector<double> rates;
+  for (const auto &[name, job] : jobs) {
+    if (job.snapshot.state == demu::LiveState::RUNNING && !job.gone) {
+      rates.push_back(job.snapshot.khz);
+    }
+  }
+  std::sort(rates.begin(), rates.end());
+  const double median = rates.empty() ? 0.0 : rates[rates.size() / 2];
+
+  if (clear) {
+    fmt::print("\033[H\033[2J");
+  }
+  fmt::print("demu-top: {} simulations, median {:.1f} kHz\n\n", jobs.size(),
+             median);
+  fmt::print("{:>8} {:<8} {:>9} {:>14} {:>14} {:>6} {:>9} {:>6} {:>6} {:>6}  "
+             "{}\n",
+             "PID", "STATE", "ELAPSED", "CYCLES", "INSTRET", "IPC", "KHZ",
+             "L1I%", "L1D%", "BPU%", "PROGRAM");
+
+  using demu::PerfCounters;
+  for (const auto &[name, job] : jobs) {
+    const auto &s = job.snapshot;
+    const uint64_t cycles = s.counter(&PerfCounters::cycles);
+    const uint64_t instret = s.counter(&PerfCounters::instret);
+    const double idle =
+        std::chrono::duration<double>(now - job.progress).count();
+
+    std::string state = "run";
+    if (s.state == demu::LiveState::EXITED) {
+      state = fmt::format("exit({})", s.exit_code);
+    } else if (job.gone || !alive(s.pid)) {
+      state = "dead";
+    } else if (idle > stuck_seconds) {
+      state = "stuck";
+    } else if (median > 0 && s.khz < 0.5 * median) {
+      state = "slow";
+    }
+
+    const uint64_t end_ns =
+        s.state == demu::LiveState::EXITED ? s.update_ns : now_ns;
+    fmt::print("{:>8} {:<8} {:>9} {:>14} {:>14} {:>6.3f} {:>9.1f} {:>6.1f} "
+               "{:>6.1f} {:>6.1f}  {}\n",
+               s.pid, state, elapsed(s.start_ns, end_ns), cycles, instret,
+               cycles > 0 ? static_cast<double>(instret) / cycles : 0.0, s.khz,
+               hit_percent(s.counter(&PerfCounters::l1_icache_miss),
+                           s.counter(&PerfCounters::l1_icache_access)),
+               hit_percent(s.counter(&PerfCounters::l1_dcache_miss),
+                           s.counter(&PerfCounters::l1_dcache_access)),
+               hit_percent(s.counter(&PerfCounters::bpu_mispredict),
+                           s.counter(&PerfCounters::branch_commit)),
+               basename(s.program));
+  }
+  std::fflush(stdout);
+}
+
+// Removes the segments of processes that no longer exist
+auto clean() -> int {
+  int removed = 0;
+  for (const auto &name : demu::LiveStatsReader::list()) {
+    demu::LiveStatsReader reader;
+    demu::LiveSnapshot s;
+    if (reader.attach(name) && reader.read(s) && !alive(s.pid)) {
+      reader.detach();
+      if (shm_unlink(name.c_str()) == 0) {
+        fmt::print("removed {} (pid {})\n", name, s.pid);
+        removed++;
+      }
+    }
+  }
+  fmt::print("{} stale segments removed\n", removed);
+  return 0;
+}
+
+} // namespace
+
+void print_usage(const char *prog) {
+  std::cout << "Usage: " << prog << " [options]\n\n";
+  std::cout << "Live view of every simulation started with --live-stats on "
+               "this host.\n\n";
+  std::cout << "Options:\n";
+  std::cout << "  -h, --help                Show this help message\n";
+  std::cout << "  -d, --delay <seconds>     Refresh period (default: 1)\n";
+  std::cout << "  -1, --once                Print one view and exit\n";
+  std::cout << "      --stuck <seconds>     Flag jobs that retire nothing for "
+               "this long (default: 30)\n";
+  std::cout << "      --clean               Remove segments left by dead "
+               "processes\n";
+  std::cout << std::endl;
+}
+
+auto main(int argc, char **argv) -> int {
+  double delay = 1.0;
+  double stuck_seconds = 30.0;
+  bool once = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-h" || arg == "--help") {
+      print_usage(argv[0]);
+      return 0;
+    } else if (arg == "-d" || arg == "--delay") {
+      if (i + 1 < argc) {
+        delay = std::max(std::stod(argv[++i]), 0.1);
+      }
+    } else if (arg == "-1" || arg == "--once") {
+      once = true;
+    } else if (arg == "--stuck") {
+      if (i + 1 < argc) {
+        stuck_seconds = std::stod(argv[++i]);
+      }
+    } else if (arg == "--clean") {
+      return clean();
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  std::map<std::string, Job> jobs;
+  for (;;) {
+    refresh(jobs);
+    render(jobs, stuck_seconds, !once);
+    if (once) {
+      return 0;
+    }
+    for (auto it = jobs.begin(); it != jobs.end();) {
+      it = it->second.gone ? jobs.erase(it) : std::next(it);
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+  }
+}